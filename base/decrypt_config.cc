@@ -8,15 +8,23 @@
 
 #include "base/logging.h"
 #include "base/strings/string_number_conversions.h"
+#include "media/base/media_util.h"
 
 namespace media {
 
 DecryptConfig::DecryptConfig(const std::string& key_id,
                              const std::string& iv,
                              const std::vector<SubsampleEntry>& subsamples)
+    : DecryptConfig(key_id, iv, subsamples, AesCtrEncryptionScheme()) {}
+
+DecryptConfig::DecryptConfig(const std::string& key_id,
+                             const std::string& iv,
+                             const std::vector<SubsampleEntry>& subsamples,
+                             const EncryptionScheme& encryption_scheme)
     : key_id_(key_id),
       iv_(iv),
-      subsamples_(subsamples) {
+      subsamples_(subsamples),
+      encryption_scheme_(encryption_scheme) {
   CHECK_GT(key_id.size(), 0u);
   CHECK(iv.size() == static_cast<size_t>(DecryptConfig::kDecryptionKeySize) ||
         iv.empty());
@@ -26,7 +34,8 @@ DecryptConfig::~DecryptConfig() {}
 
 bool DecryptConfig::Matches(const DecryptConfig& config) const {
   if (key_id() != config.key_id() || iv() != config.iv() ||
-      subsamples().size() != config.subsamples().size()) {
+      subsamples().size() != config.subsamples().size() ||
+      !encryption_scheme().Matches(config.encryption_scheme())) {
     return false;
   }
 
@@ -50,6 +59,12 @@ std::ostream& DecryptConfig::Print(std::ostream& os) const {
        << ")";
   }
   os << "]";
+
+  os << " mode:" << encryption_scheme_.mode();
+  if (encryption_scheme_.pattern().IsInEffect()) {
+    os << " pattern:(" << encryption_scheme_.pattern().encrypt_blocks() << ":"
+       << encryption_scheme_.pattern().skip_blocks() << ")";
+  }
   return os;
 }
 
@@ -12,6 +12,7 @@
 #include <vector>
 
 #include "base/macros.h"
+#include "media/base/encryption_scheme.h"
 #include "media/base/media_export.h"
 #include "media/base/subsample_entry.h"
 
@@ -30,14 +31,27 @@ class MEDIA_EXPORT DecryptConfig {
   // |subsamples| defines the clear and encrypted portions of the sample as
   //   described above. A decrypted buffer will be equal in size to the sum
   //   of the subsample sizes.
+  // The sample is assumed to be protected with AES-CTR and no pattern, as in
+  //   the 'cenc' scheme.
   DecryptConfig(const std::string& key_id,
                 const std::string& iv,
                 const std::vector<SubsampleEntry>& subsamples);
+
+  // Same as above, but for a sample protected with |encryption_scheme|, e.g.
+  // the 'cens' and 'cbcs' pattern encryption schemes. The pattern, if any,
+  // applies to the encrypted portion of each subsample.
+  DecryptConfig(const std::string& key_id,
+                const std::string& iv,
+                const std::vector<SubsampleEntry>& subsamples,
+                const EncryptionScheme& encryption_scheme);
   ~DecryptConfig();
 
   const std::string& key_id() const { return key_id_; }
   const std::string& iv() const { return iv_; }
   const std::vector<SubsampleEntry>& subsamples() const { return subsamples_; }
+  const EncryptionScheme& encryption_scheme() const {
+    return encryption_scheme_;
+  }
 
   // Returns true if the corresponding decoder buffer requires decryption and
   // false if that buffer is clear despite the presense of DecryptConfig.
@@ -59,6 +73,9 @@ class MEDIA_EXPORT DecryptConfig {
   // (less data ignored by data_offset_) is encrypted.
   const std::vector<SubsampleEntry> subsamples_;
 
+  // Cipher mode and (encrypt:skip) pattern used for the encrypted bytes.
+  const EncryptionScheme encryption_scheme_;
+
   DISALLOW_COPY_AND_ASSIGN(DecryptConfig);
 };
 
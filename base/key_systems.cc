@@ -9,8 +9,10 @@
 #include <memory>
 
 #include "base/containers/hash_tables.h"
+#include "base/containers/mru_cache.h"
 #include "base/logging.h"
 #include "base/macros.h"
+#include "base/strings/string_number_conversions.h"
 #include "base/strings/string_util.h"
 #include "base/threading/thread_checker.h"
 #include "base/time/time.h"
@@ -179,6 +181,33 @@ static bool IsPotentiallySupportedKeySystem(const std::string& key_system) {
                           base::CompareCase::SENSITIVE);
 }
 
+// The number of GetContentTypeConfigRule() and GetRobustnessConfigRule()
+// results remembered. requestMediaKeySystemAccess() probing by a page asks
+// about a few dozen combinations.
+static const size_t kConfigRuleCacheSize = 256;
+
+// Appends |value| to the cache key |key|, prefixed by its length so that no two
+// lists of values make the same key.
+static void AppendToCacheKey(const std::string& value, std::string* key) {
+  key->append(base::SizeTToString(value.size()));
+  key->push_back(':');
+  key->append(value);
+}
+
+static std::string CreateConfigRuleCacheKey(
+    const std::string& key_system,
+    EmeMediaType media_type,
+    const std::string& value,
+    const std::vector<std::string>& codecs) {
+  std::string key;
+  key.push_back(media_type == EmeMediaType::AUDIO ? 'a' : 'v');
+  AppendToCacheKey(key_system, &key);
+  AppendToCacheKey(value, &key);
+  for (const std::string& codec : codecs)
+    AppendToCacheKey(codec, &key);
+  return key;
+}
+
 class KeySystemsImpl : public KeySystems {
  public:
   static KeySystemsImpl* GetInstance();
@@ -239,6 +268,22 @@ class KeySystemsImpl : public KeySystems {
   void AddSupportedKeySystems(
       std::vector<std::unique_ptr<KeySystemProperties>> key_systems);
 
+  // Uncached implementations of GetContentTypeConfigRule() and
+  // GetRobustnessConfigRule().
+  EmeConfigRule ComputeContentTypeConfigRule(
+      const std::string& key_system,
+      EmeMediaType media_type,
+      const std::string& container_mime_type,
+      const std::vector<std::string>& codecs) const;
+  EmeConfigRule ComputeRobustnessConfigRule(
+      const std::string& key_system,
+      EmeMediaType media_type,
+      const std::string& requested_robustness) const;
+
+  // Forgets the results of the Get*ConfigRule() methods, which must be done
+  // whenever the key systems or codecs they depend on change.
+  void ClearConfigRuleCaches();
+
   void RegisterMimeType(const std::string& mime_type, EmeCodec codecs_mask);
   bool IsValidMimeTypeCodecsCombination(const std::string& mime_type,
                                         SupportedCodecs codecs_mask) const;
@@ -266,6 +311,13 @@ class KeySystemsImpl : public KeySystems {
   SupportedCodecs audio_codec_mask_;
   SupportedCodecs video_codec_mask_;
 
+  // Results of GetContentTypeConfigRule() and GetRobustnessConfigRule(), keyed
+  // by CreateConfigRuleCacheKey() of their arguments.
+  mutable base::HashingMRUCache<std::string, EmeConfigRule>
+      content_type_rule_cache_;
+  mutable base::HashingMRUCache<std::string, EmeConfigRule>
+      robustness_rule_cache_;
+
   // Makes sure all methods are called from the same thread.
   base::ThreadChecker thread_checker_;
 
@@ -282,7 +334,9 @@ KeySystemsImpl* KeySystemsImpl::GetInstance() {
 // when the instance is constructed.
 KeySystemsImpl::KeySystemsImpl()
     : audio_codec_mask_(EME_CODEC_AUDIO_ALL),
-      video_codec_mask_(EME_CODEC_VIDEO_ALL) {
+      video_codec_mask_(EME_CODEC_VIDEO_ALL),
+      content_type_rule_cache_(kConfigRuleCacheSize),
+      robustness_rule_cache_(kConfigRuleCacheSize) {
   for (size_t i = 0; i < arraysize(kCodecStrings); ++i) {
     const std::string& name = kCodecStrings[i].name;
     DCHECK(!codec_string_map_.count(name));
@@ -326,6 +380,7 @@ void KeySystemsImpl::UpdateIfNeeded() {
 void KeySystemsImpl::UpdateSupportedKeySystems() {
   DCHECK(thread_checker_.CalledOnValidThread());
   key_system_properties_map_.clear();
+  ClearConfigRuleCaches();
 
   std::vector<std::unique_ptr<KeySystemProperties>> key_systems_properties;
 
@@ -454,6 +509,12 @@ void KeySystemsImpl::RegisterMimeType(const std::string& mime_type,
   DCHECK(IsValidMimeTypeCodecsCombination(mime_type, codecs_mask));
 
   mime_type_to_codec_mask_map_[mime_type] = static_cast<EmeCodec>(codecs_mask);
+  ClearConfigRuleCaches();
+}
+
+void KeySystemsImpl::ClearConfigRuleCaches() {
+  content_type_rule_cache_.Clear();
+  robustness_rule_cache_.Clear();
 }
 
 // Returns whether |mime_type| follows a valid format and the specified codecs
@@ -544,6 +605,7 @@ void KeySystemsImpl::AddCodecMask(EmeMediaType media_type,
   } else {
     video_codec_mask_ |= mask;
   }
+  ClearConfigRuleCaches();
 }
 
 void KeySystemsImpl::AddMimeTypeCodecMask(const std::string& mime_type,
@@ -567,6 +629,23 @@ EmeConfigRule KeySystemsImpl::GetContentTypeConfigRule(
     const std::vector<std::string>& codecs) const {
   DCHECK(thread_checker_.CalledOnValidThread());
 
+  const std::string key = CreateConfigRuleCacheKey(
+      key_system, media_type, container_mime_type, codecs);
+  auto it = content_type_rule_cache_.Get(key);
+  if (it != content_type_rule_cache_.end())
+    return it->second;
+
+  const EmeConfigRule rule = ComputeContentTypeConfigRule(
+      key_system, media_type, container_mime_type, codecs);
+  content_type_rule_cache_.Put(key, rule);
+  return rule;
+}
+
+EmeConfigRule KeySystemsImpl::ComputeContentTypeConfigRule(
+    const std::string& key_system,
+    EmeMediaType media_type,
+    const std::string& container_mime_type,
+    const std::vector<std::string>& codecs) const {
   // Make sure the container MIME type matches |media_type|.
   switch (media_type) {
     case EmeMediaType::AUDIO:
@@ -638,6 +717,22 @@ EmeConfigRule KeySystemsImpl::GetRobustnessConfigRule(
     const std::string& requested_robustness) const {
   DCHECK(thread_checker_.CalledOnValidThread());
 
+  const std::string key = CreateConfigRuleCacheKey(
+      key_system, media_type, requested_robustness, {});
+  auto it = robustness_rule_cache_.Get(key);
+  if (it != robustness_rule_cache_.end())
+    return it->second;
+
+  const EmeConfigRule rule = ComputeRobustnessConfigRule(
+      key_system, media_type, requested_robustness);
+  robustness_rule_cache_.Put(key, rule);
+  return rule;
+}
+
+EmeConfigRule KeySystemsImpl::ComputeRobustnessConfigRule(
+    const std::string& key_system,
+    EmeMediaType media_type,
+    const std::string& requested_robustness) const {
   KeySystemPropertiesMap::const_iterator key_system_iter =
       key_system_properties_map_.find(key_system);
   if (key_system_iter == key_system_properties_map_.end()) {
@@ -0,0 +1,114 @@
+// Copyright 2017 The Chromium Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#include <string>
+#include <vector>
+
+#include "base/time/time.h"
+#include "media/base/eme_constants.h"
+#include "media/base/key_systems.h"
+#include "media/base/mime_util.h"
+#include "media/media_features.h"
+#include "testing/gtest/include/gtest/gtest.h"
+#include "testing/perf/perf_test.h"
+#include "third_party/widevine/cdm/widevine_cdm_common.h"
+
+namespace media {
+
+namespace {
+
+const int kIterations = 1000;
+
+struct Capability {
+  EmeMediaType media_type;
+  const char* content_type;
+  const char* codecs;
+};
+
+// The capabilities a player library offers requestMediaKeySystemAccess() when
+// probing which codecs it can use, from most to least preferred.
+const Capability kCapabilities[] = {
+    {EmeMediaType::VIDEO, "video/webm", "vp09.00.10.08"},
+    {EmeMediaType::VIDEO, "video/webm", "vp9"},
+    {EmeMediaType::VIDEO, "video/webm", "vp8"},
+#if BUILDFLAG(USE_PROPRIETARY_CODECS)
+    {EmeMediaType::VIDEO, "video/mp4", "hev1.1.6.L93.B0"},
+    {EmeMediaType::VIDEO, "video/mp4", "avc1.640028"},
+    {EmeMediaType::VIDEO, "video/mp4", "avc1.4d401f"},
+    {EmeMediaType::VIDEO, "video/mp4", "avc1.42e01e"},
+    {EmeMediaType::AUDIO, "audio/mp4", "mp4a.40.2"},
+    {EmeMediaType::AUDIO, "audio/mp4", "ec-3"},
+#endif
+    {EmeMediaType::AUDIO, "audio/webm", "opus"},
+    {EmeMediaType::AUDIO, "audio/webm", "vorbis"},
+};
+
+// Robustness levels are probed from the most to the least secure.
+const char* const kRobustnessLevels[] = {
+    "HW_SECURE_ALL", "HW_SECURE_DECODE", "HW_SECURE_CRYPTO",
+    "SW_SECURE_DECODE", "SW_SECURE_CRYPTO", "",
+};
+
+// Replays the checks KeySystemConfigSelector makes for each capability of one
+// requestMediaKeySystemAccess() per key system and robustness level. Returns
+// the number of supported combinations.
+int ReplayProbing() {
+  const char* const kKeySystems[] = {kWidevineKeySystem, "org.w3.clearkey"};
+  KeySystems* key_systems = KeySystems::GetInstance();
+
+  int supported = 0;
+  for (const char* key_system : kKeySystems) {
+    if (!key_systems->IsSupportedKeySystem(key_system))
+      continue;
+
+    for (const char* robustness : kRobustnessLevels) {
+      for (const Capability& capability : kCapabilities) {
+        std::vector<std::string> codecs;
+        SplitCodecsToVector(capability.codecs, &codecs, false);
+        if (IsSupportedEncryptedMediaFormat(capability.content_type, codecs) ==
+            IsNotSupported) {
+          continue;
+        }
+
+        std::vector<std::string> stripped_codecs;
+        SplitCodecsToVector(capability.codecs, &stripped_codecs, true);
+        if (key_systems->GetContentTypeConfigRule(
+                key_system, capability.media_type, capability.content_type,
+                stripped_codecs) == EmeConfigRule::NOT_SUPPORTED) {
+          continue;
+        }
+
+        if (key_systems->GetRobustnessConfigRule(
+                key_system, capability.media_type, robustness) ==
+            EmeConfigRule::NOT_SUPPORTED) {
+          continue;
+        }
+        ++supported;
+      }
+    }
+  }
+  return supported;
+}
+
+}  // namespace
+
+TEST(KeySystemsPerfTest, ReplayProbing) {
+  // The first replay runs with nothing cached.
+  base::TimeTicks start = base::TimeTicks::Now();
+  const int supported = ReplayProbing();
+  perf_test::PrintResult("key_systems", "", "first_probe",
+                         (base::TimeTicks::Now() - start).InMicrosecondsF(),
+                         "us", true);
+  EXPECT_GT(supported, 0);
+
+  start = base::TimeTicks::Now();
+  for (int i = 0; i < kIterations; ++i)
+    ASSERT_EQ(supported, ReplayProbing());
+  perf_test::PrintResult(
+      "key_systems", "", "repeated_probe",
+      (base::TimeTicks::Now() - start).InMicrosecondsF() / kIterations, "us",
+      true);
+}
+
+}  // namespace media
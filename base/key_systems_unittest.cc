@@ -750,6 +750,40 @@ TEST_F(KeySystemsTest, KeySystemsUpdate) {
     EXPECT_FALSE(IsSupportedKeySystem(kExternal));
 }
 
+// Results are cached; repeated queries must get the same answers, and
+// different arguments must not share cache entries.
+TEST_F(KeySystemsTest, RepeatedContentTypeQueries) {
+  const CodecVector kVp8AndUnknown = {"vp8", "unknown"};
+  const CodecVector kVp8Unknown = {"vp8unknown"};
+  for (int i = 0; i < 2; ++i) {
+    EXPECT_TRUE(IsSupportedKeySystemWithMediaMimeType(kVideoWebM, vp8_codec(),
+                                                      kUsesAes));
+    EXPECT_FALSE(IsSupportedKeySystemWithMediaMimeType(
+        kVideoWebM, kVp8AndUnknown, kUsesAes));
+    EXPECT_FALSE(IsSupportedKeySystemWithMediaMimeType(kVideoWebM, kVp8Unknown,
+                                                       kUsesAes));
+    EXPECT_FALSE(IsSupportedKeySystemWithAudioMimeType(kVideoWebM, vp8_codec(),
+                                                       kUsesAes));
+  }
+}
+
+TEST_F(KeySystemsTest, AddCodecMaskClearsCachedResults) {
+  // KeySystems is a singleton, so the codec can only be added once per
+  // process.
+  static bool is_codec_added = false;
+  if (is_codec_added)
+    return;
+
+  const CodecVector kNewCodec = {"foovideo2"};
+  EXPECT_FALSE(
+      IsSupportedKeySystemWithMediaMimeType(kVideoFoo, kNewCodec, kUsesAes));
+
+  AddCodecMask(EmeMediaType::VIDEO, "foovideo2", TEST_CODEC_FOO_VIDEO);
+  is_codec_added = true;
+  EXPECT_TRUE(
+      IsSupportedKeySystemWithMediaMimeType(kVideoFoo, kNewCodec, kUsesAes));
+}
+
 TEST_F(KeySystemsTest, GetContentTypeConfigRule) {
   if (!CanRunExternalKeySystemTests())
     return;
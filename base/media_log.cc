@@ -10,6 +10,7 @@
 #include "base/json/json_writer.h"
 #include "base/strings/string_util.h"
 #include "base/values.h"
+#include "media/base/media_log_event_ring.h"
 
 namespace media {
 
@@ -17,6 +18,18 @@ namespace media {
 // unique IDs.
 static base::AtomicSequenceNumber g_media_log_count;
 
+// Initializes |event| as a property change of |key|. Returns false if |key|
+// cannot be interned.
+static bool InitCompactPropertyEvent(const std::string& key,
+                                     CompactMediaLogEvent* event) {
+  event->key = CompactMediaLogEvent::InternKey(key);
+  if (event->key == CompactMediaLogEvent::kInvalidKey)
+    return false;
+  event->type = MediaLogEvent::PROPERTY_CHANGE;
+  event->time = base::TimeTicks::Now();
+  return true;
+}
+
 std::string MediaLog::MediaLogLevelToString(MediaLogLevel level) {
   switch (level) {
     case MEDIALOG_ERROR:
@@ -168,6 +181,11 @@ MediaLog::~MediaLog() {}
 
 void MediaLog::AddEvent(std::unique_ptr<MediaLogEvent> event) {}
 
+void MediaLog::AddEvents(std::vector<std::unique_ptr<MediaLogEvent>> events) {
+  for (auto& event : events)
+    AddEvent(std::move(event));
+}
+
 std::string MediaLog::GetErrorMessage() {
   return "";
 }
@@ -278,6 +296,15 @@ void MediaLog::AddLogEvent(MediaLogLevel level, const std::string& message) {
 
 void MediaLog::SetStringProperty(
     const std::string& key, const std::string& value) {
+  if (event_ring_) {
+    CompactMediaLogEvent compact_event;
+    if (InitCompactPropertyEvent(key, &compact_event) &&
+        compact_event.SetString(value)) {
+      event_ring_->Push(compact_event);
+      return;
+    }
+  }
+
   std::unique_ptr<MediaLogEvent> event(
       CreateEvent(MediaLogEvent::PROPERTY_CHANGE));
   event->params.SetString(key, value);
@@ -286,6 +313,15 @@ void MediaLog::SetStringProperty(
 
 void MediaLog::SetDoubleProperty(
     const std::string& key, double value) {
+  if (event_ring_) {
+    CompactMediaLogEvent compact_event;
+    if (InitCompactPropertyEvent(key, &compact_event)) {
+      compact_event.SetDouble(value);
+      event_ring_->Push(compact_event);
+      return;
+    }
+  }
+
   std::unique_ptr<MediaLogEvent> event(
       CreateEvent(MediaLogEvent::PROPERTY_CHANGE));
   event->params.SetDouble(key, value);
@@ -294,12 +330,48 @@ void MediaLog::SetDoubleProperty(
 
 void MediaLog::SetBooleanProperty(
     const std::string& key, bool value) {
+  if (event_ring_) {
+    CompactMediaLogEvent compact_event;
+    if (InitCompactPropertyEvent(key, &compact_event)) {
+      compact_event.SetBoolean(value);
+      event_ring_->Push(compact_event);
+      return;
+    }
+  }
+
   std::unique_ptr<MediaLogEvent> event(
       CreateEvent(MediaLogEvent::PROPERTY_CHANGE));
   event->params.SetBoolean(key, value);
   AddEvent(std::move(event));
 }
 
+void MediaLog::EnableEventRing(size_t capacity) {
+  DCHECK(!event_ring_);
+  event_ring_.reset(new MediaLogEventRing(capacity));
+}
+
+void MediaLog::FlushEventRing() {
+  if (!event_ring_)
+    return;
+
+  std::vector<std::unique_ptr<MediaLogEvent>> events;
+  CompactMediaLogEvent compact_event;
+  while (event_ring_->Pop(&compact_event))
+    events.push_back(compact_event.ToMediaLogEvent(id_));
+
+  const int64_t dropped_events = event_ring_->dropped_events();
+  if (dropped_events != reported_dropped_events_) {
+    reported_dropped_events_ = dropped_events;
+    std::unique_ptr<MediaLogEvent> event(
+        CreateEvent(MediaLogEvent::PROPERTY_CHANGE));
+    event->params.SetDouble("dropped_events", dropped_events);
+    events.push_back(std::move(event));
+  }
+
+  if (!events.empty())
+    AddEvents(std::move(events));
+}
+
 LogHelper::LogHelper(MediaLog::MediaLogLevel level, MediaLog* media_log)
     : level_(level), media_log_(media_log) {
   DCHECK(media_log_);
@@ -11,6 +11,7 @@
 #include <memory>
 #include <sstream>
 #include <string>
+#include <vector>
 
 #include "base/logging.h"
 #include "base/macros.h"
@@ -23,6 +24,8 @@
 
 namespace media {
 
+class MediaLogEventRing;
+
 class MEDIA_EXPORT MediaLog {
  public:
   enum MediaLogLevel {
@@ -57,6 +60,11 @@ class MEDIA_EXPORT MediaLog {
   // with it.
   virtual void AddEvent(std::unique_ptr<MediaLogEvent> event);
 
+  // Adds the events drained by FlushEventRing(), in order. The default
+  // implementation calls AddEvent() for each; inheritors which send events
+  // elsewhere can override it to send them all at once.
+  virtual void AddEvents(std::vector<std::unique_ptr<MediaLogEvent>> events);
+
   // Returns a string usable as the contents of a MediaError.message.
   // This method returns an incomplete message if it is called before the
   // pertinent events for the error have been added to the log.
@@ -101,6 +109,21 @@ class MEDIA_EXPORT MediaLog {
   void SetDoubleProperty(const std::string& key, double value);
   void SetBooleanProperty(const std::string& key, bool value);
 
+  // Makes the Set*Property() methods record into a ring of |capacity| compact
+  // events instead of allocating a MediaLogEvent for each call; see
+  // MediaLogEventRing. Properties that do not fit a compact event still go
+  // through AddEvent(). When the ring is full, properties are dropped, and the
+  // number dropped is reported by the next FlushEventRing() as the
+  // "dropped_events" property. Must be called before the MediaLog is shared
+  // between threads.
+  void EnableEventRing(size_t capacity);
+
+  // Passes the events recorded in the ring since the last call to
+  // AddEvents(). Events added through AddEvent() in the meantime are not
+  // delayed, so their order relative to the ring's events is only told by
+  // their |time|. Must only be called on one thread at a time.
+  void FlushEventRing();
+
   // Getter for |id_|. Used by MojoMediaLogService to construct MediaLogEvents
   // to log into this MediaLog. Also used in trace events to associate each
   // event with a specific media playback.
@@ -110,6 +133,11 @@ class MEDIA_EXPORT MediaLog {
   // A unique (to this process) id for this MediaLog.
   int32_t id_;
 
+  std::unique_ptr<MediaLogEventRing> event_ring_;
+
+  // The number of dropped events last reported by FlushEventRing().
+  int64_t reported_dropped_events_ = 0;
+
   DISALLOW_COPY_AND_ASSIGN(MediaLog);
 };
 
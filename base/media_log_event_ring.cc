@@ -0,0 +1,189 @@
+// Copyright 2017 The Chromium Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#include "media/base/media_log_event_ring.h"
+
+#include <string.h>
+
+#include <deque>
+#include <map>
+
+#include "base/logging.h"
+#include "base/synchronization/lock.h"
+
+namespace media {
+
+namespace {
+
+// Bounds the memory held by the key table; MediaLog keys are a small, fixed
+// set of literals.
+const size_t kMaxKeys = 1024;
+
+class KeyTable {
+ public:
+  KeyTable() {}
+
+  uint16_t Intern(const std::string& key) {
+    base::AutoLock auto_lock(lock_);
+    auto it = ids_.find(key);
+    if (it != ids_.end())
+      return it->second;
+    if (names_.size() == kMaxKeys)
+      return CompactMediaLogEvent::kInvalidKey;
+
+    const uint16_t id = static_cast<uint16_t>(names_.size());
+    names_.push_back(key);
+    ids_[key] = id;
+    return id;
+  }
+
+  const std::string& GetName(uint16_t id) {
+    base::AutoLock auto_lock(lock_);
+    DCHECK_LT(id, names_.size());
+    // std::deque does not move its elements when appended to.
+    return names_[id];
+  }
+
+ private:
+  base::Lock lock_;
+  std::map<std::string, uint16_t> ids_;
+  std::deque<std::string> names_;
+
+  DISALLOW_COPY_AND_ASSIGN(KeyTable);
+};
+
+KeyTable* GetKeyTable() {
+  static KeyTable* key_table = new KeyTable();
+  return key_table;
+}
+
+size_t RoundUpToPowerOfTwo(size_t value) {
+  size_t result = 1;
+  while (result < value)
+    result <<= 1;
+  return result;
+}
+
+}  // namespace
+
+// static
+const size_t CompactMediaLogEvent::kMaxStringLength;
+
+// static
+const uint16_t CompactMediaLogEvent::kInvalidKey;
+
+// static
+uint16_t CompactMediaLogEvent::InternKey(const std::string& key) {
+  return GetKeyTable()->Intern(key);
+}
+
+// static
+const std::string& CompactMediaLogEvent::GetKeyName(uint16_t id) {
+  return GetKeyTable()->GetName(id);
+}
+
+void CompactMediaLogEvent::SetBoolean(bool boolean) {
+  value_type = ValueType::kBoolean;
+  value.boolean = boolean;
+}
+
+void CompactMediaLogEvent::SetDouble(double number) {
+  value_type = ValueType::kDouble;
+  value.number = number;
+}
+
+bool CompactMediaLogEvent::SetString(const std::string& string) {
+  if (string.size() > kMaxStringLength)
+    return false;
+  value_type = ValueType::kString;
+  string_length = static_cast<uint8_t>(string.size());
+  memcpy(value.string, string.data(), string.size());
+  return true;
+}
+
+std::unique_ptr<MediaLogEvent> CompactMediaLogEvent::ToMediaLogEvent(
+    int32_t media_log_id) const {
+  std::unique_ptr<MediaLogEvent> event(new MediaLogEvent);
+  event->id = media_log_id;
+  event->type = type;
+  event->time = time;
+
+  const std::string& name = GetKeyName(key);
+  switch (value_type) {
+    case ValueType::kBoolean:
+      event->params.SetBoolean(name, value.boolean);
+      break;
+    case ValueType::kDouble:
+      event->params.SetDouble(name, value.number);
+      break;
+    case ValueType::kString:
+      event->params.SetString(name,
+                              std::string(value.string, string_length));
+      break;
+  }
+  return event;
+}
+
+MediaLogEventRing::MediaLogEventRing(size_t capacity)
+    : mask_(RoundUpToPowerOfTwo(capacity) - 1),
+      slots_(new Slot[mask_ + 1]),
+      push_position_(0),
+      dropped_events_(0),
+      pop_position_(0) {
+  DCHECK_GT(capacity, 0u);
+  for (size_t i = 0; i <= mask_; ++i)
+    base::subtle::NoBarrier_Store(&slots_[i].sequence, i);
+}
+
+MediaLogEventRing::~MediaLogEventRing() {}
+
+bool MediaLogEventRing::Push(const CompactMediaLogEvent& event) {
+  base::subtle::AtomicWord position =
+      base::subtle::NoBarrier_Load(&push_position_);
+  Slot* slot;
+  for (;;) {
+    slot = &slots_[position & mask_];
+    const base::subtle::AtomicWord sequence =
+        base::subtle::Acquire_Load(&slot->sequence);
+    if (sequence == position) {
+      // The slot is free; claim it unless another thread got there first.
+      const base::subtle::AtomicWord previous =
+          base::subtle::NoBarrier_CompareAndSwap(&push_position_, position,
+                                                 position + 1);
+      if (previous == position)
+        break;
+      position = previous;
+    } else if (sequence < position) {
+      // The slot still holds the event pushed one lap ago: the ring is full.
+      base::subtle::NoBarrier_AtomicIncrement(&dropped_events_, 1);
+      return false;
+    } else {
+      // Another thread has claimed the slot since |position| was loaded.
+      position = base::subtle::NoBarrier_Load(&push_position_);
+    }
+  }
+
+  slot->event = event;
+  base::subtle::Release_Store(&slot->sequence, position + 1);
+  return true;
+}
+
+bool MediaLogEventRing::Pop(CompactMediaLogEvent* event) {
+  Slot* slot = &slots_[pop_position_ & mask_];
+  const base::subtle::AtomicWord sequence =
+      base::subtle::Acquire_Load(&slot->sequence);
+  if (sequence != static_cast<base::subtle::AtomicWord>(pop_position_ + 1))
+    return false;
+
+  *event = slot->event;
+  base::subtle::Release_Store(&slot->sequence, pop_position_ + mask_ + 1);
+  ++pop_position_;
+  return true;
+}
+
+int64_t MediaLogEventRing::dropped_events() const {
+  return base::subtle::NoBarrier_Load(&dropped_events_);
+}
+
+}  // namespace media
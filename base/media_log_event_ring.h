@@ -0,0 +1,108 @@
+// Copyright 2017 The Chromium Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#ifndef MEDIA_BASE_MEDIA_LOG_EVENT_RING_H_
+#define MEDIA_BASE_MEDIA_LOG_EVENT_RING_H_
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include <memory>
+#include <string>
+
+#include "base/atomicops.h"
+#include "base/macros.h"
+#include "base/time/time.h"
+#include "media/base/media_export.h"
+#include "media/base/media_log_event.h"
+
+namespace media {
+
+// A MediaLog property change which, unlike MediaLogEvent, can be recorded
+// without allocating: the property name is interned into a process-wide table
+// and the value is stored inline. Strings longer than |kMaxStringLength| do
+// not fit.
+struct MEDIA_EXPORT CompactMediaLogEvent {
+  enum class ValueType : uint8_t {
+    kBoolean,
+    kDouble,
+    kString,
+  };
+
+  static const size_t kMaxStringLength = 39;
+
+  // Returned by InternKey() once the table is full.
+  static const uint16_t kInvalidKey = 0xffff;
+
+  // Returns the id of |key|, adding it to the table on first use. This takes
+  // a lock, but does not allocate once |key| is known.
+  static uint16_t InternKey(const std::string& key);
+
+  // Returns the name of the interned key |id|.
+  static const std::string& GetKeyName(uint16_t id);
+
+  void SetBoolean(bool boolean);
+  void SetDouble(double number);
+
+  // Returns false, leaving the event unchanged, if |string| is too long.
+  bool SetString(const std::string& string);
+
+  // Converts to a MediaLogEvent of the MediaLog |media_log_id|.
+  std::unique_ptr<MediaLogEvent> ToMediaLogEvent(int32_t media_log_id) const;
+
+  base::TimeTicks time;
+  MediaLogEvent::Type type;
+  uint16_t key;
+  ValueType value_type;
+  uint8_t string_length;
+  union {
+    bool boolean;
+    double number;
+    char string[kMaxStringLength];
+  } value;
+};
+
+// A bounded queue of CompactMediaLogEvents which any number of threads can
+// push to, and one thread pops from. It neither allocates nor takes a lock
+// after construction: when it is full, Push() drops the event and counts it.
+class MEDIA_EXPORT MediaLogEventRing {
+ public:
+  // |capacity| is rounded up to a power of two.
+  explicit MediaLogEventRing(size_t capacity);
+  ~MediaLogEventRing();
+
+  // Can be called on any thread. Returns false if |event| was dropped.
+  bool Push(const CompactMediaLogEvent& event);
+
+  // Must only be called on one thread at a time. Returns false if the ring is
+  // empty.
+  bool Pop(CompactMediaLogEvent* event);
+
+  size_t capacity() const { return mask_ + 1; }
+
+  // The number of events dropped by Push() so far.
+  int64_t dropped_events() const;
+
+ private:
+  // |sequence| tells the state of |event|: equal to the slot's position when
+  // the slot is free, one past it when |event| is ready to be popped.
+  struct Slot {
+    base::subtle::AtomicWord sequence;
+    CompactMediaLogEvent event;
+  };
+
+  const size_t mask_;
+  std::unique_ptr<Slot[]> slots_;
+  base::subtle::AtomicWord push_position_;
+  base::subtle::AtomicWord dropped_events_;
+
+  // Only accessed by the thread popping.
+  size_t pop_position_;
+
+  DISALLOW_COPY_AND_ASSIGN(MediaLogEventRing);
+};
+
+}  // namespace media
+
+#endif  // MEDIA_BASE_MEDIA_LOG_EVENT_RING_H_
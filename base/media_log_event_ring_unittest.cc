@@ -0,0 +1,217 @@
+// Copyright 2017 The Chromium Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#include "media/base/media_log_event_ring.h"
+
+#include <memory>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "base/macros.h"
+#include "base/memory/ptr_util.h"
+#include "base/threading/simple_thread.h"
+#include "media/base/media_log.h"
+#include "testing/gtest/include/gtest/gtest.h"
+
+namespace media {
+
+namespace {
+
+CompactMediaLogEvent CreateDoubleEvent(const std::string& key, double value) {
+  CompactMediaLogEvent event;
+  event.time = base::TimeTicks::Now();
+  event.type = MediaLogEvent::PROPERTY_CHANGE;
+  event.key = CompactMediaLogEvent::InternKey(key);
+  event.SetDouble(value);
+  return event;
+}
+
+// Records the events passed to AddEvent() and AddEvents().
+class RecordingMediaLog : public MediaLog {
+ public:
+  RecordingMediaLog() {}
+
+  void AddEvent(std::unique_ptr<MediaLogEvent> event) override {
+    events_.push_back(std::move(event));
+  }
+
+  void AddEvents(std::vector<std::unique_ptr<MediaLogEvent>> events) override {
+    ++batches_;
+    MediaLog::AddEvents(std::move(events));
+  }
+
+  const std::vector<std::unique_ptr<MediaLogEvent>>& events() const {
+    return events_;
+  }
+  int batches() const { return batches_; }
+
+ private:
+  std::vector<std::unique_ptr<MediaLogEvent>> events_;
+  int batches_ = 0;
+
+  DISALLOW_COPY_AND_ASSIGN(RecordingMediaLog);
+};
+
+// Pushes |count| events whose values are |first_value| onwards.
+class PushThread : public base::SimpleThread {
+ public:
+  PushThread(MediaLogEventRing* ring, int first_value, int count)
+      : base::SimpleThread("PushThread"),
+        ring_(ring),
+        first_value_(first_value),
+        count_(count) {}
+
+  void Run() override {
+    for (int i = 0; i < count_; ++i) {
+      while (!ring_->Push(CreateDoubleEvent("value", first_value_ + i))) {
+      }
+    }
+  }
+
+ private:
+  MediaLogEventRing* const ring_;
+  const int first_value_;
+  const int count_;
+
+  DISALLOW_COPY_AND_ASSIGN(PushThread);
+};
+
+}  // namespace
+
+TEST(MediaLogEventRingTest, InternKey) {
+  const uint16_t id = CompactMediaLogEvent::InternKey("interned_key");
+  EXPECT_NE(CompactMediaLogEvent::kInvalidKey, id);
+  EXPECT_EQ(id, CompactMediaLogEvent::InternKey("interned_key"));
+  EXPECT_NE(id, CompactMediaLogEvent::InternKey("other_key"));
+  EXPECT_EQ("interned_key", CompactMediaLogEvent::GetKeyName(id));
+}
+
+TEST(MediaLogEventRingTest, ToMediaLogEvent) {
+  CompactMediaLogEvent event = CreateDoubleEvent("key", 0);
+
+  event.SetBoolean(true);
+  bool boolean = false;
+  EXPECT_TRUE(event.ToMediaLogEvent(1)->params.GetBoolean("key", &boolean));
+  EXPECT_TRUE(boolean);
+
+  event.SetDouble(0.5);
+  std::unique_ptr<MediaLogEvent> media_log_event = event.ToMediaLogEvent(2);
+  EXPECT_EQ(2, media_log_event->id);
+  EXPECT_EQ(MediaLogEvent::PROPERTY_CHANGE, media_log_event->type);
+  EXPECT_EQ(event.time, media_log_event->time);
+  double number = 0;
+  EXPECT_TRUE(media_log_event->params.GetDouble("key", &number));
+  EXPECT_EQ(0.5, number);
+
+  const std::string kLongest(CompactMediaLogEvent::kMaxStringLength, 'a');
+  EXPECT_TRUE(event.SetString(kLongest));
+  std::string string;
+  EXPECT_TRUE(event.ToMediaLogEvent(1)->params.GetString("key", &string));
+  EXPECT_EQ(kLongest, string);
+
+  EXPECT_FALSE(event.SetString(kLongest + "a"));
+}
+
+TEST(MediaLogEventRingTest, PushAndPop) {
+  MediaLogEventRing ring(3);
+  EXPECT_EQ(4u, ring.capacity());
+
+  CompactMediaLogEvent event;
+  EXPECT_FALSE(ring.Pop(&event));
+
+  // Go around the ring a few times.
+  for (int i = 0; i < 10; ++i) {
+    EXPECT_TRUE(ring.Push(CreateDoubleEvent("value", i)));
+    ASSERT_TRUE(ring.Pop(&event));
+    EXPECT_EQ(i, event.value.number);
+  }
+  EXPECT_FALSE(ring.Pop(&event));
+  EXPECT_EQ(0, ring.dropped_events());
+}
+
+TEST(MediaLogEventRingTest, DropsWhenFull) {
+  MediaLogEventRing ring(4);
+  for (int i = 0; i < 6; ++i)
+    EXPECT_EQ(i < 4, ring.Push(CreateDoubleEvent("value", i)));
+  EXPECT_EQ(2, ring.dropped_events());
+
+  // The oldest events are kept.
+  CompactMediaLogEvent event;
+  for (int i = 0; i < 4; ++i) {
+    ASSERT_TRUE(ring.Pop(&event));
+    EXPECT_EQ(i, event.value.number);
+  }
+  EXPECT_FALSE(ring.Pop(&event));
+  EXPECT_TRUE(ring.Push(CreateDoubleEvent("value", 4)));
+}
+
+TEST(MediaLogEventRingTest, ConcurrentPush) {
+  const int kThreads = 4;
+  const int kEventsPerThread = 10000;
+  MediaLogEventRing ring(64);
+
+  std::vector<std::unique_ptr<PushThread>> threads;
+  for (int i = 0; i < kThreads; ++i) {
+    threads.push_back(base::MakeUnique<PushThread>(
+        &ring, i * kEventsPerThread, kEventsPerThread));
+    threads.back()->Start();
+  }
+
+  // Each thread's events must be popped in the order they were pushed.
+  std::vector<int> next_values(kThreads);
+  for (int i = 0; i < kThreads; ++i)
+    next_values[i] = i * kEventsPerThread;
+  int popped = 0;
+  CompactMediaLogEvent event;
+  while (popped < kThreads * kEventsPerThread) {
+    if (!ring.Pop(&event))
+      continue;
+    const int value = static_cast<int>(event.value.number);
+    const int thread = value / kEventsPerThread;
+    ASSERT_EQ(next_values[thread], value);
+    ++next_values[thread];
+    ++popped;
+  }
+
+  for (auto& thread : threads)
+    thread->Join();
+  EXPECT_FALSE(ring.Pop(&event));
+}
+
+TEST(MediaLogEventRingTest, MediaLogFlush) {
+  RecordingMediaLog media_log;
+  media_log.EnableEventRing(2);
+
+  media_log.SetBooleanProperty("boolean", true);
+  media_log.SetDoubleProperty("double", 1);
+  media_log.SetStringProperty("string", "value");
+  media_log.SetStringProperty(
+      "long_string",
+      std::string(CompactMediaLogEvent::kMaxStringLength + 1, 'a'));
+
+  // Only the string which does not fit a compact event is added right away.
+  ASSERT_EQ(1u, media_log.events().size());
+  EXPECT_TRUE(media_log.events()[0]->params.HasKey("long_string"));
+
+  media_log.FlushEventRing();
+  EXPECT_EQ(1, media_log.batches());
+  ASSERT_EQ(4u, media_log.events().size());
+  EXPECT_EQ(media_log.id(), media_log.events()[1]->id);
+  EXPECT_TRUE(media_log.events()[1]->params.HasKey("boolean"));
+  EXPECT_TRUE(media_log.events()[2]->params.HasKey("double"));
+
+  // The string property did not fit the ring.
+  double dropped_events = 0;
+  EXPECT_TRUE(
+      media_log.events()[3]->params.GetDouble("dropped_events",
+                                              &dropped_events));
+  EXPECT_EQ(1, dropped_events);
+
+  // Nothing is added when there is nothing new.
+  media_log.FlushEventRing();
+  EXPECT_EQ(1, media_log.batches());
+}
+
+}  // namespace media
@@ -0,0 +1,83 @@
+// Copyright 2017 The Chromium Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#include <memory>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "base/macros.h"
+#include "base/time/time.h"
+#include "media/base/media_log.h"
+#include "testing/gtest/include/gtest/gtest.h"
+#include "testing/perf/perf_test.h"
+
+namespace media {
+
+namespace {
+
+const int kEventsPerFlush = 100;
+const int kFlushes = 2000;
+
+// Counts the MediaLogEvents allocated for it, as a media player's MediaLog
+// would forward them.
+class CountingMediaLog : public MediaLog {
+ public:
+  CountingMediaLog() {}
+
+  void AddEvent(std::unique_ptr<MediaLogEvent> event) override {
+    ++allocated_events_;
+  }
+
+  int allocated_events() const { return allocated_events_; }
+
+ private:
+  int allocated_events_ = 0;
+
+  DISALLOW_COPY_AND_ASSIGN(CountingMediaLog);
+};
+
+// Sets the properties a video decoder might set for each frame, and reports
+// how many are set per second, and how many MediaLogEvents are allocated for
+// each: while they are being set, and in total, i.e. including the flushes.
+void RunPropertyBenchmark(const std::string& trace, bool use_event_ring) {
+  CountingMediaLog media_log;
+  if (use_event_ring)
+    media_log.EnableEventRing(kEventsPerFlush);
+
+  int allocated_events = 0;
+  const base::TimeTicks start = base::TimeTicks::Now();
+  for (int i = 0; i < kFlushes; ++i) {
+    const int allocated_before_set = media_log.allocated_events();
+    for (int j = 0; j < kEventsPerFlush; j += 4) {
+      media_log.SetDoubleProperty("frame_duration", j);
+      media_log.SetBooleanProperty("is_keyframe", j == 0);
+      media_log.SetStringProperty("pixel_format", "PIXEL_FORMAT_I420");
+      media_log.SetDoubleProperty("decode_time", i);
+    }
+    allocated_events += media_log.allocated_events() - allocated_before_set;
+    media_log.FlushEventRing();
+  }
+  const base::TimeDelta elapsed = base::TimeTicks::Now() - start;
+  const int total_allocated_events = media_log.allocated_events();
+
+  const int events = kFlushes * kEventsPerFlush;
+  perf_test::PrintResult("media_log", trace, "throughput",
+                         events / elapsed.InSecondsF(), "events/s", true);
+  perf_test::PrintResult("media_log", trace, "allocations",
+                         static_cast<double>(allocated_events) / events,
+                         "allocations/event", true);
+  perf_test::PrintResult("media_log", trace, "allocations_with_flush",
+                         static_cast<double>(total_allocated_events) / events,
+                         "allocations/event", true);
+}
+
+}  // namespace
+
+TEST(MediaLogPerfTest, SetProperties) {
+  RunPropertyBenchmark("_allocating", false);
+  RunPropertyBenchmark("_event_ring", true);
+}
+
+}  // namespace media
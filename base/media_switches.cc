@@ -103,6 +103,11 @@ const char kUseFakeDeviceForMediaStream[] = "use-fake-device-for-media-stream";
 // media/capture/video/file_video_capture_device.h for more details.
 const char kUseFileForFakeVideoCapture[] = "use-file-for-fake-video-capture";
 
+// Deliver the frames of the file given in --use-file-for-fake-video-capture as
+// fast as the capture pipeline takes them instead of at the file's frame rate,
+// for throughput testing.
+const char kUnthrottledFileVideoCapture[] = "unthrottled-file-video-capture";
+
 // Play a .wav file as the microphone. Note that for WebRTC calls we'll treat
 // the bits as if they came from the microphone, which means you should disable
 // audio processing (lest your audio file will play back distorted). The input
@@ -116,6 +121,16 @@ const char kUseFileForFakeAudioCapture[] = "use-file-for-fake-audio-capture";
 // accelerator hardware to be present.
 const char kUseFakeJpegDecodeAccelerator[] = "use-fake-jpeg-decode-accelerator";
 
+// Number of buffers to request from V4L2 capture drivers, between 2 and 32.
+// More buffers tolerate longer consumer holds at the cost of latency and
+// memory.
+const char kV4L2CaptureBufferCount[] = "v4l2-capture-buffer-count";
+
+// Number of spare client buffers, beyond those lent to the driver, that the
+// buffer pool must have for V4L2 capture to write into client buffers, between
+// 1 and 32. Each spare lets consumers hold one more frame without drops.
+const char kV4L2ClientBufferHeadroom[] = "v4l2-client-buffer-headroom";
+
 // Enables support for inband text tracks in media content.
 const char kEnableInbandTextTracks[] = "enable-inband-text-tracks";
 
@@ -223,15 +238,31 @@ const base::Feature kBackgroundVideoTrackOptimization{
 const base::Feature kBackgroundVideoPauseOptimization{
     "BackgroundVideoPauseOptimization", base::FEATURE_ENABLED_BY_DEFAULT};
 
+// Let the cast VP8 encoder skip the macroblocks outside of the capture update
+// rect of each frame.
+const base::Feature kCastVp8ActiveMap{"CastVp8ActiveMap",
+                                      base::FEATURE_DISABLED_BY_DEFAULT};
+
 const base::Feature kComplexityBasedVideoBuffering{
     "ComplexityBasedVideoBuffering", base::FEATURE_DISABLED_BY_DEFAULT};
 
+// Let DecryptingDemuxerStream read and decrypt a few buffers ahead of the
+// decoder, so that decryption is off the critical path of decoder reads.
+const base::Feature kDecryptAhead{"DecryptAhead",
+                                  base::FEATURE_DISABLED_BY_DEFAULT};
+
 // Make MSE garbage collection algorithm more aggressive when we are under
 // moderate or critical memory pressure. This will relieve memory pressure by
 // releasing stale data from MSE buffers.
 const base::Feature kMemoryPressureBasedSourceBufferGC{
     "MemoryPressureBasedSourceBufferGC", base::FEATURE_DISABLED_BY_DEFAULT};
 
+// Let screen capture auto-throttling predict the utilization of each capture
+// size and frame rate from recent history, and adapt within a few frames,
+// instead of stepping one size at a time with long hysteresis.
+const base::Feature kModelBasedCaptureThrottling{
+    "ModelBasedCaptureThrottling", base::FEATURE_DISABLED_BY_DEFAULT};
+
 // On systems where pepper CDMs are enabled, use mojo CDM instead of PPAPI CDM.
 // Note that mojo CDM support is still under development. Some features are
 // still missing and this feature should only be enabled for testing.
@@ -261,6 +292,12 @@ const base::Feature kUseNewMediaCache{"use-new-media-cache",
 const base::Feature kUseR16Texture{"use-r16-texture",
                                    base::FEATURE_DISABLED_BY_DEFAULT};
 
+// Let V4L2 capture drivers producing I420 write directly into the capture
+// buffer pool's shared memory (V4L2_MEMORY_USERPTR) instead of copying every
+// frame out of driver-owned MMAP buffers.
+const base::Feature kV4L2CaptureIntoClientBuffers{
+    "V4L2CaptureIntoClientBuffers", base::FEATURE_DISABLED_BY_DEFAULT};
+
 // Enables the Unified Autoplay policy by overriding the platform's default
 // autoplay policy.
 const base::Feature kUnifiedAutoplay{"UnifiedAutoplay",
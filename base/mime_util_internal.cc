@@ -4,6 +4,9 @@
 
 #include "media/base/mime_util_internal.h"
 
+#include <algorithm>
+#include <iterator>
+
 #include "base/command_line.h"
 #include "base/strings/string_number_conversions.h"
 #include "base/strings/string_split.h"
@@ -28,57 +31,223 @@
 namespace media {
 namespace internal {
 
-// Wrapped to avoid static initializer startup cost.
-const base::flat_map<std::string, MimeUtil::Codec>& GetStringToCodecMap() {
-  static const base::flat_map<std::string, MimeUtil::Codec> kStringToCodecMap(
-      {
-        // We only allow this for WAV so it isn't ambiguous.
-        {"1", MimeUtil::PCM},
-        // avc1/avc3.XXXXXX may be unambiguous; handled by
-        // ParseAVCCodecId(). hev1/hvc1.XXXXXX may be unambiguous; handled
-        // by ParseHEVCCodecID(). vp9, vp9.0, vp09.xx.xx.xx.xx.xx.xx.xx may
-        // be unambiguous; handled by ParseVp9CodecID().
-        {"mp3", MimeUtil::MP3},
-        // Following is the list of RFC 6381 compliant audio codec strings:
-        //   mp4a.66     - MPEG-2 AAC MAIN
-        //   mp4a.67     - MPEG-2 AAC LC
-        //   mp4a.68     - MPEG-2 AAC SSR
-        //   mp4a.69     - MPEG-2 extension to MPEG-1 (MP3)
-        //   mp4a.6B     - MPEG-1 audio (MP3)
-        //   mp4a.40.2   - MPEG-4 AAC LC
-        //   mp4a.40.02  - MPEG-4 AAC LC (leading 0 in aud-oti for
-        //   compatibility) mp4a.40.5   - MPEG-4 HE-AAC v1 (AAC LC + SBR)
-        //   mp4a.40.05  - MPEG-4 HE-AAC v1 (AAC LC + SBR) (leading 0 in
-        //   aud-oti
-        //                 for compatibility)
-        //   mp4a.40.29  - MPEG-4 HE-AAC v2 (AAC LC + SBR + PS)
-        {"mp4a.66", MimeUtil::MPEG2_AAC}, {"mp4a.67", MimeUtil::MPEG2_AAC},
-        {"mp4a.68", MimeUtil::MPEG2_AAC}, {"mp4a.69", MimeUtil::MP3},
-        {"mp4a.6B", MimeUtil::MP3}, {"mp4a.40.2", MimeUtil::MPEG4_AAC},
-        {"mp4a.40.02", MimeUtil::MPEG4_AAC},
-        {"mp4a.40.5", MimeUtil::MPEG4_AAC},
-        {"mp4a.40.05", MimeUtil::MPEG4_AAC},
-        {"mp4a.40.29", MimeUtil::MPEG4_AAC},
+namespace {
+
+constexpr uint32_t CodecMask(MimeUtil::Codec codec) {
+  return 1u << codec;
+}
+
+struct CodecIdInfo {
+  const char* codec_id;
+  MimeUtil::Codec codec;
+};
+
+// Codec IDs which map to a codec without further parsing, sorted by
+// |codec_id| for binary search. avc1/avc3.XXXXXX may be unambiguous; handled
+// by ParseAVCCodecId(). hev1/hvc1.XXXXXX may be unambiguous; handled by
+// ParseHEVCCodecID(). vp9, vp9.0, vp09.xx.xx.xx.xx.xx.xx.xx may be
+// unambiguous; handled by ParseVp9CodecID().
+//
+// Following is the list of RFC 6381 compliant audio codec strings:
+//   mp4a.66     - MPEG-2 AAC MAIN
+//   mp4a.67     - MPEG-2 AAC LC
+//   mp4a.68     - MPEG-2 AAC SSR
+//   mp4a.69     - MPEG-2 extension to MPEG-1 (MP3)
+//   mp4a.6B     - MPEG-1 audio (MP3)
+//   mp4a.40.2   - MPEG-4 AAC LC
+//   mp4a.40.02  - MPEG-4 AAC LC (leading 0 in aud-oti for compatibility)
+//   mp4a.40.5   - MPEG-4 HE-AAC v1 (AAC LC + SBR)
+//   mp4a.40.05  - MPEG-4 HE-AAC v1 (AAC LC + SBR) (leading 0 in aud-oti for
+//                 compatibility)
+//   mp4a.40.29  - MPEG-4 HE-AAC v2 (AAC LC + SBR + PS)
+//
+// TODO(servolk): Strictly speaking only mp4a.A5 and mp4a.A6 codec ids are
+// valid according to RFC 6381 section 3.3, 3.4. Lower-case oti (mp4a.a5 and
+// mp4a.a6) should be rejected. But we used to allow those in older versions of
+// Chromecast firmware and some apps (notably MPL) depend on those codec types
+// being supported, so they should be allowed for now (crbug.com/564960).
+constexpr CodecIdInfo kCodecIds[] = {
+    // We only allow this for WAV so it isn't ambiguous.
+    {"1", MimeUtil::PCM},
+#if BUILDFLAG(ENABLE_AC3_EAC3_AUDIO_DEMUXING)
+    {"ac-3", MimeUtil::AC3},
+    {"ec-3", MimeUtil::EAC3},
+#endif
+    {"flac", MimeUtil::FLAC},
+    {"mp3", MimeUtil::MP3},
+    {"mp4a.40.02", MimeUtil::MPEG4_AAC},
+    {"mp4a.40.05", MimeUtil::MPEG4_AAC},
+    {"mp4a.40.2", MimeUtil::MPEG4_AAC},
+    {"mp4a.40.29", MimeUtil::MPEG4_AAC},
+    {"mp4a.40.5", MimeUtil::MPEG4_AAC},
+    {"mp4a.66", MimeUtil::MPEG2_AAC},
+    {"mp4a.67", MimeUtil::MPEG2_AAC},
+    {"mp4a.68", MimeUtil::MPEG2_AAC},
+    {"mp4a.69", MimeUtil::MP3},
+    {"mp4a.6B", MimeUtil::MP3},
+#if BUILDFLAG(ENABLE_AC3_EAC3_AUDIO_DEMUXING)
+    {"mp4a.A5", MimeUtil::AC3},
+    {"mp4a.A6", MimeUtil::EAC3},
+    {"mp4a.a5", MimeUtil::AC3},
+    {"mp4a.a6", MimeUtil::EAC3},
+#endif
+    {"opus", MimeUtil::OPUS},
+    {"theora", MimeUtil::THEORA},
+    {"vorbis", MimeUtil::VORBIS},
+    {"vp8", MimeUtil::VP8},
+    {"vp8.0", MimeUtil::VP8},
+};
+
+constexpr uint32_t kWavCodecs = CodecMask(MimeUtil::PCM);
+constexpr uint32_t kOggAudioCodecs = CodecMask(MimeUtil::FLAC) |
+                                     CodecMask(MimeUtil::OPUS) |
+                                     CodecMask(MimeUtil::VORBIS);
+#if !defined(OS_ANDROID)
+constexpr uint32_t kOggVideoCodecs = CodecMask(MimeUtil::THEORA);
+#else
+constexpr uint32_t kOggVideoCodecs = 0;
+#endif  // !defined(OS_ANDROID)
+constexpr uint32_t kOggCodecs = kOggAudioCodecs | kOggVideoCodecs;
+constexpr uint32_t kWebmAudioCodecs =
+    CodecMask(MimeUtil::OPUS) | CodecMask(MimeUtil::VORBIS);
+constexpr uint32_t kWebmVideoCodecs =
+    CodecMask(MimeUtil::VP8) | CodecMask(MimeUtil::VP9);
+constexpr uint32_t kWebmCodecs = kWebmAudioCodecs | kWebmVideoCodecs;
+constexpr uint32_t kImplicitCodec = 0;
+
+#if BUILDFLAG(USE_PROPRIETARY_CODECS)
+constexpr uint32_t kMp3Codecs = CodecMask(MimeUtil::MP3);
+constexpr uint32_t kAacCodecs =
+    CodecMask(MimeUtil::MPEG2_AAC) | CodecMask(MimeUtil::MPEG4_AAC);
+constexpr uint32_t kAvcAndAacCodecs = kAacCodecs | CodecMask(MimeUtil::H264);
+constexpr uint32_t kMp4AudioCodecs =
+    kAacCodecs | CodecMask(MimeUtil::MP3) | CodecMask(MimeUtil::FLAC)
 #if BUILDFLAG(ENABLE_AC3_EAC3_AUDIO_DEMUXING)
-        // TODO(servolk): Strictly speaking only mp4a.A5 and mp4a.A6 codec
-        // ids are valid according to RFC 6381 section 3.3, 3.4. Lower-case
-        // oti (mp4a.a5 and mp4a.a6) should be rejected. But we used to
-        // allow those in older versions of Chromecast firmware and some
-        // apps (notably MPL) depend on those codec types being supported,
-        // so they should be allowed for now (crbug.com/564960).
-        {"ac-3", MimeUtil::AC3}, {"mp4a.a5", MimeUtil::AC3},
-        {"mp4a.A5", MimeUtil::AC3}, {"ec-3", MimeUtil::EAC3},
-        {"mp4a.a6", MimeUtil::EAC3}, {"mp4a.A6", MimeUtil::EAC3},
+    | CodecMask(MimeUtil::AC3) | CodecMask(MimeUtil::EAC3)
+#endif  // BUILDFLAG(ENABLE_AC3_EAC3_AUDIO_DEMUXING)
+    ;
+// Only VP9 with valid codec string vp09.xx.xx.xx.xx.xx.xx.xx is supported.
+// See ParseVp9CodecID for details.
+constexpr uint32_t kMp4VideoCodecs =
+    CodecMask(MimeUtil::H264) | CodecMask(MimeUtil::VP9)
+#if BUILDFLAG(ENABLE_HEVC_DEMUXING)
+    | CodecMask(MimeUtil::HEVC)
+#endif  // BUILDFLAG(ENABLE_HEVC_DEMUXING)
+#if BUILDFLAG(ENABLE_DOLBY_VISION_DEMUXING)
+    | CodecMask(MimeUtil::DOLBY_VISION)
+#endif  // BUILDFLAG(ENABLE_DOLBY_VISION_DEMUXING)
+    ;
+constexpr uint32_t kMp4Codecs = kMp4AudioCodecs | kMp4VideoCodecs;
+#if defined(OS_ANDROID)
+// HTTP Live Streaming (HLS).
+// TODO(ddorwin): Is any MP3 codec string variant included in real queries?
+// Android HLS only supports MPEG4_AAC (missing demuxer support for MPEG2_AAC).
+constexpr uint32_t kHlsCodecs = CodecMask(MimeUtil::H264) |
+                                CodecMask(MimeUtil::MP3) |
+                                CodecMask(MimeUtil::MPEG4_AAC);
+#endif  // defined(OS_ANDROID)
+#endif  // BUILDFLAG(USE_PROPRIETARY_CODECS)
+
+struct ContainerInfo {
+  const char* mime_type;
+  uint32_t codecs;
+  bool is_proprietary;
+};
+
+// Each entry contains a media type (https://en.wikipedia.org/wiki/Media_type)
+// and the media codec(s) supported by this type/container, sorted by
+// |mime_type| for binary search.
+constexpr ContainerInfo kContainers[] = {
+    // TODO(ddorwin): Should the application type support Opus?
+    {"application/ogg", kOggCodecs, false},
+#if BUILDFLAG(USE_PROPRIETARY_CODECS) && defined(OS_ANDROID)
+    {"application/vnd.apple.mpegurl", kHlsCodecs, true},
+    {"application/x-mpegurl", kHlsCodecs, true},
+#endif
+#if BUILDFLAG(USE_PROPRIETARY_CODECS)
+    {"audio/aac", kImplicitCodec, true},  // AAC / ADTS.
 #endif
-        {"vorbis", MimeUtil::VORBIS}, {"opus", MimeUtil::OPUS},
-        {"flac", MimeUtil::FLAC}, {"vp8", MimeUtil::VP8},
-        {"vp8.0", MimeUtil::VP8}, {"theora", MimeUtil::THEORA},
-      },
-      base::KEEP_FIRST_OF_DUPES);
+    {"audio/flac", kImplicitCodec, false},
+#if BUILDFLAG(USE_PROPRIETARY_CODECS)
+    {"audio/mp3", kImplicitCodec, true},
+    {"audio/mp4", kMp4AudioCodecs, true},
+    {"audio/mpeg", kMp3Codecs, true},  // Allow "mp3".
+#endif
+#if BUILDFLAG(USE_PROPRIETARY_CODECS) && defined(OS_ANDROID)
+    {"audio/mpegurl", kHlsCodecs, true},
+#endif
+    {"audio/ogg", kOggAudioCodecs, false},
+    {"audio/wav", kWavCodecs, false},
+    {"audio/webm", kWebmAudioCodecs, false},
+#if BUILDFLAG(USE_PROPRIETARY_CODECS)
+    // These strings are supported for backwards compatibility only and thus
+    // only support the codecs needed for compatibility.
+    {"audio/x-m4a", kAacCodecs, true},
+    {"audio/x-mp3", kImplicitCodec, true},
+#endif
+#if BUILDFLAG(USE_PROPRIETARY_CODECS) && defined(OS_ANDROID)
+    // Not documented by Apple, but unfortunately used extensively by Apple and
+    // others for both audio-only and audio+video playlists. See
+    // https://crbug.com/675552 for details and examples.
+    {"audio/x-mpegurl", kHlsCodecs, true},
+#endif
+    {"audio/x-wav", kWavCodecs, false},
+#if BUILDFLAG(USE_PROPRIETARY_CODECS) && \
+    BUILDFLAG(ENABLE_MSE_MPEG2TS_STREAM_PARSER)
+    // TODO(ddorwin): Exactly which codecs should be supported?
+    {"video/mp2t", kMp4Codecs, true},
+#endif
+#if BUILDFLAG(USE_PROPRIETARY_CODECS)
+    {"video/mp4", kMp4Codecs, true},
+#endif
+    // video/ogg is only supported if an appropriate video codec is supported.
+#if !defined(OS_ANDROID)
+    {"video/ogg", kOggCodecs, false},
+#endif
+    {"video/webm", kWebmCodecs, false},
+#if BUILDFLAG(USE_PROPRIETARY_CODECS)
+    {"video/x-m4v", kAvcAndAacCodecs, true},
+#endif
+};
+
+static_assert(MimeUtil::LAST_CODEC < 32, "Codecs must fit a uint32_t mask");
+
+template <typename T>
+bool IsSortedByKey(const T* begin, const T* end, const char* T::*key) {
+  for (const T* it = begin; it + 1 < end; ++it) {
+    if (base::StringPiece(it->*key) >= base::StringPiece((it + 1)->*key))
+      return false;
+  }
+  return true;
+}
+
+// Returns the entry of the sorted table [|begin|, |end|) whose |key| is
+// |value|, or null.
+template <typename T>
+const T* FindByKey(const T* begin,
+                   const T* end,
+                   const char* T::*key,
+                   base::StringPiece value) {
+  const T* it = std::lower_bound(
+      begin, end, value, [key](const T& entry, base::StringPiece target) {
+        return base::StringPiece(entry.*key) < target;
+      });
+  if (it == end || base::StringPiece(it->*key) != value)
+    return nullptr;
+  return it;
+}
 
-  return kStringToCodecMap;
+const CodecIdInfo* FindCodecId(base::StringPiece codec_id) {
+  return FindByKey(std::begin(kCodecIds), std::end(kCodecIds),
+                   &CodecIdInfo::codec_id, codec_id);
 }
 
+// The number of mime type and codec ID pairs whose parse results are cached.
+// Pages probing for adaptive streaming support ask about a few dozen.
+const size_t kParsedCodecCacheSize = 128;
+
+}  // namespace
+
 static bool ParseVp9CodecID(const std::string& mime_type_lower_case,
                             const std::string& codec_id,
                             VideoCodecProfile* out_profile,
@@ -110,7 +279,14 @@ static bool IsValidH264Level(uint8_t level_idc) {
           (level_idc >= 50 && level_idc <= 51));
 }
 
-MimeUtil::MimeUtil() : allow_proprietary_codecs_(false) {
+MimeUtil::MimeUtil()
+    : allow_proprietary_codecs_(false),
+      parsed_codec_cache_(kParsedCodecCacheSize) {
+  DCHECK(IsSortedByKey(std::begin(kCodecIds), std::end(kCodecIds),
+                       &CodecIdInfo::codec_id));
+  DCHECK(IsSortedByKey(std::begin(kContainers), std::end(kContainers),
+                       &ContainerInfo::mime_type));
+
 #if defined(OS_ANDROID)
   // When the unified media pipeline is enabled, we need support for both GPU
   // video decoders and MediaCodec; indicated by HasPlatformDecoderSupport().
@@ -123,7 +299,9 @@ MimeUtil::MimeUtil() : allow_proprietary_codecs_(false) {
   platform_info_.supports_opus = PlatformHasOpusSupport();
 #endif
 
-  InitializeMimeTypeMaps();
+#if BUILDFLAG(USE_PROPRIETARY_CODECS)
+  allow_proprietary_codecs_ = true;
+#endif
 }
 
 MimeUtil::~MimeUtil() {}
@@ -237,134 +415,18 @@ SupportsType MimeUtil::AreSupportedCodecs(
   return combined_result;
 }
 
-void MimeUtil::InitializeMimeTypeMaps() {
-#if BUILDFLAG(USE_PROPRIETARY_CODECS)
-  allow_proprietary_codecs_ = true;
-#endif
-
-  AddSupportedMediaFormats();
-}
-
-// Each call to AddContainerWithCodecs() contains a media type
-// (https://en.wikipedia.org/wiki/Media_type) and corresponding media codec(s)
-// supported by these types/containers.
-void MimeUtil::AddSupportedMediaFormats() {
-  const CodecSet wav_codecs{PCM};
-  const CodecSet ogg_audio_codecs{FLAC, OPUS, VORBIS};
-
-#if !defined(OS_ANDROID)
-  CodecSet ogg_video_codecs{THEORA};
-#else
-  CodecSet ogg_video_codecs;
-#endif  // !defined(OS_ANDROID)
-
-  CodecSet ogg_codecs(ogg_audio_codecs);
-  ogg_codecs.insert(ogg_video_codecs.begin(), ogg_video_codecs.end());
-
-  const CodecSet webm_audio_codecs{OPUS, VORBIS};
-  const CodecSet webm_video_codecs{VP8, VP9};
-  CodecSet webm_codecs(webm_audio_codecs);
-  webm_codecs.insert(webm_video_codecs.begin(), webm_video_codecs.end());
-
-#if BUILDFLAG(USE_PROPRIETARY_CODECS)
-  const CodecSet mp3_codecs{MP3};
-  const CodecSet aac{MPEG2_AAC, MPEG4_AAC};
-
-  CodecSet avc_and_aac(aac);
-  avc_and_aac.emplace(H264);
-
-  CodecSet mp4_audio_codecs(aac);
-  mp4_audio_codecs.emplace(MP3);
-  mp4_audio_codecs.emplace(FLAC);
-#if BUILDFLAG(ENABLE_AC3_EAC3_AUDIO_DEMUXING)
-  mp4_audio_codecs.emplace(AC3);
-  mp4_audio_codecs.emplace(EAC3);
-#endif  // BUILDFLAG(ENABLE_AC3_EAC3_AUDIO_DEMUXING)
-
-  CodecSet mp4_video_codecs;
-  mp4_video_codecs.emplace(H264);
-#if BUILDFLAG(ENABLE_HEVC_DEMUXING)
-  mp4_video_codecs.emplace(HEVC);
-#endif  // BUILDFLAG(ENABLE_HEVC_DEMUXING)
-  // Only VP9 with valid codec string vp09.xx.xx.xx.xx.xx.xx.xx is supported.
-  // See ParseVp9CodecID for details.
-  mp4_video_codecs.emplace(VP9);
-#if BUILDFLAG(ENABLE_DOLBY_VISION_DEMUXING)
-  mp4_video_codecs.emplace(DOLBY_VISION);
-#endif  // BUILDFLAG(ENABLE_DOLBY_VISION_DEMUXING)
-  CodecSet mp4_codecs(mp4_audio_codecs);
-  mp4_codecs.insert(mp4_video_codecs.begin(), mp4_video_codecs.end());
-#endif  // BUILDFLAG(USE_PROPRIETARY_CODECS)
-
-  const CodecSet implicit_codec;
-  AddContainerWithCodecs("audio/wav", wav_codecs, false);
-  AddContainerWithCodecs("audio/x-wav", wav_codecs, false);
-  AddContainerWithCodecs("audio/webm", webm_audio_codecs, false);
-  DCHECK(!webm_video_codecs.empty());
-  AddContainerWithCodecs("video/webm", webm_codecs, false);
-  AddContainerWithCodecs("audio/ogg", ogg_audio_codecs, false);
-  // video/ogg is only supported if an appropriate video codec is supported.
-  // Note: This assumes such codecs cannot be later excluded.
-  if (!ogg_video_codecs.empty())
-    AddContainerWithCodecs("video/ogg", ogg_codecs, false);
-  // TODO(ddorwin): Should the application type support Opus?
-  AddContainerWithCodecs("application/ogg", ogg_codecs, false);
-  AddContainerWithCodecs("audio/flac", implicit_codec, false);
-
-#if BUILDFLAG(USE_PROPRIETARY_CODECS)
-  AddContainerWithCodecs("audio/mpeg", mp3_codecs, true);  // Allow "mp3".
-  AddContainerWithCodecs("audio/mp3", implicit_codec, true);
-  AddContainerWithCodecs("audio/x-mp3", implicit_codec, true);
-  AddContainerWithCodecs("audio/aac", implicit_codec, true);  // AAC / ADTS.
-  AddContainerWithCodecs("audio/mp4", mp4_audio_codecs, true);
-  DCHECK(!mp4_video_codecs.empty());
-  AddContainerWithCodecs("video/mp4", mp4_codecs, true);
-  // These strings are supported for backwards compatibility only and thus only
-  // support the codecs needed for compatibility.
-  AddContainerWithCodecs("audio/x-m4a", aac, true);
-  AddContainerWithCodecs("video/x-m4v", avc_and_aac, true);
-
-#if BUILDFLAG(ENABLE_MSE_MPEG2TS_STREAM_PARSER)
-  // TODO(ddorwin): Exactly which codecs should be supported?
-  DCHECK(!mp4_video_codecs.empty());
-  AddContainerWithCodecs("video/mp2t", mp4_codecs, true);
-#endif  // BUILDFLAG(ENABLE_MSE_MPEG2TS_STREAM_PARSER)
-#if defined(OS_ANDROID)
-  // HTTP Live Streaming (HLS).
-  CodecSet hls_codecs{H264,
-                      // TODO(ddorwin): Is any MP3 codec string variant included
-                      // in real queries?
-                      MP3,
-                      // Android HLS only supports MPEG4_AAC (missing demuxer
-                      // support for MPEG2_AAC)
-                      MPEG4_AAC};
-  AddContainerWithCodecs("application/x-mpegurl", hls_codecs, true);
-  AddContainerWithCodecs("application/vnd.apple.mpegurl", hls_codecs, true);
-  AddContainerWithCodecs("audio/mpegurl", hls_codecs, true);
-  // Not documented by Apple, but unfortunately used extensively by Apple and
-  // others for both audio-only and audio+video playlists. See
-  // https://crbug.com/675552 for details and examples.
-  AddContainerWithCodecs("audio/x-mpegurl", hls_codecs, true);
-#endif  // defined(OS_ANDROID)
-#endif  // BUILDFLAG(USE_PROPRIETARY_CODECS)
-}
-
-void MimeUtil::AddContainerWithCodecs(const std::string& mime_type,
-                                      const CodecSet& codecs,
-                                      bool is_proprietary_mime_type) {
-#if !BUILDFLAG(USE_PROPRIETARY_CODECS)
-  DCHECK(!is_proprietary_mime_type);
-#endif
-
-  media_format_map_[mime_type] = codecs;
-
-  if (is_proprietary_mime_type)
-    proprietary_media_containers_.push_back(mime_type);
+const uint32_t* MimeUtil::FindContainerCodecs(
+    base::StringPiece mime_type_lower_case) const {
+  const ContainerInfo* container =
+      FindByKey(std::begin(kContainers), std::end(kContainers),
+                &ContainerInfo::mime_type, mime_type_lower_case);
+  if (!container || (container->is_proprietary && !allow_proprietary_codecs_))
+    return nullptr;
+  return &container->codecs;
 }
 
 bool MimeUtil::IsSupportedMediaMimeType(const std::string& mime_type) const {
-  return media_format_map_.find(base::ToLowerASCII(mime_type)) !=
-         media_format_map_.end();
+  return FindContainerCodecs(base::ToLowerASCII(mime_type)) != nullptr;
 }
 
 void MimeUtil::SplitCodecsToVector(const std::string& codecs,
@@ -496,8 +558,6 @@ SupportsType MimeUtil::IsSupportedMediaFormat(
 }
 
 void MimeUtil::RemoveProprietaryMediaTypesAndCodecs() {
-  for (const auto& container : proprietary_media_containers_)
-    media_format_map_.erase(container);
   allow_proprietary_codecs_ = false;
 }
 
@@ -655,15 +715,13 @@ bool MimeUtil::ParseCodecStrings(
   DCHECK(out_results);
 
   // Reject unrecognized mime types.
-  MediaFormatMappings::const_iterator it_media_format_map =
-      media_format_map_.find(mime_type_lower_case);
-  if (it_media_format_map == media_format_map_.end()) {
+  const uint32_t* valid_codecs = FindContainerCodecs(mime_type_lower_case);
+  if (!valid_codecs) {
     DVLOG(3) << __func__ << " Unrecognized mime type: " << mime_type_lower_case;
     return false;
   }
 
-  const CodecSet& valid_codecs = it_media_format_map->second;
-  if (valid_codecs.empty()) {
+  if (*valid_codecs == 0) {
     // We get here if the mimetype does not expect a codecs parameter.
     if (!codecs.empty()) {
       DVLOG(3) << __func__
@@ -703,7 +761,7 @@ bool MimeUtil::ParseCodecStrings(
       codec_string = TranslateLegacyAvc1CodecIds(codec_string);
 #endif
 
-    if (!ParseCodecHelper(mime_type_lower_case, codec_string, &result)) {
+    if (!ParseCodecCached(mime_type_lower_case, codec_string, &result)) {
       DVLOG(3) << __func__
                << " Failed to parse mime/codec pair: " << mime_type_lower_case
                << "; " << codec_string;
@@ -712,7 +770,7 @@ bool MimeUtil::ParseCodecStrings(
     DCHECK_NE(INVALID_CODEC, result.codec);
 
     // Fail if mime + codec is not a valid combination.
-    if (valid_codecs.find(result.codec) == valid_codecs.end()) {
+    if (!(*valid_codecs & CodecMask(result.codec))) {
       DVLOG(3) << __func__
                << " Incompatible mime/codec pair: " << mime_type_lower_case
                << "; " << codec_string;
@@ -725,6 +783,33 @@ bool MimeUtil::ParseCodecStrings(
   return true;
 }
 
+bool MimeUtil::ParseCodecCached(const std::string& mime_type_lower_case,
+                                const std::string& codec_id,
+                                ParsedCodecResult* out_result) const {
+  // |mime_type_lower_case| is a supported container, so has no space.
+  std::string key;
+  key.reserve(mime_type_lower_case.size() + 1 + codec_id.size());
+  key.append(mime_type_lower_case).append(1, ' ').append(codec_id);
+
+  {
+    base::AutoLock auto_lock(parsed_codec_cache_lock_);
+    auto it = parsed_codec_cache_.Get(key);
+    if (it != parsed_codec_cache_.end()) {
+      *out_result = it->second.result;
+      return it->second.success;
+    }
+  }
+
+  CachedParsedCodec parsed;
+  parsed.success = ParseCodecHelper(mime_type_lower_case, codec_id,
+                                    &parsed.result);
+  *out_result = parsed.result;
+
+  base::AutoLock auto_lock(parsed_codec_cache_lock_);
+  parsed_codec_cache_.Put(key, parsed);
+  return parsed.success;
+}
+
 bool MimeUtil::ParseCodecHelper(const std::string& mime_type_lower_case,
                                 const std::string& codec_id,
                                 ParsedCodecResult* out_result) const {
@@ -733,11 +818,10 @@ bool MimeUtil::ParseCodecHelper(const std::string& mime_type_lower_case,
 
   *out_result = MakeDefaultParsedCodecResult();
 
-  // Simple codecs can be found in the codec map.
-  base::flat_map<std::string, Codec>::const_iterator itr =
-      GetStringToCodecMap().find(codec_id);
-  if (itr != GetStringToCodecMap().end()) {
-    out_result->codec = itr->second;
+  // Simple codecs can be found in the codec table.
+  const CodecIdInfo* codec_id_info = FindCodecId(codec_id);
+  if (codec_id_info) {
+    out_result->codec = codec_id_info->codec;
 
     // Even "simple" video codecs should have an associated profile.
     if (MimeUtilToVideoCodec(out_result->codec) != kUnknownVideoCodec) {
@@ -770,10 +854,9 @@ bool MimeUtil::ParseCodecHelper(const std::string& mime_type_lower_case,
     return true;
   }
 
-  // If |codec_id| is not in |kStringToCodecMap|, then we assume that it is
-  // either VP9, H.264 or HEVC/H.265 codec ID because currently those are the
-  // only ones that are not added to the |kStringToCodecMap| and require
-  // parsing.
+  // If |codec_id| is not in |kCodecIds|, then we assume that it is either VP9,
+  // H.264 or HEVC/H.265 codec ID because currently those are the only ones
+  // that are not added to |kCodecIds| and require parsing.
   VideoCodecProfile* out_profile = &out_result->video_profile;
   uint8_t* out_level = &out_result->video_level;
   VideoColorSpace* out_color_space = &out_result->video_color_space;
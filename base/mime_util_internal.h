@@ -5,12 +5,15 @@
 #ifndef MEDIA_BASE_MIME_UTIL_INTERNAL_H_
 #define MEDIA_BASE_MIME_UTIL_INTERNAL_H_
 
+#include <stdint.h>
+
 #include <string>
 #include <vector>
 
-#include "base/containers/flat_map.h"
-#include "base/containers/flat_set.h"
+#include "base/containers/mru_cache.h"
 #include "base/macros.h"
+#include "base/strings/string_piece.h"
+#include "base/synchronization/lock.h"
 #include "media/base/media_export.h"
 #include "media/base/mime_util.h"
 #include "media/base/video_codecs.h"
@@ -98,19 +101,16 @@ class MEDIA_EXPORT MimeUtil {
                                         const PlatformInfo& platform_info);
 
  private:
-  typedef base::flat_set<int> CodecSet;
-  typedef base::flat_map<std::string, CodecSet> MediaFormatMappings;
-
-  // Initializes the supported media types into hash sets for faster lookup.
-  void InitializeMimeTypeMaps();
-
-  // Initializes the supported media formats (|media_format_map_|).
-  void AddSupportedMediaFormats();
+  struct CachedParsedCodec {
+    bool success;
+    ParsedCodecResult result;
+  };
 
-  // Adds |mime_type| with the specified codecs to |media_format_map_|.
-  void AddContainerWithCodecs(const std::string& mime_type,
-                              const CodecSet& codecs_list,
-                              bool is_proprietary_mime_type);
+  // Returns the mask of codecs, indexed by Codec, allowed in
+  // |mime_type_lower_case|, or null if it is not a supported container. An
+  // empty mask means the container implies its codec.
+  const uint32_t* FindContainerCodecs(
+      base::StringPiece mime_type_lower_case) const;
 
   // Returns IsSupported if all codec IDs in |codecs| are unambiguous and are
   // supported in |mime_type_lower_case|. MayBeSupported is returned if at least
@@ -179,6 +179,12 @@ class MEDIA_EXPORT MimeUtil {
                                       Codec codec,
                                       bool is_encrypted) const;
 
+  // Same as ParseCodecHelper(), but remembers the results for recently parsed
+  // pairs of |mime_type_lower_case| and |codec_id|.
+  bool ParseCodecCached(const std::string& mime_type_lower_case,
+                        const std::string& codec_id,
+                        ParsedCodecResult* out_result) const;
+
   // Returns true if |codec| refers to a proprietary codec.
   bool IsCodecProprietary(Codec codec) const;
 
@@ -193,14 +199,17 @@ class MEDIA_EXPORT MimeUtil {
   PlatformInfo platform_info_;
 #endif
 
-  // A map of mime_types and hash map of the supported codecs for the mime_type.
-  MediaFormatMappings media_format_map_;
-
-  // List of proprietary containers in |media_format_map_|.
-  std::vector<std::string> proprietary_media_containers_;
-  // Whether proprietary codec support should be advertised to callers.
+  // Whether proprietary containers and codecs should be advertised to callers.
   bool allow_proprietary_codecs_;
 
+  // Parsing results do not depend on the platform or on
+  // |allow_proprietary_codecs_|, so are kept for the lifetime of the MimeUtil.
+  // Guarded by |parsed_codec_cache_lock_| since MimeUtil is used from several
+  // threads.
+  mutable base::Lock parsed_codec_cache_lock_;
+  mutable base::HashingMRUCache<std::string, CachedParsedCodec>
+      parsed_codec_cache_;
+
   DISALLOW_COPY_AND_ASSIGN(MimeUtil);
 };
 
@@ -0,0 +1,103 @@
+// Copyright 2017 The Chromium Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#include <string>
+#include <vector>
+
+#include "base/macros.h"
+#include "base/time/time.h"
+#include "media/base/mime_util.h"
+#include "media/media_features.h"
+#include "testing/gtest/include/gtest/gtest.h"
+#include "testing/perf/perf_test.h"
+
+namespace media {
+
+namespace {
+
+const int kIterations = 20000;
+
+struct Query {
+  const char* mime_type;
+  const char* codecs;
+};
+
+// What a page probing for adaptive streaming support might ask for, including
+// codecs this build does not know about.
+const Query kQueries[] = {
+    {"video/webm", "vp8, vorbis"},
+    {"video/webm", "vp9"},
+    {"video/webm", "vp09.00.10.08"},
+    {"video/webm", "vp09.02.10.10.01.09.16.09.01, opus"},
+    {"video/webm", "av01.0.04M.08"},
+    {"audio/webm", "opus"},
+#if BUILDFLAG(USE_PROPRIETARY_CODECS)
+    {"video/mp4", "avc1.42E01E"},
+    {"video/mp4", "avc1.4D401F, mp4a.40.2"},
+    {"video/mp4", "avc1.640028, mp4a.40.5"},
+    {"video/mp4", "avc3.64001F"},
+    {"video/mp4", "hev1.1.6.L93.B0"},
+    {"video/mp4", "hvc1.2.4.L120.B0"},
+    {"video/mp4", "vp09.00.51.08.01.01.01.01"},
+    {"video/mp4", "av01.0.05M.08"},
+    {"audio/mp4", "mp4a.40.29"},
+#endif
+};
+
+// Runs |kQueries| |kIterations| times, as clear or |encrypted| content, and
+// reports how many are answered per second.
+void RunQueryBenchmark(const std::string& trace, bool encrypted) {
+  std::vector<std::vector<std::string>> codecs(arraysize(kQueries));
+  for (size_t i = 0; i < arraysize(kQueries); ++i)
+    SplitCodecsToVector(kQueries[i].codecs, &codecs[i], false);
+
+  int supported = 0;
+  const base::TimeTicks start = base::TimeTicks::Now();
+  for (int i = 0; i < kIterations; ++i) {
+    for (size_t j = 0; j < arraysize(kQueries); ++j) {
+      const SupportsType result =
+          encrypted
+              ? IsSupportedEncryptedMediaFormat(kQueries[j].mime_type,
+                                                codecs[j])
+              : IsSupportedMediaFormat(kQueries[j].mime_type, codecs[j]);
+      if (result != IsNotSupported)
+        ++supported;
+    }
+  }
+  const base::TimeDelta elapsed = base::TimeTicks::Now() - start;
+
+  perf_test::PrintResult("mime_util", trace, "is_supported_media_format",
+                         kIterations * arraysize(kQueries) /
+                             elapsed.InSecondsF(),
+                         "lookups/s", true);
+  EXPECT_GT(supported, 0);
+}
+
+void RunSplitBenchmark() {
+  std::vector<std::string> codecs;
+  const base::TimeTicks start = base::TimeTicks::Now();
+  for (int i = 0; i < kIterations; ++i) {
+    for (const Query& query : kQueries)
+      SplitCodecsToVector(query.codecs, &codecs, false);
+  }
+  const base::TimeDelta elapsed = base::TimeTicks::Now() - start;
+
+  perf_test::PrintResult("mime_util", "", "split_codecs_to_vector",
+                         kIterations * arraysize(kQueries) /
+                             elapsed.InSecondsF(),
+                         "lookups/s", true);
+}
+
+}  // namespace
+
+TEST(MimeUtilPerfTest, IsSupportedMediaFormat) {
+  RunQueryBenchmark("_clear", false);
+  RunQueryBenchmark("_encrypted", true);
+}
+
+TEST(MimeUtilPerfTest, SplitCodecsToVector) {
+  RunSplitBenchmark();
+}
+
+}  // namespace media
@@ -4,6 +4,9 @@
 
 #include <stddef.h>
 
+#include <string>
+#include <vector>
+
 #include "base/macros.h"
 #include "base/strings/string_split.h"
 #include "base/strings/stringprintf.h"
@@ -407,6 +410,39 @@ TEST(MimeUtilTest, ParseVideoCodecString_SimpleCodecsHaveProfiles) {
 #endif
 }
 
+// Parsing results are cached; repeated queries must not change the answer.
+TEST(MimeUtilTest, RepeatedQueriesUseCachedParse) {
+  MimeUtil mime_util;
+  const std::vector<std::string> kValid = {"vp09.00.10.08", "opus"};
+  const std::vector<std::string> kInvalid = {"vp09.00.10.08", "bogus"};
+  const SupportsType valid_result =
+      mime_util.IsSupportedMediaFormat("video/webm", kValid, false);
+  EXPECT_NE(IsNotSupported, valid_result);
+
+  for (int i = 0; i < 3; ++i) {
+    EXPECT_EQ(valid_result,
+              mime_util.IsSupportedMediaFormat("video/webm", kValid, false));
+    EXPECT_EQ(IsNotSupported,
+              mime_util.IsSupportedMediaFormat("video/webm", kInvalid, false));
+    // The same codec is parsed differently in another container.
+    EXPECT_EQ(IsNotSupported,
+              mime_util.IsSupportedMediaFormat("audio/webm", kValid, false));
+  }
+}
+
+TEST(MimeUtilTest, RemoveProprietaryMediaTypesAndCodecs) {
+  MimeUtil mime_util;
+  EXPECT_EQ(kUsePropCodecs, mime_util.IsSupportedMediaMimeType("video/mp4"));
+
+  mime_util.RemoveProprietaryMediaTypesAndCodecs();
+  EXPECT_FALSE(mime_util.IsSupportedMediaMimeType("video/mp4"));
+  EXPECT_FALSE(mime_util.IsSupportedMediaMimeType("audio/mpeg"));
+  EXPECT_TRUE(mime_util.IsSupportedMediaMimeType("video/webm"));
+  EXPECT_EQ(IsNotSupported,
+            mime_util.IsSupportedMediaFormat("video/mp4", {"avc1.42E01E"},
+                                             false));
+}
+
 TEST(IsCodecSupportedOnAndroidTest, EncryptedCodecsFailWithoutPlatformSupport) {
   // Vary all parameters except |has_platform_decoders|.
   MimeUtil::PlatformInfo states_to_vary = VaryAllFields();
@@ -6,6 +6,8 @@
 
 #include <stdint.h>
 
+#include <cmath>
+
 #include "base/bind.h"
 #include "base/logging.h"
 #include "base/macros.h"
@@ -338,4 +340,41 @@ bool VerifyFakeVideoBufferForTest(
           height == config.coded_size().height());
 }
 
+static void AppendUint16(uint16_t value, std::vector<uint8_t>* data) {
+  data->push_back(value & 0xff);
+  data->push_back(value >> 8);
+}
+
+static void AppendUint32(uint32_t value, std::vector<uint8_t>* data) {
+  AppendUint16(value & 0xffff, data);
+  AppendUint16(value >> 16, data);
+}
+
+std::vector<uint8_t> CreateWaveFileForTest(int channels,
+                                           int sample_rate,
+                                           int seconds) {
+  const uint32_t data_size = channels * sample_rate * seconds * 2;
+  std::vector<uint8_t> data;
+  data.insert(data.end(), {'R', 'I', 'F', 'F'});
+  AppendUint32(36 + data_size, &data);
+  data.insert(data.end(), {'W', 'A', 'V', 'E', 'f', 'm', 't', ' '});
+  AppendUint32(16, &data);
+  AppendUint16(1, &data);  // PCM.
+  AppendUint16(channels, &data);
+  AppendUint32(sample_rate, &data);
+  AppendUint32(sample_rate * channels * 2, &data);
+  AppendUint16(channels * 2, &data);
+  AppendUint16(16, &data);
+  data.insert(data.end(), {'d', 'a', 't', 'a'});
+  AppendUint32(data_size, &data);
+  for (int i = 0; i < sample_rate * seconds; ++i) {
+    for (int ch = 0; ch < channels; ++ch) {
+      const double phase = 0.001 * i * (1 + ch) * (1.0 + i / sample_rate);
+      const int16_t sample = static_cast<int16_t>(10000 * std::sin(phase));
+      AppendUint16(static_cast<uint16_t>(sample), &data);
+    }
+  }
+  return data;
+}
+
 }  // namespace media
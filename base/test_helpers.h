@@ -6,7 +6,9 @@
 #define MEDIA_BASE_TEST_HELPERS_H_
 
 #include <stddef.h>
+#include <stdint.h>
 #include <memory>
+#include <vector>
 
 #include "base/callback.h"
 #include "base/macros.h"
@@ -185,6 +187,12 @@ scoped_refptr<DecoderBuffer> CreateFakeVideoBufferForTest(
 bool VerifyFakeVideoBufferForTest(const scoped_refptr<DecoderBuffer>& buffer,
                                   const VideoDecoderConfig& config);
 
+// Create a 16-bit PCM WAVE file of |seconds| of a sweeping tone, whose pitch
+// differs per channel.
+std::vector<uint8_t> CreateWaveFileForTest(int channels,
+                                           int sample_rate,
+                                           int seconds);
+
 // Compares two {Audio|Video}DecoderConfigs
 MATCHER_P(DecoderConfigEq, config, "") {
   return arg.Matches(config);
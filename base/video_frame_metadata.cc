@@ -47,6 +47,15 @@ void VideoFrameMetadata::SetRotation(Key key, VideoRotation value) {
   dictionary_.SetKey(ToInternalKey(key), base::Value(value));
 }
 
+void VideoFrameMetadata::SetRect(Key key, const gfx::Rect& value) {
+  base::ListValue list;
+  list.AppendInteger(value.x());
+  list.AppendInteger(value.y());
+  list.AppendInteger(value.width());
+  list.AppendInteger(value.height());
+  dictionary_.SetKey(ToInternalKey(key), std::move(list));
+}
+
 void VideoFrameMetadata::SetString(Key key, const std::string& value) {
   dictionary_.SetWithoutPathExpansion(
       ToInternalKey(key),
@@ -107,6 +116,22 @@ bool VideoFrameMetadata::GetRotation(Key key, VideoRotation* value) const {
   return rv;
 }
 
+bool VideoFrameMetadata::GetRect(Key key, gfx::Rect* value) const {
+  DCHECK(value);
+  const base::ListValue* list = nullptr;
+  if (!dictionary_.GetListWithoutPathExpansion(ToInternalKey(key), &list) ||
+      list->GetSize() != 4) {
+    return false;
+  }
+  int x, y, width, height;
+  if (!list->GetInteger(0, &x) || !list->GetInteger(1, &y) ||
+      !list->GetInteger(2, &width) || !list->GetInteger(3, &height)) {
+    return false;
+  }
+  value->SetRect(x, y, width, height);
+  return true;
+}
+
 bool VideoFrameMetadata::GetString(Key key, std::string* value) const {
   DCHECK(value);
   const base::Value* const binary_value = GetBinaryValue(key);
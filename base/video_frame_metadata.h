@@ -14,6 +14,7 @@
 #include "base/values.h"
 #include "media/base/media_export.h"
 #include "media/base/video_rotation.h"
+#include "ui/gfx/geometry/rect.h"
 
 namespace media {
 
@@ -32,6 +33,20 @@ class MEDIA_EXPORT VideoFrameMetadata {
     CAPTURE_BEGIN_TIME,
     CAPTURE_END_TIME,
 
+    // A counter that is incremented for each frame delivered by a video
+    // capturer.  Consumers can use it to detect dropped frames, in which case
+    // CAPTURE_UPDATE_RECT does not apply relative to the last frame they saw.
+    // Use Get/SetInteger() for this key.
+    CAPTURE_COUNTER,
+
+    // The region of this captured frame that changed since the previously
+    // delivered frame (the one whose CAPTURE_COUNTER is one less), in the
+    // coordinates of the visible rectangle.  An empty rect means nothing
+    // changed.  Consumers may skip unchanged regions, e.g. when converting or
+    // encoding.  If absent, the whole frame must be assumed to have changed.
+    // Use Get/SetRect() for this key.
+    CAPTURE_UPDATE_RECT,
+
     // Some VideoFrames have an indication of the color space used.  Use
     // GetInteger()/SetInteger() and ColorSpace enumeration.
     COLOR_SPACE,
@@ -136,6 +151,7 @@ class MEDIA_EXPORT VideoFrameMetadata {
   void SetInteger(Key key, int value);
   void SetDouble(Key key, double value);
   void SetRotation(Key key, VideoRotation value);
+  void SetRect(Key key, const gfx::Rect& value);
   void SetString(Key key, const std::string& value);
   void SetTimeDelta(Key key, const base::TimeDelta& value);
   void SetTimeTicks(Key key, const base::TimeTicks& value);
@@ -146,6 +162,7 @@ class MEDIA_EXPORT VideoFrameMetadata {
   bool GetInteger(Key key, int* value) const WARN_UNUSED_RESULT;
   bool GetDouble(Key key, double* value) const WARN_UNUSED_RESULT;
   bool GetRotation(Key key, VideoRotation* value) const WARN_UNUSED_RESULT;
+  bool GetRect(Key key, gfx::Rect* value) const WARN_UNUSED_RESULT;
   bool GetString(Key key, std::string* value) const WARN_UNUSED_RESULT;
   bool GetTimeDelta(Key key, base::TimeDelta* value) const WARN_UNUSED_RESULT;
   bool GetTimeTicks(Key key, base::TimeTicks* value) const WARN_UNUSED_RESULT;
@@ -525,6 +525,14 @@ TEST(VideoFrameMetadata, SetAndThenGetAllKeysForAllTypes) {
     EXPECT_EQ(3.14 * i, double_value);
     metadata.Clear();
 
+    EXPECT_FALSE(metadata.HasKey(key));
+    metadata.SetRect(key, gfx::Rect(i, 2 * i, 3 * i + 1, 4 * i + 1));
+    EXPECT_TRUE(metadata.HasKey(key));
+    gfx::Rect rect_value;
+    EXPECT_TRUE(metadata.GetRect(key, &rect_value));
+    EXPECT_EQ(gfx::Rect(i, 2 * i, 3 * i + 1, 4 * i + 1), rect_value);
+    metadata.Clear();
+
     EXPECT_FALSE(metadata.HasKey(key));
     metadata.SetString(key, base::StringPrintf("\xfe%d\xff", i));
     EXPECT_TRUE(metadata.HasKey(key));
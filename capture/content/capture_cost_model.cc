@@ -0,0 +1,106 @@
+// Copyright 2017 The Chromium Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#include "media/capture/content/capture_cost_model.h"
+
+#include <algorithm>
+
+#include "base/logging.h"
+
+namespace media {
+
+namespace {
+
+// The weight of past observations is multiplied by this for each new one.
+// This gives the history a half-life of about four frames.
+const double kDecayFactor = 0.85;
+
+// The number of observations required before predictions are made.
+const int kMinUpdatesForPrediction = 3;
+
+// The pixel rates in the history must vary by at least this fraction of their
+// mean for the overhead and cost per pixel to be fit separately.
+const double kMinRelativeRateDeviation = 0.05;
+
+const double kPixelsPerMegapixel = 1000000.0;
+
+}  // namespace
+
+CaptureCostModel::CaptureCostModel() {
+  Reset();
+}
+
+CaptureCostModel::~CaptureCostModel() {}
+
+void CaptureCostModel::Reset() {
+  weight_sum_ = 0.0;
+  rate_sum_ = 0.0;
+  utilization_sum_ = 0.0;
+  rate_squared_sum_ = 0.0;
+  rate_utilization_sum_ = 0.0;
+  num_updates_ = 0;
+}
+
+void CaptureCostModel::Update(double pixel_rate, double utilization) {
+  DCHECK_GE(pixel_rate, 0.0);
+  DCHECK_GE(utilization, 0.0);
+  const double rate = pixel_rate / kPixelsPerMegapixel;
+  weight_sum_ = weight_sum_ * kDecayFactor + 1.0;
+  rate_sum_ = rate_sum_ * kDecayFactor + rate;
+  utilization_sum_ = utilization_sum_ * kDecayFactor + utilization;
+  rate_squared_sum_ = rate_squared_sum_ * kDecayFactor + rate * rate;
+  rate_utilization_sum_ =
+      rate_utilization_sum_ * kDecayFactor + rate * utilization;
+  ++num_updates_;
+}
+
+bool CaptureCostModel::has_sufficient_history() const {
+  return num_updates_ >= kMinUpdatesForPrediction;
+}
+
+double CaptureCostModel::PredictUtilization(double pixel_rate) const {
+  double overhead, cost_per_pixel;
+  Fit(&overhead, &cost_per_pixel);
+  return overhead + cost_per_pixel * pixel_rate / kPixelsPerMegapixel;
+}
+
+double CaptureCostModel::FindMaxPixelRate(double utilization) const {
+  double overhead, cost_per_pixel;
+  Fit(&overhead, &cost_per_pixel);
+  if (cost_per_pixel <= 0.0)
+    return -1.0;
+  return std::max(0.0, (utilization - overhead) / cost_per_pixel) *
+         kPixelsPerMegapixel;
+}
+
+void CaptureCostModel::Fit(double* overhead, double* cost_per_pixel) const {
+  *overhead = 0.0;
+  *cost_per_pixel = 0.0;
+  if (weight_sum_ <= 0.0)
+    return;
+
+  const double mean_rate = rate_sum_ / weight_sum_;
+  const double mean_utilization = utilization_sum_ / weight_sum_;
+  const double rate_variance =
+      rate_squared_sum_ / weight_sum_ - mean_rate * mean_rate;
+  const double min_deviation = kMinRelativeRateDeviation * mean_rate;
+  if (rate_variance > min_deviation * min_deviation) {
+    const double covariance =
+        rate_utilization_sum_ / weight_sum_ - mean_rate * mean_utilization;
+    const double slope = covariance / rate_variance;
+    const double intercept = mean_utilization - slope * mean_rate;
+    // A negative cost per pixel, or a negative overhead, is noise.  Fall back
+    // to the proportional model in that case.
+    if (slope > 0.0 && intercept >= 0.0) {
+      *overhead = intercept;
+      *cost_per_pixel = slope;
+      return;
+    }
+  }
+
+  if (mean_rate > 0.0)
+    *cost_per_pixel = mean_utilization / mean_rate;
+}
+
+}  // namespace media
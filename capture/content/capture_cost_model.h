@@ -0,0 +1,64 @@
+// Copyright 2017 The Chromium Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#ifndef MEDIA_CAPTURE_CONTENT_CAPTURE_COST_MODEL_H_
+#define MEDIA_CAPTURE_CONTENT_CAPTURE_COST_MODEL_H_
+
+#include "media/capture/capture_export.h"
+
+namespace media {
+
+// Predicts the utilization of a capture pipeline stage (e.g., the buffer pool
+// or the consumer's encoder) as a function of the pixel rate, that is the
+// frame area times the frame rate.  The cost is modeled as linear in the pixel
+// rate, with a fixed per-second overhead:
+//
+//   utilization = overhead + cost_per_pixel * pixel_rate
+//
+// Both terms are fit by least squares over the recent history of observed
+// utilizations, with exponentially decaying weights so that the model tracks
+// changes in system load within a few frames.  While the history does not span
+// enough different pixel rates to separate the two terms, utilization is
+// assumed proportional to the pixel rate.
+class CAPTURE_EXPORT CaptureCostModel {
+ public:
+  CaptureCostModel();
+  ~CaptureCostModel();
+
+  // Forgets all history.
+  void Reset();
+
+  // Records that |utilization| was observed for frames captured at
+  // |pixel_rate|, in pixels per second.
+  void Update(double pixel_rate, double utilization);
+
+  // Returns true once enough observations were made for predictions to be
+  // meaningful.
+  bool has_sufficient_history() const;
+
+  // Returns the predicted utilization at |pixel_rate|.
+  double PredictUtilization(double pixel_rate) const;
+
+  // Returns the highest pixel rate predicted to result in at most
+  // |utilization|, or a negative value if the model predicts no cost.
+  double FindMaxPixelRate(double utilization) const;
+
+ private:
+  // Computes the |overhead| and |cost_per_pixel| best fitting the history.
+  void Fit(double* overhead, double* cost_per_pixel) const;
+
+  // Exponentially-weighted sums over the history, with pixel rates in
+  // megapixels per second to keep the squares well-conditioned.
+  double weight_sum_;
+  double rate_sum_;
+  double utilization_sum_;
+  double rate_squared_sum_;
+  double rate_utilization_sum_;
+
+  int num_updates_;
+};
+
+}  // namespace media
+
+#endif  // MEDIA_CAPTURE_CONTENT_CAPTURE_COST_MODEL_H_
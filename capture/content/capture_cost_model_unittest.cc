@@ -0,0 +1,71 @@
+// Copyright 2017 The Chromium Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#include "media/capture/content/capture_cost_model.h"
+
+#include "testing/gtest/include/gtest/gtest.h"
+
+namespace media {
+
+namespace {
+
+const double k720pAt30Fps = 1280 * 720 * 30.0;
+const double k360pAt30Fps = 640 * 360 * 30.0;
+
+}  // namespace
+
+TEST(CaptureCostModelTest, RequiresHistoryForPrediction) {
+  CaptureCostModel model;
+  EXPECT_FALSE(model.has_sufficient_history());
+  model.Update(k720pAt30Fps, 0.5);
+  model.Update(k720pAt30Fps, 0.5);
+  EXPECT_FALSE(model.has_sufficient_history());
+  model.Update(k720pAt30Fps, 0.5);
+  EXPECT_TRUE(model.has_sufficient_history());
+
+  model.Reset();
+  EXPECT_FALSE(model.has_sufficient_history());
+  EXPECT_EQ(-1.0, model.FindMaxPixelRate(0.9));
+}
+
+// With observations at a single pixel rate, utilization is assumed
+// proportional to the pixel rate.
+TEST(CaptureCostModelTest, AssumesProportionalCostForSinglePixelRate) {
+  CaptureCostModel model;
+  for (int i = 0; i < 10; ++i)
+    model.Update(k720pAt30Fps, 0.6);
+  EXPECT_NEAR(0.6, model.PredictUtilization(k720pAt30Fps), 1e-9);
+  EXPECT_NEAR(0.15, model.PredictUtilization(k360pAt30Fps), 1e-9);
+  EXPECT_NEAR(k720pAt30Fps * 1.5, model.FindMaxPixelRate(0.9),
+              k720pAt30Fps * 1e-9);
+}
+
+// With observations at several pixel rates, the fixed overhead is separated
+// from the cost per pixel.
+TEST(CaptureCostModelTest, FitsOverheadAndCostPerPixel) {
+  CaptureCostModel model;
+  const double overhead = 0.1;
+  const double cost_per_megapixel = 0.02;
+  for (int i = 0; i < 20; ++i) {
+    const double pixel_rate = (i % 2) ? k720pAt30Fps : k360pAt30Fps;
+    model.Update(pixel_rate,
+                 overhead + cost_per_megapixel * pixel_rate / 1000000.0);
+  }
+  EXPECT_NEAR(overhead + cost_per_megapixel * 50.0,
+              model.PredictUtilization(50000000.0), 1e-6);
+  EXPECT_NEAR((0.9 - overhead) / cost_per_megapixel * 1000000.0,
+              model.FindMaxPixelRate(0.9), 1.0);
+}
+
+// Tests that a change in system load is tracked within a few frames.
+TEST(CaptureCostModelTest, TracksChangesQuickly) {
+  CaptureCostModel model;
+  for (int i = 0; i < 100; ++i)
+    model.Update(k720pAt30Fps, 0.5);
+  for (int i = 0; i < 10; ++i)
+    model.Update(k720pAt30Fps, 1.5);
+  EXPECT_LT(1.2, model.PredictUtilization(k720pAt30Fps));
+}
+
+}  // namespace media
@@ -266,6 +266,10 @@ void ThreadSafeCaptureOracle::DidCaptureFrame(
                                   capture->frame_duration);
   frame->metadata()->SetTimeTicks(VideoFrameMetadata::REFERENCE_TIME,
                                   reference_time);
+  frame->metadata()->SetInteger(VideoFrameMetadata::CAPTURE_COUNTER,
+                                oracle_.capture_counter());
+  frame->metadata()->SetRect(VideoFrameMetadata::CAPTURE_UPDATE_RECT,
+                             oracle_.update_rect());
 
   media::VideoCaptureFormat format(frame->coded_size(),
                                    params_.requested_format.frame_rate,
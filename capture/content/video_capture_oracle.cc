@@ -5,11 +5,16 @@
 #include "media/capture/content/video_capture_oracle.h"
 
 #include <algorithm>
+#include <limits>
 
 #include "base/compiler_specific.h"
+#include "base/feature_list.h"
 #include "base/format_macros.h"
 #include "base/numerics/safe_conversions.h"
 #include "base/strings/stringprintf.h"
+#include "media/base/media_switches.h"
+#include "media/base/video_util.h"
+#include "ui/gfx/geometry/rect_conversions.h"
 
 namespace media {
 
@@ -63,6 +68,18 @@ const int kDebouncingPeriodForAnimatedContentMicros = 3000000;  // 3 seconds
 // contiguously under-utilized before increasing the capture size.
 const int kProvingPeriodForAnimatedContentMicros = 30000000;  // 30 seconds
 
+// With model-based throttling, the minimum amount of time that must pass
+// between changes to the capture size.  The cost models predict the effect of a
+// change, so this only needs to be long enough for the utilization of the new
+// size to be observed.
+const int kMinSizeChangePeriodWithCostModelMicros = 250000;  // 0.25 seconds
+
+// With model-based throttling, the highest predicted utilization allowed for
+// the current or a smaller capture size, and for a larger one.  The gap between
+// the two prevents oscillating between adjacent sizes.
+const double kMaxSustainableUtilization = 0.9;
+const double kMaxUtilizationForIncrease = 0.7;
+
 // Given the amount of time between frames, compare to the expected amount of
 // time between frames at |frame_rate| and return the fractional difference.
 double FractionFromExpectedFrameRate(base::TimeDelta delta, int frame_rate) {
@@ -100,18 +117,26 @@ constexpr base::TimeDelta VideoCaptureOracle::kDefaultMinCapturePeriod;
 
 VideoCaptureOracle::VideoCaptureOracle(bool enable_auto_throttling)
     : auto_throttling_enabled_(enable_auto_throttling),
+      use_cost_model_(enable_auto_throttling &&
+                      base::FeatureList::IsEnabled(
+                          media::kModelBasedCaptureThrottling)),
       next_frame_number_(0),
       source_is_dirty_(true),
       last_successfully_delivered_frame_number_(-1),
       num_frames_pending_(0),
       smoothing_sampler_(kDefaultMinCapturePeriod),
       content_sampler_(kDefaultMinCapturePeriod),
+      damage_is_unknown_(true),
+      num_frames_delivered_(0),
       buffer_pool_utilization_(base::TimeDelta::FromMicroseconds(
           kBufferUtilizationEvaluationMicros)),
       estimated_capable_area_(base::TimeDelta::FromMicroseconds(
-          kConsumerCapabilityEvaluationMicros)) {
+          kConsumerCapabilityEvaluationMicros)),
+      frame_pixel_rates_() {
   VLOG(1) << "Auto-throttling is "
-          << (auto_throttling_enabled_ ? "enabled." : "disabled.");
+          << (auto_throttling_enabled_
+                  ? (use_cost_model_ ? "enabled, model-based." : "enabled.")
+                  : "disabled.");
 }
 
 VideoCaptureOracle::~VideoCaptureOracle() {
@@ -133,10 +158,13 @@ void VideoCaptureOracle::SetCaptureSizeConstraints(
 
 void VideoCaptureOracle::SetSourceSize(const gfx::Size& source_size) {
   resolution_chooser_.SetSourceSize(source_size);
+  damage_is_unknown_ = true;
   // If the |resolution_chooser_| computed a new capture size, that will become
   // visible via a future call to ObserveEventAndDecideCapture().
   source_size_change_time_ = (next_frame_number_ == 0) ?
       base::TimeTicks() : GetFrameTimestamp(next_frame_number_ - 1);
+  pool_cost_model_.Reset();
+  consumer_cost_model_.Reset();
 }
 
 bool VideoCaptureOracle::ObserveEventAndDecideCapture(
@@ -156,6 +184,7 @@ bool VideoCaptureOracle::ObserveEventAndDecideCapture(
   // prevent passive refresh requests until a capture is made.
   if (event != kActiveRefreshRequest && event != kPassiveRefreshRequest)
     source_is_dirty_ = true;
+  AccumulateDamage(event, damage_rect);
 
   bool should_sample = false;
   duration_of_next_frame_ = base::TimeDelta();
@@ -205,6 +234,14 @@ bool VideoCaptureOracle::ObserveEventAndDecideCapture(
   if (!should_sample)
     return false;
 
+  // If even the smallest capture size cannot be sustained, lower the frame
+  // rate.
+  if (!throttled_capture_period_.is_zero() && next_frame_number_ > 0 &&
+      event_time - GetFrameTimestamp(next_frame_number_ - 1) <
+          throttled_capture_period_) {
+    return false;
+  }
+
   // If the exact duration of the next frame has not been determined, estimate
   // it using the difference between the current and last frame.
   if (duration_of_next_frame_.is_zero()) {
@@ -227,11 +264,18 @@ bool VideoCaptureOracle::ObserveEventAndDecideCapture(
   } else if (capture_size_ != resolution_chooser_.capture_size()) {
     const base::TimeDelta time_since_last_change =
         event_time - buffer_pool_utilization_.reset_time();
-    if (time_since_last_change.InMicroseconds() >= kMinSizeChangePeriodMicros)
+    if (time_since_last_change.InMicroseconds() >=
+        (use_cost_model_ ? kMinSizeChangePeriodWithCostModelMicros
+                         : kMinSizeChangePeriodMicros)) {
       CommitCaptureSizeAndReset(GetFrameTimestamp(next_frame_number_ - 1));
+    }
   }
 
   SetFrameTimestamp(next_frame_number_, event_time);
+  frame_pixel_rates_[next_frame_number_ % kMaxFrameTimestamps] =
+      capture_size_.GetArea() / duration_of_next_frame_.InSecondsF();
+  frame_damage_rects_[next_frame_number_ % kMaxFrameTimestamps] =
+      GetAccumulatedDamageInCaptureCoordinates();
   return true;
 }
 
@@ -239,12 +283,19 @@ void VideoCaptureOracle::RecordCapture(double pool_utilization) {
   DCHECK(std::isfinite(pool_utilization) && pool_utilization >= 0.0);
 
   source_is_dirty_ = false;
+  accumulated_damage_ = gfx::Rect();
+  damage_is_unknown_ = false;
 
   smoothing_sampler_.RecordSample();
   const base::TimeTicks timestamp = GetFrameTimestamp(next_frame_number_);
   content_sampler_.RecordSample(timestamp);
 
-  if (auto_throttling_enabled_) {
+  if (use_cost_model_) {
+    pool_cost_model_.Update(
+        frame_pixel_rates_[next_frame_number_ % kMaxFrameTimestamps],
+        pool_utilization);
+    AnalyzeWithCostModels();
+  } else if (auto_throttling_enabled_) {
     buffer_pool_utilization_.Update(pool_utilization, timestamp);
     AnalyzeAndAdjust(timestamp);
   }
@@ -257,7 +308,13 @@ void VideoCaptureOracle::RecordWillNotCapture(double pool_utilization) {
   VLOG(1) << "Client rejects proposal to capture frame (at #"
           << next_frame_number_ << ").";
 
-  if (auto_throttling_enabled_) {
+  if (use_cost_model_) {
+    DCHECK(std::isfinite(pool_utilization) && pool_utilization >= 0.0);
+    pool_cost_model_.Update(
+        frame_pixel_rates_[next_frame_number_ % kMaxFrameTimestamps],
+        pool_utilization);
+    AnalyzeWithCostModels();
+  } else if (auto_throttling_enabled_) {
     DCHECK(std::isfinite(pool_utilization) && pool_utilization >= 0.0);
     const base::TimeTicks timestamp = GetFrameTimestamp(next_frame_number_);
     buffer_pool_utilization_.Update(pool_utilization, timestamp);
@@ -297,6 +354,22 @@ bool VideoCaptureOracle::CompleteCapture(int frame_number,
   }
 
   DCHECK_NE(last_successfully_delivered_frame_number_, frame_number);
+
+  // The frame reflects the damage of every frame captured since the one last
+  // delivered, since the consumer never saw those.
+  const gfx::Rect frame_rect(capture_size_);
+  if (last_successfully_delivered_frame_number_ < 0 ||
+      !IsFrameInRecentHistory(last_successfully_delivered_frame_number_ + 1)) {
+    update_rect_ = frame_rect;
+  } else {
+    update_rect_ = gfx::Rect();
+    for (int i = last_successfully_delivered_frame_number_ + 1;
+         i <= frame_number; ++i) {
+      update_rect_.Union(frame_damage_rects_[i % kMaxFrameTimestamps]);
+    }
+    update_rect_.Intersect(frame_rect);
+  }
+  ++num_frames_delivered_;
   last_successfully_delivered_frame_number_ = frame_number;
 
   *frame_timestamp = GetFrameTimestamp(frame_number);
@@ -351,6 +424,13 @@ void VideoCaptureOracle::RecordConsumerFeedback(int frame_number,
     VLOG(1) << "Very old frame feedback being ignored: frame #" << frame_number;
     return;
   }
+  if (use_cost_model_) {
+    consumer_cost_model_.Update(
+        frame_pixel_rates_[frame_number % kMaxFrameTimestamps],
+        resource_utilization);
+    return;
+  }
+
   const base::TimeTicks timestamp = GetFrameTimestamp(frame_number);
 
   // Translate the utilization metric to be in terms of the capable frame area
@@ -402,11 +482,62 @@ NOINLINE bool VideoCaptureOracle::IsFrameInRecentHistory(
           (next_frame_number_ - frame_number) < kMaxFrameTimestamps);
 }
 
+void VideoCaptureOracle::AccumulateDamage(Event event,
+                                          const gfx::Rect& damage_rect) {
+  switch (event) {
+    case kCompositorUpdate:
+      // An empty |damage_rect| means the damaged region is not known.
+      if (damage_rect.IsEmpty())
+        damage_is_unknown_ = true;
+      else
+        accumulated_damage_.Union(damage_rect);
+      break;
+    case kActiveRefreshRequest:
+    case kMouseCursorUpdate:
+      // Refreshes are requested when consumers need the whole frame again, and
+      // the location of the cursor is not reported with its updates.
+      damage_is_unknown_ = true;
+      break;
+    case kPassiveRefreshRequest:
+      // Re-delivers the last frame: nothing changed.
+      break;
+    case kNumEvents:
+      NOTREACHED();
+      break;
+  }
+}
+
+gfx::Rect VideoCaptureOracle::GetAccumulatedDamageInCaptureCoordinates()
+    const {
+  const gfx::Rect frame_rect(capture_size_);
+  const gfx::Size& source_size = resolution_chooser_.source_size();
+  if (damage_is_unknown_ || source_size.IsEmpty())
+    return frame_rect;
+  if (accumulated_damage_.IsEmpty())
+    return gfx::Rect();
+
+  // Map into the letterboxed content region, and grow by one pixel to account
+  // for the filtering applied when scaling.
+  const gfx::Rect content_rect =
+      ComputeLetterboxRegion(frame_rect, source_size);
+  gfx::Rect damage = gfx::ScaleToEnclosingRect(
+      accumulated_damage_,
+      static_cast<float>(content_rect.width()) / source_size.width(),
+      static_cast<float>(content_rect.height()) / source_size.height());
+  damage.Offset(content_rect.OffsetFromOrigin());
+  damage.Inset(-1, -1);
+  damage.Intersect(frame_rect);
+  return damage;
+}
+
 void VideoCaptureOracle::CommitCaptureSizeAndReset(
     base::TimeTicks last_frame_time) {
   capture_size_ = resolution_chooser_.capture_size();
   VLOG(2) << "Now proposing a capture size of " << capture_size_.ToString();
 
+  // Everything changes with the capture size.
+  damage_is_unknown_ = true;
+
   // Reset each short-term feedback accumulator with a stable-state starting
   // value.
   const base::TimeTicks ignore_before_time = JustAfter(last_frame_time);
@@ -582,4 +713,71 @@ int VideoCaptureOracle::AnalyzeForIncreasedArea(base::TimeTicks analyze_time) {
   return increased_area;
 }
 
+void VideoCaptureOracle::AnalyzeWithCostModels() {
+  DCHECK(use_cost_model_);
+
+  const double max_pixel_rate =
+      FindMaxSustainablePixelRate(kMaxSustainableUtilization);
+  if (max_pixel_rate < 0.0) {
+    // No prediction yet: keep the current capture size.
+    return;
+  }
+  const double max_pixel_rate_for_increase =
+      FindMaxSustainablePixelRate(kMaxUtilizationForIncrease);
+
+  // Frames can be captured as often as every min_capture_period(), so the
+  // chosen size must be sustainable at that rate even if content currently
+  // updates less often.
+  const double max_frame_rate = 1.0 / min_capture_period().InSecondsF();
+  const int current_area = capture_size_.GetArea();
+  gfx::Size size = resolution_chooser_.FindNearestFrameSize(
+      std::numeric_limits<int>::max());
+  while (true) {
+    const int area = size.GetArea();
+    const double limit =
+        area > current_area ? max_pixel_rate_for_increase : max_pixel_rate;
+    if (area * max_frame_rate <= limit)
+      break;
+    const gfx::Size smaller_size =
+        resolution_chooser_.FindSmallerFrameSize(area, 1);
+    if (smaller_size.GetArea() >= area)
+      break;  // Already the smallest size.
+    size = smaller_size;
+  }
+
+  // If the smallest size still is not sustainable at the maximum frame rate,
+  // space frames out further.
+  const double pixel_rate = size.GetArea() * max_frame_rate;
+  if (pixel_rate > max_pixel_rate && max_pixel_rate > 0.0) {
+    throttled_capture_period_ =
+        base::TimeDelta::FromSecondsD(size.GetArea() / max_pixel_rate);
+    throttled_capture_period_ =
+        std::min(throttled_capture_period_, kDefaultMinCapturePeriod);
+  } else {
+    throttled_capture_period_ = base::TimeDelta();
+  }
+
+  VLOG_IF(2, size != resolution_chooser_.capture_size())
+      << "Cost models propose a capture size of " << size.ToString()
+      << " (sustainable pixel rate: " << max_pixel_rate << "/s).";
+  resolution_chooser_.SetTargetFrameArea(size.GetArea());
+}
+
+double VideoCaptureOracle::FindMaxSustainablePixelRate(
+    double utilization) const {
+  double max_pixel_rate = -1.0;
+  for (const CaptureCostModel* model :
+       {&pool_cost_model_, &consumer_cost_model_}) {
+    if (!model->has_sufficient_history())
+      continue;
+    const double model_max_pixel_rate = model->FindMaxPixelRate(utilization);
+    if (model_max_pixel_rate < 0.0)
+      continue;
+    max_pixel_rate = max_pixel_rate < 0.0
+                         ? model_max_pixel_rate
+                         : std::min(max_pixel_rate, model_max_pixel_rate);
+  }
+  return max_pixel_rate;
+}
+
 }  // namespace media
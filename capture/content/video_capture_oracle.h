@@ -10,6 +10,7 @@
 #include "media/base/feedback_signal_accumulator.h"
 #include "media/capture/capture_export.h"
 #include "media/capture/content/animated_content_sampler.h"
+#include "media/capture/content/capture_cost_model.h"
 #include "media/capture/content/capture_resolution_chooser.h"
 #include "media/capture/content/smooth_event_sampler.h"
 #include "ui/gfx/geometry/rect.h"
@@ -35,7 +36,10 @@ class CAPTURE_EXPORT VideoCaptureOracle {
   // SetCaptureSizeConstraints() to provide more-accurate hard limits. If
   // |enable_auto_throttling| is true, enable realtime analysis of system
   // performance and auto-adjust the capture resolution and sampling decisions
-  // to provide the best user experience.
+  // to provide the best user experience.  When the ModelBasedCaptureThrottling
+  // feature is enabled, auto-throttling predicts the utilization of each
+  // capture size from recent history and also lowers the frame rate when even
+  // the smallest size cannot be sustained.
   explicit VideoCaptureOracle(bool enable_auto_throttling);
 
   virtual ~VideoCaptureOracle();
@@ -61,8 +65,9 @@ class CAPTURE_EXPORT VideoCaptureOracle {
 
   // Record a event of type |event|, and decide whether the caller should do a
   // frame capture.  |damage_rect| is the region of a frame about to be drawn,
-  // and may be an empty Rect, if this is not known.  If the caller accepts the
-  // oracle's proposal, it should call RecordCapture() to indicate this.
+  // in source coordinates, and may be an empty Rect, if this is not known.  If
+  // the caller accepts the oracle's proposal, it should call RecordCapture() to
+  // indicate this.
   bool ObserveEventAndDecideCapture(Event event,
                                     const gfx::Rect& damage_rect,
                                     base::TimeTicks event_time);
@@ -86,6 +91,19 @@ class CAPTURE_EXPORT VideoCaptureOracle {
                        bool capture_was_successful,
                        base::TimeTicks* frame_timestamp);
 
+  // Returns the region, in capture coordinates, of the frame most recently
+  // accepted by CompleteCapture() that changed since the frame delivered before
+  // it.  This accumulates the damage of all events since then, including those
+  // of frames that were not delivered, and is the whole frame whenever the
+  // damage is unknown.  This should be called just after CompleteCapture()
+  // returned true.
+  gfx::Rect update_rect() const { return update_rect_; }
+
+  // Returns the number of frames accepted by CompleteCapture() so far, minus
+  // one.  Consumers use this to tell whether update_rect() is relative to the
+  // last frame they received.
+  int capture_counter() const { return num_frames_delivered_ - 1; }
+
   // Record the resource utilization feedback for a frame that was processed by
   // the consumer.  This allows the oracle to reduce/increase future data volume
   // if the consumer is overloaded/under-utilized.  |resource_utilization| is a
@@ -132,6 +150,13 @@ class CAPTURE_EXPORT VideoCaptureOracle {
   // slot for the given |frame_number|.
   bool IsFrameInRecentHistory(int frame_number) const;
 
+  // Adds the damage reported with an event of type |event| to
+  // |accumulated_damage_|.
+  void AccumulateDamage(Event event, const gfx::Rect& damage_rect);
+
+  // Returns |accumulated_damage_| in the coordinates of |capture_size_|.
+  gfx::Rect GetAccumulatedDamageInCaptureCoordinates() const;
+
   // Queries the ResolutionChooser to update |capture_size_|, and resets all the
   // FeedbackSignalAccumulator members to stable-state starting values.  The
   // accumulators are reset such that they can only apply feedback updates for
@@ -153,10 +178,24 @@ class CAPTURE_EXPORT VideoCaptureOracle {
   // or -1 if no increase should be made.
   int AnalyzeForIncreasedArea(base::TimeTicks analyze_time);
 
+  // Used instead of the three methods above when |use_cost_model_| is true:
+  // picks the largest capture size that |pool_cost_model_| and
+  // |consumer_cost_model_| predict to be sustainable at the maximum frame rate,
+  // and updates |throttled_capture_period_|.
+  void AnalyzeWithCostModels();
+
+  // Returns the highest pixel rate the cost models predict to result in at most
+  // |utilization|, or a negative value if there is no prediction.
+  double FindMaxSustainablePixelRate(double utilization) const;
+
   // Set to false to prevent the oracle from automatically adjusting the capture
   // size in response to end-to-end utilization.
   const bool auto_throttling_enabled_;
 
+  // Whether auto-throttling is driven by the cost models below instead of the
+  // feedback signal accumulator heuristics.
+  const bool use_cost_model_;
+
   // Incremented every time RecordCapture() is called.
   int next_frame_number_;
 
@@ -205,6 +244,21 @@ class CAPTURE_EXPORT VideoCaptureOracle {
   enum { kMaxFrameTimestamps = 16 };
   base::TimeTicks frame_timestamps_[kMaxFrameTimestamps];
 
+  // The damage of each frame in |frame_timestamps_| since the frame proposed
+  // before it, in capture coordinates.  Indexed the same way.
+  gfx::Rect frame_damage_rects_[kMaxFrameTimestamps];
+
+  // The union of all damage rects observed since the last capture, in source
+  // coordinates.  If |damage_is_unknown_| is true, the whole source must be
+  // assumed damaged.
+  gfx::Rect accumulated_damage_;
+  bool damage_is_unknown_;
+
+  // Set by CompleteCapture() for the frame it accepted.  See update_rect() and
+  // capture_counter().
+  gfx::Rect update_rect_;
+  int num_frames_delivered_;
+
   // Recent average buffer pool utilization for capture.
   FeedbackSignalAccumulator<base::TimeTicks> buffer_pool_utilization_;
 
@@ -220,6 +274,19 @@ class CAPTURE_EXPORT VideoCaptureOracle {
   // increase in capture size.
   base::TimeTicks start_time_of_underutilization_;
 
+  // Predict the buffer pool and consumer utilizations from the pixel rate.
+  // Only used if |use_cost_model_| is true.
+  CaptureCostModel pool_cost_model_;
+  CaptureCostModel consumer_cost_model_;
+
+  // The pixel rate, in pixels per second, of each frame in |frame_timestamps_|.
+  // Indexed the same way.
+  double frame_pixel_rates_[kMaxFrameTimestamps];
+
+  // When non-zero, the minimum time between frames needed to keep utilization
+  // sustainable at the smallest capture size.
+  base::TimeDelta throttled_capture_period_;
+
   // The timestamp of the frame where |content_sampler_| last detected
   // animation.  This determines whether capture size increases will be
   // aggressive (because content is not animating).
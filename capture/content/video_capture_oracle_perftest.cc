@@ -0,0 +1,143 @@
+// Copyright 2017 The Chromium Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#include <stdint.h>
+
+#include <algorithm>
+#include <string>
+#include <vector>
+
+#include "base/time/time.h"
+#include "media/capture/content/video_capture_oracle.h"
+#include "testing/gtest/include/gtest/gtest.h"
+#include "testing/perf/perf_test.h"
+#include "third_party/libyuv/include/libyuv/convert.h"
+#include "ui/gfx/geometry/rect.h"
+
+namespace media {
+
+namespace {
+
+const int kSimulationSeconds = 10;
+
+// A screen content workload: the damage rect of the compositor update at
+// |event_number|, which occurs at |event_rate| updates per second.
+struct Workload {
+  const char* name;
+  int event_rate;
+  gfx::Rect (*damage_for_event)(int event_number);
+};
+
+// Typing: a caret advancing one glyph per keystroke, eight per second.
+gfx::Rect TypingDamage(int event_number) {
+  const int glyphs_per_line = 100;
+  return gfx::Rect(200 + (event_number % glyphs_per_line) * 12,
+                   150 + (event_number / glyphs_per_line) * 20 % 800, 12, 20);
+}
+
+// Scrolling: the whole content area of a browser window, every vsync.
+gfx::Rect ScrollingDamage(int event_number) {
+  return gfx::Rect(0, 120, 1920, 900);
+}
+
+// Video: a 480p player embedded in a page, at 30 FPS.
+gfx::Rect VideoDamage(int event_number) {
+  return gfx::Rect(533, 300, 854, 480);
+}
+
+const Workload kWorkloads[] = {
+    {"typing", 8, &TypingDamage},
+    {"scrolling", 60, &ScrollingDamage},
+    {"video", 30, &VideoDamage},
+};
+
+// Converts the |rect| region of an ARGB |source| of |size| into the I420
+// planes of |dest|, the way a capturer produces frames.
+void ConvertRegion(const std::vector<uint8_t>& source,
+                   const gfx::Size& size,
+                   const gfx::Rect& rect,
+                   std::vector<uint8_t>* dest) {
+  // I420 needs even coordinates.
+  const int x = rect.x() & ~1;
+  const int y = rect.y() & ~1;
+  const int width = std::min(size.width() - x, (rect.right() - x + 1) & ~1);
+  const int height = std::min(size.height() - y, (rect.bottom() - y + 1) & ~1);
+  if (width <= 0 || height <= 0)
+    return;
+  uint8_t* const y_plane = dest->data();
+  uint8_t* const u_plane = y_plane + size.GetArea();
+  uint8_t* const v_plane = u_plane + size.GetArea() / 4;
+  const int uv_stride = size.width() / 2;
+  libyuv::ARGBToI420(
+      source.data() + y * size.width() * 4 + x * 4, size.width() * 4,
+      y_plane + y * size.width() + x, size.width(),
+      u_plane + (y / 2) * uv_stride + x / 2, uv_stride,
+      v_plane + (y / 2) * uv_stride + x / 2, uv_stride, width, height);
+}
+
+// Feeds |kSimulationSeconds| of |workload| through a VideoCaptureOracle and
+// converts either the whole of each delivered frame or only its update rect,
+// reporting the CPU time spent per second of content.
+void RunWorkload(const Workload& workload) {
+  const gfx::Size size(1920, 1080);
+  VideoCaptureOracle oracle(false);
+  oracle.SetMinCapturePeriod(base::TimeDelta::FromSeconds(1) / 30);
+  oracle.SetCaptureSizeConstraints(size, size, false);
+  oracle.SetSourceSize(size);
+
+  std::vector<uint8_t> source(size.GetArea() * 4);
+  for (size_t i = 0; i < source.size(); ++i)
+    source[i] = static_cast<uint8_t>(i * 7);
+  std::vector<uint8_t> dest(size.GetArea() * 3 / 2);
+
+  int64_t damaged_pixels = 0;
+  int64_t total_pixels = 0;
+  base::TimeDelta full_frame_time;
+  base::TimeDelta damage_only_time;
+  const base::TimeDelta event_interval =
+      base::TimeDelta::FromSeconds(1) / workload.event_rate;
+  base::TimeTicks t = base::TimeTicks() + base::TimeDelta::FromSeconds(1);
+  for (int i = 0; i < kSimulationSeconds * workload.event_rate; ++i) {
+    t += event_interval;
+    if (!oracle.ObserveEventAndDecideCapture(
+            VideoCaptureOracle::kCompositorUpdate,
+            workload.damage_for_event(i), t)) {
+      continue;
+    }
+    const int frame_number = oracle.next_frame_number();
+    oracle.RecordCapture(0.0);
+    base::TimeTicks frame_timestamp;
+    ASSERT_TRUE(oracle.CompleteCapture(frame_number, true, &frame_timestamp));
+    const gfx::Rect update_rect = oracle.update_rect();
+    damaged_pixels += update_rect.size().GetArea();
+    total_pixels += size.GetArea();
+
+    base::TimeTicks start = base::TimeTicks::Now();
+    ConvertRegion(source, size, gfx::Rect(size), &dest);
+    full_frame_time += base::TimeTicks::Now() - start;
+    start = base::TimeTicks::Now();
+    ConvertRegion(source, size, update_rect, &dest);
+    damage_only_time += base::TimeTicks::Now() - start;
+  }
+  ASSERT_GT(total_pixels, 0);
+
+  const std::string trace = std::string("_") + workload.name;
+  perf_test::PrintResult("capture_damage", trace, "updated_pixels",
+                         100.0 * damaged_pixels / total_pixels, "%", true);
+  perf_test::PrintResult(
+      "capture_damage", trace, "full_frame_convert",
+      full_frame_time.InMillisecondsF() / kSimulationSeconds, "ms/s", true);
+  perf_test::PrintResult(
+      "capture_damage", trace, "damage_only_convert",
+      damage_only_time.InMillisecondsF() / kSimulationSeconds, "ms/s", true);
+}
+
+}  // namespace
+
+TEST(VideoCaptureOraclePerfTest, DamageTrackingWorkloads) {
+  for (const Workload& workload : kWorkloads)
+    RunWorkload(workload);
+}
+
+}  // namespace media
@@ -4,7 +4,11 @@
 
 #include "media/capture/content/video_capture_oracle.h"
 
+#include <vector>
+
 #include "base/strings/stringprintf.h"
+#include "base/test/scoped_feature_list.h"
+#include "media/base/media_switches.h"
 #include "testing/gtest/include/gtest/gtest.h"
 
 namespace media {
@@ -688,4 +692,209 @@ TEST(VideoCaptureOracleTest, DoesNotAutoThrottleWhenResolutionIsFixed) {
   }
 }
 
+// Tests that the update rect of each delivered frame covers the damage reported
+// since the previously delivered frame, including the damage of frames whose
+// capture failed, and covers the whole frame when the damage is unknown.
+TEST(VideoCaptureOracleTest, ReportsDamageSinceLastDeliveredFrame) {
+  const gfx::Rect frame_rect(Get720pSize());
+  const base::TimeDelta event_increment = Get30HzPeriod() * 2;
+
+  VideoCaptureOracle oracle(false);
+  oracle.SetMinCapturePeriod(Get30HzPeriod());
+  oracle.SetCaptureSizeConstraints(Get720pSize(), Get720pSize(), false);
+  oracle.SetSourceSize(Get720pSize());
+
+  base::TimeTicks t = InitialTestTimeTicks();
+  base::TimeTicks ignored;
+  const struct {
+    VideoCaptureOracle::Event event;
+    gfx::Rect damage_rect;
+    bool capture_was_successful;
+    gfx::Rect expected_update_rect;
+  } kFrames[] = {
+      // The first frame is always whole.
+      {VideoCaptureOracle::kCompositorUpdate, gfx::Rect(10, 10, 20, 20), true,
+       frame_rect},
+      // Damage grows by one pixel, and is clipped to the frame.
+      {VideoCaptureOracle::kCompositorUpdate, gfx::Rect(100, 100, 10, 10),
+       true, gfx::Rect(99, 99, 12, 12)},
+      {VideoCaptureOracle::kCompositorUpdate, gfx::Rect(200, 0, 10, 10), false,
+       gfx::Rect()},
+      {VideoCaptureOracle::kCompositorUpdate, gfx::Rect(0, 300, 10, 10), true,
+       gfx::Rect(0, 0, 211, 311)},
+      // Unknown damage.
+      {VideoCaptureOracle::kCompositorUpdate, gfx::Rect(), true, frame_rect},
+      {VideoCaptureOracle::kMouseCursorUpdate, gfx::Rect(), true, frame_rect},
+      // Nothing changed since the last frame.
+      {VideoCaptureOracle::kPassiveRefreshRequest, gfx::Rect(), true,
+       gfx::Rect()},
+      {VideoCaptureOracle::kActiveRefreshRequest, gfx::Rect(), true,
+       frame_rect},
+  };
+  int expected_capture_counter = 0;
+  for (const auto& frame : kFrames) {
+    SCOPED_TRACE(::testing::Message()
+                 << VideoCaptureOracle::EventAsString(frame.event) << " "
+                 << frame.damage_rect.ToString());
+    t += event_increment;
+    ASSERT_TRUE(
+        oracle.ObserveEventAndDecideCapture(frame.event, frame.damage_rect, t));
+    const int frame_number = oracle.next_frame_number();
+    oracle.RecordCapture(0.0);
+    ASSERT_EQ(frame.capture_was_successful,
+              oracle.CompleteCapture(frame_number,
+                                     frame.capture_was_successful, &ignored));
+    if (!frame.capture_was_successful)
+      continue;
+    EXPECT_EQ(frame.expected_update_rect, oracle.update_rect());
+    EXPECT_EQ(expected_capture_counter++, oracle.capture_counter());
+  }
+}
+
+// Tests that damage is mapped from source to capture coordinates, and that a
+// change in capture size invalidates the whole frame.
+TEST(VideoCaptureOracleTest, ScalesDamageToCaptureSize) {
+  const gfx::Size capture_size(960, 540);
+  const base::TimeDelta event_increment = Get30HzPeriod() * 2;
+
+  VideoCaptureOracle oracle(false);
+  oracle.SetMinCapturePeriod(Get30HzPeriod());
+  oracle.SetCaptureSizeConstraints(capture_size, capture_size, false);
+  oracle.SetSourceSize(Get1080pSize());
+
+  base::TimeTicks t = InitialTestTimeTicks();
+  base::TimeTicks ignored;
+  for (int i = 0; i < 2; ++i) {
+    t += event_increment;
+    ASSERT_TRUE(oracle.ObserveEventAndDecideCapture(
+        VideoCaptureOracle::kCompositorUpdate, gfx::Rect(300, 300, 30, 30), t));
+    ASSERT_EQ(capture_size, oracle.capture_size());
+    const int frame_number = oracle.next_frame_number();
+    oracle.RecordCapture(0.0);
+    ASSERT_TRUE(oracle.CompleteCapture(frame_number, true, &ignored));
+  }
+  EXPECT_EQ(gfx::Rect(149, 149, 17, 17), oracle.update_rect());
+
+  // The source size change causes the next frame to be whole.
+  oracle.SetSourceSize(Get720pSize());
+  t += event_increment;
+  ASSERT_TRUE(oracle.ObserveEventAndDecideCapture(
+      VideoCaptureOracle::kCompositorUpdate, gfx::Rect(300, 300, 30, 30), t));
+  const int frame_number = oracle.next_frame_number();
+  oracle.RecordCapture(0.0);
+  ASSERT_TRUE(oracle.CompleteCapture(frame_number, true, &ignored));
+  EXPECT_EQ(gfx::Rect(oracle.capture_size()), oracle.update_rect());
+}
+
+namespace {
+
+// A phase of a recorded utilization trace: for |seconds|, each frame costs
+// |overhead| plus |cost_per_megapixel| per megapixel per second of utilization.
+struct UtilizationTracePhase {
+  int seconds;
+  double overhead;
+  double cost_per_megapixel;
+};
+
+// Feeds |phase| of a utilization trace through |oracle| as consumer feedback,
+// with compositor updates at 30 FPS.  Returns the capture sizes of the frames
+// captured, in order.
+std::vector<gfx::Size> RunUtilizationTracePhase(
+    const UtilizationTracePhase& phase,
+    VideoCaptureOracle* oracle,
+    base::TimeTicks* t) {
+  std::vector<gfx::Size> captured_sizes;
+  const base::TimeTicks end_t =
+      *t + base::TimeDelta::FromSeconds(phase.seconds);
+  for (; *t < end_t; *t += Get30HzPeriod()) {
+    if (!oracle->ObserveEventAndDecideCapture(
+            VideoCaptureOracle::kCompositorUpdate, gfx::Rect(), *t)) {
+      continue;
+    }
+    const gfx::Size size = oracle->capture_size();
+    captured_sizes.push_back(size);
+    const int frame_number = oracle->next_frame_number();
+    oracle->RecordCapture(0.25);
+    base::TimeTicks ignored;
+    EXPECT_TRUE(oracle->CompleteCapture(frame_number, true, &ignored));
+    const double pixel_rate =
+        size.GetArea() / oracle->estimated_frame_duration().InSecondsF();
+    oracle->RecordConsumerFeedback(
+        frame_number,
+        phase.overhead + phase.cost_per_megapixel * pixel_rate / 1000000.0);
+  }
+  return captured_sizes;
+}
+
+}  // namespace
+
+// Tests that, with model-based throttling, the capture size follows changes in
+// consumer load within a few frames, settles on the largest sustainable size,
+// and that the frame rate is lowered when no size is sustainable.
+TEST(VideoCaptureOracleTest, ModelBasedThrottlingFollowsUtilizationTrace) {
+  base::test::ScopedFeatureList feature_list;
+  feature_list.InitAndEnableFeature(kModelBasedCaptureThrottling);
+
+  VideoCaptureOracle oracle(true);
+  oracle.SetMinCapturePeriod(Get30HzPeriod());
+  oracle.SetCaptureSizeConstraints(GetSmallestNonEmptySize(), Get720pSize(),
+                                   false);
+  oracle.SetSourceSize(Get1080pSize());
+
+  // 720p at 30 FPS is 27.6 megapixels per second.
+  const UtilizationTracePhase kLight = {5, 0.05, 0.02};  // 720p: 60%.
+  const UtilizationTracePhase kHeavy = {5, 0.05, 0.06};  // 720p: 171%.
+  // Even 160x90 at 30 FPS is at 870%.
+  const UtilizationTracePhase kOverload = {5, 0.05, 20.0};
+  base::TimeTicks t = InitialTestTimeTicks();
+
+  std::vector<gfx::Size> sizes = RunUtilizationTracePhase(kLight, &oracle, &t);
+  EXPECT_EQ(Get720pSize(), sizes.back());
+  for (size_t i = 10; i < sizes.size(); ++i)
+    ASSERT_EQ(Get720pSize(), sizes[i]) << "frame " << i;
+
+  // The size steps down within half a second, and stays at a size whose
+  // utilization is sustainable for the rest of the phase.
+  sizes = RunUtilizationTracePhase(kHeavy, &oracle, &t);
+  ASSERT_GT(sizes.size(), 15u);
+  EXPECT_LT(sizes[15].GetArea(), Get720pSize().GetArea());
+  const gfx::Size heavy_size = sizes.back();
+  const double heavy_utilization =
+      kHeavy.overhead +
+      kHeavy.cost_per_megapixel * heavy_size.GetArea() * 30 / 1000000.0;
+  EXPECT_LE(heavy_utilization, 0.9);
+  EXPECT_GE(heavy_utilization, 0.3);
+  for (size_t i = sizes.size() - 60; i < sizes.size(); ++i)
+    ASSERT_EQ(heavy_size, sizes[i]) << "frame " << i;
+
+  // Once the load is gone, the size is restored within a second.
+  sizes = RunUtilizationTracePhase(kLight, &oracle, &t);
+  ASSERT_GT(sizes.size(), 30u);
+  EXPECT_EQ(Get720pSize(), sizes[30]);
+  EXPECT_EQ(Get720pSize(), sizes.back());
+
+  // Under overload, frames are captured less often than 30 FPS.
+  sizes = RunUtilizationTracePhase(kOverload, &oracle, &t);
+  EXPECT_LT(sizes.size(), 5u * 15);
+  EXPECT_GE(sizes.size(), 5u * 4);
+}
+
+// Tests that the model-based throttling does not change anything when the
+// feature is disabled.
+TEST(VideoCaptureOracleTest, ModelBasedThrottlingIsDisabledByDefault) {
+  VideoCaptureOracle oracle(true);
+  oracle.SetMinCapturePeriod(Get30HzPeriod());
+  oracle.SetCaptureSizeConstraints(GetSmallestNonEmptySize(), Get720pSize(),
+                                   false);
+  oracle.SetSourceSize(Get1080pSize());
+
+  // The heuristic only steps down after a few seconds of overload.
+  const UtilizationTracePhase kHeavy = {1, 0.05, 0.06};
+  base::TimeTicks t = InitialTestTimeTicks();
+  const std::vector<gfx::Size> sizes =
+      RunUtilizationTracePhase(kHeavy, &oracle, &t);
+  for (const gfx::Size& size : sizes)
+    ASSERT_EQ(Get720pSize(), size);
+}
+
 }  // namespace media
@@ -5,25 +5,36 @@
 #include "media/capture/video/file_video_capture_device.h"
 
 #include <stddef.h>
+
+#include <algorithm>
 #include <utility>
+#include <vector>
 
 #include "base/bind.h"
+#include "base/files/memory_mapped_file.h"
 #include "base/location.h"
 #include "base/macros.h"
+#include "base/process/process_metrics.h"
 #include "base/single_thread_task_runner.h"
 #include "base/strings/string_number_conversions.h"
 #include "base/strings/string_piece.h"
 #include "base/strings/string_util.h"
 #include "base/threading/thread_task_runner_handle.h"
+#include "build/build_config.h"
 #include "media/capture/video_capture_types.h"
 #include "media/filters/jpeg_parser.h"
 
+#if defined(OS_POSIX)
+#include <sys/mman.h>
+#endif
+
 namespace media {
 
 static const int kY4MHeaderMaxSize = 200;
 static const char kY4MSimpleFrameDelimiter[] = "FRAME";
 static const int kY4MSimpleFrameDelimiterSize = 6;
 static const float kMJpegFrameRate = 30.0f;
+static const float kRawFrameRate = 30.0f;
 
 int ParseY4MInt(const base::StringPiece& token) {
   int temp_int;
@@ -108,37 +119,58 @@ void ParseY4MTags(const std::string& file_header,
   *video_format = format;
 }
 
+// Maps a whole video file into memory and indexes its frames up front, so that
+// frames can be handed out as pointers into the mapping, in a loop, without
+// reading, copying or re-parsing them on the capture thread.
 class VideoFileParser {
  public:
   explicit VideoFileParser(const base::FilePath& file_path);
   virtual ~VideoFileParser();
 
-  // Parses file header and collects format information in |capture_format|.
-  virtual bool Initialize(media::VideoCaptureFormat* capture_format) = 0;
+  // Maps the file, parses its header and indexes all frames. Collects format
+  // information in |capture_format|.
+  bool Initialize(media::VideoCaptureFormat* capture_format);
 
   // Gets the start pointer of next frame and stores current frame size in
-  // |frame_size|.
-  virtual const uint8_t* GetNextFrame(int* frame_size) = 0;
+  // |frame_size|. Wraps around to the first frame after the last one.
+  const uint8_t* GetNextFrame(int* frame_size);
+
+  size_t num_frames() const { return frames_.size(); }
 
  protected:
+  struct Frame {
+    size_t offset;
+    size_t size;
+  };
+
+  // Parses the mapped file in |data|, fills in |frames_| and collects format
+  // information in |capture_format|.
+  virtual bool ParseFile(const uint8_t* data,
+                         size_t length,
+                         media::VideoCaptureFormat* capture_format) = 0;
+
   const base::FilePath file_path_;
-  int frame_size_;
-  size_t current_byte_index_;
-  size_t first_frame_byte_index_;
+  std::vector<Frame> frames_;
+
+ private:
+  // Asks the OS to start paging in frame |index| if it isn't resident yet, so
+  // that large frames don't fault in page by page when they are read.
+  void PrefetchFrame(size_t index);
+
+  base::MemoryMappedFile mapped_file_;
+  size_t next_frame_index_;
 };
 
 class Y4mFileParser final : public VideoFileParser {
  public:
   explicit Y4mFileParser(const base::FilePath& file_path);
-
-  // VideoFileParser implementation, class methods.
   ~Y4mFileParser() override;
-  bool Initialize(media::VideoCaptureFormat* capture_format) override;
-  const uint8_t* GetNextFrame(int* frame_size) override;
 
  private:
-  std::unique_ptr<base::File> file_;
-  std::unique_ptr<uint8_t[]> video_frame_;
+  // VideoFileParser implementation.
+  bool ParseFile(const uint8_t* data,
+                 size_t length,
+                 media::VideoCaptureFormat* capture_format) override;
 
   DISALLOW_COPY_AND_ASSIGN(Y4mFileParser);
 };
@@ -146,73 +178,104 @@ class Y4mFileParser final : public VideoFileParser {
 class MjpegFileParser final : public VideoFileParser {
  public:
   explicit MjpegFileParser(const base::FilePath& file_path);
-
-  // VideoFileParser implementation, class methods.
   ~MjpegFileParser() override;
-  bool Initialize(media::VideoCaptureFormat* capture_format) override;
-  const uint8_t* GetNextFrame(int* frame_size) override;
 
  private:
-  std::unique_ptr<base::MemoryMappedFile> mapped_file_;
+  // VideoFileParser implementation.
+  bool ParseFile(const uint8_t* data,
+                 size_t length,
+                 media::VideoCaptureFormat* capture_format) override;
 
   DISALLOW_COPY_AND_ASSIGN(MjpegFileParser);
 };
 
+// Parses headerless dumps of back-to-back I420 or NV12 frames. The frame size
+// is taken from the file name, which must end in "_<width>x<height>.i420" or
+// "_<width>x<height>.nv12", e.g. "conference_3840x2160.nv12".
+class RawFileParser final : public VideoFileParser {
+ public:
+  RawFileParser(const base::FilePath& file_path, VideoPixelFormat pixel_format);
+  ~RawFileParser() override;
+
+ private:
+  // VideoFileParser implementation.
+  bool ParseFile(const uint8_t* data,
+                 size_t length,
+                 media::VideoCaptureFormat* capture_format) override;
+
+  const VideoPixelFormat pixel_format_;
+
+  DISALLOW_COPY_AND_ASSIGN(RawFileParser);
+};
+
 VideoFileParser::VideoFileParser(const base::FilePath& file_path)
-    : file_path_(file_path),
-      frame_size_(0),
-      current_byte_index_(0),
-      first_frame_byte_index_(0) {}
+    : file_path_(file_path), next_frame_index_(0) {}
 
 VideoFileParser::~VideoFileParser() {}
 
+bool VideoFileParser::Initialize(media::VideoCaptureFormat* capture_format) {
+  if (!mapped_file_.Initialize(file_path_) || !mapped_file_.IsValid()) {
+    LOG(ERROR) << "File memory map error: " << file_path_.value();
+    return false;
+  }
+  if (!ParseFile(mapped_file_.data(), mapped_file_.length(), capture_format))
+    return false;
+  if (frames_.empty()) {
+    LOG(ERROR) << "No frames found in " << file_path_.value();
+    return false;
+  }
+  PrefetchFrame(0);
+  return true;
+}
+
+const uint8_t* VideoFileParser::GetNextFrame(int* frame_size) {
+  DCHECK(!frames_.empty());
+  const Frame& frame = frames_[next_frame_index_];
+  next_frame_index_ = (next_frame_index_ + 1) % frames_.size();
+  PrefetchFrame(next_frame_index_);
+
+  *frame_size = static_cast<int>(frame.size);
+  return mapped_file_.data() + frame.offset;
+}
+
+void VideoFileParser::PrefetchFrame(size_t index) {
+#if defined(OS_POSIX)
+  const Frame& frame = frames_[index];
+  const uintptr_t page_mask = base::GetPageSize() - 1;
+  const uintptr_t start =
+      reinterpret_cast<uintptr_t>(mapped_file_.data() + frame.offset) &
+      ~page_mask;
+  const uintptr_t end =
+      reinterpret_cast<uintptr_t>(mapped_file_.data() + frame.offset) +
+      frame.size;
+  if (madvise(reinterpret_cast<void*>(start), end - start, MADV_WILLNEED) < 0)
+    DPLOG(WARNING) << "madvise";
+#endif
+}
+
 Y4mFileParser::Y4mFileParser(const base::FilePath& file_path)
     : VideoFileParser(file_path) {}
 
 Y4mFileParser::~Y4mFileParser() {}
 
-bool Y4mFileParser::Initialize(media::VideoCaptureFormat* capture_format) {
-  file_.reset(new base::File(file_path_,
-                             base::File::FLAG_OPEN | base::File::FLAG_READ));
-  if (!file_->IsValid()) {
-    DLOG(ERROR) << file_path_.value() << ", error: "
-                << base::File::ErrorToString(file_->error_details());
-    return false;
-  }
-
-  std::string header(kY4MHeaderMaxSize, '\0');
-  file_->Read(0, &header[0], header.size());
+bool Y4mFileParser::ParseFile(const uint8_t* data,
+                              size_t length,
+                              media::VideoCaptureFormat* capture_format) {
+  const std::string header(reinterpret_cast<const char*>(data),
+                           std::min<size_t>(length, kY4MHeaderMaxSize));
   const size_t header_end = header.find(kY4MSimpleFrameDelimiter);
   CHECK_NE(header_end, header.npos);
 
   ParseY4MTags(header, capture_format);
-  first_frame_byte_index_ = header_end + kY4MSimpleFrameDelimiterSize;
-  current_byte_index_ = first_frame_byte_index_;
-  frame_size_ = capture_format->ImageAllocationSize();
-  return true;
-}
+  const size_t frame_size = capture_format->ImageAllocationSize();
 
-const uint8_t* Y4mFileParser::GetNextFrame(int* frame_size) {
-  if (!video_frame_)
-    video_frame_.reset(new uint8_t[frame_size_]);
-  int result =
-      file_->Read(current_byte_index_,
-                  reinterpret_cast<char*>(video_frame_.get()), frame_size_);
-
-  // If we passed EOF to base::File, it will return 0 read characters. In that
-  // case, reset the pointer and read again.
-  if (result != frame_size_) {
-    CHECK_EQ(result, 0);
-    current_byte_index_ = first_frame_byte_index_;
-    CHECK_EQ(
-        file_->Read(current_byte_index_,
-                    reinterpret_cast<char*>(video_frame_.get()), frame_size_),
-        frame_size_);
-  } else {
-    current_byte_index_ += frame_size_ + kY4MSimpleFrameDelimiterSize;
+  // Every frame is preceded by a trivial "FRAME\n" per-frame header.
+  for (size_t offset = header_end + kY4MSimpleFrameDelimiterSize;
+       offset + frame_size <= length;
+       offset += frame_size + kY4MSimpleFrameDelimiterSize) {
+    frames_.push_back({offset, frame_size});
   }
-  *frame_size = frame_size_;
-  return video_frame_.get();
+  return true;
 }
 
 MjpegFileParser::MjpegFileParser(const base::FilePath& file_path)
@@ -220,23 +283,12 @@ MjpegFileParser::MjpegFileParser(const base::FilePath& file_path)
 
 MjpegFileParser::~MjpegFileParser() {}
 
-bool MjpegFileParser::Initialize(media::VideoCaptureFormat* capture_format) {
-  mapped_file_.reset(new base::MemoryMappedFile());
-
-  if (!mapped_file_->Initialize(file_path_) || !mapped_file_->IsValid()) {
-    LOG(ERROR) << "File memory map error: " << file_path_.value();
-    return false;
-  }
-
+bool MjpegFileParser::ParseFile(const uint8_t* data,
+                                size_t length,
+                                media::VideoCaptureFormat* capture_format) {
   JpegParseResult result;
-  if (!ParseJpegStream(mapped_file_->data(), mapped_file_->length(), &result))
-    return false;
-
-  frame_size_ = result.image_size;
-  if (frame_size_ > static_cast<int>(mapped_file_->length())) {
-    LOG(ERROR) << "File is incomplete";
+  if (!ParseJpegStream(data, length, &result))
     return false;
-  }
 
   VideoCaptureFormat format;
   format.pixel_format = media::PIXEL_FORMAT_MJPEG;
@@ -245,24 +297,57 @@ bool MjpegFileParser::Initialize(media::VideoCaptureFormat* capture_format) {
   format.frame_rate = kMJpegFrameRate;
   if (!format.IsValid())
     return false;
+
+  // Index all the images up front; a truncated last one is ignored.
+  size_t offset = 0;
+  while (offset < length &&
+         ParseJpegStream(data + offset, length - offset, &result)) {
+    frames_.push_back({offset, result.image_size});
+    offset += result.image_size;
+  }
+
   *capture_format = format;
   return true;
 }
 
-const uint8_t* MjpegFileParser::GetNextFrame(int* frame_size) {
-  const uint8_t* buf_ptr = mapped_file_->data() + current_byte_index_;
-
-  JpegParseResult result;
-  if (!ParseJpegStream(buf_ptr, mapped_file_->length() - current_byte_index_,
-                       &result)) {
-    return nullptr;
+RawFileParser::RawFileParser(const base::FilePath& file_path,
+                             VideoPixelFormat pixel_format)
+    : VideoFileParser(file_path), pixel_format_(pixel_format) {}
+
+RawFileParser::~RawFileParser() {}
+
+bool RawFileParser::ParseFile(const uint8_t* data,
+                              size_t length,
+                              media::VideoCaptureFormat* capture_format) {
+  const std::string name =
+      file_path_.BaseName().RemoveExtension().MaybeAsASCII();
+  const size_t size_start = name.rfind('_');
+  const size_t size_divider = name.rfind('x');
+  int width = 0;
+  int height = 0;
+  if (size_start == std::string::npos || size_divider == std::string::npos ||
+      size_divider < size_start ||
+      !base::StringToInt(
+          base::StringPiece(name).substr(size_start + 1,
+                                         size_divider - size_start - 1),
+          &width) ||
+      !base::StringToInt(base::StringPiece(name).substr(size_divider + 1),
+                         &height)) {
+    LOG(ERROR) << "Raw file name must end in _<width>x<height>: " << name;
+    return false;
   }
-  *frame_size = frame_size_ = result.image_size;
-  current_byte_index_ += frame_size_;
-  // Reset the pointer to play repeatedly.
-  if (current_byte_index_ >= mapped_file_->length())
-    current_byte_index_ = first_frame_byte_index_;
-  return buf_ptr;
+
+  VideoCaptureFormat format(gfx::Size(width, height), kRawFrameRate,
+                            pixel_format_);
+  if (!format.IsValid())
+    return false;
+
+  const size_t frame_size = format.ImageAllocationSize();
+  for (size_t offset = 0; offset + frame_size <= length; offset += frame_size)
+    frames_.push_back({offset, frame_size});
+
+  *capture_format = format;
+  return true;
 }
 
 // static
@@ -287,6 +372,12 @@ std::unique_ptr<VideoFileParser> FileVideoCaptureDevice::GetVideoFileParser(
   } else if (base::EndsWith(file_name, "mjpeg",
                             base::CompareCase::INSENSITIVE_ASCII)) {
     file_parser.reset(new MjpegFileParser(file_path));
+  } else if (base::EndsWith(file_name, "i420",
+                            base::CompareCase::INSENSITIVE_ASCII)) {
+    file_parser.reset(new RawFileParser(file_path, PIXEL_FORMAT_I420));
+  } else if (base::EndsWith(file_name, "nv12",
+                            base::CompareCase::INSENSITIVE_ASCII)) {
+    file_parser.reset(new RawFileParser(file_path, PIXEL_FORMAT_NV12));
   } else {
     LOG(ERROR) << "Unsupported file format.";
     return file_parser;
@@ -298,8 +389,11 @@ std::unique_ptr<VideoFileParser> FileVideoCaptureDevice::GetVideoFileParser(
   return file_parser;
 }
 
-FileVideoCaptureDevice::FileVideoCaptureDevice(const base::FilePath& file_path)
-    : capture_thread_("CaptureThread"), file_path_(file_path) {}
+FileVideoCaptureDevice::FileVideoCaptureDevice(const base::FilePath& file_path,
+                                               PacingMode pacing_mode)
+    : capture_thread_("CaptureThread"),
+      file_path_(file_path),
+      pacing_mode_(pacing_mode) {}
 
 FileVideoCaptureDevice::~FileVideoCaptureDevice() {
   DCHECK(thread_checker_.CalledOnValidThread());
@@ -376,6 +470,14 @@ void FileVideoCaptureDevice::OnCaptureTask() {
     first_ref_time_ = current_time;
   client_->OnIncomingCapturedData(frame_ptr, frame_size, capture_format_, 0,
                                   current_time, current_time - first_ref_time_);
+
+  if (pacing_mode_ == PacingMode::kAsFastAsPossible) {
+    base::ThreadTaskRunnerHandle::Get()->PostTask(
+        FROM_HERE, base::Bind(&FileVideoCaptureDevice::OnCaptureTask,
+                              base::Unretained(this)));
+    return;
+  }
+
   // Reschedule next CaptureTask.
   const base::TimeDelta frame_interval =
       base::TimeDelta::FromMicroseconds(1E6 / capture_format_.frame_rate);
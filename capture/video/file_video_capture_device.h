@@ -10,8 +10,7 @@
 #include <memory>
 #include <string>
 
-#include "base/files/file.h"
-#include "base/files/memory_mapped_file.h"
+#include "base/files/file_path.h"
 #include "base/macros.h"
 #include "base/threading/thread.h"
 #include "base/threading/thread_checker.h"
@@ -23,15 +22,19 @@ class VideoFileParser;
 
 // Implementation of a VideoCaptureDevice class that reads from a file. Used for
 // testing the video capture pipeline when no real hardware is available. The
-// supported file formats are YUV4MPEG2 (a.k.a. Y4M) and MJPEG/JPEG. YUV4MPEG2
-// is a minimal container with a series of uncompressed video only frames, see
-// the link http://wiki.multimedia.cx/index.php?title=YUV4MPEG2 for more
-// information on the file format. Several restrictions and notes apply, see the
+// supported file formats are YUV4MPEG2 (a.k.a. Y4M), MJPEG/JPEG and raw I420 or
+// NV12 frame dumps. YUV4MPEG2 is a minimal container with a series of
+// uncompressed video only frames, see the link
+// http://wiki.multimedia.cx/index.php?title=YUV4MPEG2 for more information on
+// the file format. Several restrictions and notes apply, see the
 // implementation file.
 // Example Y4M videos can be found in http://media.xiph.org/video/derf.
 // Example MJPEG videos can be found in media/data/test/bear.mjpeg.
 // Restrictions: Y4M videos should have .y4m file extension and MJPEG videos
-// should have .mjpeg file extension.
+// should have .mjpeg file extension. Raw dumps should have .i420 or .nv12 file
+// extension and carry their frame size in the file name, e.g. foo_640x480.nv12.
+// The whole file is memory-mapped and its frames indexed when the device
+// starts, so that frames are delivered straight from the mapping.
 class CAPTURE_EXPORT FileVideoCaptureDevice : public VideoCaptureDevice {
  public:
   // Reads and parses the header of a |file_path|, returning the collected
@@ -41,9 +44,15 @@ class CAPTURE_EXPORT FileVideoCaptureDevice : public VideoCaptureDevice {
   static bool GetVideoCaptureFormat(const base::FilePath& file_path,
                                     media::VideoCaptureFormat* video_format);
 
+  // Frames are either delivered at the frame rate of the file, or back to back
+  // as fast as the capture pipeline takes them, for throughput testing.
+  enum class PacingMode { kFrameRate, kAsFastAsPossible };
+
   // Constructor of the class, with a fully qualified file path as input, which
-  // represents the Y4M or MJPEG file to stream repeatedly.
-  explicit FileVideoCaptureDevice(const base::FilePath& file_path);
+  // represents the Y4M, MJPEG or raw file to stream repeatedly.
+  explicit FileVideoCaptureDevice(
+      const base::FilePath& file_path,
+      PacingMode pacing_mode = PacingMode::kFrameRate);
 
   // VideoCaptureDevice implementation, class methods.
   ~FileVideoCaptureDevice() override;
@@ -77,6 +86,7 @@ class CAPTURE_EXPORT FileVideoCaptureDevice : public VideoCaptureDevice {
   // The following members belong to |capture_thread_|.
   std::unique_ptr<VideoCaptureDevice::Client> client_;
   const base::FilePath file_path_;
+  const PacingMode pacing_mode_;
   std::unique_ptr<VideoFileParser> file_parser_;
   VideoCaptureFormat capture_format_;
   // Target time for the next frame.
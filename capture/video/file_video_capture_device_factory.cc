@@ -30,12 +30,18 @@ std::unique_ptr<VideoCaptureDevice> FileVideoCaptureDeviceFactory::CreateDevice(
     const VideoCaptureDeviceDescriptor& device_descriptor) {
   DCHECK(thread_checker_.CalledOnValidThread());
   base::AssertBlockingAllowed();
+  const FileVideoCaptureDevice::PacingMode pacing_mode =
+      base::CommandLine::ForCurrentProcess()->HasSwitch(
+          switches::kUnthrottledFileVideoCapture)
+          ? FileVideoCaptureDevice::PacingMode::kAsFastAsPossible
+          : FileVideoCaptureDevice::PacingMode::kFrameRate;
 #if defined(OS_WIN)
   return std::unique_ptr<VideoCaptureDevice>(new FileVideoCaptureDevice(
-      base::FilePath(base::SysUTF8ToWide(device_descriptor.display_name))));
+      base::FilePath(base::SysUTF8ToWide(device_descriptor.display_name)),
+      pacing_mode));
 #else
   return std::unique_ptr<VideoCaptureDevice>(new FileVideoCaptureDevice(
-      base::FilePath(device_descriptor.display_name)));
+      base::FilePath(device_descriptor.display_name), pacing_mode));
 #endif
 }
 
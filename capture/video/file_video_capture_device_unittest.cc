@@ -0,0 +1,172 @@
+// Copyright 2017 The Chromium Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#include "media/capture/video/file_video_capture_device.h"
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include <memory>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "base/files/file_util.h"
+#include "base/files/scoped_temp_dir.h"
+#include "base/memory/ptr_util.h"
+#include "base/synchronization/waitable_event.h"
+#include "base/test/test_timeouts.h"
+#include "media/base/test_data_util.h"
+#include "media/capture/video_capture_types.h"
+#include "testing/gtest/include/gtest/gtest.h"
+
+namespace media {
+
+namespace {
+
+// Client recording the data pointer and size of the first |num_frames|
+// captured frames, signaling |done| once they have all arrived.
+class FrameRecordingClient : public VideoCaptureDevice::Client {
+ public:
+  FrameRecordingClient(size_t num_frames, base::WaitableEvent* done)
+      : num_frames_(num_frames), done_(done) {}
+
+  void OnIncomingCapturedData(const uint8_t* data,
+                              int length,
+                              const VideoCaptureFormat& format,
+                              int rotation,
+                              base::TimeTicks reference_time,
+                              base::TimeDelta timestamp,
+                              int frame_feedback_id) override {
+    if (frames_.size() == num_frames_)
+      return;
+    frames_.push_back({data, length});
+    if (frames_.size() == num_frames_)
+      done_->Signal();
+  }
+  Buffer ReserveOutputBuffer(const gfx::Size& dimensions,
+                             VideoPixelFormat format,
+                             VideoPixelStorage storage,
+                             int frame_feedback_id) override {
+    return Buffer();
+  }
+  void OnIncomingCapturedBuffer(Buffer buffer,
+                                const VideoCaptureFormat& format,
+                                base::TimeTicks reference_time,
+                                base::TimeDelta timestamp) override {}
+  void OnIncomingCapturedBufferExt(
+      Buffer buffer,
+      const VideoCaptureFormat& format,
+      base::TimeTicks reference_time,
+      base::TimeDelta timestamp,
+      gfx::Rect visible_rect,
+      const VideoFrameMetadata& additional_metadata) override {}
+  Buffer ResurrectLastOutputBuffer(const gfx::Size& dimensions,
+                                   VideoPixelFormat format,
+                                   VideoPixelStorage storage,
+                                   int frame_feedback_id) override {
+    return Buffer();
+  }
+  void OnError(const base::Location& from_here,
+               const std::string& reason) override {
+    ADD_FAILURE() << reason;
+  }
+  double GetBufferPoolUtilization() const override { return 0.0; }
+  void OnStarted() override {}
+
+  struct Frame {
+    const uint8_t* data;
+    int length;
+  };
+  // Only to be read once |done_| is signaled.
+  const std::vector<Frame>& frames() const { return frames_; }
+
+ private:
+  const size_t num_frames_;
+  base::WaitableEvent* const done_;
+  std::vector<Frame> frames_;
+};
+
+}  // namespace
+
+class FileVideoCaptureDeviceTest : public ::testing::Test {
+ protected:
+  void SetUp() override { ASSERT_TRUE(temp_dir_.CreateUniqueTempDir()); }
+
+  // Writes |num_frames| frames of |frame_size| bytes, each filled with its
+  // index, to |name| in the temporary directory.
+  base::FilePath WriteRawFile(const std::string& name,
+                              size_t frame_size,
+                              int num_frames) {
+    std::vector<char> data;
+    for (int i = 0; i < num_frames; ++i)
+      data.insert(data.end(), frame_size, static_cast<char>(i));
+    const base::FilePath path = temp_dir_.GetPath().AppendASCII(name);
+    EXPECT_EQ(static_cast<int>(data.size()),
+              base::WriteFile(path, data.data(), data.size()));
+    return path;
+  }
+
+  base::ScopedTempDir temp_dir_;
+};
+
+TEST_F(FileVideoCaptureDeviceTest, GetMjpegCaptureFormat) {
+  VideoCaptureFormat format;
+  ASSERT_TRUE(FileVideoCaptureDevice::GetVideoCaptureFormat(
+      GetTestDataFilePath("bear.mjpeg"), &format));
+  EXPECT_EQ(PIXEL_FORMAT_MJPEG, format.pixel_format);
+  EXPECT_EQ(gfx::Size(320, 192), format.frame_size);
+}
+
+TEST_F(FileVideoCaptureDeviceTest, GetRawCaptureFormat) {
+  VideoCaptureFormat format;
+  ASSERT_TRUE(FileVideoCaptureDevice::GetVideoCaptureFormat(
+      WriteRawFile("frames_32x16.nv12", 32 * 16 * 3 / 2, 2), &format));
+  EXPECT_EQ(PIXEL_FORMAT_NV12, format.pixel_format);
+  EXPECT_EQ(gfx::Size(32, 16), format.frame_size);
+
+  ASSERT_TRUE(FileVideoCaptureDevice::GetVideoCaptureFormat(
+      WriteRawFile("frames_32x16.i420", 32 * 16 * 3 / 2, 2), &format));
+  EXPECT_EQ(PIXEL_FORMAT_I420, format.pixel_format);
+
+  // The frame size must be part of the file name.
+  EXPECT_FALSE(FileVideoCaptureDevice::GetVideoCaptureFormat(
+      WriteRawFile("frames.i420", 32 * 16 * 3 / 2, 2), &format));
+  // A file shorter than one frame has no frames.
+  EXPECT_FALSE(FileVideoCaptureDevice::GetVideoCaptureFormat(
+      WriteRawFile("short_32x16.i420", 32 * 16, 1), &format));
+}
+
+// Verifies that frames are delivered in order straight from the mapped file,
+// and that the file is looped without being reopened.
+TEST_F(FileVideoCaptureDeviceTest, LoopsOverMappedFramesAsFastAsPossible) {
+  const int kNumFramesInFile = 3;
+  const size_t kFrameSize = 32 * 16 * 3 / 2;
+  const base::FilePath path =
+      WriteRawFile("frames_32x16.i420", kFrameSize, kNumFramesInFile);
+
+  base::WaitableEvent done(base::WaitableEvent::ResetPolicy::MANUAL,
+                           base::WaitableEvent::InitialState::NOT_SIGNALED);
+  auto client =
+      base::MakeUnique<FrameRecordingClient>(2 * kNumFramesInFile, &done);
+  FrameRecordingClient* const client_ptr = client.get();
+
+  FileVideoCaptureDevice device(
+      path, FileVideoCaptureDevice::PacingMode::kAsFastAsPossible);
+  device.AllocateAndStart(VideoCaptureParams(), std::move(client));
+  ASSERT_TRUE(done.TimedWait(TestTimeouts::action_max_timeout()));
+
+  const std::vector<FrameRecordingClient::Frame>& frames =
+      client_ptr->frames();
+  for (int i = 0; i < kNumFramesInFile; ++i) {
+    EXPECT_EQ(static_cast<int>(kFrameSize), frames[i].length);
+    EXPECT_EQ(i, frames[i].data[0]);
+    EXPECT_EQ(frames[i].data, frames[i + kNumFramesInFile].data);
+    if (i > 0)
+      EXPECT_EQ(frames[i - 1].data + kFrameSize, frames[i].data);
+  }
+  device.StopAndDeAllocate();
+}
+
+}  // namespace media
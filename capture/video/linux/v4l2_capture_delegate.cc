@@ -11,15 +11,21 @@
 #include <sys/ioctl.h>
 #include <sys/mman.h>
 #include <utility>
+#include <vector>
 
 #include "base/bind.h"
+#include "base/command_line.h"
+#include "base/feature_list.h"
 #include "base/files/file_enumerator.h"
 #include "base/posix/eintr_wrapper.h"
+#include "base/strings/string_number_conversions.h"
 #include "base/strings/stringprintf.h"
 #include "build/build_config.h"
 #include "media/base/bind_to_current_loop.h"
+#include "media/base/media_switches.h"
 #include "media/capture/video/blob_utils.h"
 #include "media/capture/video/linux/video_capture_device_linux.h"
+#include "media/capture/video/video_capture_buffer_handle.h"
 
 using media::mojom::MeteringMode;
 
@@ -43,6 +49,15 @@ namespace media {
 // kNumVideoBuffers should not be too small, or Chrome may not return enough
 // buffers back to driver in time.
 const uint32_t kNumVideoBuffers = 4;
+// Bounds for the number of video buffers set via --v4l2-capture-buffer-count.
+const uint32_t kMinNumVideoBuffers = 2;
+const uint32_t kMaxNumVideoBuffers = VIDEO_MAX_FRAME;
+// Default number of spare client buffers required to capture into client
+// buffers, so that consumers can hold a couple of frames without drops.
+const uint32_t kClientBufferHeadroom = 2;
+// Bounds for the headroom set via --v4l2-client-buffer-headroom.
+const uint32_t kMinClientBufferHeadroom = 1;
+const uint32_t kMaxClientBufferHeadroom = VIDEO_MAX_FRAME;
 // Timeout in milliseconds v4l2_thread_ blocks waiting for a frame from the hw.
 // This value has been fine tuned. Before changing or modifying it see
 // https://crbug.com/470717
@@ -103,18 +118,21 @@ static void FillV4L2Format(v4l2_format* format,
 }
 
 // Fills all parts of |buffer|.
-static void FillV4L2Buffer(v4l2_buffer* buffer, int index) {
+static void FillV4L2Buffer(v4l2_buffer* buffer,
+                           int index,
+                           v4l2_memory memory_type) {
   memset(buffer, 0, sizeof(*buffer));
-  buffer->memory = V4L2_MEMORY_MMAP;
+  buffer->memory = memory_type;
   buffer->index = index;
   buffer->type = V4L2_BUF_TYPE_VIDEO_CAPTURE;
 }
 
 static void FillV4L2RequestBuffer(v4l2_requestbuffers* request_buffer,
-                                  int count) {
+                                  int count,
+                                  v4l2_memory memory_type) {
   memset(request_buffer, 0, sizeof(*request_buffer));
   request_buffer->type = V4L2_BUF_TYPE_VIDEO_CAPTURE;
-  request_buffer->memory = V4L2_MEMORY_MMAP;
+  request_buffer->memory = memory_type;
   request_buffer->count = count;
 }
 
@@ -368,6 +386,45 @@ std::list<uint32_t> V4L2CaptureDelegate::GetListOfUsableFourCcs(
   return supported_formats;
 }
 
+// static
+uint32_t V4L2CaptureDelegate::GetNumVideoBuffers() {
+  const base::CommandLine* command_line =
+      base::CommandLine::ForCurrentProcess();
+  if (!command_line->HasSwitch(switches::kV4L2CaptureBufferCount))
+    return kNumVideoBuffers;
+
+  unsigned num_buffers = 0;
+  if (!base::StringToUint(
+          command_line->GetSwitchValueASCII(switches::kV4L2CaptureBufferCount),
+          &num_buffers) ||
+      num_buffers < kMinNumVideoBuffers || num_buffers > kMaxNumVideoBuffers) {
+    DLOG(WARNING) << "Invalid " << switches::kV4L2CaptureBufferCount
+                  << ", using " << kNumVideoBuffers << " buffers";
+    return kNumVideoBuffers;
+  }
+  return num_buffers;
+}
+
+// static
+uint32_t V4L2CaptureDelegate::GetClientBufferHeadroom() {
+  const base::CommandLine* command_line =
+      base::CommandLine::ForCurrentProcess();
+  if (!command_line->HasSwitch(switches::kV4L2ClientBufferHeadroom))
+    return kClientBufferHeadroom;
+
+  unsigned headroom = 0;
+  if (!base::StringToUint(command_line->GetSwitchValueASCII(
+                              switches::kV4L2ClientBufferHeadroom),
+                          &headroom) ||
+      headroom < kMinClientBufferHeadroom ||
+      headroom > kMaxClientBufferHeadroom) {
+    DLOG(WARNING) << "Invalid " << switches::kV4L2ClientBufferHeadroom
+                  << ", using " << kClientBufferHeadroom << " buffers";
+    return kClientBufferHeadroom;
+  }
+  return headroom;
+}
+
 V4L2CaptureDelegate::V4L2CaptureDelegate(
     const VideoCaptureDeviceDescriptor& device_descriptor,
     const scoped_refptr<base::SingleThreadTaskRunner>& v4l2_task_runner,
@@ -375,6 +432,7 @@ V4L2CaptureDelegate::V4L2CaptureDelegate(
     : v4l2_task_runner_(v4l2_task_runner),
       device_descriptor_(device_descriptor),
       power_line_frequency_(power_line_frequency),
+      use_client_buffers_(false),
       is_capturing_(false),
       timeout_count_(0),
       rotation_(0),
@@ -400,7 +458,7 @@ void V4L2CaptureDelegate::AllocateAndStart(
   ResetUserAndCameraControlsToDefault(device_fd_.get());
 
   v4l2_capability cap = {};
-  if (!((HANDLE_EINTR(ioctl(device_fd_.get(), VIDIOC_QUERYCAP, &cap)) == 0) &&
+  if (!((HANDLE_EINTR(DoIoctl(VIDIOC_QUERYCAP, &cap)) == 0) &&
         ((cap.capabilities & V4L2_CAP_VIDEO_CAPTURE) &&
          !(cap.capabilities & V4L2_CAP_VIDEO_OUTPUT)))) {
     device_fd_.reset();
@@ -416,7 +474,7 @@ void V4L2CaptureDelegate::AllocateAndStart(
 
   v4l2_fmtdesc fmtdesc = {};
   fmtdesc.type = V4L2_BUF_TYPE_VIDEO_CAPTURE;
-  for (; HANDLE_EINTR(ioctl(device_fd_.get(), VIDIOC_ENUM_FMT, &fmtdesc)) == 0;
+  for (; HANDLE_EINTR(DoIoctl(VIDIOC_ENUM_FMT, &fmtdesc)) == 0;
        ++fmtdesc.index) {
     best = std::find(desired_v4l2_formats.begin(), best, fmtdesc.pixelformat);
   }
@@ -428,7 +486,7 @@ void V4L2CaptureDelegate::AllocateAndStart(
   DVLOG(1) << "Chosen pixel format is " << FourccToString(*best);
   FillV4L2Format(&video_fmt_, width, height, *best);
 
-  if (HANDLE_EINTR(ioctl(device_fd_.get(), VIDIOC_S_FMT, &video_fmt_)) < 0) {
+  if (HANDLE_EINTR(DoIoctl(VIDIOC_S_FMT, &video_fmt_)) < 0) {
     SetErrorState(FROM_HERE, "Failed to set video capture format");
     return;
   }
@@ -443,7 +501,7 @@ void V4L2CaptureDelegate::AllocateAndStart(
   v4l2_streamparm streamparm = {};
   streamparm.type = V4L2_BUF_TYPE_VIDEO_CAPTURE;
   // The following line checks that the driver knows about framerate get/set.
-  if (HANDLE_EINTR(ioctl(device_fd_.get(), VIDIOC_G_PARM, &streamparm)) >= 0) {
+  if (HANDLE_EINTR(DoIoctl(VIDIOC_G_PARM, &streamparm)) >= 0) {
     // Now check if the device is able to accept a capture framerate set.
     if (streamparm.parm.capture.capability & V4L2_CAP_TIMEPERFRAME) {
       // |frame_rate| is float, approximate by a fraction.
@@ -453,8 +511,7 @@ void V4L2CaptureDelegate::AllocateAndStart(
           (frame_rate) ? (frame_rate * media::kFrameRatePrecision)
                        : (kTypicalFramerate * media::kFrameRatePrecision);
 
-      if (HANDLE_EINTR(ioctl(device_fd_.get(), VIDIOC_S_PARM, &streamparm)) <
-          0) {
+      if (HANDLE_EINTR(DoIoctl(VIDIOC_S_PARM, &streamparm)) < 0) {
         SetErrorState(FROM_HERE, "Failed to set camera framerate");
         return;
       }
@@ -475,7 +532,7 @@ void V4L2CaptureDelegate::AllocateAndStart(
     control.id = V4L2_CID_POWER_LINE_FREQUENCY;
     control.value = power_line_frequency_;
     const int retval =
-        HANDLE_EINTR(ioctl(device_fd_.get(), VIDIOC_S_CTRL, &control));
+        HANDLE_EINTR(DoIoctl(VIDIOC_S_CTRL, &control));
     if (retval != 0)
       DVLOG(1) << "Error setting power line frequency removal";
   }
@@ -485,22 +542,11 @@ void V4L2CaptureDelegate::AllocateAndStart(
   capture_format_.frame_rate = frame_rate;
   capture_format_.pixel_format = pixel_format;
 
-  v4l2_requestbuffers r_buffer;
-  FillV4L2RequestBuffer(&r_buffer, kNumVideoBuffers);
-  if (HANDLE_EINTR(ioctl(device_fd_.get(), VIDIOC_REQBUFS, &r_buffer)) < 0) {
-    SetErrorState(FROM_HERE, "Error requesting MMAP buffers from V4L2");
+  if (!AllocateVideoBuffers())
     return;
-  }
-  for (unsigned int i = 0; i < r_buffer.count; ++i) {
-    if (!MapAndQueueBuffer(i)) {
-      SetErrorState(FROM_HERE, "Allocate buffer failed");
-      return;
-    }
-  }
 
   v4l2_buf_type capture_type = V4L2_BUF_TYPE_VIDEO_CAPTURE;
-  if (HANDLE_EINTR(ioctl(device_fd_.get(), VIDIOC_STREAMON, &capture_type)) <
-      0) {
+  if (HANDLE_EINTR(DoIoctl(VIDIOC_STREAMON, &capture_type)) < 0) {
     SetErrorState(FROM_HERE, "VIDIOC_STREAMON failed");
     return;
   }
@@ -518,18 +564,19 @@ void V4L2CaptureDelegate::StopAndDeAllocate() {
   // The order is important: stop streaming, clear |buffer_pool_|,
   // thus munmap()ing the v4l2_buffers, and then return them to the OS.
   v4l2_buf_type capture_type = V4L2_BUF_TYPE_VIDEO_CAPTURE;
-  if (HANDLE_EINTR(ioctl(device_fd_.get(), VIDIOC_STREAMOFF, &capture_type)) <
-      0) {
+  if (HANDLE_EINTR(DoIoctl(VIDIOC_STREAMOFF, &capture_type)) < 0) {
     SetErrorState(FROM_HERE, "VIDIOC_STREAMOFF failed");
     return;
   }
 
   buffer_tracker_pool_.clear();
+  client_buffers_.clear();
 
   v4l2_requestbuffers r_buffer;
-  FillV4L2RequestBuffer(&r_buffer, 0);
-  if (HANDLE_EINTR(ioctl(device_fd_.get(), VIDIOC_REQBUFS, &r_buffer)) < 0)
+  FillV4L2RequestBuffer(&r_buffer, 0, memory_type());
+  if (HANDLE_EINTR(DoIoctl(VIDIOC_REQBUFS, &r_buffer)) < 0)
     SetErrorState(FROM_HERE, "Failed to VIDIOC_REQBUFS with count = 0");
+  use_client_buffers_ = false;
 
   // At this point we can close the device.
   // This is also needed for correctly changing settings later via VIDIOC_S_FMT.
@@ -570,8 +617,7 @@ void V4L2CaptureDelegate::GetPhotoState(
   photo_capabilities->current_focus_mode = MeteringMode::NONE;
   v4l2_control auto_focus_current = {};
   auto_focus_current.id = V4L2_CID_FOCUS_AUTO;
-  if (HANDLE_EINTR(
-          ioctl(device_fd_.get(), VIDIOC_G_CTRL, &auto_focus_current)) >= 0) {
+  if (HANDLE_EINTR(DoIoctl(VIDIOC_G_CTRL, &auto_focus_current)) >= 0) {
     photo_capabilities->current_focus_mode = auto_focus_current.value
                                                  ? MeteringMode::CONTINUOUS
                                                  : MeteringMode::MANUAL;
@@ -589,8 +635,7 @@ void V4L2CaptureDelegate::GetPhotoState(
   photo_capabilities->current_exposure_mode = MeteringMode::NONE;
   v4l2_control exposure_current = {};
   exposure_current.id = V4L2_CID_EXPOSURE_AUTO;
-  if (HANDLE_EINTR(ioctl(device_fd_.get(), VIDIOC_G_CTRL, &exposure_current)) >=
-      0) {
+  if (HANDLE_EINTR(DoIoctl(VIDIOC_G_CTRL, &exposure_current)) >= 0) {
     photo_capabilities->current_exposure_mode =
         exposure_current.value == V4L2_EXPOSURE_MANUAL
             ? MeteringMode::MANUAL
@@ -617,7 +662,7 @@ void V4L2CaptureDelegate::GetPhotoState(
   photo_capabilities->current_white_balance_mode = MeteringMode::NONE;
   v4l2_control white_balance_current = {};
   white_balance_current.id = V4L2_CID_AUTO_WHITE_BALANCE;
-  if (HANDLE_EINTR(ioctl(device_fd_.get(), VIDIOC_G_CTRL,
+  if (HANDLE_EINTR(DoIoctl(VIDIOC_G_CTRL,
                          &white_balance_current)) >= 0) {
     photo_capabilities->current_white_balance_mode =
         white_balance_current.value ? MeteringMode::CONTINUOUS
@@ -657,7 +702,7 @@ void V4L2CaptureDelegate::SetPhotoOptions(
     v4l2_control zoom_current = {};
     zoom_current.id = V4L2_CID_ZOOM_ABSOLUTE;
     zoom_current.value = settings->zoom;
-    if (HANDLE_EINTR(ioctl(device_fd_.get(), VIDIOC_S_CTRL, &zoom_current)) < 0)
+    if (HANDLE_EINTR(DoIoctl(VIDIOC_S_CTRL, &zoom_current)) < 0)
       DPLOG(ERROR) << "setting zoom to " << settings->zoom;
   }
 
@@ -668,20 +713,20 @@ void V4L2CaptureDelegate::SetPhotoOptions(
     white_balance_set.id = V4L2_CID_AUTO_WHITE_BALANCE;
     white_balance_set.value =
         settings->white_balance_mode == mojom::MeteringMode::CONTINUOUS;
-    HANDLE_EINTR(ioctl(device_fd_.get(), VIDIOC_S_CTRL, &white_balance_set));
+    HANDLE_EINTR(DoIoctl(VIDIOC_S_CTRL, &white_balance_set));
   }
 
   if (settings->has_color_temperature) {
     v4l2_control auto_white_balance_current = {};
     auto_white_balance_current.id = V4L2_CID_AUTO_WHITE_BALANCE;
-    const int result = HANDLE_EINTR(
-        ioctl(device_fd_.get(), VIDIOC_G_CTRL, &auto_white_balance_current));
+    const int result =
+        HANDLE_EINTR(DoIoctl(VIDIOC_G_CTRL, &auto_white_balance_current));
     // Color temperature can only be applied if Auto White Balance is off.
     if (result >= 0 && !auto_white_balance_current.value) {
       v4l2_control set_temperature = {};
       set_temperature.id = V4L2_CID_WHITE_BALANCE_TEMPERATURE;
       set_temperature.value = settings->color_temperature;
-      HANDLE_EINTR(ioctl(device_fd_.get(), VIDIOC_S_CTRL, &set_temperature));
+      HANDLE_EINTR(DoIoctl(VIDIOC_S_CTRL, &set_temperature));
     }
   }
 
@@ -694,20 +739,20 @@ void V4L2CaptureDelegate::SetPhotoOptions(
         settings->exposure_mode == mojom::MeteringMode::CONTINUOUS
             ? V4L2_EXPOSURE_APERTURE_PRIORITY
             : V4L2_EXPOSURE_MANUAL;
-    HANDLE_EINTR(ioctl(device_fd_.get(), VIDIOC_S_CTRL, &exposure_mode_set));
+    HANDLE_EINTR(DoIoctl(VIDIOC_S_CTRL, &exposure_mode_set));
   }
 
   if (settings->has_exposure_compensation) {
     v4l2_control auto_exposure_current = {};
     auto_exposure_current.id = V4L2_CID_EXPOSURE_AUTO;
-    const int result = HANDLE_EINTR(
-        ioctl(device_fd_.get(), VIDIOC_G_CTRL, &auto_exposure_current));
+    const int result =
+        HANDLE_EINTR(DoIoctl(VIDIOC_G_CTRL, &auto_exposure_current));
     // Exposure Compensation can only be applied if Auto Exposure is off.
     if (result >= 0 && auto_exposure_current.value == V4L2_EXPOSURE_MANUAL) {
       v4l2_control set_exposure = {};
       set_exposure.id = V4L2_CID_EXPOSURE_ABSOLUTE;
       set_exposure.value = settings->exposure_compensation;
-      HANDLE_EINTR(ioctl(device_fd_.get(), VIDIOC_S_CTRL, &set_exposure));
+      HANDLE_EINTR(DoIoctl(VIDIOC_S_CTRL, &set_exposure));
     }
   }
 
@@ -715,28 +760,28 @@ void V4L2CaptureDelegate::SetPhotoOptions(
     v4l2_control current = {};
     current.id = V4L2_CID_BRIGHTNESS;
     current.value = settings->brightness;
-    if (HANDLE_EINTR(ioctl(device_fd_.get(), VIDIOC_S_CTRL, &current)) < 0)
+    if (HANDLE_EINTR(DoIoctl(VIDIOC_S_CTRL, &current)) < 0)
       DPLOG(ERROR) << "setting brightness to " << settings->brightness;
   }
   if (settings->has_contrast) {
     v4l2_control current = {};
     current.id = V4L2_CID_CONTRAST;
     current.value = settings->contrast;
-    if (HANDLE_EINTR(ioctl(device_fd_.get(), VIDIOC_S_CTRL, &current)) < 0)
+    if (HANDLE_EINTR(DoIoctl(VIDIOC_S_CTRL, &current)) < 0)
       DPLOG(ERROR) << "setting contrast to " << settings->contrast;
   }
   if (settings->has_saturation) {
     v4l2_control current = {};
     current.id = V4L2_CID_SATURATION;
     current.value = settings->saturation;
-    if (HANDLE_EINTR(ioctl(device_fd_.get(), VIDIOC_S_CTRL, &current)) < 0)
+    if (HANDLE_EINTR(DoIoctl(VIDIOC_S_CTRL, &current)) < 0)
       DPLOG(ERROR) << "setting saturation to " << settings->saturation;
   }
   if (settings->has_sharpness) {
     v4l2_control current = {};
     current.id = V4L2_CID_SHARPNESS;
     current.value = settings->sharpness;
-    if (HANDLE_EINTR(ioctl(device_fd_.get(), VIDIOC_S_CTRL, &current)) < 0)
+    if (HANDLE_EINTR(DoIoctl(VIDIOC_S_CTRL, &current)) < 0)
       DPLOG(ERROR) << "setting sharpness to " << settings->sharpness;
   }
 
@@ -755,11 +800,42 @@ base::WeakPtr<V4L2CaptureDelegate> V4L2CaptureDelegate::GetWeakPtr() {
 
 V4L2CaptureDelegate::~V4L2CaptureDelegate() {}
 
+int V4L2CaptureDelegate::DoIoctl(int request, void* argp) {
+  if (!ioctl_for_testing_.is_null())
+    return ioctl_for_testing_.Run(request, argp);
+  return ioctl(device_fd_.get(), request, argp);
+}
+
+bool V4L2CaptureDelegate::AllocateVideoBuffers() {
+  const uint32_t num_buffers = GetNumVideoBuffers();
+  use_client_buffers_ =
+      base::FeatureList::IsEnabled(kV4L2CaptureIntoClientBuffers) &&
+      CanCaptureIntoClientBuffers() && AllocateClientBuffers(num_buffers);
+  if (use_client_buffers_) {
+    client_->OnLog("Capturing into client buffers (USERPTR)");
+    return true;
+  }
+
+  v4l2_requestbuffers r_buffer;
+  FillV4L2RequestBuffer(&r_buffer, num_buffers, V4L2_MEMORY_MMAP);
+  if (HANDLE_EINTR(DoIoctl(VIDIOC_REQBUFS, &r_buffer)) < 0) {
+    SetErrorState(FROM_HERE, "Error requesting MMAP buffers from V4L2");
+    return false;
+  }
+  for (unsigned int i = 0; i < r_buffer.count; ++i) {
+    if (!MapAndQueueBuffer(i)) {
+      SetErrorState(FROM_HERE, "Allocate buffer failed");
+      return false;
+    }
+  }
+  return true;
+}
+
 bool V4L2CaptureDelegate::MapAndQueueBuffer(int index) {
   v4l2_buffer buffer;
-  FillV4L2Buffer(&buffer, index);
+  FillV4L2Buffer(&buffer, index, V4L2_MEMORY_MMAP);
 
-  if (HANDLE_EINTR(ioctl(device_fd_.get(), VIDIOC_QUERYBUF, &buffer)) < 0) {
+  if (HANDLE_EINTR(DoIoctl(VIDIOC_QUERYBUF, &buffer)) < 0) {
     DLOG(ERROR) << "Error querying status of a MMAP V4L2 buffer";
     return false;
   }
@@ -772,13 +848,127 @@ bool V4L2CaptureDelegate::MapAndQueueBuffer(int index) {
   buffer_tracker_pool_.push_back(buffer_tracker);
 
   // Enqueue the buffer in the drivers incoming queue.
-  if (HANDLE_EINTR(ioctl(device_fd_.get(), VIDIOC_QBUF, &buffer)) < 0) {
+  if (HANDLE_EINTR(DoIoctl(VIDIOC_QBUF, &buffer)) < 0) {
     DLOG(ERROR) << "Error enqueuing a V4L2 buffer back into the driver";
     return false;
   }
   return true;
 }
 
+bool V4L2CaptureDelegate::CanCaptureIntoClientBuffers() const {
+  const gfx::Size& size = capture_format_.frame_size;
+  return capture_format_.pixel_format == PIXEL_FORMAT_I420 &&
+         size.width() % 2 == 0 && size.height() % 2 == 0 &&
+         video_fmt_.fmt.pix.bytesperline ==
+             static_cast<uint32_t>(size.width()) &&
+         video_fmt_.fmt.pix.sizeimage <= capture_format_.ImageAllocationSize();
+}
+
+bool V4L2CaptureDelegate::AllocateClientBuffers(uint32_t num_buffers) {
+  v4l2_requestbuffers r_buffer;
+  FillV4L2RequestBuffer(&r_buffer, num_buffers, V4L2_MEMORY_USERPTR);
+  if (HANDLE_EINTR(DoIoctl(VIDIOC_REQBUFS, &r_buffer)) < 0) {
+    DVLOG(1) << "V4L2 driver does not support USERPTR buffers";
+    return false;
+  }
+
+  client_buffers_.resize(r_buffer.count);
+  for (unsigned int i = 0; i < r_buffer.count; ++i) {
+    if (!ReserveClientBuffer(i) || !QueueClientBuffer(i)) {
+      DVLOG(1) << "Could not lend " << r_buffer.count
+               << " client buffers to the driver";
+      ReleaseClientBuffers();
+      return false;
+    }
+  }
+
+  // DeliverClientBuffer() swaps each filled buffer for a newly reserved one,
+  // and drops the frame if there is none, so without spares every frame would
+  // be dropped.
+  const uint32_t headroom = GetClientBufferHeadroom();
+  if (!HasSpareClientBuffers(headroom)) {
+    DVLOG(1) << "Fewer than " << headroom << " client buffers to spare";
+    ReleaseClientBuffers();
+    return false;
+  }
+  return true;
+}
+
+bool V4L2CaptureDelegate::HasSpareClientBuffers(uint32_t num_spares) {
+  std::vector<VideoCaptureDevice::Client::Buffer> spares;
+  for (uint32_t i = 0; i < num_spares; ++i) {
+    spares.push_back(ReserveClientOutputBuffer());
+    if (!spares.back().is_valid())
+      return false;
+  }
+  return true;
+}
+
+VideoCaptureDevice::Client::Buffer
+V4L2CaptureDelegate::ReserveClientOutputBuffer() {
+  // The driver, not the client, picks the frame that lands in each buffer, so
+  // there is no feedback id to reserve it for.  As with the frames delivered
+  // through OnIncomingCapturedData(), it is always 0.
+  return client_->ReserveOutputBuffer(capture_format_.frame_size,
+                                      PIXEL_FORMAT_I420, PIXEL_STORAGE_CPU,
+                                      0 /* frame_feedback_id */);
+}
+
+void V4L2CaptureDelegate::ReleaseClientBuffers() {
+  // Dropping the buffers queued so far before returning them to the driver is
+  // fine since streaming hasn't started yet.
+  client_buffers_.clear();
+  v4l2_requestbuffers r_buffer;
+  FillV4L2RequestBuffer(&r_buffer, 0, V4L2_MEMORY_USERPTR);
+  if (HANDLE_EINTR(DoIoctl(VIDIOC_REQBUFS, &r_buffer)) < 0)
+    DPLOG(ERROR) << "Failed to VIDIOC_REQBUFS USERPTR with count = 0";
+}
+
+bool V4L2CaptureDelegate::ReserveClientBuffer(int index) {
+  VideoCaptureDevice::Client::Buffer buffer = ReserveClientOutputBuffer();
+  if (!buffer.is_valid())
+    return false;
+
+  ClientBuffer& client_buffer = client_buffers_[index];
+  client_buffer.access = buffer.handle_provider->GetHandleForInProcessAccess();
+  client_buffer.buffer = std::move(buffer);
+  return true;
+}
+
+bool V4L2CaptureDelegate::QueueClientBuffer(int index) {
+  const ClientBuffer& client_buffer = client_buffers_[index];
+  DCHECK(client_buffer.access);
+
+  v4l2_buffer buffer;
+  FillV4L2Buffer(&buffer, index, V4L2_MEMORY_USERPTR);
+  buffer.m.userptr = reinterpret_cast<unsigned long>(
+      client_buffer.access->data());
+  buffer.length = client_buffer.access->mapped_size();
+  if (HANDLE_EINTR(DoIoctl(VIDIOC_QBUF, &buffer)) < 0) {
+    DPLOG(ERROR) << "Error enqueuing a client buffer into the driver";
+    return false;
+  }
+  return true;
+}
+
+bool V4L2CaptureDelegate::DeliverClientBuffer(int index,
+                                              base::TimeTicks reference_time,
+                                              base::TimeDelta timestamp) {
+  ClientBuffer filled_buffer = std::move(client_buffers_[index]);
+  if (!ReserveClientBuffer(index)) {
+    // All output buffers are in use by consumers, drop this frame and let the
+    // driver overwrite it.
+    client_buffers_[index] = std::move(filled_buffer);
+    return QueueClientBuffer(index);
+  }
+
+  filled_buffer.access.reset();
+  client_->OnIncomingCapturedBuffer(std::move(filled_buffer.buffer),
+                                    capture_format_, reference_time,
+                                    timestamp);
+  return QueueClientBuffer(index);
+}
+
 void V4L2CaptureDelegate::DoCapture() {
   DCHECK(v4l2_task_runner_->BelongsToCurrentThread());
   if (!is_capturing_)
@@ -809,16 +999,20 @@ void V4L2CaptureDelegate::DoCapture() {
   // Deenqueue, send and reenqueue a buffer if the driver has filled one in.
   if (device_pfd.revents & POLLIN) {
     v4l2_buffer buffer;
-    FillV4L2Buffer(&buffer, 0);
+    FillV4L2Buffer(&buffer, 0, memory_type());
 
-    if (HANDLE_EINTR(ioctl(device_fd_.get(), VIDIOC_DQBUF, &buffer)) < 0) {
+    if (HANDLE_EINTR(DoIoctl(VIDIOC_DQBUF, &buffer)) < 0) {
       SetErrorState(FROM_HERE, "Failed to dequeue capture buffer");
       return;
     }
 
-    buffer_tracker_pool_[buffer.index]->set_payload_size(buffer.bytesused);
-    const scoped_refptr<BufferTracker>& buffer_tracker =
-        buffer_tracker_pool_[buffer.index];
+    const uint8_t* frame_data;
+    if (use_client_buffers_) {
+      frame_data = client_buffers_[buffer.index].access->const_data();
+    } else {
+      buffer_tracker_pool_[buffer.index]->set_payload_size(buffer.bytesused);
+      frame_data = buffer_tracker_pool_[buffer.index]->start();
+    }
 
     // There's a wide-spread issue where the kernel does not report accurate,
     // monotonically-increasing timestamps in the v4l2_buffer::timestamp
@@ -830,31 +1024,55 @@ void V4L2CaptureDelegate::DoCapture() {
       first_ref_time_ = now;
     const base::TimeDelta timestamp = now - first_ref_time_;
 
+    bool is_corrupted = false;
 #ifdef V4L2_BUF_FLAG_ERROR
     if (buffer.flags & V4L2_BUF_FLAG_ERROR) {
       LOG(ERROR) << "Dequeued v4l2 buffer contains corrupted data ("
                  << buffer.bytesused << " bytes).";
       buffer.bytesused = 0;
-    } else
+      is_corrupted = true;
+    }
 #endif
-      client_->OnIncomingCapturedData(
-          buffer_tracker->start(), buffer_tracker->payload_size(),
-          capture_format_, rotation_, now, timestamp);
 
+    // Photos are taken before the frame is delivered, since in USERPTR mode
+    // delivery hands the buffer over to |client_|.
     while (!take_photo_callbacks_.empty()) {
       VideoCaptureDevice::TakePhotoCallback cb =
           std::move(take_photo_callbacks_.front());
       take_photo_callbacks_.pop();
 
       mojom::BlobPtr blob =
-          Blobify(buffer_tracker->start(), buffer.bytesused, capture_format_);
+          Blobify(frame_data, buffer.bytesused, capture_format_);
       if (blob)
         std::move(cb).Run(std::move(blob));
     }
 
-    if (HANDLE_EINTR(ioctl(device_fd_.get(), VIDIOC_QBUF, &buffer)) < 0) {
-      SetErrorState(FROM_HERE, "Failed to enqueue capture buffer");
-      return;
+    bool delivered_without_copy = false;
+    if (is_corrupted) {
+      // Just hand the buffer back to the driver.
+    } else if (use_client_buffers_ && rotation_ == 0 &&
+               buffer.bytesused >= capture_format_.ImageAllocationSize()) {
+      if (!DeliverClientBuffer(buffer.index, now, timestamp)) {
+        SetErrorState(FROM_HERE, "Failed to enqueue capture buffer");
+        return;
+      }
+      delivered_without_copy = true;
+    } else {
+      // MMAP buffers, and rotated frames, are converted into a new buffer.
+      client_->OnIncomingCapturedData(frame_data, buffer.bytesused,
+                                      capture_format_, rotation_, now,
+                                      timestamp);
+    }
+
+    if (!delivered_without_copy) {
+      const bool queued =
+          use_client_buffers_
+              ? QueueClientBuffer(buffer.index)
+              : HANDLE_EINTR(DoIoctl(VIDIOC_QBUF, &buffer)) >= 0;
+      if (!queued) {
+        SetErrorState(FROM_HERE, "Failed to enqueue capture buffer");
+        return;
+      }
     }
   }
 
@@ -869,6 +1087,15 @@ void V4L2CaptureDelegate::SetErrorState(const base::Location& from_here,
   client_->OnError(from_here, reason);
 }
 
+V4L2CaptureDelegate::ClientBuffer::ClientBuffer() = default;
+
+V4L2CaptureDelegate::ClientBuffer::ClientBuffer(ClientBuffer&& other) = default;
+
+V4L2CaptureDelegate::ClientBuffer& V4L2CaptureDelegate::ClientBuffer::
+operator=(ClientBuffer&& other) = default;
+
+V4L2CaptureDelegate::ClientBuffer::~ClientBuffer() = default;
+
 V4L2CaptureDelegate::BufferTracker::BufferTracker() {}
 
 V4L2CaptureDelegate::BufferTracker::~BufferTracker() {
@@ -8,6 +8,10 @@
 #include <stddef.h>
 #include <stdint.h>
 
+#include <memory>
+#include <vector>
+
+#include "base/callback.h"
 #include "base/containers/queue.h"
 #include "base/files/scoped_file.h"
 #include "base/macros.h"
@@ -26,6 +30,8 @@ class Location;
 
 namespace media {
 
+class VideoCaptureBufferHandle;
+
 // Class doing the actual Linux capture using V4L2 API. V4L2 SPLANE/MPLANE
 // capture specifics are implemented in derived classes. Created on the owner's
 // thread, otherwise living, operating and destroyed on |v4l2_task_runner_|.
@@ -41,6 +47,14 @@ class CAPTURE_EXPORT V4L2CaptureDelegate final {
   // preference, with MJPEG prioritised depending on |prefer_mjpeg|.
   static std::list<uint32_t> GetListOfUsableFourCcs(bool prefer_mjpeg);
 
+  // Returns the number of buffers to request from the driver, which can be
+  // overridden with the --v4l2-capture-buffer-count switch.
+  static uint32_t GetNumVideoBuffers();
+  // Returns the number of spare output buffers |client_| must have to capture
+  // into client buffers, which can be overridden with the
+  // --v4l2-client-buffer-headroom switch.
+  static uint32_t GetClientBufferHeadroom();
+
   V4L2CaptureDelegate(
       const VideoCaptureDeviceDescriptor& device_descriptor,
       const scoped_refptr<base::SingleThreadTaskRunner>& v4l2_task_runner,
@@ -69,10 +83,62 @@ class CAPTURE_EXPORT V4L2CaptureDelegate final {
 
   class BufferTracker;
 
+  // An output buffer of |client_| lent to the driver in USERPTR mode.
+  struct ClientBuffer {
+    ClientBuffer();
+    ClientBuffer(ClientBuffer&& other);
+    ClientBuffer& operator=(ClientBuffer&& other);
+    ~ClientBuffer();
+
+    VideoCaptureDevice::Client::Buffer buffer;
+    std::unique_ptr<VideoCaptureBufferHandle> access;
+  };
+
+  // Runs |request| on |device_fd_|, or on |ioctl_for_testing_| if set.
+  int DoIoctl(int request, void* argp);
+
+  // Requests the driver buffers, backed by |client_|'s output buffers if
+  // possible and by MMAP buffers otherwise, and enqueues them all. Sets the
+  // error state and returns false on failure.
+  bool AllocateVideoBuffers();
+
   // VIDIOC_QUERYBUFs a buffer from V4L2, creates a BufferTracker for it and
   // enqueues it (VIDIOC_QBUF) back into V4L2.
   bool MapAndQueueBuffer(int index);
 
+  // Returns true if the negotiated format can be captured by the driver
+  // straight into |client_|'s output buffers, i.e. it is tightly packed I420.
+  bool CanCaptureIntoClientBuffers() const;
+  // Requests |num_buffers| USERPTR buffers from V4L2 and backs each of them
+  // with a freshly reserved output buffer of |client_|. Returns false, with
+  // nothing left allocated, if either the driver or |client_| can't do so, or
+  // if |client_| would be left with fewer than GetClientBufferHeadroom() spare
+  // buffers to swap in for delivered frames.
+  bool AllocateClientBuffers(uint32_t num_buffers);
+  void ReleaseClientBuffers();
+  // Returns true if |num_spares| more output buffers of |client_| can be
+  // reserved. They are released again before returning.
+  bool HasSpareClientBuffers(uint32_t num_spares);
+  // Reserves an I420 output buffer of |client_| of the capture size.
+  VideoCaptureDevice::Client::Buffer ReserveClientOutputBuffer();
+  // Reserves a new output buffer of |client_| for |index|, replacing the one
+  // it had, if any. Returns false if none is available. The buffer's
+  // |frame_feedback_id| is always 0.
+  bool ReserveClientBuffer(int index);
+  // Enqueues the output buffer of |client_| for |index| into the driver.
+  bool QueueClientBuffer(int index);
+  // Hands the frame the driver wrote into the output buffer at |index| to
+  // |client_| without copying, and lends a new output buffer to the driver in
+  // its place. If |client_| has no buffer to spare the frame is dropped and
+  // the buffer is re-enqueued as is.
+  bool DeliverClientBuffer(int index,
+                           base::TimeTicks reference_time,
+                           base::TimeDelta timestamp);
+
+  v4l2_memory memory_type() const {
+    return use_client_buffers_ ? V4L2_MEMORY_USERPTR : V4L2_MEMORY_MMAP;
+  }
+
   void DoCapture();
 
   void SetErrorState(const base::Location& from_here,
@@ -88,11 +154,20 @@ class CAPTURE_EXPORT V4L2CaptureDelegate final {
   std::unique_ptr<VideoCaptureDevice::Client> client_;
   base::ScopedFD device_fd_;
 
+  // Emulates the device in tests, see DoIoctl().
+  base::Callback<int(int request, void* argp)> ioctl_for_testing_;
+
   base::queue<VideoCaptureDevice::TakePhotoCallback> take_photo_callbacks_;
 
   // Vector of BufferTracker to keep track of mmap()ed pointers and their use.
   std::vector<scoped_refptr<BufferTracker>> buffer_tracker_pool_;
 
+  // Whether the driver writes into |client_buffers_| (V4L2_MEMORY_USERPTR)
+  // instead of into |buffer_tracker_pool_| (V4L2_MEMORY_MMAP).
+  bool use_client_buffers_;
+  // Output buffers of |client_| currently lent to the driver, by V4L2 index.
+  std::vector<ClientBuffer> client_buffers_;
+
   bool is_capturing_;
   int timeout_count_;
 
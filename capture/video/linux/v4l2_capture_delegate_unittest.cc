@@ -5,14 +5,28 @@
 #include <sys/fcntl.h>
 #include <sys/ioctl.h>
 
+#include <deque>
+#include <set>
+
+#include "base/files/file.h"
 #include "base/files/file_enumerator.h"
+#include "base/files/scoped_temp_dir.h"
 #include "base/run_loop.h"
+#include "base/test/scoped_command_line.h"
+#include "base/test/scoped_feature_list.h"
 #include "base/test/scoped_task_environment.h"
 #include "base/threading/thread_task_runner_handle.h"
 #include "build/build_config.h"
+#include "media/base/media_switches.h"
+#include "media/base/video_frame.h"
 #include "media/capture/video/linux/v4l2_capture_delegate.h"
+#include "media/capture/video/mock_video_frame_receiver.h"
+#include "media/capture/video/video_capture_buffer_pool_impl.h"
+#include "media/capture/video/video_capture_buffer_tracker_factory_impl.h"
 #include "media/capture/video/video_capture_device.h"
+#include "media/capture/video/video_capture_device_client.h"
 #include "media/capture/video/video_capture_device_descriptor.h"
+#include "media/capture/video/video_capture_jpeg_decoder.h"
 #include "media/capture/video_capture_types.h"
 #include "testing/gmock/include/gmock/gmock.h"
 #include "testing/gtest/include/gtest/gtest.h"
@@ -214,6 +228,94 @@ class MockVideoCaptureDeviceClient : public VideoCaptureDevice::Client {
   MOCK_METHOD0(OnStarted, void(void));
 };
 
+std::unique_ptr<VideoCaptureJpegDecoder> ReturnNullPtrAsJpegDecoder() {
+  return nullptr;
+}
+
+// The size of the frames captured from FakeV4L2Driver, and of its MMAP buffers.
+const int kFakeFrameWidth = 64;
+const int kFakeFrameHeight = 48;
+const uint32_t kFakeMmapBufferSize = 8192;
+
+// Emulates the buffer handling ioctls of a V4L2 driver that supports both MMAP
+// and USERPTR buffers. MMAP buffer |i| is at offset |i| * kFakeMmapBufferSize
+// in the device file.
+class FakeV4L2Driver {
+ public:
+  FakeV4L2Driver()
+      : memory_type_(V4L2_MEMORY_MMAP), num_buffers_(0), num_releases_(0) {}
+
+  int Ioctl(int request, void* argp) {
+    switch (request) {
+      case VIDIOC_REQBUFS: {
+        v4l2_requestbuffers* request_buffers =
+            static_cast<v4l2_requestbuffers*>(argp);
+        memory_type_ = static_cast<v4l2_memory>(request_buffers->memory);
+        num_buffers_ = request_buffers->count;
+        queued_buffers_.clear();
+        if (num_buffers_ == 0)
+          ++num_releases_;
+        return 0;
+      }
+      case VIDIOC_QUERYBUF: {
+        v4l2_buffer* buffer = static_cast<v4l2_buffer*>(argp);
+        if (buffer->memory != V4L2_MEMORY_MMAP || buffer->index >= num_buffers_)
+          return -1;
+        buffer->length = kFakeMmapBufferSize;
+        buffer->m.offset = buffer->index * kFakeMmapBufferSize;
+        return 0;
+      }
+      case VIDIOC_QBUF: {
+        const v4l2_buffer* buffer = static_cast<v4l2_buffer*>(argp);
+        if (buffer->memory != memory_type_ || buffer->index >= num_buffers_)
+          return -1;
+        if (memory_type_ == V4L2_MEMORY_USERPTR &&
+            (!buffer->m.userptr || buffer->length < I420FrameSize())) {
+          return -1;
+        }
+        queued_buffers_.push_back(*buffer);
+        return 0;
+      }
+      case VIDIOC_STREAMON:
+      case VIDIOC_STREAMOFF:
+        return 0;
+    }
+    return -1;
+  }
+
+  // Removes and returns the oldest queued buffer, as if a frame was captured
+  // into it.
+  v4l2_buffer DequeueBuffer() {
+    v4l2_buffer buffer = queued_buffers_.front();
+    queued_buffers_.pop_front();
+    buffer.bytesused = I420FrameSize();
+    return buffer;
+  }
+
+  static uint32_t I420FrameSize() {
+    return VideoFrame::AllocationSize(
+        PIXEL_FORMAT_I420, gfx::Size(kFakeFrameWidth, kFakeFrameHeight));
+  }
+
+  v4l2_memory memory_type() const { return memory_type_; }
+  uint32_t num_buffers() const { return num_buffers_; }
+  const std::deque<v4l2_buffer>& queued_buffers() const {
+    return queued_buffers_;
+  }
+  int num_releases() const { return num_releases_; }
+
+ private:
+  v4l2_memory memory_type_;
+  uint32_t num_buffers_;
+  std::deque<v4l2_buffer> queued_buffers_;
+  // Number of VIDIOC_REQBUFS with a count of 0.
+  int num_releases_;
+
+  DISALLOW_COPY_AND_ASSIGN(FakeV4L2Driver);
+};
+
+}  // anonymous namespace
+
 class V4L2CaptureDelegateTest : public ::testing::Test {
  public:
   V4L2CaptureDelegateTest()
@@ -224,13 +326,56 @@ class V4L2CaptureDelegateTest : public ::testing::Test {
             50)) {}
   ~V4L2CaptureDelegateTest() override = default;
 
+ protected:
+  // Points |delegate_| at |fake_driver_| and a client with a buffer pool of
+  // |pool_size| buffers, in the state AllocateAndStart() leaves it in after
+  // negotiating a tightly packed I420 format.
+  void SetUpFakeDevice(int pool_size) {
+    buffer_pool_ = new VideoCaptureBufferPoolImpl(
+        base::MakeUnique<VideoCaptureBufferTrackerFactoryImpl>(), pool_size);
+    delegate_->client_ = base::MakeUnique<VideoCaptureDeviceClient>(
+        base::MakeUnique<::testing::NiceMock<MockVideoFrameReceiver>>(),
+        buffer_pool_, base::Bind(&ReturnNullPtrAsJpegDecoder));
+
+    // The MMAP buffers are mapped from a regular file.
+    ASSERT_TRUE(temp_dir_.CreateUniqueTempDir());
+    base::File device_file(
+        temp_dir_.GetPath().AppendASCII("video0"),
+        base::File::FLAG_CREATE | base::File::FLAG_READ |
+            base::File::FLAG_WRITE);
+    ASSERT_TRUE(device_file.SetLength(VIDEO_MAX_FRAME * kFakeMmapBufferSize));
+    delegate_->device_fd_.reset(device_file.TakePlatformFile());
+    delegate_->ioctl_for_testing_ = base::Bind(
+        &FakeV4L2Driver::Ioctl, base::Unretained(&fake_driver_));
+
+    const gfx::Size frame_size(kFakeFrameWidth, kFakeFrameHeight);
+    delegate_->capture_format_ =
+        VideoCaptureFormat(frame_size, 30.0f, PIXEL_FORMAT_I420);
+    delegate_->video_fmt_.fmt.pix.width = kFakeFrameWidth;
+    delegate_->video_fmt_.fmt.pix.height = kFakeFrameHeight;
+    delegate_->video_fmt_.fmt.pix.pixelformat = V4L2_PIX_FMT_YUV420;
+    delegate_->video_fmt_.fmt.pix.bytesperline = kFakeFrameWidth;
+    delegate_->video_fmt_.fmt.pix.sizeimage = FakeV4L2Driver::I420FrameSize();
+  }
+
+  bool AllocateVideoBuffers() { return delegate_->AllocateVideoBuffers(); }
+  bool use_client_buffers() const { return delegate_->use_client_buffers_; }
+
+  // Hands the next frame captured by |fake_driver_| to the client.
+  bool DeliverNextClientBuffer() {
+    const v4l2_buffer buffer = fake_driver_.DequeueBuffer();
+    return delegate_->DeliverClientBuffer(
+        buffer.index, base::TimeTicks::Now(), base::TimeDelta());
+  }
+
   base::test::ScopedTaskEnvironment scoped_task_environment_;
   VideoCaptureDeviceDescriptor device_descriptor_;
   std::unique_ptr<V4L2CaptureDelegate> delegate_;
+  FakeV4L2Driver fake_driver_;
+  scoped_refptr<VideoCaptureBufferPoolImpl> buffer_pool_;
+  base::ScopedTempDir temp_dir_;
 };
 
-}  // anonymous namespace
-
 // Fails on Linux, see crbug/732355
 #if defined(OS_LINUX)
 #define MAYBE_CreateAndDestroyAndVerifyControls \
@@ -290,4 +435,149 @@ TEST_F(V4L2CaptureDelegateTest, MAYBE_CreateAndDestroyAndVerifyControls) {
   }
 }
 
+TEST_F(V4L2CaptureDelegateTest, NumVideoBuffersFromCommandLine) {
+  const uint32_t default_num_buffers =
+      V4L2CaptureDelegate::GetNumVideoBuffers();
+  EXPECT_GE(default_num_buffers, 2u);
+
+  const struct {
+    const char* value;
+    uint32_t expected_num_buffers;
+  } kTestCases[] = {{"8", 8u},
+                    {"2", 2u},
+                    {"32", 32u},
+                    {"1", default_num_buffers},
+                    {"33", default_num_buffers},
+                    {"many", default_num_buffers}};
+  for (const auto& test_case : kTestCases) {
+    base::test::ScopedCommandLine scoped_command_line;
+    scoped_command_line.GetProcessCommandLine()->AppendSwitchASCII(
+        switches::kV4L2CaptureBufferCount, test_case.value);
+    EXPECT_EQ(test_case.expected_num_buffers,
+              V4L2CaptureDelegate::GetNumVideoBuffers())
+        << test_case.value;
+  }
+}
+
+TEST_F(V4L2CaptureDelegateTest, ClientBufferHeadroomFromCommandLine) {
+  const uint32_t default_headroom =
+      V4L2CaptureDelegate::GetClientBufferHeadroom();
+  EXPECT_GE(default_headroom, 1u);
+
+  const struct {
+    const char* value;
+    uint32_t expected_headroom;
+  } kTestCases[] = {{"1", 1u},
+                    {"4", 4u},
+                    {"32", 32u},
+                    {"0", default_headroom},
+                    {"33", default_headroom},
+                    {"many", default_headroom}};
+  for (const auto& test_case : kTestCases) {
+    base::test::ScopedCommandLine scoped_command_line;
+    scoped_command_line.GetProcessCommandLine()->AppendSwitchASCII(
+        switches::kV4L2ClientBufferHeadroom, test_case.value);
+    EXPECT_EQ(test_case.expected_headroom,
+              V4L2CaptureDelegate::GetClientBufferHeadroom())
+        << test_case.value;
+  }
+}
+
+TEST_F(V4L2CaptureDelegateTest, CapturesIntoClientBuffers) {
+  base::test::ScopedFeatureList feature_list;
+  feature_list.InitAndEnableFeature(kV4L2CaptureIntoClientBuffers);
+  const uint32_t num_buffers = V4L2CaptureDelegate::GetNumVideoBuffers();
+  ASSERT_EQ(2u, V4L2CaptureDelegate::GetClientBufferHeadroom());
+  SetUpFakeDevice(num_buffers + 2);
+
+  ASSERT_TRUE(AllocateVideoBuffers());
+  EXPECT_TRUE(use_client_buffers());
+  EXPECT_EQ(V4L2_MEMORY_USERPTR, fake_driver_.memory_type());
+  EXPECT_EQ(num_buffers, fake_driver_.num_buffers());
+
+  // Every driver buffer is backed by a distinct pool buffer.
+  ASSERT_EQ(num_buffers, fake_driver_.queued_buffers().size());
+  std::set<unsigned long> userptrs;
+  for (const v4l2_buffer& buffer : fake_driver_.queued_buffers())
+    userptrs.insert(buffer.m.userptr);
+  EXPECT_EQ(num_buffers, userptrs.size());
+  EXPECT_DOUBLE_EQ(static_cast<double>(num_buffers) / (num_buffers + 2),
+                   buffer_pool_->GetBufferPoolUtilization());
+}
+
+TEST_F(V4L2CaptureDelegateTest, FallsBackToMmapWhenPoolRunsShort) {
+  base::test::ScopedFeatureList feature_list;
+  feature_list.InitAndEnableFeature(kV4L2CaptureIntoClientBuffers);
+  const uint32_t num_buffers = V4L2CaptureDelegate::GetNumVideoBuffers();
+  SetUpFakeDevice(num_buffers - 1);
+
+  ASSERT_TRUE(AllocateVideoBuffers());
+  EXPECT_FALSE(use_client_buffers());
+
+  // The USERPTR buffers were given back to the driver and the pool, and MMAP
+  // buffers requested instead.
+  EXPECT_EQ(1, fake_driver_.num_releases());
+  EXPECT_EQ(V4L2_MEMORY_MMAP, fake_driver_.memory_type());
+  EXPECT_EQ(num_buffers, fake_driver_.queued_buffers().size());
+  EXPECT_EQ(0.0, buffer_pool_->GetBufferPoolUtilization());
+}
+
+TEST_F(V4L2CaptureDelegateTest, FallsBackToMmapWithoutSpareClientBuffers) {
+  base::test::ScopedFeatureList feature_list;
+  feature_list.InitAndEnableFeature(kV4L2CaptureIntoClientBuffers);
+  const uint32_t num_buffers = V4L2CaptureDelegate::GetNumVideoBuffers();
+
+  // The pool could back every driver buffer, but then no frame could ever be
+  // delivered.
+  SetUpFakeDevice(num_buffers);
+  ASSERT_TRUE(AllocateVideoBuffers());
+  EXPECT_FALSE(use_client_buffers());
+  EXPECT_EQ(1, fake_driver_.num_releases());
+  EXPECT_EQ(V4L2_MEMORY_MMAP, fake_driver_.memory_type());
+  EXPECT_EQ(num_buffers, fake_driver_.queued_buffers().size());
+  EXPECT_EQ(0.0, buffer_pool_->GetBufferPoolUtilization());
+}
+
+TEST_F(V4L2CaptureDelegateTest, CapturesWithConfiguredHeadroom) {
+  base::test::ScopedFeatureList feature_list;
+  feature_list.InitAndEnableFeature(kV4L2CaptureIntoClientBuffers);
+  base::test::ScopedCommandLine scoped_command_line;
+  scoped_command_line.GetProcessCommandLine()->AppendSwitchASCII(
+      switches::kV4L2ClientBufferHeadroom, "1");
+  const uint32_t num_buffers = V4L2CaptureDelegate::GetNumVideoBuffers();
+  SetUpFakeDevice(num_buffers + 1);
+
+  ASSERT_TRUE(AllocateVideoBuffers());
+  EXPECT_TRUE(use_client_buffers());
+  EXPECT_EQ(V4L2_MEMORY_USERPTR, fake_driver_.memory_type());
+}
+
+TEST_F(V4L2CaptureDelegateTest, ReturnsClientBuffersOnRelease) {
+  base::test::ScopedFeatureList feature_list;
+  feature_list.InitAndEnableFeature(kV4L2CaptureIntoClientBuffers);
+  const uint32_t num_buffers = V4L2CaptureDelegate::GetNumVideoBuffers();
+  const int pool_size =
+      num_buffers + V4L2CaptureDelegate::GetClientBufferHeadroom();
+  SetUpFakeDevice(pool_size);
+  ASSERT_TRUE(AllocateVideoBuffers());
+  ASSERT_TRUE(use_client_buffers());
+
+  // A delivered buffer is replaced by a spare pool buffer, rather than being
+  // dropped and re-enqueued, and returns to the pool once the consumer is done
+  // with it.
+  const unsigned long filled_userptr =
+      fake_driver_.queued_buffers().front().m.userptr;
+  ASSERT_TRUE(DeliverNextClientBuffer());
+  ASSERT_EQ(num_buffers, fake_driver_.queued_buffers().size());
+  EXPECT_NE(filled_userptr, fake_driver_.queued_buffers().back().m.userptr);
+  EXPECT_DOUBLE_EQ(static_cast<double>(num_buffers) / pool_size,
+                   buffer_pool_->GetBufferPoolUtilization());
+
+  // Stopping returns the buffers lent to the driver to the pool.
+  delegate_->StopAndDeAllocate();
+  EXPECT_EQ(1, fake_driver_.num_releases());
+  EXPECT_EQ(V4L2_MEMORY_USERPTR, fake_driver_.memory_type());
+  EXPECT_EQ(0.0, buffer_pool_->GetBufferPoolUtilization());
+}
+
 };  // namespace media
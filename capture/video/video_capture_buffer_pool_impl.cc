@@ -4,6 +4,7 @@
 
 #include "media/capture/video/video_capture_buffer_pool_impl.h"
 
+#include <algorithm>
 #include <memory>
 
 #include "base/logging.h"
@@ -19,10 +20,16 @@ VideoCaptureBufferPoolImpl::VideoCaptureBufferPoolImpl(
     std::unique_ptr<VideoCaptureBufferTrackerFactory> buffer_tracker_factory,
     int count)
     : count_(count),
+      slots_(new TrackerSlot[count]),
+      num_buffers_held_(0),
       next_buffer_id_(0),
       last_relinquished_buffer_id_(kInvalidId),
       buffer_tracker_factory_(std::move(buffer_tracker_factory)) {
   DCHECK_GT(count, 0);
+  for (int i = 0; i < count_; ++i) {
+    slots_[i].buffer_id = kInvalidId;
+    slots_[i].tracker = nullptr;
+  }
 }
 
 VideoCaptureBufferPoolImpl::~VideoCaptureBufferPoolImpl() {}
@@ -84,15 +91,14 @@ void VideoCaptureBufferPoolImpl::RelinquishProducerReservation(int buffer_id) {
     NOTREACHED() << "Invalid buffer_id.";
     return;
   }
-  DCHECK(tracker->held_by_producer());
-  tracker->set_held_by_producer(false);
+  if (tracker->RelinquishProducerHold())
+    base::subtle::Barrier_AtomicIncrement(&num_buffers_held_, -1);
   last_relinquished_buffer_id_ = buffer_id;
 }
 
 void VideoCaptureBufferPoolImpl::HoldForConsumers(int buffer_id,
                                                   int num_clients) {
-  base::AutoLock lock(lock_);
-  VideoCaptureBufferTracker* tracker = GetTracker(buffer_id);
+  VideoCaptureBufferTracker* tracker = GetHeldTracker(buffer_id);
   if (!tracker) {
     NOTREACHED() << "Invalid buffer_id.";
     return;
@@ -100,7 +106,7 @@ void VideoCaptureBufferPoolImpl::HoldForConsumers(int buffer_id,
   DCHECK(tracker->held_by_producer());
   DCHECK(!tracker->consumer_hold_count());
 
-  tracker->set_consumer_hold_count(num_clients);
+  tracker->AddConsumerHolds(num_clients);
   // Note: |held_by_producer()| will stay true until
   // RelinquishProducerReservation() (usually called by destructor of the object
   // wrapping this tracker, e.g. a media::VideoFrame).
@@ -108,16 +114,13 @@ void VideoCaptureBufferPoolImpl::HoldForConsumers(int buffer_id,
 
 void VideoCaptureBufferPoolImpl::RelinquishConsumerHold(int buffer_id,
                                                         int num_clients) {
-  base::AutoLock lock(lock_);
-  VideoCaptureBufferTracker* tracker = GetTracker(buffer_id);
+  VideoCaptureBufferTracker* tracker = GetHeldTracker(buffer_id);
   if (!tracker) {
     NOTREACHED() << "Invalid buffer_id.";
     return;
   }
-  DCHECK_GE(tracker->consumer_hold_count(), num_clients);
-
-  tracker->set_consumer_hold_count(tracker->consumer_hold_count() -
-                                   num_clients);
+  if (tracker->RelinquishConsumerHolds(num_clients))
+    base::subtle::Barrier_AtomicIncrement(&num_buffers_held_, -1);
 }
 
 int VideoCaptureBufferPoolImpl::ResurrectLastForProducer(
@@ -141,7 +144,8 @@ int VideoCaptureBufferPoolImpl::ResurrectLastForProducer(
       it->second->dimensions() == dimensions &&
       it->second->pixel_format() == format &&
       it->second->storage_type() == storage) {
-    it->second->set_held_by_producer(true);
+    base::subtle::Barrier_AtomicIncrement(&num_buffers_held_, 1);
+    it->second->HoldForProducer();
     const int resurrected_buffer_id = last_relinquished_buffer_id_;
     last_relinquished_buffer_id_ = kInvalidId;
     return resurrected_buffer_id;
@@ -151,14 +155,8 @@ int VideoCaptureBufferPoolImpl::ResurrectLastForProducer(
 }
 
 double VideoCaptureBufferPoolImpl::GetBufferPoolUtilization() const {
-  base::AutoLock lock(lock_);
-  int num_buffers_held = 0;
-  for (const auto& entry : trackers_) {
-    VideoCaptureBufferTracker* const tracker = entry.second.get();
-    if (tracker->held_by_producer() || tracker->consumer_hold_count() > 0)
-      ++num_buffers_held;
-  }
-  return static_cast<double>(num_buffers_held) / count_;
+  return static_cast<double>(base::subtle::Acquire_Load(&num_buffers_held_)) /
+         count_;
 }
 
 int VideoCaptureBufferPoolImpl::ReserveForProducerInternal(
@@ -170,57 +168,59 @@ int VideoCaptureBufferPoolImpl::ReserveForProducerInternal(
   lock_.AssertAcquired();
 
   const size_t size_in_pixels = dimensions.GetArea();
-  // Look for a tracker that's allocated, big enough, and not in use. Track the
-  // largest one that's not big enough, in case we have to reallocate a tracker.
+  // Look for a tracker with the right format and storage that's allocated, big
+  // enough, and not in use. Trackers only go from unused to used under
+  // |lock_|, so a tracker found unused here stays so until reserved below.
   *buffer_id_to_drop = kInvalidId;
-  size_t largest_size_in_pixels = 0;
-  auto tracker_of_last_resort = trackers_.end();
-  auto tracker_to_drop = trackers_.end();
-  for (auto it = trackers_.begin(); it != trackers_.end(); ++it) {
-    VideoCaptureBufferTracker* const tracker = it->second.get();
-    if (!tracker->consumer_hold_count() && !tracker->held_by_producer()) {
-      if (tracker->max_pixel_count() >= size_in_pixels &&
-          (tracker->pixel_format() == pixel_format) &&
-          (tracker->storage_type() == storage_type)) {
-        if (it->first == last_relinquished_buffer_id_) {
-          // This buffer would do just fine, but avoid returning it because the
-          // client may want to resurrect it. It will be returned perforce if
-          // the pool has reached it's maximum limit (see code below).
-          tracker_of_last_resort = it;
-          continue;
-        }
-        // Existing tracker is big enough and has correct format. Reuse it.
-        tracker->set_dimensions(dimensions);
-        tracker->set_held_by_producer(true);
-        tracker->set_frame_feedback_id(frame_feedback_id);
-        return it->first;
-      }
-      if (tracker->max_pixel_count() > largest_size_in_pixels) {
-        largest_size_in_pixels = tracker->max_pixel_count();
-        tracker_to_drop = it;
+  int buffer_id_of_last_resort = kInvalidId;
+  const auto key_it =
+      buffer_ids_by_key_.find(TrackerKey(pixel_format, storage_type));
+  if (key_it != buffer_ids_by_key_.end()) {
+    for (int buffer_id : key_it->second) {
+      VideoCaptureBufferTracker* const tracker = trackers_[buffer_id].get();
+      if (tracker->is_held() || tracker->max_pixel_count() < size_in_pixels)
+        continue;
+      if (buffer_id == last_relinquished_buffer_id_) {
+        // This buffer would do just fine, but avoid returning it because the
+        // client may want to resurrect it. It will be returned perforce if
+        // the pool has reached it's maximum limit (see code below).
+        buffer_id_of_last_resort = buffer_id;
+        continue;
       }
+      // Existing tracker is big enough and has correct format. Reuse it.
+      HoldTrackerForProducer(tracker, dimensions, frame_feedback_id);
+      return buffer_id;
     }
   }
 
   // Preferably grow the pool by creating a new tracker. If we're at maximum
-  // size, then try using |tracker_of_last_resort| or reallocate by deleting an
-  // existing one instead.
+  // size, then try using |buffer_id_of_last_resort| or reallocate by deleting
+  // the largest unused tracker instead.
   if (trackers_.size() == static_cast<size_t>(count_)) {
-    if (tracker_of_last_resort != trackers_.end()) {
+    if (buffer_id_of_last_resort != kInvalidId) {
       last_relinquished_buffer_id_ = kInvalidId;
-      tracker_of_last_resort->second->set_dimensions(dimensions);
-      tracker_of_last_resort->second->set_held_by_producer(true);
-      tracker_of_last_resort->second->set_frame_feedback_id(frame_feedback_id);
-      return tracker_of_last_resort->first;
+      HoldTrackerForProducer(trackers_[buffer_id_of_last_resort].get(),
+                             dimensions, frame_feedback_id);
+      return buffer_id_of_last_resort;
+    }
+    size_t largest_size_in_pixels = 0;
+    int buffer_id_to_reallocate = kInvalidId;
+    for (const auto& entry : trackers_) {
+      VideoCaptureBufferTracker* const tracker = entry.second.get();
+      if (!tracker->is_held() &&
+          tracker->max_pixel_count() > largest_size_in_pixels) {
+        largest_size_in_pixels = tracker->max_pixel_count();
+        buffer_id_to_reallocate = entry.first;
+      }
     }
-    if (tracker_to_drop == trackers_.end()) {
+    if (buffer_id_to_reallocate == kInvalidId) {
       // We're out of space, and can't find an unused tracker to reallocate.
       return kInvalidId;
     }
-    if (tracker_to_drop->first == last_relinquished_buffer_id_)
+    if (buffer_id_to_reallocate == last_relinquished_buffer_id_)
       last_relinquished_buffer_id_ = kInvalidId;
-    *buffer_id_to_drop = tracker_to_drop->first;
-    trackers_.erase(tracker_to_drop);
+    *buffer_id_to_drop = buffer_id_to_reallocate;
+    DropTracker(buffer_id_to_reallocate);
   }
 
   // Create the new tracker.
@@ -233,17 +233,65 @@ int VideoCaptureBufferPoolImpl::ReserveForProducerInternal(
     return kInvalidId;
   }
 
-  tracker->set_held_by_producer(true);
-  tracker->set_frame_feedback_id(frame_feedback_id);
+  HoldTrackerForProducer(tracker.get(), dimensions, frame_feedback_id);
+  TrackerSlot* const slot = std::find_if(
+      slots_.get(), slots_.get() + count_, [](const TrackerSlot& slot) {
+        return base::subtle::NoBarrier_Load(&slot.buffer_id) == kInvalidId;
+      });
+  DCHECK(slot != slots_.get() + count_);
+  slot->tracker = tracker.get();
+  base::subtle::Release_Store(&slot->buffer_id, buffer_id);
+  buffer_ids_by_key_[TrackerKey(pixel_format, storage_type)].push_back(
+      buffer_id);
   trackers_[buffer_id] = std::move(tracker);
 
   return buffer_id;
 }
 
+void VideoCaptureBufferPoolImpl::HoldTrackerForProducer(
+    VideoCaptureBufferTracker* tracker,
+    const gfx::Size& dimensions,
+    int frame_feedback_id) {
+  lock_.AssertAcquired();
+  tracker->set_dimensions(dimensions);
+  tracker->set_frame_feedback_id(frame_feedback_id);
+  base::subtle::Barrier_AtomicIncrement(&num_buffers_held_, 1);
+  tracker->HoldForProducer();
+}
+
+void VideoCaptureBufferPoolImpl::DropTracker(int buffer_id) {
+  lock_.AssertAcquired();
+  auto it = trackers_.find(buffer_id);
+  DCHECK(it != trackers_.end());
+  DCHECK(!it->second->is_held());
+
+  for (int i = 0; i < count_; ++i) {
+    if (base::subtle::NoBarrier_Load(&slots_[i].buffer_id) == buffer_id) {
+      base::subtle::Release_Store(&slots_[i].buffer_id, kInvalidId);
+      slots_[i].tracker = nullptr;
+      break;
+    }
+  }
+
+  std::vector<int>& buffer_ids = buffer_ids_by_key_[TrackerKey(
+      it->second->pixel_format(), it->second->storage_type())];
+  buffer_ids.erase(std::find(buffer_ids.begin(), buffer_ids.end(), buffer_id));
+  trackers_.erase(it);
+}
+
 VideoCaptureBufferTracker* VideoCaptureBufferPoolImpl::GetTracker(
     int buffer_id) {
   auto it = trackers_.find(buffer_id);
   return (it == trackers_.end()) ? nullptr : it->second.get();
 }
 
+VideoCaptureBufferTracker* VideoCaptureBufferPoolImpl::GetHeldTracker(
+    int buffer_id) const {
+  for (int i = 0; i < count_; ++i) {
+    if (base::subtle::Acquire_Load(&slots_[i].buffer_id) == buffer_id)
+      return slots_[i].tracker;
+  }
+  return nullptr;
+}
+
 }  // namespace media
@@ -8,7 +8,11 @@
 #include <stddef.h>
 
 #include <map>
+#include <memory>
+#include <utility>
+#include <vector>
 
+#include "base/atomicops.h"
 #include "base/files/file.h"
 #include "base/macros.h"
 #include "base/memory/ref_counted.h"
@@ -27,6 +31,11 @@
 
 namespace media {
 
+// Producer-side operations (reserving, relinquishing and resurrecting buffers)
+// are serialized by a lock. Consumer holds are counted atomically on each
+// tracker and looked up through a fixed table of slots, so that the many
+// consumers of a capture session (preview, encoder, recorder, ...) never
+// contend on the pool lock when they acquire or release a buffer.
 class CAPTURE_EXPORT VideoCaptureBufferPoolImpl
     : public VideoCaptureBufferPool {
  public:
@@ -57,6 +66,7 @@ class CAPTURE_EXPORT VideoCaptureBufferPoolImpl
 
  private:
   friend class base::RefCountedThreadSafe<VideoCaptureBufferPoolImpl>;
+  friend class VideoCaptureBufferPoolTest;
   ~VideoCaptureBufferPoolImpl() override;
 
   int ReserveForProducerInternal(const gfx::Size& dimensions,
@@ -65,11 +75,42 @@ class CAPTURE_EXPORT VideoCaptureBufferPoolImpl
                                  int frame_feedback_id,
                                  int* tracker_id_to_drop);
 
+  // Buffers are reused by format and storage type, for any dimensions that
+  // fit in their |max_pixel_count()|.
+  using TrackerKey = std::pair<VideoPixelFormat, VideoPixelStorage>;
+
+  // Lock-free lookup entry for a live tracker. |buffer_id| is published with
+  // release semantics after |tracker| is set, and cleared before the tracker
+  // is destroyed. A tracker is only destroyed while unused, so a consumer
+  // holding |buffer_id| can always dereference |tracker|.
+  struct TrackerSlot {
+    base::subtle::Atomic32 buffer_id;
+    VideoCaptureBufferTracker* tracker;
+  };
+
   VideoCaptureBufferTracker* GetTracker(int buffer_id);
 
+  // Finds the tracker of a buffer that is held by the producer or a consumer
+  // without taking |lock_|.
+  VideoCaptureBufferTracker* GetHeldTracker(int buffer_id) const;
+
+  // Reserves the unused |tracker| for the producer. Requires |lock_|.
+  void HoldTrackerForProducer(VideoCaptureBufferTracker* tracker,
+                              const gfx::Size& dimensions,
+                              int frame_feedback_id);
+
+  // Destroys the unused tracker |buffer_id|. Requires |lock_|.
+  void DropTracker(int buffer_id);
+
   // The max number of buffers that the pool is allowed to have at any moment.
   const int count_;
 
+  // |count_| lookup slots, one per possible live tracker.
+  const std::unique_ptr<TrackerSlot[]> slots_;
+
+  // Number of buffers currently held by the producer or any consumer.
+  base::subtle::Atomic32 num_buffers_held_;
+
   // Protects everything below it.
   mutable base::Lock lock_;
 
@@ -83,6 +124,10 @@ class CAPTURE_EXPORT VideoCaptureBufferPoolImpl
   // The buffers, indexed by the first parameter, a buffer id.
   std::map<int, std::unique_ptr<VideoCaptureBufferTracker>> trackers_;
 
+  // The ids in |trackers_| indexed by format and storage type, in creation
+  // order.
+  std::map<TrackerKey, std::vector<int>> buffer_ids_by_key_;
+
   const std::unique_ptr<VideoCaptureBufferTrackerFactory>
       buffer_tracker_factory_;
 
@@ -0,0 +1,98 @@
+// Copyright 2017 The Chromium Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "base/memory/ptr_util.h"
+#include "base/strings/string_number_conversions.h"
+#include "base/threading/simple_thread.h"
+#include "base/time/time.h"
+#include "media/capture/video/video_capture_buffer_pool_impl.h"
+#include "media/capture/video/video_capture_buffer_tracker_factory_impl.h"
+#include "testing/gtest/include/gtest/gtest.h"
+#include "testing/perf/perf_test.h"
+
+namespace media {
+
+namespace {
+
+const int kFramesPerProducer = 20000;
+const int kConsumersPerFrame = 4;
+
+// Emulates a capture session: reserves a buffer, hands it to
+// |kConsumersPerFrame| consumers which each release it individually, and
+// samples the pool utilization as VideoCaptureDeviceClient does.
+class ProducerConsumerLoop : public base::DelegateSimpleThread::Delegate {
+ public:
+  explicit ProducerConsumerLoop(VideoCaptureBufferPool* buffer_pool)
+      : buffer_pool_(buffer_pool), frames_delivered_(0) {}
+
+  void Run() override {
+    const gfx::Size dimensions(320, 240);
+    for (int i = 0; i < kFramesPerProducer; ++i) {
+      int buffer_id_to_drop = VideoCaptureBufferPool::kInvalidId;
+      const int buffer_id = buffer_pool_->ReserveForProducer(
+          dimensions, PIXEL_FORMAT_I420, PIXEL_STORAGE_CPU, i,
+          &buffer_id_to_drop);
+      if (buffer_id == VideoCaptureBufferPool::kInvalidId)
+        continue;
+      buffer_pool_->HoldForConsumers(buffer_id, kConsumersPerFrame);
+      buffer_pool_->RelinquishProducerReservation(buffer_id);
+      buffer_pool_->GetBufferPoolUtilization();
+      for (int j = 0; j < kConsumersPerFrame; ++j)
+        buffer_pool_->RelinquishConsumerHold(buffer_id, 1);
+      ++frames_delivered_;
+    }
+  }
+
+  int frames_delivered() const { return frames_delivered_; }
+
+ private:
+  VideoCaptureBufferPool* const buffer_pool_;
+  int frames_delivered_;
+};
+
+void RunContentionBenchmark(int num_threads) {
+  scoped_refptr<VideoCaptureBufferPoolImpl> buffer_pool(
+      new VideoCaptureBufferPoolImpl(
+          base::MakeUnique<VideoCaptureBufferTrackerFactoryImpl>(),
+          2 * num_threads));
+
+  std::vector<std::unique_ptr<ProducerConsumerLoop>> loops;
+  for (int i = 0; i < num_threads; ++i)
+    loops.push_back(base::MakeUnique<ProducerConsumerLoop>(buffer_pool.get()));
+
+  const base::TimeTicks start = base::TimeTicks::Now();
+  std::vector<std::unique_ptr<base::DelegateSimpleThread>> threads;
+  for (int i = 0; i < num_threads; ++i) {
+    threads.push_back(base::MakeUnique<base::DelegateSimpleThread>(
+        loops[i].get(), "BufferPoolPerfTest" + base::IntToString(i)));
+    threads.back()->Start();
+  }
+  for (const auto& thread : threads)
+    thread->Join();
+  const double elapsed_ms = (base::TimeTicks::Now() - start).InMillisecondsF();
+
+  int frames_delivered = 0;
+  for (const auto& loop : loops)
+    frames_delivered += loop->frames_delivered();
+  EXPECT_GT(frames_delivered, 0);
+  EXPECT_EQ(0.0, buffer_pool->GetBufferPoolUtilization());
+
+  perf_test::PrintResult("capture_buffer_pool",
+                         "_" + base::IntToString(num_threads) + "_threads",
+                         "frames", frames_delivered * 1000 / elapsed_ms,
+                         "frames/s", true);
+}
+
+}  // namespace
+
+TEST(VideoCaptureBufferPoolPerfTest, ProducerConsumerContention) {
+  for (int num_threads : {1, 2, 4, 8})
+    RunContentionBenchmark(num_threads);
+}
+
+}  // namespace media
@@ -0,0 +1,220 @@
+// Copyright 2017 The Chromium Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#include "media/capture/video/video_capture_buffer_pool_impl.h"
+
+#include <memory>
+#include <set>
+#include <vector>
+
+#include "base/bind.h"
+#include "base/macros.h"
+#include "base/memory/ptr_util.h"
+#include "base/strings/string_number_conversions.h"
+#include "base/threading/thread.h"
+#include "media/capture/video/video_capture_buffer_tracker.h"
+#include "media/capture/video/video_capture_buffer_tracker_factory_impl.h"
+#include "testing/gtest/include/gtest/gtest.h"
+
+namespace media {
+
+namespace {
+
+const int kPoolSize = 3;
+
+}  // namespace
+
+class VideoCaptureBufferPoolTest : public ::testing::Test {
+ protected:
+  VideoCaptureBufferPoolTest() { CreatePool(kPoolSize); }
+
+  void CreatePool(int count) {
+    pool_ = new VideoCaptureBufferPoolImpl(
+        base::MakeUnique<VideoCaptureBufferTrackerFactoryImpl>(), count);
+  }
+
+  int Reserve(const gfx::Size& dimensions, int* buffer_id_to_drop) {
+    return pool_->ReserveForProducer(dimensions, PIXEL_FORMAT_I420,
+                                     PIXEL_STORAGE_CPU, 0, buffer_id_to_drop);
+  }
+
+  // Looks |buffer_id| up the way consumers do, without the pool lock.
+  VideoCaptureBufferTracker* GetHeldTracker(int buffer_id) const {
+    return pool_->GetHeldTracker(buffer_id);
+  }
+
+  scoped_refptr<VideoCaptureBufferPoolImpl> pool_;
+
+ private:
+  DISALLOW_COPY_AND_ASSIGN(VideoCaptureBufferPoolTest);
+};
+
+TEST_F(VideoCaptureBufferPoolTest, ProducerReleasesBeforeConsumers) {
+  int buffer_id_to_drop;
+  const int buffer_id = Reserve(gfx::Size(320, 240), &buffer_id_to_drop);
+  ASSERT_NE(VideoCaptureBufferPool::kInvalidId, buffer_id);
+  VideoCaptureBufferTracker* const tracker = GetHeldTracker(buffer_id);
+  ASSERT_TRUE(tracker);
+  EXPECT_TRUE(tracker->held_by_producer());
+  EXPECT_EQ(0, tracker->consumer_hold_count());
+  EXPECT_TRUE(tracker->is_held());
+  EXPECT_DOUBLE_EQ(1.0 / kPoolSize, pool_->GetBufferPoolUtilization());
+
+  pool_->HoldForConsumers(buffer_id, 2);
+  EXPECT_TRUE(tracker->held_by_producer());
+  EXPECT_EQ(2, tracker->consumer_hold_count());
+  EXPECT_DOUBLE_EQ(1.0 / kPoolSize, pool_->GetBufferPoolUtilization());
+
+  pool_->RelinquishProducerReservation(buffer_id);
+  EXPECT_FALSE(tracker->held_by_producer());
+  EXPECT_EQ(2, tracker->consumer_hold_count());
+  EXPECT_TRUE(tracker->is_held());
+  EXPECT_DOUBLE_EQ(1.0 / kPoolSize, pool_->GetBufferPoolUtilization());
+
+  pool_->RelinquishConsumerHold(buffer_id, 1);
+  EXPECT_EQ(1, tracker->consumer_hold_count());
+  EXPECT_TRUE(tracker->is_held());
+  EXPECT_DOUBLE_EQ(1.0 / kPoolSize, pool_->GetBufferPoolUtilization());
+
+  pool_->RelinquishConsumerHold(buffer_id, 1);
+  EXPECT_EQ(0, tracker->consumer_hold_count());
+  EXPECT_FALSE(tracker->is_held());
+  EXPECT_EQ(0.0, pool_->GetBufferPoolUtilization());
+}
+
+TEST_F(VideoCaptureBufferPoolTest, ConsumersReleaseBeforeProducer) {
+  int buffer_id_to_drop;
+  const int buffer_id = Reserve(gfx::Size(320, 240), &buffer_id_to_drop);
+  ASSERT_NE(VideoCaptureBufferPool::kInvalidId, buffer_id);
+  VideoCaptureBufferTracker* const tracker = GetHeldTracker(buffer_id);
+  ASSERT_TRUE(tracker);
+
+  pool_->HoldForConsumers(buffer_id, 3);
+  EXPECT_EQ(3, tracker->consumer_hold_count());
+
+  pool_->RelinquishConsumerHold(buffer_id, 2);
+  EXPECT_EQ(1, tracker->consumer_hold_count());
+  EXPECT_TRUE(tracker->held_by_producer());
+  EXPECT_DOUBLE_EQ(1.0 / kPoolSize, pool_->GetBufferPoolUtilization());
+
+  pool_->RelinquishConsumerHold(buffer_id, 1);
+  EXPECT_EQ(0, tracker->consumer_hold_count());
+  EXPECT_TRUE(tracker->held_by_producer());
+  EXPECT_TRUE(tracker->is_held());
+  EXPECT_DOUBLE_EQ(1.0 / kPoolSize, pool_->GetBufferPoolUtilization());
+
+  pool_->RelinquishProducerReservation(buffer_id);
+  EXPECT_FALSE(tracker->is_held());
+  EXPECT_EQ(0.0, pool_->GetBufferPoolUtilization());
+}
+
+TEST_F(VideoCaptureBufferPoolTest, HoldsOfSeveralBuffersAreIndependent) {
+  int buffer_id_to_drop;
+  const int first_id = Reserve(gfx::Size(320, 240), &buffer_id_to_drop);
+  const int second_id = Reserve(gfx::Size(320, 240), &buffer_id_to_drop);
+  ASSERT_NE(VideoCaptureBufferPool::kInvalidId, first_id);
+  ASSERT_NE(VideoCaptureBufferPool::kInvalidId, second_id);
+  ASSERT_NE(first_id, second_id);
+  EXPECT_DOUBLE_EQ(2.0 / kPoolSize, pool_->GetBufferPoolUtilization());
+
+  pool_->HoldForConsumers(first_id, 1);
+  pool_->HoldForConsumers(second_id, 1);
+  pool_->RelinquishProducerReservation(first_id);
+  pool_->RelinquishProducerReservation(second_id);
+  EXPECT_DOUBLE_EQ(2.0 / kPoolSize, pool_->GetBufferPoolUtilization());
+
+  pool_->RelinquishConsumerHold(second_id, 1);
+  EXPECT_TRUE(GetHeldTracker(first_id)->is_held());
+  EXPECT_FALSE(GetHeldTracker(second_id)->is_held());
+  EXPECT_DOUBLE_EQ(1.0 / kPoolSize, pool_->GetBufferPoolUtilization());
+
+  pool_->RelinquishConsumerHold(first_id, 1);
+  EXPECT_EQ(0.0, pool_->GetBufferPoolUtilization());
+}
+
+TEST_F(VideoCaptureBufferPoolTest, DroppedTrackersAreNotFound) {
+  CreatePool(2);
+  int buffer_id_to_drop;
+  std::set<int> live_ids;
+  for (int i = 0; i < 2; ++i) {
+    const int buffer_id = Reserve(gfx::Size(64, 48), &buffer_id_to_drop);
+    ASSERT_NE(VideoCaptureBufferPool::kInvalidId, buffer_id);
+    pool_->RelinquishProducerReservation(buffer_id);
+    live_ids.insert(buffer_id);
+  }
+
+  // Each request is larger than any unused buffer in the full pool, so one of
+  // them is dropped and its slot reused for the new buffer.
+  std::set<int> dropped_ids;
+  for (int i = 1; i <= 8; ++i) {
+    const gfx::Size dimensions(64 * (i + 1), 48 * (i + 1));
+    const int buffer_id = Reserve(dimensions, &buffer_id_to_drop);
+    ASSERT_NE(VideoCaptureBufferPool::kInvalidId, buffer_id);
+    ASSERT_NE(VideoCaptureBufferPool::kInvalidId, buffer_id_to_drop);
+    EXPECT_EQ(0u, live_ids.count(buffer_id));
+    ASSERT_EQ(1u, live_ids.erase(buffer_id_to_drop));
+    dropped_ids.insert(buffer_id_to_drop);
+    live_ids.insert(buffer_id);
+
+    VideoCaptureBufferTracker* const tracker = GetHeldTracker(buffer_id);
+    ASSERT_TRUE(tracker);
+    EXPECT_TRUE(tracker->held_by_producer());
+    EXPECT_EQ(dimensions, tracker->dimensions());
+    for (int dropped_id : dropped_ids)
+      EXPECT_FALSE(GetHeldTracker(dropped_id)) << dropped_id;
+    for (int live_id : live_ids)
+      EXPECT_TRUE(GetHeldTracker(live_id)) << live_id;
+
+    pool_->RelinquishProducerReservation(buffer_id);
+  }
+  EXPECT_EQ(0.0, pool_->GetBufferPoolUtilization());
+}
+
+// A producer reserves buffers, including ones of a new format that force
+// unused buffers to be dropped, while consumers on other threads release their
+// holds. Meant to be run under ThreadSanitizer.
+TEST_F(VideoCaptureBufferPoolTest, ConcurrentProducerAndConsumers) {
+  const int kNumConsumers = 3;
+  const int kNumFrames = 2000;
+  std::vector<std::unique_ptr<base::Thread>> consumers;
+  for (int i = 0; i < kNumConsumers; ++i) {
+    consumers.push_back(base::MakeUnique<base::Thread>(
+        "BufferPoolConsumer" + base::IntToString(i)));
+    ASSERT_TRUE(consumers.back()->Start());
+  }
+
+  const gfx::Size dimensions(64, 48);
+  int frames_delivered = 0;
+  for (int i = 0; i < kNumFrames; ++i) {
+    const VideoPixelFormat format =
+        i % 2 ? PIXEL_FORMAT_Y16 : PIXEL_FORMAT_I420;
+    int buffer_id_to_drop;
+    const int buffer_id = pool_->ReserveForProducer(
+        dimensions, format, PIXEL_STORAGE_CPU, i, &buffer_id_to_drop);
+    const double utilization = pool_->GetBufferPoolUtilization();
+    EXPECT_GE(utilization, 0.0);
+    EXPECT_LE(utilization, 1.0);
+    // All buffers may still be held by consumers.
+    if (buffer_id == VideoCaptureBufferPool::kInvalidId)
+      continue;
+
+    pool_->HoldForConsumers(buffer_id, kNumConsumers);
+    for (const auto& consumer : consumers) {
+      consumer->task_runner()->PostTask(
+          FROM_HERE,
+          base::BindOnce(&VideoCaptureBufferPool::RelinquishConsumerHold,
+                         pool_, buffer_id, 1));
+    }
+    pool_->RelinquishProducerReservation(buffer_id);
+    ++frames_delivered;
+  }
+
+  // Stopping runs the pending releases.
+  for (const auto& consumer : consumers)
+    consumer->Stop();
+  EXPECT_GT(frames_delivered, 0);
+  EXPECT_EQ(0.0, pool_->GetBufferPoolUtilization());
+}
+
+}  // namespace media
@@ -7,6 +7,8 @@
 
 #include <memory>
 
+#include "base/atomicops.h"
+#include "base/logging.h"
 #include "base/synchronization/lock.h"
 #include "media/capture/video/video_capture_buffer_handle.h"
 #include "media/capture/video_capture_types.h"
@@ -18,12 +20,15 @@ namespace media {
 // VideoCaptureBufferTracker carries indication of pixel format and storage
 // type. This is a base class for implementations using different kinds of
 // storage.
+//
+// The producer reservation and the consumer holds are kept in a single atomic
+// word so that consumers can add and drop holds without taking the pool lock,
+// and so that exactly one caller observes the transition to "unused".
 class CAPTURE_EXPORT VideoCaptureBufferTracker {
  public:
   VideoCaptureBufferTracker()
       : max_pixel_count_(0),
-        held_by_producer_(false),
-        consumer_hold_count_(0),
+        hold_state_(0),
         frame_feedback_id_(0) {}
   virtual bool Init(const gfx::Size& dimensions,
                     media::VideoPixelFormat format,
@@ -42,10 +47,41 @@ class CAPTURE_EXPORT VideoCaptureBufferTracker {
   void set_storage_type(media::VideoPixelStorage storage_type) {
     storage_type_ = storage_type;
   }
-  bool held_by_producer() const { return held_by_producer_; }
-  void set_held_by_producer(bool value) { held_by_producer_ = value; }
-  int consumer_hold_count() const { return consumer_hold_count_; }
-  void set_consumer_hold_count(int value) { consumer_hold_count_ = value; }
+  bool held_by_producer() const {
+    return (base::subtle::Acquire_Load(&hold_state_) & kProducerHold) != 0;
+  }
+  int consumer_hold_count() const {
+    return base::subtle::Acquire_Load(&hold_state_) / kConsumerHold;
+  }
+  // True if either the producer or any consumer references this tracker.
+  bool is_held() const { return base::subtle::Acquire_Load(&hold_state_) != 0; }
+
+  // Marks an unused tracker as reserved by the producer. Only the pool does
+  // this, under its lock, so no other thread can race the transition.
+  void HoldForProducer() {
+    DCHECK(!is_held());
+    base::subtle::Release_Store(&hold_state_, kProducerHold);
+  }
+  // Drops the producer reservation. Returns true if this left the tracker
+  // unused.
+  bool RelinquishProducerHold() {
+    DCHECK(held_by_producer());
+    return base::subtle::Barrier_AtomicIncrement(&hold_state_,
+                                                 -kProducerHold) == 0;
+  }
+  void AddConsumerHolds(int num_clients) {
+    DCHECK_GE(num_clients, 0);
+    base::subtle::Barrier_AtomicIncrement(&hold_state_,
+                                          num_clients * kConsumerHold);
+  }
+  // Drops |num_clients| consumer holds. Returns true if this left the tracker
+  // unused.
+  bool RelinquishConsumerHolds(int num_clients) {
+    DCHECK_GE(consumer_hold_count(), num_clients);
+    return base::subtle::Barrier_AtomicIncrement(
+               &hold_state_, -num_clients * kConsumerHold) == 0;
+  }
+
   void set_frame_feedback_id(int value) { frame_feedback_id_ = value; }
   int frame_feedback_id() { return frame_feedback_id_; }
 
@@ -64,12 +100,11 @@ class CAPTURE_EXPORT VideoCaptureBufferTracker {
   media::VideoPixelFormat pixel_format_;
   media::VideoPixelStorage storage_type_;
 
-  // Indicates whether this VideoCaptureBufferTracker is currently referenced by
-  // the producer.
-  bool held_by_producer_;
-
-  // Number of consumer processes which hold this VideoCaptureBufferTracker.
-  int consumer_hold_count_;
+  // Bit 0 is set while the producer references this tracker; the remaining
+  // bits count the consumer processes which hold it.
+  static constexpr base::subtle::Atomic32 kProducerHold = 1;
+  static constexpr base::subtle::Atomic32 kConsumerHold = 2;
+  base::subtle::Atomic32 hold_state_;
 
   int frame_feedback_id_;
 };
@@ -5,13 +5,19 @@
 #include "media/capture/video/video_capture_device_client.h"
 
 #include <algorithm>
+#include <memory>
 #include <utility>
+#include <vector>
 
 #include "base/bind.h"
 #include "base/command_line.h"
 #include "base/location.h"
 #include "base/memory/ptr_util.h"
 #include "base/strings/stringprintf.h"
+#include "base/synchronization/waitable_event.h"
+#include "base/sys_info.h"
+#include "base/task_scheduler/post_task.h"
+#include "base/task_scheduler/task_scheduler.h"
 #include "base/trace_event/trace_event.h"
 #include "build/build_config.h"
 #include "media/base/bind_to_current_loop.h"
@@ -33,8 +39,110 @@ bool IsFormatSupported(media::VideoPixelFormat pixel_format) {
   return (pixel_format == media::PIXEL_FORMAT_I420 ||
           pixel_format == media::PIXEL_FORMAT_Y16);
 }
+
+// Frames of at least this many pixels are converted to I420 in several
+// horizontal bands concurrently, see ConvertToI420InBands().
+const int kMinPixelsForBandedConversion = 1280 * 720;
+const int kMaxConversionBands = 4;
+
+// A horizontal band of the destination I420 frame, converted by a single task.
+struct ConversionBand {
+  ConversionBand()
+      : done(base::WaitableEvent::ResetPolicy::MANUAL,
+             base::WaitableEvent::InitialState::NOT_SIGNALED) {}
+
+  int first_row = 0;
+  int num_rows = 0;
+  int result = -1;
+  base::WaitableEvent done;
+};
+
+struct ConversionParams {
+  const uint8_t* data;
+  size_t length;
+  uint8_t* y_plane;
+  int y_stride;
+  uint8_t* u_plane;
+  uint8_t* v_plane;
+  int uv_stride;
+  int src_width;
+  int src_height;
+  int width;
+  libyuv::FourCC fourcc;
+};
+
+void ConvertBand(const ConversionParams* params, ConversionBand* band) {
+  TRACE_EVENT1("video", "ConvertBand", "first_row", band->first_row);
+  const int uv_row = band->first_row / 2;
+  band->result = libyuv::ConvertToI420(
+      params->data, params->length,
+      params->y_plane + band->first_row * params->y_stride, params->y_stride,
+      params->u_plane + uv_row * params->uv_stride, params->uv_stride,
+      params->v_plane + uv_row * params->uv_stride, params->uv_stride,
+      0 /* crop_x */, band->first_row, params->src_width, params->src_height,
+      params->width, band->num_rows, libyuv::kRotate0, params->fourcc);
+  band->done.Signal();
+}
+
+// Returns how many bands a frame should be split into for conversion, or 1 if
+// it should be converted in one go. Only unrotated, unflipped, uncompressed
+// formats can be split, since libyuv can then convert any row range of the
+// source independently.
+int GetNumConversionBands(const gfx::Size& size,
+                          libyuv::RotationMode rotation_mode,
+                          bool flip,
+                          libyuv::FourCC fourcc) {
+  if (rotation_mode != libyuv::kRotate0 || flip ||
+      fourcc == libyuv::FOURCC_MJPG || fourcc == libyuv::FOURCC_ANY) {
+    return 1;
+  }
+  if (size.GetArea() < kMinPixelsForBandedConversion ||
+      !base::TaskScheduler::GetInstance()) {
+    return 1;
+  }
+  return std::min(kMaxConversionBands, base::SysInfo::NumberOfProcessors());
 }
 
+// Same as libyuv::ConvertToI420() without rotation, but splits the destination
+// into |num_bands| bands of even height. All bands but the first are posted to
+// the task scheduler, the calling thread converts the first one itself and
+// then waits for the others, so that the frame is complete on return.
+int ConvertToI420InBands(const ConversionParams& params,
+                         int height,
+                         int num_bands) {
+  DCHECK_GT(num_bands, 1);
+  DCHECK_EQ(0, height % 2);
+  const int rows_per_band = std::max(2, ((height / num_bands) + 1) & ~1);
+
+  std::vector<std::unique_ptr<ConversionBand>> bands;
+  for (int first_row = 0; first_row < height; first_row += rows_per_band) {
+    auto band = base::MakeUnique<ConversionBand>();
+    band->first_row = first_row;
+    band->num_rows = std::min(rows_per_band, height - first_row);
+    bands.push_back(std::move(band));
+  }
+
+  // |params| and |bands| outlive the posted tasks since this function does
+  // not return before all of them have signaled completion.
+  for (size_t i = 1; i < bands.size(); ++i) {
+    base::PostTaskWithTraits(
+        FROM_HERE, {base::TaskPriority::USER_BLOCKING},
+        base::BindOnce(&ConvertBand, base::Unretained(&params),
+                       base::Unretained(bands[i].get())));
+  }
+  ConvertBand(&params, bands[0].get());
+
+  int result = 0;
+  for (const auto& band : bands) {
+    band->done.Wait();
+    if (band->result != 0)
+      result = band->result;
+  }
+  return result;
+}
+
+}  // namespace
+
 namespace media {
 
 template <typename ReleaseTraits>
@@ -304,12 +412,32 @@ void VideoCaptureDeviceClient::OnIncomingCapturedData(
     }
   }
 
-  if (libyuv::ConvertToI420(
-          data, length, y_plane_data, yplane_stride, u_plane_data,
-          uv_plane_stride, v_plane_data, uv_plane_stride, crop_x, crop_y,
-          format.frame_size.width(),
-          (flip ? -1 : 1) * format.frame_size.height(), new_unrotated_width,
-          new_unrotated_height, rotation_mode, origin_colorspace) != 0) {
+  const int num_bands = GetNumConversionBands(
+      format.frame_size, rotation_mode, flip, origin_colorspace);
+  int conversion_result;
+  if (num_bands > 1) {
+    const ConversionParams params = {data,
+                                     static_cast<size_t>(length),
+                                     y_plane_data,
+                                     yplane_stride,
+                                     u_plane_data,
+                                     v_plane_data,
+                                     uv_plane_stride,
+                                     format.frame_size.width(),
+                                     format.frame_size.height(),
+                                     new_unrotated_width,
+                                     origin_colorspace};
+    conversion_result =
+        ConvertToI420InBands(params, new_unrotated_height, num_bands);
+  } else {
+    conversion_result = libyuv::ConvertToI420(
+        data, length, y_plane_data, yplane_stride, u_plane_data,
+        uv_plane_stride, v_plane_data, uv_plane_stride, crop_x, crop_y,
+        format.frame_size.width(),
+        (flip ? -1 : 1) * format.frame_size.height(), new_unrotated_width,
+        new_unrotated_height, rotation_mode, origin_colorspace);
+  }
+  if (conversion_result != 0) {
     DLOG(WARNING) << "Failed to convert buffer's pixel format to I420 from "
                   << media::VideoPixelFormatToString(format.pixel_format);
     return;
@@ -0,0 +1,93 @@
+// Copyright 2017 The Chromium Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#include <stdint.h>
+
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "base/bind.h"
+#include "base/memory/ptr_util.h"
+#include "base/test/scoped_task_environment.h"
+#include "base/time/time.h"
+#include "media/capture/video/mock_video_frame_receiver.h"
+#include "media/capture/video/video_capture_buffer_pool_impl.h"
+#include "media/capture/video/video_capture_buffer_tracker_factory_impl.h"
+#include "media/capture/video/video_capture_device_client.h"
+#include "media/capture/video/video_capture_jpeg_decoder.h"
+#include "testing/gmock/include/gmock/gmock.h"
+#include "testing/gtest/include/gtest/gtest.h"
+#include "testing/perf/perf_test.h"
+
+using ::testing::_;
+using ::testing::NiceMock;
+
+namespace media {
+
+namespace {
+
+const int kBenchmarkFrames = 60;
+
+std::unique_ptr<VideoCaptureJpegDecoder> ReturnNullPtrAsJpegDecoder() {
+  return nullptr;
+}
+
+// Feeds |kBenchmarkFrames| frames of |format| and |size| through a
+// VideoCaptureDeviceClient and reports the conversion throughput. With
+// |use_task_scheduler| large frames are converted in several bands
+// concurrently, otherwise on the calling thread only.
+void RunConversionBenchmark(VideoPixelFormat format,
+                            const gfx::Size& size,
+                            bool use_task_scheduler) {
+  std::unique_ptr<base::test::ScopedTaskEnvironment> task_environment;
+  if (use_task_scheduler)
+    task_environment = base::MakeUnique<base::test::ScopedTaskEnvironment>();
+
+  scoped_refptr<VideoCaptureBufferPoolImpl> buffer_pool(
+      new VideoCaptureBufferPoolImpl(
+          base::MakeUnique<VideoCaptureBufferTrackerFactoryImpl>(), 3));
+  VideoCaptureDeviceClient client(
+      base::MakeUnique<NiceMock<MockVideoFrameReceiver>>(), buffer_pool,
+      base::Bind(&ReturnNullPtrAsJpegDecoder));
+
+  const VideoCaptureFormat capture_format(size, 30.0f, format,
+                                          PIXEL_STORAGE_CPU);
+  std::vector<uint8_t> data(capture_format.ImageAllocationSize());
+  for (size_t i = 0; i < data.size(); ++i)
+    data[i] = static_cast<uint8_t>(i);
+
+  const base::TimeTicks start = base::TimeTicks::Now();
+  for (int i = 0; i < kBenchmarkFrames; ++i) {
+    client.OnIncomingCapturedData(data.data(), data.size(), capture_format,
+                                  0 /* clockwise_rotation */,
+                                  base::TimeTicks(), base::TimeDelta());
+  }
+  const double elapsed_ms = (base::TimeTicks::Now() - start).InMillisecondsF();
+
+  perf_test::PrintResult(
+      "capture_convert_to_i420",
+      std::string("_") + VideoPixelFormatToString(format) + "_" +
+          size.ToString(),
+      use_task_scheduler ? "banded" : "single_pass",
+      kBenchmarkFrames * 1000 / elapsed_ms, "frames/s", true);
+}
+
+}  // namespace
+
+TEST(VideoCaptureDeviceClientPerfTest, ConvertToI420) {
+  // The formats FakeVideoCaptureDevice and common webcams produce.
+  const VideoPixelFormat kFormats[] = {PIXEL_FORMAT_I420, PIXEL_FORMAT_NV12,
+                                       PIXEL_FORMAT_YUY2, PIXEL_FORMAT_ARGB};
+  const gfx::Size kSizes[] = {gfx::Size(1280, 720), gfx::Size(1920, 1080),
+                              gfx::Size(3840, 2160)};
+  for (VideoPixelFormat format : kFormats) {
+    for (const gfx::Size& size : kSizes) {
+      RunConversionBenchmark(format, size, false);
+      RunConversionBenchmark(format, size, true);
+    }
+  }
+}
+
+}  // namespace media
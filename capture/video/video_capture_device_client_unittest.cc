@@ -5,12 +5,15 @@
 #include "media/capture/video/video_capture_device_client.h"
 
 #include <stddef.h>
+#include <string.h>
 
 #include <memory>
+#include <vector>
 
 #include "base/bind.h"
 #include "base/logging.h"
 #include "base/macros.h"
+#include "base/test/scoped_task_environment.h"
 #include "build/build_config.h"
 #include "media/base/limits.h"
 #include "media/capture/video/mock_video_frame_receiver.h"
@@ -20,8 +23,10 @@
 #include "media/capture/video/video_frame_receiver.h"
 #include "testing/gmock/include/gmock/gmock.h"
 #include "testing/gtest/include/gtest/gtest.h"
+#include "third_party/libyuv/include/libyuv.h"
 
 using ::testing::_;
+using ::testing::AtMost;
 using ::testing::Mock;
 using ::testing::InSequence;
 using ::testing::Invoke;
@@ -45,19 +50,19 @@ std::unique_ptr<media::VideoCaptureJpegDecoder> ReturnNullPtrAsJpecDecoder() {
 class VideoCaptureDeviceClientTest : public ::testing::Test {
  public:
   VideoCaptureDeviceClientTest() {
-    scoped_refptr<media::VideoCaptureBufferPoolImpl> buffer_pool(
-        new media::VideoCaptureBufferPoolImpl(
-            base::MakeUnique<media::VideoCaptureBufferTrackerFactoryImpl>(),
-            1));
+    buffer_pool_ = new media::VideoCaptureBufferPoolImpl(
+        base::MakeUnique<media::VideoCaptureBufferTrackerFactoryImpl>(), 1);
     auto controller = base::MakeUnique<MockVideoFrameReceiver>();
     receiver_ = controller.get();
     device_client_ = base::MakeUnique<media::VideoCaptureDeviceClient>(
-        std::move(controller), buffer_pool,
+        std::move(controller), buffer_pool_,
         base::Bind(&ReturnNullPtrAsJpecDecoder));
   }
   ~VideoCaptureDeviceClientTest() override {}
 
  protected:
+  base::test::ScopedTaskEnvironment scoped_task_environment_;
+  scoped_refptr<media::VideoCaptureBufferPoolImpl> buffer_pool_;
   MockVideoFrameReceiver* receiver_;
   std::unique_ptr<media::VideoCaptureDeviceClient> device_client_;
 
@@ -233,4 +238,62 @@ TEST_F(VideoCaptureDeviceClientTest, CheckRotationsAndCrops) {
   }
 }
 
+// Tests that frames large enough to be converted in several bands on the task
+// scheduler produce the same I420 output as a single-pass conversion.
+TEST_F(VideoCaptureDeviceClientTest, ConvertsLargeFramesInBands) {
+  const gfx::Size kCaptureResolution(1280, 720);
+  const media::VideoPixelFormat kFormats[] = {media::PIXEL_FORMAT_I420,
+                                              media::PIXEL_FORMAT_NV12,
+                                              media::PIXEL_FORMAT_YUY2};
+
+  for (media::VideoPixelFormat format : kFormats) {
+    const media::VideoCaptureFormat capture_format(
+        kCaptureResolution, 30.0f, format, media::PIXEL_STORAGE_CPU);
+    std::vector<uint8_t> data(capture_format.ImageAllocationSize());
+    for (size_t i = 0; i < data.size(); ++i)
+      data[i] = static_cast<uint8_t>(i * 7 + i / 4096);
+
+    const int width = kCaptureResolution.width();
+    const int height = kCaptureResolution.height();
+    std::vector<uint8_t> expected(width * height * 3 / 2);
+    uint8_t* const expected_u = expected.data() + width * height;
+    uint8_t* const expected_v = expected_u + width * height / 4;
+    const libyuv::FourCC fourcc = format == media::PIXEL_FORMAT_I420
+                                      ? libyuv::FOURCC_I420
+                                      : format == media::PIXEL_FORMAT_NV12
+                                            ? libyuv::FOURCC_NV12
+                                            : libyuv::FOURCC_YUY2;
+    ASSERT_EQ(0, libyuv::ConvertToI420(
+                     data.data(), data.size(), expected.data(), width,
+                     expected_u, width / 2, expected_v, width / 2, 0, 0, width,
+                     height, width, height, libyuv::kRotate0, fourcc));
+
+    int buffer_id = VideoCaptureBufferPool::kInvalidId;
+    std::unique_ptr<VideoCaptureDevice::Client::Buffer::ScopedAccessPermission>
+        read_permission;
+    EXPECT_CALL(*receiver_, OnLog(_)).Times(1);
+    EXPECT_CALL(*receiver_, MockOnNewBufferHandle(_)).Times(AtMost(1));
+    EXPECT_CALL(*receiver_, MockOnFrameReadyInBuffer(_, _, _))
+        .WillOnce(Invoke([&buffer_id, &read_permission](
+                             int id,
+                             std::unique_ptr<media::VideoCaptureDevice::Client::
+                                                 Buffer::ScopedAccessPermission>*
+                                 buffer_read_permission,
+                             const gfx::Size&) {
+          buffer_id = id;
+          read_permission = std::move(*buffer_read_permission);
+        }));
+    device_client_->OnIncomingCapturedData(
+        data.data(), data.size(), capture_format, 0 /* clockwise_rotation */,
+        base::TimeTicks(), base::TimeDelta());
+    Mock::VerifyAndClearExpectations(receiver_);
+
+    ASSERT_NE(VideoCaptureBufferPool::kInvalidId, buffer_id);
+    auto handle = buffer_pool_->GetHandleForInProcessAccess(buffer_id);
+    ASSERT_GE(handle->mapped_size(), expected.size());
+    EXPECT_EQ(0, memcmp(expected.data(), handle->const_data(), expected.size()))
+        << media::VideoPixelFormatToString(format);
+  }
+}
+
 }  // namespace media
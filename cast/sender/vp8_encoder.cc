@@ -4,8 +4,13 @@
 
 #include "media/cast/sender/vp8_encoder.h"
 
+#include <algorithm>
+
+#include "base/feature_list.h"
 #include "base/logging.h"
+#include "media/base/media_switches.h"
 #include "media/base/video_frame.h"
+#include "media/base/video_frame_metadata.h"
 #include "media/cast/constants.h"
 #include "third_party/libvpx/source/libvpx/vpx/vp8cx.h"
 
@@ -70,6 +75,8 @@ Vp8Encoder::Vp8Encoder(const FrameSenderConfig& video_config)
       key_frame_requested_(true),
       bitrate_kbit_(cast_config_.start_bitrate / 1000),
       next_frame_id_(FrameId::first()),
+      active_map_enabled_(base::FeatureList::IsEnabled(kCastVp8ActiveMap)),
+      last_capture_counter_(-1),
       encoding_speed_acc_(
           base::TimeDelta::FromMicroseconds(kEncodingSpeedAccHalfLife)),
       encoding_speed_(kHighestEncodingSpeed) {
@@ -96,7 +103,10 @@ void Vp8Encoder::Initialize() {
 }
 
 void Vp8Encoder::ConfigureForNewFrameSize(const gfx::Size& frame_size) {
+  // Update rects are not meaningful across a change in frame size.
+  last_capture_counter_ = -1;
   if (is_initialized()) {
+    DisableActiveMap();
     // Workaround for VP8 bug: If the new size is strictly less-than-or-equal to
     // the old size, in terms of area, the existing encoder instance can
     // continue.  Otherwise, completely tear-down and re-create a new encoder to
@@ -199,6 +209,8 @@ void Vp8Encoder::Encode(const scoped_refptr<media::VideoFrame>& video_frame,
   const gfx::Size frame_size = video_frame->visible_rect().size();
   if (!is_initialized() || gfx::Size(config_.g_w, config_.g_h) != frame_size)
     ConfigureForNewFrameSize(frame_size);
+  if (active_map_enabled_)
+    UpdateActiveMap(*video_frame);
 
   // Wrapper for vpx_codec_encode() to access the YUV data in the |video_frame|.
   // Only the VISIBLE rectangle within |video_frame| is exposed to the codec.
@@ -368,6 +380,56 @@ void Vp8Encoder::Encode(const scoped_refptr<media::VideoFrame>& video_frame,
   }
 }
 
+void Vp8Encoder::UpdateActiveMap(const media::VideoFrame& video_frame) {
+  const media::VideoFrameMetadata& metadata = *video_frame.metadata();
+  int capture_counter = -1;
+  gfx::Rect update_rect;
+  const bool has_update_rect =
+      metadata.GetInteger(media::VideoFrameMetadata::CAPTURE_COUNTER,
+                          &capture_counter) &&
+      last_capture_counter_ >= 0 &&
+      capture_counter == last_capture_counter_ + 1 &&
+      metadata.GetRect(media::VideoFrameMetadata::CAPTURE_UPDATE_RECT,
+                       &update_rect);
+  last_capture_counter_ = capture_counter;
+
+  // Key frames must be encoded in full.
+  if (!has_update_rect || key_frame_requested_) {
+    DisableActiveMap();
+    return;
+  }
+
+  const int mb_cols = (config_.g_w + 15) / 16;
+  const int mb_rows = (config_.g_h + 15) / 16;
+  active_map_.assign(mb_cols * mb_rows, 0);
+  if (!update_rect.IsEmpty()) {
+    const int first_col = std::max(0, update_rect.x() / 16);
+    const int last_col = std::min(mb_cols - 1, (update_rect.right() - 1) / 16);
+    const int first_row = std::max(0, update_rect.y() / 16);
+    const int last_row = std::min(mb_rows - 1, (update_rect.bottom() - 1) / 16);
+    for (int row = first_row; row <= last_row; ++row) {
+      std::fill(active_map_.begin() + row * mb_cols + first_col,
+                active_map_.begin() + row * mb_cols + last_col + 1, 1);
+    }
+  }
+  vpx_active_map_t map = {active_map_.data(),
+                          static_cast<unsigned int>(mb_rows),
+                          static_cast<unsigned int>(mb_cols)};
+  if (vpx_codec_control(&encoder_, VP8E_SET_ACTIVEMAP, &map) != VPX_CODEC_OK) {
+    DLOG(ERROR) << "Failed to set the VP8 active map.";
+    active_map_.clear();
+  }
+}
+
+void Vp8Encoder::DisableActiveMap() {
+  if (active_map_.empty())
+    return;
+  active_map_.clear();
+  vpx_active_map_t map = {nullptr, 0, 0};
+  if (vpx_codec_control(&encoder_, VP8E_SET_ACTIVEMAP, &map) != VPX_CODEC_OK)
+    DLOG(ERROR) << "Failed to disable the VP8 active map.";
+}
+
 void Vp8Encoder::UpdateRates(uint32_t new_bitrate) {
   DCHECK(thread_checker_.CalledOnValidThread());
 
@@ -8,6 +8,7 @@
 #include <stdint.h>
 
 #include <memory>
+#include <vector>
 
 #include "base/macros.h"
 #include "base/threading/thread_checker.h"
@@ -51,6 +52,12 @@ class Vp8Encoder : public SoftwareVideoEncoder {
   // |encoder_| instance.
   void ConfigureForNewFrameSize(const gfx::Size& frame_size);
 
+  // Uses the CAPTURE_UPDATE_RECT of |video_frame|, when it is relative to the
+  // previously encoded frame, to mark the macroblocks outside of it inactive so
+  // the encoder skips them.  Otherwise, all macroblocks are encoded.
+  void UpdateActiveMap(const media::VideoFrame& video_frame);
+  void DisableActiveMap();
+
   const FrameSenderConfig cast_config_;
 
   const double target_encoder_utilization_;
@@ -74,6 +81,17 @@ class Vp8Encoder : public SoftwareVideoEncoder {
   // The ID for the next frame to be emitted.
   FrameId next_frame_id_;
 
+  // Whether the CAPTURE_UPDATE_RECT of each frame is used to build an active
+  // map.  Controlled by the kCastVp8ActiveMap feature.
+  const bool active_map_enabled_;
+
+  // The CAPTURE_COUNTER of the last encoded frame, or -1 if unknown.
+  int last_capture_counter_;
+
+  // One byte per macroblock, set to 1 if the macroblock is to be encoded.
+  // Empty while the active map is disabled in the |encoder_|.
+  std::vector<unsigned char> active_map_;
+
   // This is bound to the thread where Initialize() is called.
   base::ThreadChecker thread_checker_;
 
@@ -0,0 +1,172 @@
+// Copyright 2017 The Chromium Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#include "media/cast/sender/vp8_encoder.h"
+
+#include <stdint.h>
+#include <string.h>
+
+#include "base/macros.h"
+#include "base/memory/ref_counted.h"
+#include "base/test/scoped_feature_list.h"
+#include "base/time/time.h"
+#include "media/base/media_switches.h"
+#include "media/base/video_frame.h"
+#include "media/base/video_frame_metadata.h"
+#include "media/cast/sender/sender_encoded_frame.h"
+#include "media/cast/test/utility/default_config.h"
+#include "media/cast/test/utility/video_utility.h"
+#include "testing/gtest/include/gtest/gtest.h"
+#include "third_party/libvpx/source/libvpx/vpx/vp8dx.h"
+#include "third_party/libvpx/source/libvpx/vpx/vpx_decoder.h"
+#include "ui/gfx/geometry/rect.h"
+#include "ui/gfx/geometry/size.h"
+
+namespace media {
+namespace cast {
+
+namespace {
+
+const int kWidth = 320;
+const int kHeight = 240;
+
+}  // namespace
+
+// Encodes a frame, then a second frame with entirely different content, and
+// decodes both so the tests can check which macroblocks of the second frame
+// were encoded.
+class Vp8EncoderTest : public ::testing::Test {
+ protected:
+  Vp8EncoderTest() {
+    vpx_codec_dec_cfg_t config = {0};
+    CHECK_EQ(VPX_CODEC_OK,
+             vpx_codec_dec_init(&decoder_, vpx_codec_vp8_dx(), &config, 0));
+  }
+
+  ~Vp8EncoderTest() override { vpx_codec_destroy(&decoder_); }
+
+  // Creates |first_frame_| and |second_frame_|.  The frames carry consecutive
+  // CAPTURE_COUNTERs if |has_capture_counters| is true, and the second one
+  // carries |update_rect| if it is not empty.
+  void CreateFrames(bool has_capture_counters, const gfx::Rect& update_rect) {
+    const gfx::Size size(kWidth, kHeight);
+    first_frame_ = VideoFrame::CreateFrame(PIXEL_FORMAT_I420, size,
+                                           gfx::Rect(size), size,
+                                           base::TimeDelta());
+    PopulateVideoFrame(first_frame_.get(), 0);
+    second_frame_ = VideoFrame::CreateFrame(
+        PIXEL_FORMAT_I420, size, gfx::Rect(size), size,
+        base::TimeDelta::FromMilliseconds(33));
+    PopulateVideoFrame(second_frame_.get(), 128);
+
+    if (has_capture_counters) {
+      first_frame_->metadata()->SetInteger(VideoFrameMetadata::CAPTURE_COUNTER,
+                                           0);
+      second_frame_->metadata()->SetInteger(
+          VideoFrameMetadata::CAPTURE_COUNTER, 1);
+    }
+    if (!update_rect.IsEmpty()) {
+      second_frame_->metadata()->SetRect(
+          VideoFrameMetadata::CAPTURE_UPDATE_RECT, update_rect);
+    }
+  }
+
+  // Encodes and decodes both frames, and returns the second decoded frame.
+  scoped_refptr<VideoFrame> EncodeAndDecodeFrames() {
+    Vp8Encoder encoder(GetDefaultVideoSenderConfig());
+    encoder.Initialize();
+    EncodeAndDecode(&encoder, first_frame_);
+    return EncodeAndDecode(&encoder, second_frame_);
+  }
+
+  scoped_refptr<VideoFrame> first_frame_;
+  scoped_refptr<VideoFrame> second_frame_;
+
+ private:
+  scoped_refptr<VideoFrame> EncodeAndDecode(
+      Vp8Encoder* encoder,
+      const scoped_refptr<VideoFrame>& video_frame) {
+    SenderEncodedFrame encoded_frame;
+    encoder->Encode(video_frame,
+                    base::TimeTicks::UnixEpoch() + video_frame->timestamp(),
+                    &encoded_frame);
+    EXPECT_FALSE(encoded_frame.data.empty());
+
+    EXPECT_EQ(VPX_CODEC_OK,
+              vpx_codec_decode(
+                  &decoder_,
+                  reinterpret_cast<const uint8_t*>(encoded_frame.data.data()),
+                  encoded_frame.data.size(), nullptr, 0));
+    vpx_codec_iter_t iter = nullptr;
+    vpx_image_t* const image = vpx_codec_get_frame(&decoder_, &iter);
+    if (!image)
+      return nullptr;
+
+    const gfx::Size size(image->d_w, image->d_h);
+    scoped_refptr<VideoFrame> decoded_frame = VideoFrame::CreateFrame(
+        PIXEL_FORMAT_I420, size, gfx::Rect(size), size, base::TimeDelta());
+    for (size_t plane = VideoFrame::kYPlane; plane <= VideoFrame::kVPlane;
+         ++plane) {
+      const int rows =
+          VideoFrame::Rows(plane, PIXEL_FORMAT_I420, size.height());
+      const int row_bytes =
+          VideoFrame::RowBytes(plane, PIXEL_FORMAT_I420, size.width());
+      for (int row = 0; row < rows; ++row) {
+        memcpy(decoded_frame->data(plane) + row * decoded_frame->stride(plane),
+               image->planes[plane] + row * image->stride[plane], row_bytes);
+      }
+    }
+    return decoded_frame;
+  }
+
+  vpx_codec_ctx_t decoder_;
+
+  DISALLOW_COPY_AND_ASSIGN(Vp8EncoderTest);
+};
+
+TEST_F(Vp8EncoderTest, EncodesEveryMacroblockWithoutDamageInfo) {
+  base::test::ScopedFeatureList feature_list;
+  feature_list.InitAndEnableFeature(kCastVp8ActiveMap);
+
+  // No metadata at all.
+  CreateFrames(false, gfx::Rect());
+  scoped_refptr<VideoFrame> decoded_frame = EncodeAndDecodeFrames();
+  ASSERT_TRUE(decoded_frame);
+  EXPECT_GT(I420PSNR(decoded_frame, second_frame_),
+            I420PSNR(decoded_frame, first_frame_));
+
+  // Consecutive capture counters, but no update rect.
+  CreateFrames(true, gfx::Rect());
+  decoded_frame = EncodeAndDecodeFrames();
+  ASSERT_TRUE(decoded_frame);
+  EXPECT_GT(I420PSNR(decoded_frame, second_frame_),
+            I420PSNR(decoded_frame, first_frame_));
+}
+
+TEST_F(Vp8EncoderTest, SkipsMacroblocksOutsideUpdateRect) {
+  base::test::ScopedFeatureList feature_list;
+  feature_list.InitAndEnableFeature(kCastVp8ActiveMap);
+
+  // Only the top-left macroblock is marked as updated, so most of the decoded
+  // picture still shows the first frame.
+  CreateFrames(true, gfx::Rect(0, 0, 16, 16));
+  scoped_refptr<VideoFrame> decoded_frame = EncodeAndDecodeFrames();
+  ASSERT_TRUE(decoded_frame);
+  EXPECT_GT(I420PSNR(decoded_frame, first_frame_),
+            I420PSNR(decoded_frame, second_frame_));
+}
+
+TEST_F(Vp8EncoderTest, IgnoresUpdateRectWhenFeatureDisabled) {
+  base::test::ScopedFeatureList feature_list;
+  feature_list.InitAndDisableFeature(kCastVp8ActiveMap);
+
+  CreateFrames(true, gfx::Rect(0, 0, 16, 16));
+  scoped_refptr<VideoFrame> decoded_frame = EncodeAndDecodeFrames();
+  ASSERT_TRUE(decoded_frame);
+  EXPECT_GT(I420PSNR(decoded_frame, second_frame_),
+            I420PSNR(decoded_frame, first_frame_));
+}
+
+}  // namespace cast
+}  // namespace media
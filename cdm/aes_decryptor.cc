@@ -5,22 +5,27 @@
 #include "media/cdm/aes_decryptor.h"
 
 #include <stddef.h>
+#include <algorithm>
 #include <list>
 #include <utility>
 #include <vector>
 
+#include <openssl/evp.h>
+
 #include "base/bind.h"
 #include "base/logging.h"
 #include "base/macros.h"
 #include "base/memory/ptr_util.h"
+#include "base/numerics/safe_conversions.h"
 #include "base/strings/string_number_conversions.h"
 #include "base/time/time.h"
-#include "crypto/encryptor.h"
+#include "crypto/openssl_util.h"
 #include "crypto/symmetric_key.h"
 #include "media/base/audio_decoder_config.h"
 #include "media/base/cdm_promise.h"
 #include "media/base/decoder_buffer.h"
 #include "media/base/decrypt_config.h"
+#include "media/base/encryption_scheme.h"
 #include "media/base/limits.h"
 #include "media/base/video_decoder_config.h"
 #include "media/base/video_frame.h"
@@ -150,82 +155,127 @@ void AesDecryptor::SessionIdDecryptionKeyMap::Erase(
   key_list_.erase(position);
 }
 
-enum ClearBytesBufferSel {
-  kSrcContainsClearBytes,
-  kDstContainsClearBytes
-};
-
-static void CopySubsamples(const std::vector<SubsampleEntry>& subsamples,
-                           const ClearBytesBufferSel sel,
-                           const uint8_t* src,
-                           uint8_t* dst) {
-  for (size_t i = 0; i < subsamples.size(); i++) {
-    const SubsampleEntry& subsample = subsamples[i];
-    if (sel == kSrcContainsClearBytes) {
-      src += subsample.clear_bytes;
-    } else {
-      dst += subsample.clear_bytes;
+// Decrypts |size| bytes from |src| into |dst|, continuing from the cipher
+// state that previous calls left in |ctx|.
+static bool DecryptBytes(EVP_CIPHER_CTX* ctx,
+                         const uint8_t* src,
+                         size_t size,
+                         uint8_t* dst) {
+  if (size == 0)
+    return true;
+  int decrypted_size = 0;
+  return EVP_DecryptUpdate(ctx, dst, &decrypted_size, src,
+                           base::checked_cast<int>(size)) &&
+         decrypted_size == static_cast<int>(size);
+}
+
+// Decrypts the |size| byte encrypted portion of a subsample from |src| into
+// |dst|. With a |pattern| in effect, runs of encrypted blocks are decrypted and
+// the skipped blocks between them are copied without passing through the
+// cipher; only whole blocks are covered by the pattern and any remaining bytes
+// are clear. Without a pattern every byte is decrypted, except for a trailing
+// partial block in CBC mode, which is left in the clear.
+static bool DecryptProtectedRange(EVP_CIPHER_CTX* ctx,
+                                  EncryptionScheme::CipherMode mode,
+                                  const EncryptionScheme::Pattern& pattern,
+                                  const uint8_t* src,
+                                  size_t size,
+                                  uint8_t* dst) {
+  const size_t kBlockSize = DecryptConfig::kDecryptionKeySize;
+  size_t offset = 0;
+  if (!pattern.IsInEffect()) {
+    offset = mode == EncryptionScheme::CIPHER_MODE_AES_CBC
+                 ? size - size % kBlockSize
+                 : size;
+    if (!DecryptBytes(ctx, src, offset, dst))
+      return false;
+  } else {
+    const size_t encrypt_size = pattern.encrypt_blocks() * kBlockSize;
+    const size_t skip_size = pattern.skip_blocks() * kBlockSize;
+    const size_t pattern_end = size - size % kBlockSize;
+    while (offset < pattern_end) {
+      const size_t decrypt_size = std::min(encrypt_size, pattern_end - offset);
+      if (!DecryptBytes(ctx, src + offset, decrypt_size, dst + offset))
+        return false;
+      offset += decrypt_size;
+      const size_t skipped_size = std::min(skip_size, pattern_end - offset);
+      memcpy(dst + offset, src + offset, skipped_size);
+      offset += skipped_size;
     }
-    memcpy(dst, src, subsample.cypher_bytes);
-    src += subsample.cypher_bytes;
-    dst += subsample.cypher_bytes;
   }
+  memcpy(dst + offset, src + offset, size - offset);
+  return true;
 }
 
 // Decrypts |input| using |key|.  Returns a DecoderBuffer with the decrypted
 // data if decryption succeeded or NULL if decryption failed.
-static scoped_refptr<DecoderBuffer> DecryptData(
-    const DecoderBuffer& input,
-    const crypto::SymmetricKey* key) {
+//
+// The output is written in a single pass: clear bytes are copied straight
+// across and cipher bytes are decrypted from |input| directly into the output
+// buffer, so every byte of the sample is read and written exactly once.
+//
+// Both AES-CTR ('cenc' and 'cens') and AES-CBC ('cbcs') are supported. In CTR
+// mode the encrypted blocks of all subsamples form one contiguous keystream;
+// in CBC mode each subsample starts a new chain from the IV.
+static scoped_refptr<DecoderBuffer> DecryptData(const DecoderBuffer& input,
+                                                crypto::SymmetricKey* key) {
   CHECK(input.data_size());
   CHECK(input.decrypt_config());
   CHECK(key);
 
-  crypto::Encryptor encryptor;
-  if (!encryptor.Init(key, crypto::Encryptor::CTR, "")) {
-    DVLOG(1) << "Could not initialize decryptor.";
+  const size_t kBlockSize = DecryptConfig::kDecryptionKeySize;
+  const std::string& raw_key = key->key();
+  if (raw_key.size() != kBlockSize) {
+    DVLOG(1) << "Unsupported key size " << raw_key.size();
     return NULL;
   }
 
-  DCHECK_EQ(input.decrypt_config()->iv().size(),
-            static_cast<size_t>(DecryptConfig::kDecryptionKeySize));
-  if (!encryptor.SetCounter(input.decrypt_config()->iv())) {
+  const std::string& iv = input.decrypt_config()->iv();
+  DCHECK_EQ(iv.size(), kBlockSize);
+  if (iv.size() != kBlockSize) {
     DVLOG(1) << "Could not set counter block.";
     return NULL;
   }
 
-  const char* sample = reinterpret_cast<const char*>(input.data());
+  const EncryptionScheme& scheme = input.decrypt_config()->encryption_scheme();
+  const EVP_CIPHER* cipher = nullptr;
+  switch (scheme.mode()) {
+    case EncryptionScheme::CIPHER_MODE_AES_CTR:
+      cipher = EVP_aes_128_ctr();
+      break;
+    case EncryptionScheme::CIPHER_MODE_AES_CBC:
+      cipher = EVP_aes_128_cbc();
+      break;
+    case EncryptionScheme::CIPHER_MODE_UNENCRYPTED:
+      DVLOG(1) << "Encrypted buffer without a cipher mode.";
+      return NULL;
+  }
+
+  const uint8_t* sample = input.data();
   size_t sample_size = static_cast<size_t>(input.data_size());
 
   DCHECK_GT(sample_size, 0U) << "No sample data to be decrypted.";
   if (sample_size == 0)
     return NULL;
 
-  if (input.decrypt_config()->subsamples().empty()) {
-    std::string decrypted_text;
-    base::StringPiece encrypted_text(sample, sample_size);
-    if (!encryptor.Decrypt(encrypted_text, &decrypted_text)) {
-      DVLOG(1) << "Could not decrypt data.";
-      return NULL;
-    }
-
-    // TODO(xhwang): Find a way to avoid this data copy.
-    return DecoderBuffer::CopyFrom(
-        reinterpret_cast<const uint8_t*>(decrypted_text.data()),
-        decrypted_text.size());
+  // A sample without subsamples is treated as a single all-cipher subsample.
+  std::vector<SubsampleEntry> whole_sample;
+  const std::vector<SubsampleEntry>* subsamples =
+      &input.decrypt_config()->subsamples();
+  if (subsamples->empty()) {
+    whole_sample.push_back(
+        SubsampleEntry(0, base::checked_cast<uint32_t>(sample_size)));
+    subsamples = &whole_sample;
   }
 
-  const std::vector<SubsampleEntry>& subsamples =
-      input.decrypt_config()->subsamples();
-
   size_t total_clear_size = 0;
   size_t total_encrypted_size = 0;
-  for (size_t i = 0; i < subsamples.size(); i++) {
-    total_clear_size += subsamples[i].clear_bytes;
-    total_encrypted_size += subsamples[i].cypher_bytes;
+  for (const SubsampleEntry& subsample : *subsamples) {
+    total_clear_size += subsample.clear_bytes;
+    total_encrypted_size += subsample.cypher_bytes;
     // Check for overflow. This check is valid because *_size is unsigned.
-    DCHECK(total_clear_size >= subsamples[i].clear_bytes);
-    if (total_encrypted_size < subsamples[i].cypher_bytes)
+    DCHECK(total_clear_size >= subsample.clear_bytes);
+    if (total_encrypted_size < subsample.cypher_bytes)
       return NULL;
   }
   size_t total_size = total_clear_size + total_encrypted_size;
@@ -234,38 +284,54 @@ static scoped_refptr<DecoderBuffer> DecryptData(
     return NULL;
   }
 
+  scoped_refptr<DecoderBuffer> output(new DecoderBuffer(sample_size));
+
   // No need to decrypt if there is no encrypted data.
-  if (total_encrypted_size <= 0) {
-    return DecoderBuffer::CopyFrom(reinterpret_cast<const uint8_t*>(sample),
-                                   sample_size);
+  if (total_encrypted_size == 0) {
+    memcpy(output->writable_data(), sample, sample_size);
+    return output;
   }
 
-  // The encrypted portions of all subsamples must form a contiguous block,
-  // such that an encrypted subsample that ends away from a block boundary is
-  // immediately followed by the start of the next encrypted subsample. We
-  // copy all encrypted subsamples to a contiguous buffer, decrypt them, then
-  // copy the decrypted bytes over the encrypted bytes in the output.
-  // TODO(strobe): attempt to reduce number of memory copies
-  std::unique_ptr<uint8_t[]> encrypted_bytes(new uint8_t[total_encrypted_size]);
-  CopySubsamples(subsamples, kSrcContainsClearBytes,
-                 reinterpret_cast<const uint8_t*>(sample),
-                 encrypted_bytes.get());
-
-  base::StringPiece encrypted_text(
-      reinterpret_cast<const char*>(encrypted_bytes.get()),
-      total_encrypted_size);
-  std::string decrypted_text;
-  if (!encryptor.Decrypt(encrypted_text, &decrypted_text)) {
-    DVLOG(1) << "Could not decrypt data.";
+  crypto::OpenSSLErrStackTracer err_tracer(FROM_HERE);
+  bssl::ScopedEVP_CIPHER_CTX ctx;
+  if (!EVP_DecryptInit_ex(ctx.get(), cipher, nullptr,
+                          reinterpret_cast<const uint8_t*>(raw_key.data()),
+                          reinterpret_cast<const uint8_t*>(iv.data())) ||
+      !EVP_CIPHER_CTX_set_padding(ctx.get(), 0)) {
+    DVLOG(1) << "Could not initialize decryptor.";
     return NULL;
   }
-  DCHECK_EQ(decrypted_text.size(), encrypted_text.size());
 
-  scoped_refptr<DecoderBuffer> output = DecoderBuffer::CopyFrom(
-      reinterpret_cast<const uint8_t*>(sample), sample_size);
-  CopySubsamples(subsamples, kDstContainsClearBytes,
-                 reinterpret_cast<const uint8_t*>(decrypted_text.data()),
-                 output->writable_data());
+  // In CTR mode, an encrypted subsample that ends away from a block boundary
+  // is immediately followed by the start of the next encrypted subsample. The
+  // cipher context carries the partially used counter block across calls, so
+  // each cipher range can be decrypted as it is reached.
+  const uint8_t* src = sample;
+  uint8_t* dst = output->writable_data();
+  bool first_protected_range = true;
+  for (const SubsampleEntry& subsample : *subsamples) {
+    memcpy(dst, src, subsample.clear_bytes);
+    src += subsample.clear_bytes;
+    dst += subsample.clear_bytes;
+
+    if (subsample.cypher_bytes == 0)
+      continue;
+    if (scheme.mode() == EncryptionScheme::CIPHER_MODE_AES_CBC &&
+        !first_protected_range &&
+        !EVP_DecryptInit_ex(ctx.get(), nullptr, nullptr, nullptr,
+                            reinterpret_cast<const uint8_t*>(iv.data()))) {
+      DVLOG(1) << "Could not reset the CBC chain.";
+      return NULL;
+    }
+    first_protected_range = false;
+    if (!DecryptProtectedRange(ctx.get(), scheme.mode(), scheme.pattern(), src,
+                               subsample.cypher_bytes, dst)) {
+      DVLOG(1) << "Could not decrypt data.";
+      return NULL;
+    }
+    src += subsample.cypher_bytes;
+    dst += subsample.cypher_bytes;
+  }
   return output;
 }
 
@@ -30,7 +30,8 @@ class SymmetricKey;
 namespace media {
 
 // Decrypts an AES encrypted buffer into an unencrypted buffer. The AES
-// encryption must be CTR with a key size of 128bits.
+// encryption must use a key size of 128bits, in CTR mode ('cenc' and 'cens')
+// or CBC mode ('cbcs').
 class MEDIA_EXPORT AesDecryptor : public ContentDecryptionModule,
                                   public CdmContext,
                                   public Decryptor {
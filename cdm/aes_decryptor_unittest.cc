@@ -10,6 +10,8 @@
 #include <string>
 #include <vector>
 
+#include <openssl/aes.h>
+
 #include "base/bind.h"
 #include "base/debug/leak_annotations.h"
 #include "base/json/json_reader.h"
@@ -24,7 +26,9 @@
 #include "media/base/decoder_buffer.h"
 #include "media/base/decrypt_config.h"
 #include "media/base/decryptor.h"
+#include "media/base/encryption_scheme.h"
 #include "media/base/media_switches.h"
+#include "media/base/media_util.h"
 #include "media/base/mock_filters.h"
 #include "media/cdm/cdm_module.h"
 #include "media/media_features.h"
@@ -213,7 +217,8 @@ scoped_refptr<DecoderBuffer> CreateEncryptedBuffer(
     const std::vector<uint8_t>& data,
     const std::vector<uint8_t>& key_id,
     const std::vector<uint8_t>& iv,
-    const std::vector<SubsampleEntry>& subsample_entries) {
+    const std::vector<SubsampleEntry>& subsample_entries,
+    const EncryptionScheme& encryption_scheme = AesCtrEncryptionScheme()) {
   DCHECK(!data.empty());
   scoped_refptr<DecoderBuffer> encrypted_buffer(new DecoderBuffer(data.size()));
   memcpy(encrypted_buffer->writable_data(), &data[0], data.size());
@@ -224,10 +229,68 @@ scoped_refptr<DecoderBuffer> CreateEncryptedBuffer(
   std::string iv_string(
       reinterpret_cast<const char*>(iv.empty() ? NULL : &iv[0]), iv.size());
   encrypted_buffer->set_decrypt_config(std::unique_ptr<DecryptConfig>(
-      new DecryptConfig(key_id_string, iv_string, subsample_entries)));
+      new DecryptConfig(key_id_string, iv_string, subsample_entries,
+                        encryption_scheme)));
   return encrypted_buffer;
 }
 
+// Encrypts |plain_text| with the key in kKeyAsJWK and kIv following
+// |subsample_entries| and the CENC 3rd edition |encryption_scheme|. This
+// reference implementation works one AES block at a time and is used to
+// produce 'cens' and 'cbcs' test vectors. Without a pattern, every whole block
+// is encrypted.
+std::vector<uint8_t> EncryptWithScheme(
+    const std::vector<uint8_t>& plain_text,
+    const std::vector<SubsampleEntry>& subsample_entries,
+    const EncryptionScheme& encryption_scheme) {
+  const size_t kBlockSize = DecryptConfig::kDecryptionKeySize;
+  const uint8_t kKey[] = {0x04, 0x05, 0x06, 0x07, 0x08, 0x09, 0x0a, 0x0b,
+                          0x0c, 0x0d, 0x0e, 0x0f, 0x10, 0x11, 0x12, 0x13};
+  AES_KEY aes_key;
+  CHECK_EQ(0, AES_set_encrypt_key(kKey, 128, &aes_key));
+
+  const EncryptionScheme::Pattern& pattern = encryption_scheme.pattern();
+  const size_t encrypt_blocks =
+      pattern.IsInEffect() ? pattern.encrypt_blocks() : 1;
+  const size_t skip_blocks = pattern.IsInEffect() ? pattern.skip_blocks() : 0;
+  const bool is_cbc =
+      encryption_scheme.mode() == EncryptionScheme::CIPHER_MODE_AES_CBC;
+
+  std::vector<uint8_t> cipher_text(plain_text);
+  uint8_t counter[kBlockSize];
+  memcpy(counter, kIv, kBlockSize);
+  size_t offset = 0;
+  for (const SubsampleEntry& subsample : subsample_entries) {
+    offset += subsample.clear_bytes;
+    uint8_t chain[kBlockSize];
+    memcpy(chain, kIv, kBlockSize);
+    for (size_t i = 0; i < subsample.cypher_bytes / kBlockSize; ++i) {
+      if (i % (encrypt_blocks + skip_blocks) >= encrypt_blocks)
+        continue;
+      uint8_t* block = &cipher_text[offset + i * kBlockSize];
+      if (is_cbc) {
+        for (size_t j = 0; j < kBlockSize; ++j)
+          block[j] ^= chain[j];
+        AES_encrypt(block, block, &aes_key);
+        memcpy(chain, block, kBlockSize);
+      } else {
+        uint8_t keystream[kBlockSize];
+        AES_encrypt(counter, keystream, &aes_key);
+        for (size_t j = 0; j < kBlockSize; ++j)
+          block[j] ^= keystream[j];
+        // Increment the counter block as a 128-bit big-endian integer.
+        for (size_t j = kBlockSize; j > 0; --j) {
+          if (++counter[j - 1] != 0)
+            break;
+        }
+      }
+    }
+    offset += subsample.cypher_bytes;
+  }
+  CHECK_EQ(plain_text.size(), offset);
+  return cipher_text;
+}
+
 enum ExpectedResult { RESOLVED, REJECTED };
 
 enum class TestType {
@@ -746,6 +809,108 @@ TEST_P(AesDecryptorTest, SubsampleDecryptionWithOffset) {
   DecryptAndExpect(encrypted_buffer, original_data_, SUCCESS);
 }
 
+// Cypher ranges that start and end away from block boundaries must continue a
+// single keystream, independent of the clear bytes interleaved between them.
+TEST_P(AesDecryptorTest, SubsampleDecryptionAcrossBlockBoundaries) {
+  std::string session_id = CreateSession(key_id_);
+  UpdateSessionAndExpect(session_id, kKeyAsJWK, RESOLVED, true);
+
+  const SubsampleEntry kSubsampleEntries[] = {{5, 3}, {0, 14}, {2, 1}, {1, 6}};
+  std::vector<uint8_t> encrypted_data;
+  std::vector<uint8_t> expected_data;
+  size_t offset = 0;
+  for (const SubsampleEntry& subsample : kSubsampleEntries) {
+    encrypted_data.insert(encrypted_data.end(), subsample.clear_bytes, 0xAA);
+    expected_data.insert(expected_data.end(), subsample.clear_bytes, 0xAA);
+    encrypted_data.insert(encrypted_data.end(),
+                          encrypted_data_.begin() + offset,
+                          encrypted_data_.begin() + offset +
+                              subsample.cypher_bytes);
+    expected_data.insert(expected_data.end(), original_data_.begin() + offset,
+                         original_data_.begin() + offset +
+                             subsample.cypher_bytes);
+    offset += subsample.cypher_bytes;
+  }
+  ASSERT_EQ(encrypted_data_.size(), offset);
+
+  scoped_refptr<DecoderBuffer> encrypted_buffer = CreateEncryptedBuffer(
+      encrypted_data, key_id_, iv_,
+      std::vector<SubsampleEntry>(
+          kSubsampleEntries, kSubsampleEntries + arraysize(kSubsampleEntries)));
+  DecryptAndExpect(encrypted_buffer, expected_data, SUCCESS);
+}
+
+TEST_P(AesDecryptorTest, CbcsPatternDecryption) {
+  // The CDM interface does not carry the encryption scheme.
+  if (GetParam() == TestType::kCdmAdapter)
+    return;
+
+  std::string session_id = CreateSession(key_id_);
+  UpdateSessionAndExpect(session_id, kKeyAsJWK, RESOLVED, true);
+
+  // The second subsample restarts the CBC chain and ends in a partial block,
+  // which is left in the clear.
+  const EncryptionScheme scheme(EncryptionScheme::CIPHER_MODE_AES_CBC,
+                                EncryptionScheme::Pattern(1, 9));
+  const std::vector<SubsampleEntry> subsamples = {{10, 336}, {5, 49}};
+  std::vector<uint8_t> plain_text(400);
+  for (size_t i = 0; i < plain_text.size(); ++i)
+    plain_text[i] = static_cast<uint8_t>(i * 7);
+
+  scoped_refptr<DecoderBuffer> encrypted_buffer = CreateEncryptedBuffer(
+      EncryptWithScheme(plain_text, subsamples, scheme), key_id_, iv_,
+      subsamples, scheme);
+  DecryptAndExpect(encrypted_buffer, plain_text, SUCCESS);
+
+  // The same data must not decrypt as full-sample CTR.
+  encrypted_buffer = CreateEncryptedBuffer(
+      EncryptWithScheme(plain_text, subsamples, scheme), key_id_, iv_,
+      subsamples);
+  DecryptAndExpect(encrypted_buffer, plain_text, DATA_MISMATCH);
+}
+
+TEST_P(AesDecryptorTest, CensPatternDecryption) {
+  if (GetParam() == TestType::kCdmAdapter)
+    return;
+
+  std::string session_id = CreateSession(key_id_);
+  UpdateSessionAndExpect(session_id, kKeyAsJWK, RESOLVED, true);
+
+  // The keystream only advances over encrypted blocks, and runs on from one
+  // subsample to the next.
+  const EncryptionScheme scheme(EncryptionScheme::CIPHER_MODE_AES_CTR,
+                                EncryptionScheme::Pattern(2, 3));
+  const std::vector<SubsampleEntry> subsamples = {{3, 200}, {0, 90}, {7, 0}};
+  std::vector<uint8_t> plain_text(300);
+  for (size_t i = 0; i < plain_text.size(); ++i)
+    plain_text[i] = static_cast<uint8_t>(i * 13);
+
+  scoped_refptr<DecoderBuffer> encrypted_buffer = CreateEncryptedBuffer(
+      EncryptWithScheme(plain_text, subsamples, scheme), key_id_, iv_,
+      subsamples, scheme);
+  DecryptAndExpect(encrypted_buffer, plain_text, SUCCESS);
+}
+
+// AES-CBC without a pattern, as used by HLS SAMPLE-AES audio.
+TEST_P(AesDecryptorTest, CbcFullSampleDecryption) {
+  if (GetParam() == TestType::kCdmAdapter)
+    return;
+
+  std::string session_id = CreateSession(key_id_);
+  UpdateSessionAndExpect(session_id, kKeyAsJWK, RESOLVED, true);
+
+  const EncryptionScheme scheme(EncryptionScheme::CIPHER_MODE_AES_CBC,
+                                EncryptionScheme::Pattern());
+  std::vector<uint8_t> plain_text(100);
+  for (size_t i = 0; i < plain_text.size(); ++i)
+    plain_text[i] = static_cast<uint8_t>(i * 3);
+
+  scoped_refptr<DecoderBuffer> encrypted_buffer = CreateEncryptedBuffer(
+      EncryptWithScheme(plain_text, {{0, 100}}, scheme), key_id_, iv_,
+      no_subsample_entries_, scheme);
+  DecryptAndExpect(encrypted_buffer, plain_text, SUCCESS);
+}
+
 TEST_P(AesDecryptorTest, SubsampleWrongSize) {
   std::string session_id = CreateSession(key_id_);
   UpdateSessionAndExpect(session_id, kKeyAsJWK, RESOLVED, true);
@@ -4,10 +4,47 @@
 
 #include "media/cdm/cdm_allocator.h"
 
+#include "base/numerics/safe_math.h"
+
 namespace media {
 
+// Enough for the frames of a decode loop to be recycled, without holding on
+// to a lot of memory once the frame size changes.
+const size_t CdmAllocator::kMaxFreeBuffers = 3;
+
 CdmAllocator::CdmAllocator() {}
 
 CdmAllocator::~CdmAllocator() {}
 
+CdmAllocator::Stats CdmAllocator::GetStats() const {
+  return Stats();
+}
+
+// static
+size_t CdmAllocator::GetBucketSize(size_t capacity) {
+  // Small buffers, e.g. for decrypted audio, all share the smallest bucket.
+  const size_t kMinBucketSize = 4096;
+  if (capacity <= kMinBucketSize)
+    return kMinBucketSize;
+
+  // Round up to a multiple of the largest power of two that is at most 1/16th
+  // of |capacity|, which wastes less than 1/16th of the bucket.
+  size_t granularity = kMinBucketSize / 16;
+  while (granularity <= capacity / 32)
+    granularity *= 2;
+
+  base::CheckedNumeric<size_t> bucket_size(capacity);
+  bucket_size += granularity - 1;
+  if (!bucket_size.IsValid())
+    return capacity;
+  return bucket_size.ValueOrDie() & ~(granularity - 1);
+}
+
+// static
+bool CdmAllocator::CanReuseBuffer(size_t buffer_capacity, size_t bucket_size) {
+  // Do not hand out a large buffer, e.g. one that held a video frame, for a
+  // much smaller request; the large buffer will be needed again soon.
+  return buffer_capacity >= bucket_size && buffer_capacity / 2 <= bucket_size;
+}
+
 }  // namespace media
@@ -27,6 +27,18 @@ class MEDIA_EXPORT CdmAllocator {
   // Callback to create CdmAllocator for the created CDM.
   using CreationCB = base::RepeatingCallback<std::unique_ptr<CdmAllocator>()>;
 
+  // Counters describing how an allocator recycles the memory of destroyed
+  // buffers.
+  struct Stats {
+    // Number of buffers created with newly allocated memory.
+    size_t buffers_allocated = 0;
+    // Number of buffers created with the memory of a destroyed buffer.
+    size_t buffers_reused = 0;
+    // Number and total capacity of destroyed buffers kept for reuse.
+    size_t free_buffers = 0;
+    size_t free_bytes = 0;
+  };
+
   virtual ~CdmAllocator();
 
   // Creates a buffer with at least |capacity| bytes. Caller is required to
@@ -36,9 +48,25 @@ class MEDIA_EXPORT CdmAllocator {
   // Returns a new VideoFrameImpl.
   virtual std::unique_ptr<VideoFrameImpl> CreateCdmVideoFrame() = 0;
 
+  // Returns the recycling counters of this allocator. Allocators that do not
+  // recycle buffers report all zeros.
+  virtual Stats GetStats() const;
+
  protected:
+  // Maximum number of destroyed buffers kept for reuse.
+  static const size_t kMaxFreeBuffers;
+
   CdmAllocator();
 
+  // Rounds |capacity| up to the size of the bucket it belongs to. Buckets are
+  // at most 1/16th of their size apart, so that requests whose size fluctuates
+  // slightly, e.g. decoded frames of the same resolution, share buffers.
+  static size_t GetBucketSize(size_t capacity);
+
+  // Returns whether a destroyed buffer of |buffer_capacity| bytes should be
+  // reused for a request of |bucket_size| bytes.
+  static bool CanReuseBuffer(size_t buffer_capacity, size_t bucket_size);
+
  private:
   DISALLOW_COPY_AND_ASSIGN(CdmAllocator);
 };
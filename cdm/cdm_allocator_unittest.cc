@@ -0,0 +1,81 @@
+// Copyright 2017 The Chromium Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#include "media/cdm/cdm_allocator.h"
+
+#include <stddef.h>
+
+#include <limits>
+#include <memory>
+
+#include "base/macros.h"
+#include "media/cdm/cdm_helpers.h"
+#include "testing/gtest/include/gtest/gtest.h"
+
+namespace media {
+
+namespace {
+
+// Exposes the recycling policy shared by all allocators.
+class TestCdmAllocator : public CdmAllocator {
+ public:
+  TestCdmAllocator() {}
+  ~TestCdmAllocator() override {}
+
+  using CdmAllocator::GetBucketSize;
+  using CdmAllocator::CanReuseBuffer;
+
+  // CdmAllocator implementation.
+  cdm::Buffer* CreateCdmBuffer(size_t capacity) override { return nullptr; }
+  std::unique_ptr<VideoFrameImpl> CreateCdmVideoFrame() override {
+    return nullptr;
+  }
+
+ private:
+  DISALLOW_COPY_AND_ASSIGN(TestCdmAllocator);
+};
+
+}  // namespace
+
+TEST(CdmAllocatorTest, SmallBuffersShareOneBucket) {
+  EXPECT_EQ(4096u, TestCdmAllocator::GetBucketSize(0));
+  EXPECT_EQ(4096u, TestCdmAllocator::GetBucketSize(1));
+  EXPECT_EQ(4096u, TestCdmAllocator::GetBucketSize(4096));
+  EXPECT_LT(4096u, TestCdmAllocator::GetBucketSize(4097));
+}
+
+TEST(CdmAllocatorTest, BucketsWasteLessThanOneSixteenth) {
+  for (size_t capacity = 4097; capacity < 64 * 1024 * 1024;
+       capacity = capacity * 3 / 2 + 7) {
+    const size_t bucket_size = TestCdmAllocator::GetBucketSize(capacity);
+    EXPECT_GE(bucket_size, capacity);
+    EXPECT_LT(bucket_size - capacity, bucket_size / 16) << capacity;
+    // A bucket size is its own bucket.
+    EXPECT_EQ(bucket_size, TestCdmAllocator::GetBucketSize(bucket_size));
+  }
+}
+
+TEST(CdmAllocatorTest, SimilarSizesShareABucket) {
+  // Decoded frames of one resolution vary slightly in size with the strides
+  // chosen by the CDM.
+  const size_t kFrameSize = 1920 * 1080 * 3 / 2;
+  EXPECT_EQ(TestCdmAllocator::GetBucketSize(kFrameSize),
+            TestCdmAllocator::GetBucketSize(kFrameSize + 1000));
+}
+
+TEST(CdmAllocatorTest, BucketSizeDoesNotOverflow) {
+  const size_t kMax = std::numeric_limits<size_t>::max();
+  EXPECT_EQ(kMax, TestCdmAllocator::GetBucketSize(kMax));
+}
+
+TEST(CdmAllocatorTest, CanReuseBuffer) {
+  // A buffer is reused for requests between half its size and its size.
+  EXPECT_TRUE(TestCdmAllocator::CanReuseBuffer(8192, 8192));
+  EXPECT_TRUE(TestCdmAllocator::CanReuseBuffer(8192, 4096));
+  EXPECT_FALSE(TestCdmAllocator::CanReuseBuffer(8192, 4095));
+  EXPECT_FALSE(TestCdmAllocator::CanReuseBuffer(8192, 8193));
+  EXPECT_FALSE(TestCdmAllocator::CanReuseBuffer(1000000, 4096));
+}
+
+}  // namespace media
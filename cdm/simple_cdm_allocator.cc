@@ -4,8 +4,12 @@
 
 #include "media/cdm/simple_cdm_allocator.h"
 
+#include <map>
+#include <utility>
+
 #include "base/bind.h"
 #include "base/memory/ptr_util.h"
+#include "base/synchronization/lock.h"
 #include "media/base/video_frame.h"
 #include "media/cdm/cdm_helpers.h"
 #include "media/cdm/simple_cdm_buffer.h"
@@ -53,18 +57,97 @@ class SimpleCdmVideoFrame : public VideoFrameImpl {
 
 }  // namespace
 
-SimpleCdmAllocator::SimpleCdmAllocator() {}
+class SimpleCdmAllocator::BufferPool
+    : public base::RefCountedThreadSafe<BufferPool> {
+ public:
+  BufferPool() : shut_down_(false) {}
+
+  // Returns the memory of a destroyed buffer that can be reused for a request
+  // of |bucket_size| bytes, and sets |bucket_size| to its actual capacity.
+  // Returns null if there is no such buffer.
+  std::unique_ptr<uint8_t[]> Take(size_t* bucket_size) {
+    base::AutoLock auto_lock(lock_);
+    auto found = free_buffers_.lower_bound(*bucket_size);
+    if (found == free_buffers_.end() ||
+        !CanReuseBuffer(found->first, *bucket_size)) {
+      ++stats_.buffers_allocated;
+      return nullptr;
+    }
+
+    ++stats_.buffers_reused;
+    *bucket_size = found->first;
+    stats_.free_bytes -= found->first;
+    std::unique_ptr<uint8_t[]> data = std::move(found->second);
+    free_buffers_.erase(found);
+    return data;
+  }
+
+  // Keeps |data| for reuse, evicting the smallest free buffers to keep at
+  // most kMaxFreeBuffers.
+  void Release(std::unique_ptr<uint8_t[]> data, size_t capacity) {
+    base::AutoLock auto_lock(lock_);
+    if (shut_down_)
+      return;
+
+    free_buffers_.insert(std::make_pair(capacity, std::move(data)));
+    stats_.free_bytes += capacity;
+    while (free_buffers_.size() > kMaxFreeBuffers) {
+      stats_.free_bytes -= free_buffers_.begin()->first;
+      free_buffers_.erase(free_buffers_.begin());
+    }
+  }
+
+  // Frees all free buffers, and those destroyed from now on.
+  void Shutdown() {
+    base::AutoLock auto_lock(lock_);
+    shut_down_ = true;
+    free_buffers_.clear();
+    stats_.free_bytes = 0;
+  }
+
+  Stats GetStats() const {
+    base::AutoLock auto_lock(lock_);
+    Stats stats = stats_;
+    stats.free_buffers = free_buffers_.size();
+    return stats;
+  }
+
+ private:
+  friend class base::RefCountedThreadSafe<BufferPool>;
+  ~BufferPool() {}
 
-SimpleCdmAllocator::~SimpleCdmAllocator() {}
+  mutable base::Lock lock_;
+  bool shut_down_;
 
-// Creates a new SimpleCdmBuffer on every request. It does not keep track of
-// the memory allocated, so the caller is responsible for calling Destroy()
-// on the buffer when it is no longer needed.
+  // Free buffers keyed by capacity.
+  std::multimap<size_t, std::unique_ptr<uint8_t[]>> free_buffers_;
+
+  Stats stats_;
+
+  DISALLOW_COPY_AND_ASSIGN(BufferPool);
+};
+
+SimpleCdmAllocator::SimpleCdmAllocator() : buffer_pool_(new BufferPool()) {}
+
+SimpleCdmAllocator::~SimpleCdmAllocator() {
+  buffer_pool_->Shutdown();
+}
+
+// Creates a new SimpleCdmBuffer on every request, reusing the memory of a
+// destroyed buffer if one of a similar size is available. The caller is
+// responsible for calling Destroy() on the buffer when it is no longer needed.
 cdm::Buffer* SimpleCdmAllocator::CreateCdmBuffer(size_t capacity) {
   if (!capacity)
     return nullptr;
 
-  return SimpleCdmBuffer::Create(capacity);
+  capacity = GetBucketSize(capacity);
+  std::unique_ptr<uint8_t[]> data = buffer_pool_->Take(&capacity);
+  if (!data)
+    data.reset(new uint8_t[capacity]);
+
+  return SimpleCdmBuffer::Create(
+      std::move(data), capacity,
+      base::Bind(&BufferPool::Release, buffer_pool_));
 }
 
 // Creates a new SimpleCdmVideoFrame on every request.
@@ -72,4 +155,8 @@ std::unique_ptr<VideoFrameImpl> SimpleCdmAllocator::CreateCdmVideoFrame() {
   return base::MakeUnique<SimpleCdmVideoFrame>();
 }
 
+CdmAllocator::Stats SimpleCdmAllocator::GetStats() const {
+  return buffer_pool_->GetStats();
+}
+
 }  // namespace media
@@ -10,11 +10,15 @@
 #include <memory>
 
 #include "base/macros.h"
+#include "base/memory/ref_counted.h"
 #include "media/cdm/cdm_allocator.h"
 
 namespace media {
 
-// This is a simple CdmAllocator for testing.
+// This is a simple CdmAllocator for testing. Buffers use heap memory, which is
+// recycled: the memory of a destroyed buffer is kept, bucketed by size, for
+// a later CreateCdmBuffer() call of a similar size. Buffers may be destroyed
+// on any thread, and may outlive the allocator.
 class SimpleCdmAllocator : public CdmAllocator {
  public:
   SimpleCdmAllocator();
@@ -23,8 +27,14 @@ class SimpleCdmAllocator : public CdmAllocator {
   // CdmAllocator implementation.
   cdm::Buffer* CreateCdmBuffer(size_t capacity) final;
   std::unique_ptr<VideoFrameImpl> CreateCdmVideoFrame() final;
+  Stats GetStats() const final;
 
  private:
+  // The memory of destroyed buffers, shared with the buffers themselves.
+  class BufferPool;
+
+  scoped_refptr<BufferPool> buffer_pool_;
+
   DISALLOW_COPY_AND_ASSIGN(SimpleCdmAllocator);
 };
 
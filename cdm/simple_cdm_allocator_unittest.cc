@@ -4,6 +4,7 @@
 
 #include <stdint.h>
 #include <memory>
+#include <vector>
 
 #include "base/macros.h"
 #include "media/base/video_frame.h"
@@ -64,6 +65,39 @@ TEST_F(SimpleCdmAllocatorTest, CreateCdmBuffer) {
   buffer->Destroy();
 }
 
+TEST_F(SimpleCdmAllocatorTest, ReuseCdmBuffer) {
+  cdm::Buffer* buffer = allocator_.CreateCdmBuffer(100000);
+  uint8_t* data = buffer->Data();
+  buffer->Destroy();
+
+  // The memory of the destroyed buffer is handed out again.
+  cdm::Buffer* new_buffer = allocator_.CreateCdmBuffer(100000);
+  EXPECT_EQ(data, new_buffer->Data());
+  EXPECT_EQ(1u, allocator_.GetStats().buffers_reused);
+  new_buffer->Destroy();
+}
+
+TEST_F(SimpleCdmAllocatorTest, MaxFreeBuffers) {
+  const size_t kMaxExpectedFreeBuffers = 3;
+  std::vector<cdm::Buffer*> buffers;
+  for (int i = 0; i < 10; ++i)
+    buffers.push_back(allocator_.CreateCdmBuffer(100000));
+  for (cdm::Buffer* buffer : buffers)
+    buffer->Destroy();
+
+  EXPECT_EQ(10u, allocator_.GetStats().buffers_allocated);
+  EXPECT_EQ(kMaxExpectedFreeBuffers, allocator_.GetStats().free_buffers);
+}
+
+TEST_F(SimpleCdmAllocatorTest, CdmBufferOutlivesAllocator) {
+  std::unique_ptr<SimpleCdmAllocator> allocator(new SimpleCdmAllocator());
+  cdm::Buffer* buffer = allocator->CreateCdmBuffer(100);
+  allocator.reset();
+
+  // The memory is freed rather than recycled.
+  buffer->Destroy();
+}
+
 TEST_F(SimpleCdmAllocatorTest, CreateCdmVideoFrame) {
   std::unique_ptr<VideoFrameImpl> video_frame =
       allocator_.CreateCdmVideoFrame();
@@ -5,6 +5,7 @@
 #include "media/cdm/simple_cdm_buffer.h"
 
 #include <limits>
+#include <utility>
 
 #include "base/logging.h"
 #include "base/numerics/safe_conversions.h"
@@ -14,27 +15,46 @@ namespace media {
 // static
 SimpleCdmBuffer* SimpleCdmBuffer::Create(size_t capacity) {
   DCHECK(capacity);
+  return Create(std::unique_ptr<uint8_t[]>(new uint8_t[capacity]), capacity,
+                ReleaseCB());
+}
+
+// static
+SimpleCdmBuffer* SimpleCdmBuffer::Create(std::unique_ptr<uint8_t[]> data,
+                                         size_t capacity,
+                                         const ReleaseCB& release_cb) {
+  DCHECK(data);
+  DCHECK(capacity);
 
   // cdm::Buffer interface limits capacity to uint32.
   DCHECK_LE(capacity, std::numeric_limits<uint32_t>::max());
-  return new SimpleCdmBuffer(base::checked_cast<uint32_t>(capacity));
+  return new SimpleCdmBuffer(std::move(data),
+                             base::checked_cast<uint32_t>(capacity),
+                             release_cb);
 }
 
-SimpleCdmBuffer::SimpleCdmBuffer(uint32_t capacity)
-    : buffer_(capacity), size_(0) {}
+SimpleCdmBuffer::SimpleCdmBuffer(std::unique_ptr<uint8_t[]> data,
+                                 uint32_t capacity,
+                                 const ReleaseCB& release_cb)
+    : data_(std::move(data)),
+      capacity_(capacity),
+      release_cb_(release_cb),
+      size_(0) {}
 
 SimpleCdmBuffer::~SimpleCdmBuffer() {}
 
 void SimpleCdmBuffer::Destroy() {
+  if (!release_cb_.is_null())
+    release_cb_.Run(std::move(data_), capacity_);
   delete this;
 }
 
 uint32_t SimpleCdmBuffer::Capacity() const {
-  return buffer_.size();
+  return capacity_;
 }
 
 uint8_t* SimpleCdmBuffer::Data() {
-  return buffer_.data();
+  return data_.get();
 }
 
 void SimpleCdmBuffer::SetSize(uint32_t size) {
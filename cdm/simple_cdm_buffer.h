@@ -8,19 +8,32 @@
 #include <stddef.h>
 #include <stdint.h>
 
-#include <vector>
+#include <memory>
 
+#include "base/callback.h"
 #include "base/macros.h"
 #include "media/cdm/api/content_decryption_module.h"
 
 namespace media {
 
 // cdm::Buffer implementation that provides access to memory. This is a simple
-// implementation that stores the data in a std::vector<uint8_t>.
+// implementation that stores the data in an uninitialized heap allocation,
+// which may be handed back to its allocator for reuse on Destroy().
 class SimpleCdmBuffer : public cdm::Buffer {
  public:
+  // Called by Destroy() with the memory of the buffer, so that it can be
+  // reused.
+  using ReleaseCB =
+      base::Callback<void(std::unique_ptr<uint8_t[]> data, size_t capacity)>;
+
   static SimpleCdmBuffer* Create(size_t capacity);
 
+  // Creates a buffer using the |capacity| bytes of |data|, which are handed to
+  // |release_cb| instead of being freed when the buffer is destroyed.
+  static SimpleCdmBuffer* Create(std::unique_ptr<uint8_t[]> data,
+                                 size_t capacity,
+                                 const ReleaseCB& release_cb);
+
   // cdm::Buffer implementation.
   void Destroy() final;
   uint32_t Capacity() const final;
@@ -29,10 +42,14 @@ class SimpleCdmBuffer : public cdm::Buffer {
   uint32_t Size() const final;
 
  private:
-  SimpleCdmBuffer(uint32_t capacity);
+  SimpleCdmBuffer(std::unique_ptr<uint8_t[]> data,
+                  uint32_t capacity,
+                  const ReleaseCB& release_cb);
   ~SimpleCdmBuffer() final;
 
-  std::vector<uint8_t> buffer_;
+  std::unique_ptr<uint8_t[]> data_;
+  const uint32_t capacity_;
+  const ReleaseCB release_cb_;
   uint32_t size_;
 
   DISALLOW_COPY_AND_ASSIGN(SimpleCdmBuffer);
@@ -6,13 +6,20 @@
 
 #include <stddef.h>
 
+#include <algorithm>
 #include <cmath>
+#include <utility>
 #include <vector>
 
 #include "base/bind.h"
 #include "base/callback.h"
 #include "base/logging.h"
+#include "base/memory/ptr_util.h"
 #include "base/numerics/safe_math.h"
+#include "base/synchronization/waitable_event.h"
+#include "base/sys_info.h"
+#include "base/task_scheduler/post_task.h"
+#include "base/task_scheduler/task_scheduler.h"
 #include "base/time/time.h"
 #include "media/base/audio_bus.h"
 #include "media/base/audio_sample_types.h"
@@ -25,13 +32,45 @@ namespace media {
 static const int kAACPrimingFrameCount = 2112;
 static const int kAACRemainderFrameCount = 519;
 
+// Files shorter than this per segment are not worth decoding in parallel, the
+// cost of opening another demuxer and decoder would outweigh the gain.
+static const int kMinSegmentSeconds = 10;
+
+// A range of sample-frames decoded by ReadInParallel(), and its outcome.
+struct AudioFileReader::Segment {
+  Segment()
+      : done(base::WaitableEvent::ResetPolicy::MANUAL,
+             base::WaitableEvent::InitialState::NOT_SIGNALED) {}
+
+  // The sample-frames [start_frame, end_frame) to decode. The last segment
+  // decodes up to the end of the stream instead.
+  int start_frame = 0;
+  int end_frame = 0;
+  bool is_last = false;
+
+  // The protocol to decode from, or null for the segment decoded by the
+  // reader running ReadInParallel().
+  std::unique_ptr<FFmpegURLProtocol> protocol;
+
+  bool succeeded = false;
+
+  // One past the last sample-frame decoded.
+  int frames_end = 0;
+
+  // Sample-frames of the last segment past the end of the destination.
+  std::vector<std::unique_ptr<AudioBus>> overflow_packets;
+
+  base::WaitableEvent done;
+};
+
 AudioFileReader::AudioFileReader(FFmpegURLProtocol* protocol)
     : stream_index_(0),
       protocol_(protocol),
       audio_codec_(kUnknownAudioCodec),
       channels_(0),
       sample_rate_(0),
-      av_sample_format_(0) {}
+      av_sample_format_(0),
+      num_segments_read_(0) {}
 
 AudioFileReader::~AudioFileReader() {
   Close();
@@ -158,6 +197,132 @@ int AudioFileReader::Read(
   return total_frames;
 }
 
+int AudioFileReader::Read(
+    AudioBus* destination,
+    std::vector<std::unique_ptr<AudioBus>>* overflow_packets) {
+  DCHECK(glue_ && codec_context_)
+      << "AudioFileReader::Read() : reader is not opened!";
+  DCHECK_EQ(destination->channels(), channels_);
+
+  FFmpegDecodingLoop decode_loop(codec_context_.get());
+
+  int total_frames = 0;
+  auto frame_ready_cb = base::BindRepeating(
+      &AudioFileReader::OnNewFrameForBus, base::Unretained(this), &total_frames,
+      destination, overflow_packets);
+
+  AVPacket packet;
+  while (ReadPacket(&packet)) {
+    const auto status = decode_loop.DecodePacket(&packet, frame_ready_cb);
+    av_packet_unref(&packet);
+
+    if (status != FFmpegDecodingLoop::DecodeStatus::kOkay)
+      break;
+  }
+
+  return total_frames;
+}
+
+int AudioFileReader::ReadInParallel(
+    const CreateProtocolCB& create_protocol_cb,
+    int max_segments,
+    AudioBus* destination,
+    std::vector<std::unique_ptr<AudioBus>>* overflow_packets) {
+  DCHECK(glue_ && codec_context_)
+      << "AudioFileReader::ReadInParallel() : reader is not opened!";
+  DCHECK_EQ(destination->channels(), channels_);
+
+  num_segments_read_ = 1;
+  int num_segments = 1;
+  if (CanReadInParallel() && base::TaskScheduler::GetInstance()) {
+    num_segments = std::min(
+        {max_segments, base::SysInfo::NumberOfProcessors(),
+         destination->frames() / (kMinSegmentSeconds * sample_rate_)});
+  }
+  if (num_segments < 2)
+    return Read(destination, overflow_packets);
+
+  const int frames_per_segment = destination->frames() / num_segments;
+  std::vector<std::unique_ptr<Segment>> segments;
+  for (int i = 0; i < num_segments; ++i) {
+    auto segment = base::MakeUnique<Segment>();
+    segment->start_frame = i * frames_per_segment;
+    segment->is_last = i == num_segments - 1;
+    segment->end_frame = segment->is_last ? destination->frames()
+                                          : segment->start_frame +
+                                                frames_per_segment;
+    if (i > 0) {
+      segment->protocol = create_protocol_cb.Run();
+      if (!segment->protocol)
+        return Read(destination, overflow_packets);
+    }
+    segments.push_back(std::move(segment));
+  }
+
+  // |destination| and |segments| outlive the posted tasks since this function
+  // does not return before all of them have signaled completion. Each segment
+  // writes a disjoint range of |destination|.
+  for (size_t i = 1; i < segments.size(); ++i) {
+    base::PostTaskWithTraits(
+        FROM_HERE, {base::TaskPriority::USER_BLOCKING},
+        base::BindOnce(&AudioFileReader::DecodeSegmentWithNewReader,
+                       base::Unretained(segments[i].get()),
+                       base::Unretained(destination)));
+  }
+  segments[0]->succeeded = DecodeSegment(segments[0].get(), destination);
+  segments[0]->done.Signal();
+
+  bool segments_line_up = true;
+  for (const auto& segment : segments) {
+    segment->done.Wait();
+    if (!segment->succeeded ||
+        (!segment->is_last && segment->frames_end != segment->end_frame)) {
+      segments_line_up = false;
+    }
+  }
+
+  if (!segments_line_up) {
+    DVLOG(1) << "AudioFileReader::ReadInParallel() : segments do not line up,"
+             << " decoding serially.";
+    destination->Zero();
+    if (!SeekToFrame(0))
+      return 0;
+    return Read(destination, overflow_packets);
+  }
+
+  num_segments_read_ = num_segments;
+  Segment* last_segment = segments.back().get();
+  for (auto& packet : last_segment->overflow_packets)
+    overflow_packets->push_back(std::move(packet));
+  return last_segment->frames_end;
+}
+
+bool AudioFileReader::CanReadInParallel() const {
+  if (!HasKnownDuration() || protocol_->IsStreaming())
+    return false;
+
+  // Seeking in the other supported codecs is not sample accurate: their
+  // packets depend on the ones before them, or decode with priming or padding
+  // sample-frames which the timestamps do not account for.
+  switch (audio_codec_) {
+    case kCodecFLAC:
+    case kCodecPCM:
+    case kCodecPCM_S16BE:
+    case kCodecPCM_S24BE:
+    case kCodecPCM_MULAW:
+    case kCodecPCM_ALAW:
+      break;
+    default:
+      return false;
+  }
+
+  // The timestamps must count sample-frames, so that they tell exactly where
+  // each packet goes in the destination.
+  const AVRational time_base =
+      glue_->format_context()->streams[stream_index_]->time_base;
+  return time_base.num == 1 && time_base.den == sample_rate_;
+}
+
 base::TimeDelta AudioFileReader::GetDuration() const {
   const AVRational av_time_base = {1, AV_TIME_BASE};
 
@@ -219,44 +384,208 @@ bool AudioFileReader::OnNewFrame(
   if (frames_read < 0)
     return false;
 
-  const int channels = frame->channels;
-  if (frame->sample_rate != sample_rate_ || channels != channels_ ||
-      frame->format != av_sample_format_) {
-    DLOG(ERROR) << "Unsupported midstream configuration change!"
-                << " Sample Rate: " << frame->sample_rate << " vs "
-                << sample_rate_ << ", Channels: " << channels << " vs "
-                << channels_ << ", Sample Format: " << frame->format << " vs "
-                << av_sample_format_;
-
-    // This is an unrecoverable error, so bail out.  We'll return
-    // whatever we've decoded up to this point.
+  // This is an unrecoverable error, so bail out.  We'll return whatever we've
+  // decoded up to this point.
+  if (!IsFrameConfigValid(frame))
+    return false;
+
+  decoded_audio_packets->emplace_back(AudioBus::Create(channels_, frames_read));
+  CopyFrameToBus(frame, 0, frames_read, decoded_audio_packets->back().get(),
+                 0);
+
+  (*total_frames) += frames_read;
+  return true;
+}
+
+bool AudioFileReader::OnNewFrameForBus(
+    int* total_frames,
+    AudioBus* destination,
+    std::vector<std::unique_ptr<AudioBus>>* overflow_packets,
+    AVFrame* frame) {
+  const int frames_read = frame->nb_samples;
+  if (frames_read < 0 || !IsFrameConfigValid(frame))
     return false;
+
+  WriteFrames(frame, 0, frames_read, *total_frames, destination,
+              overflow_packets);
+
+  (*total_frames) += frames_read;
+  return true;
+}
+
+bool AudioFileReader::IsFrameConfigValid(const AVFrame* frame) const {
+  if (frame->sample_rate == sample_rate_ && frame->channels == channels_ &&
+      frame->format == av_sample_format_) {
+    return true;
   }
 
+  DLOG(ERROR) << "Unsupported midstream configuration change!"
+              << " Sample Rate: " << frame->sample_rate << " vs "
+              << sample_rate_ << ", Channels: " << frame->channels << " vs "
+              << channels_ << ", Sample Format: " << frame->format << " vs "
+              << av_sample_format_;
+  return false;
+}
+
+void AudioFileReader::CopyFrameToBus(const AVFrame* frame,
+                                     int frame_offset,
+                                     int frame_count,
+                                     AudioBus* destination,
+                                     int destination_offset) const {
   // Deinterleave each channel and convert to 32bit floating-point with
   // nominal range -1.0 -> +1.0.  If the output is already in float planar
   // format, just copy it into the AudioBus.
-  decoded_audio_packets->emplace_back(AudioBus::Create(channels, frames_read));
-  AudioBus* audio_bus = decoded_audio_packets->back().get();
-
   if (codec_context_->sample_fmt == AV_SAMPLE_FMT_FLT) {
-    audio_bus->FromInterleaved<Float32SampleTypeTraits>(
-        reinterpret_cast<float*>(frame->data[0]), frames_read);
+    destination->FromInterleavedPartial<Float32SampleTypeTraits>(
+        reinterpret_cast<const float*>(frame->data[0]) +
+            frame_offset * channels_,
+        destination_offset, frame_count);
   } else if (codec_context_->sample_fmt == AV_SAMPLE_FMT_FLTP) {
-    for (int ch = 0; ch < audio_bus->channels(); ++ch) {
-      memcpy(audio_bus->channel(ch), frame->extended_data[ch],
-             sizeof(float) * frames_read);
+    for (int ch = 0; ch < destination->channels(); ++ch) {
+      memcpy(destination->channel(ch) + destination_offset,
+             reinterpret_cast<const float*>(frame->extended_data[ch]) +
+                 frame_offset,
+             sizeof(float) * frame_count);
     }
   } else {
-    audio_bus->FromInterleaved(
-        frame->data[0], frames_read,
-        av_get_bytes_per_sample(codec_context_->sample_fmt));
+    const int bytes_per_sample =
+        av_get_bytes_per_sample(codec_context_->sample_fmt);
+    destination->FromInterleavedPartial(
+        frame->data[0] + frame_offset * channels_ * bytes_per_sample,
+        destination_offset, frame_count, bytes_per_sample);
   }
+}
 
-  (*total_frames) += frames_read;
+void AudioFileReader::WriteFrames(
+    const AVFrame* frame,
+    int frame_offset,
+    int frame_count,
+    int position,
+    AudioBus* destination,
+    std::vector<std::unique_ptr<AudioBus>>* overflow_packets) {
+  const int frames_to_destination = std::max(
+      0, std::min(frame_count, destination->frames() - position));
+  if (frames_to_destination > 0) {
+    CopyFrameToBus(frame, frame_offset, frames_to_destination, destination,
+                   position);
+  }
+
+  const int frames_to_overflow = frame_count - frames_to_destination;
+  if (frames_to_overflow > 0) {
+    overflow_packets->emplace_back(
+        AudioBus::Create(channels_, frames_to_overflow));
+    CopyFrameToBus(frame, frame_offset + frames_to_destination,
+                   frames_to_overflow, overflow_packets->back().get(), 0);
+  }
+}
+
+int64_t AudioFileReader::GetStartTimestamp() const {
+  const int64_t start_time =
+      glue_->format_context()->streams[stream_index_]->start_time;
+  return start_time == AV_NOPTS_VALUE ? 0 : start_time;
+}
+
+bool AudioFileReader::SeekToFrame(int frame) {
+  DCHECK(CanReadInParallel());
+  if (av_seek_frame(glue_->format_context(), stream_index_,
+                    GetStartTimestamp() + frame, AVSEEK_FLAG_BACKWARD) < 0) {
+    return false;
+  }
+  avcodec_flush_buffers(codec_context_.get());
+  return true;
+}
+
+bool AudioFileReader::DecodeSegment(Segment* segment, AudioBus* destination) {
+  if (segment->start_frame > 0 && !SeekToFrame(segment->start_frame))
+    return false;
+
+  FFmpegDecodingLoop decode_loop(codec_context_.get());
+
+  // The position of the next decoded sample-frame in |destination|, known
+  // once the first packet has been read.
+  int next_frame = -1;
+  auto frame_ready_cb = base::BindRepeating(
+      &AudioFileReader::OnNewSegmentFrame, base::Unretained(this), segment,
+      destination, &next_frame);
+
+  const int64_t start_timestamp = GetStartTimestamp();
+  AVPacket packet;
+  while (ReadPacket(&packet)) {
+    if (!segment->is_last && next_frame >= segment->end_frame) {
+      av_packet_unref(&packet);
+      break;
+    }
+
+    // Since CanReadInParallel() the timestamps count sample-frames, and since
+    // every packet decodes on its own they must follow each other exactly.
+    // Otherwise the segments can't be stitched together.
+    const int64_t packet_frame = packet.pts - start_timestamp;
+    if (packet.pts == AV_NOPTS_VALUE ||
+        (next_frame < 0 && packet_frame > segment->start_frame) ||
+        (next_frame >= 0 && packet_frame != next_frame)) {
+      av_packet_unref(&packet);
+      return false;
+    }
+    if (next_frame < 0)
+      next_frame = static_cast<int>(packet_frame);
+
+    const auto status = decode_loop.DecodePacket(&packet, frame_ready_cb);
+    av_packet_unref(&packet);
+
+    if (status != FFmpegDecodingLoop::DecodeStatus::kOkay) {
+      // Read() stops at a decode error too, so the last segment may as well.
+      if (!segment->is_last)
+        return false;
+      break;
+    }
+  }
+
+  if (next_frame < 0)
+    return false;
+
+  segment->frames_end =
+      segment->is_last ? next_frame : std::min(next_frame, segment->end_frame);
+  return true;
+}
+
+bool AudioFileReader::OnNewSegmentFrame(Segment* segment,
+                                        AudioBus* destination,
+                                        int* next_frame,
+                                        AVFrame* frame) {
+  const int frames_read = frame->nb_samples;
+  if (frames_read < 0 || !IsFrameConfigValid(frame))
+    return false;
+
+  const int frame_start = *next_frame;
+  *next_frame += frames_read;
+
+  // Drop the sample-frames which belong to the neighboring segments.
+  const int start = std::max(frame_start, segment->start_frame);
+  const int end = segment->is_last
+                      ? *next_frame
+                      : std::min(*next_frame, segment->end_frame);
+  if (end > start) {
+    WriteFrames(frame, start - frame_start, end - start, start, destination,
+                &segment->overflow_packets);
+  }
   return true;
 }
 
+// static
+void AudioFileReader::DecodeSegmentWithNewReader(Segment* segment,
+                                                 AudioBus* destination) {
+  {
+    // The reader must be gone before |segment| and its protocol are released
+    // by signaling.
+    AudioFileReader reader(segment->protocol.get());
+    segment->succeeded = reader.Open() &&
+                         reader.channels() == destination->channels() &&
+                         reader.CanReadInParallel() &&
+                         reader.DecodeSegment(segment, destination);
+  }
+  segment->done.Signal();
+}
+
 bool AudioFileReader::SeekForTesting(base::TimeDelta seek_time) {
   // Use the AVStream's time_base, since |codec_context_| does not have
   // time_base populated until after OpenDecoder().
@@ -5,9 +5,12 @@
 #ifndef MEDIA_FILTERS_AUDIO_FILE_READER_H_
 #define MEDIA_FILTERS_AUDIO_FILE_READER_H_
 
+#include <stdint.h>
+
 #include <memory>
 #include <vector>
 
+#include "base/callback_forward.h"
 #include "base/macros.h"
 #include "media/base/audio_codecs.h"
 #include "media/base/media_export.h"
@@ -28,6 +31,9 @@ class FFmpegURLProtocol;
 
 class MEDIA_EXPORT AudioFileReader {
  public:
+  using CreateProtocolCB =
+      base::RepeatingCallback<std::unique_ptr<FFmpegURLProtocol>()>;
+
   // Audio file data will be read using the given protocol.
   // The AudioFileReader does not take ownership of |protocol| and
   // simply maintains a weak reference to it.
@@ -50,6 +56,31 @@ class MEDIA_EXPORT AudioFileReader {
   // |decodedAudioPackets|.
   int Read(std::vector<std::unique_ptr<AudioBus>>* decoded_audio_packets);
 
+  // Same as above, but decodes directly into |destination| from its first
+  // frame on, rather than into packets which the caller must then copy into
+  // one bus. |destination| should have channels() channels and, if
+  // HasKnownDuration(), GetNumberOfFrames() frames. Since that is only an
+  // estimate, audio decoded past the end of |destination| is appended to
+  // |overflow_packets|. Returns the number of sample-frames read into both.
+  int Read(AudioBus* destination,
+           std::vector<std::unique_ptr<AudioBus>>* overflow_packets);
+
+  // Same as Read(AudioBus*, ...), but when CanReadInParallel() splits the
+  // range of |destination| into up to |max_segments| segments, which are
+  // decoded concurrently from their seek points on the task scheduler.
+  // |create_protocol_cb| is run once per additional segment and must return a
+  // new protocol reading the same data as the one given to the constructor.
+  // Falls back to a serial decode if the decoded segments do not line up.
+  int ReadInParallel(const CreateProtocolCB& create_protocol_cb,
+                     int max_segments,
+                     AudioBus* destination,
+                     std::vector<std::unique_ptr<AudioBus>>* overflow_packets);
+
+  // Returns true if the opened file can be decoded in segments: its duration
+  // is known, it can be seeked, and every packet of its codec (FLAC or PCM)
+  // decodes on its own to the exact sample-frames its timestamp says.
+  bool CanReadInParallel() const;
+
   // These methods can be called once Open() has been called.
   int channels() const { return channels_; }
   int sample_rate() const { return sample_rate_; }
@@ -86,13 +117,64 @@ class MEDIA_EXPORT AudioFileReader {
     return codec_context_.get();
   }
 
+  // Returns the number of segments the last ReadInParallel() call decoded
+  // concurrently, or 1 if it decoded serially.
+  int num_segments_read_for_testing() const { return num_segments_read_; }
+
  private:
+  struct Segment;
+
   bool OpenDemuxer();
   bool OpenDecoder();
   bool ReadPacket(AVPacket* output_packet);
   bool OnNewFrame(int* total_frames,
                   std::vector<std::unique_ptr<AudioBus>>* decoded_audio_packets,
                   AVFrame* frame);
+  bool OnNewFrameForBus(
+      int* total_frames,
+      AudioBus* destination,
+      std::vector<std::unique_ptr<AudioBus>>* overflow_packets,
+      AVFrame* frame);
+
+  // Returns false if |frame| has an unsupported midstream config change.
+  bool IsFrameConfigValid(const AVFrame* frame) const;
+
+  // Converts |frame_count| sample-frames of |frame| from |frame_offset| on
+  // into |destination| at |destination_offset|.
+  void CopyFrameToBus(const AVFrame* frame,
+                      int frame_offset,
+                      int frame_count,
+                      AudioBus* destination,
+                      int destination_offset) const;
+
+  // Same as above, but writes the sample-frames at |position| of the decoded
+  // audio; those past the end of |destination| go into a new overflow packet.
+  void WriteFrames(const AVFrame* frame,
+                   int frame_offset,
+                   int frame_count,
+                   int position,
+                   AudioBus* destination,
+                   std::vector<std::unique_ptr<AudioBus>>* overflow_packets);
+
+  // Returns the timestamp of the first sample-frame, in the stream's time
+  // base. Only valid if CanReadInParallel().
+  int64_t GetStartTimestamp() const;
+
+  // Seeks so that the next packet read contains sample-frame |frame|, or one
+  // before it. Only valid if CanReadInParallel().
+  bool SeekToFrame(int frame);
+
+  // Decodes the sample-frames of |segment| into |destination|.
+  bool DecodeSegment(Segment* segment, AudioBus* destination);
+  bool OnNewSegmentFrame(Segment* segment,
+                         AudioBus* destination,
+                         int* next_frame,
+                         AVFrame* frame);
+
+  // Opens a new reader on the protocol of |segment| and decodes it; run on
+  // the task scheduler by ReadInParallel().
+  static void DecodeSegmentWithNewReader(Segment* segment,
+                                         AudioBus* destination);
 
   // Destruct |glue_| after |codec_context_|.
   std::unique_ptr<FFmpegGlue> glue_;
@@ -107,6 +189,9 @@ class MEDIA_EXPORT AudioFileReader {
   // AVSampleFormat initially requested; not Chrome's SampleFormat.
   int av_sample_format_;
 
+  // See num_segments_read_for_testing().
+  int num_segments_read_;
+
   DISALLOW_COPY_AND_ASSIGN(AudioFileReader);
 };
 
@@ -0,0 +1,137 @@
+// Copyright 2017 The Chromium Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#include <stdint.h>
+
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "base/bind.h"
+#include "base/test/scoped_task_environment.h"
+#include "base/time/time.h"
+#include "media/base/audio_bus.h"
+#include "media/base/decoder_buffer.h"
+#include "media/base/test_data_util.h"
+#include "media/base/test_helpers.h"
+#include "media/filters/audio_file_reader.h"
+#include "media/filters/in_memory_url_protocol.h"
+#include "media/media_features.h"
+#include "testing/gtest/include/gtest/gtest.h"
+#include "testing/perf/perf_test.h"
+
+namespace media {
+
+namespace {
+
+const int kShortFileIterations = 100;
+const int kLongFileIterations = 3;
+
+// Length of the synthesized file, the size of a song or a game soundtrack.
+const int kLongFileSeconds = 180;
+const int kLongFileSampleRate = 48000;
+const int kLongFileChannels = 2;
+
+std::unique_ptr<FFmpegURLProtocol> CreateProtocol(const uint8_t* data,
+                                                  int64_t size) {
+  return std::unique_ptr<FFmpegURLProtocol>(
+      new InMemoryUrlProtocol(data, size, false));
+}
+
+// Decodes into packets and then copies them into one bus, as
+// decodeAudioData() used to.
+int ReadPackets(const uint8_t* data, int64_t size, AudioFileReader* reader) {
+  std::vector<std::unique_ptr<AudioBus>> packets;
+  const int frames = reader->Read(&packets);
+  std::unique_ptr<AudioBus> destination =
+      AudioBus::Create(reader->channels(), frames);
+  int dest_start_frame = 0;
+  for (const auto& packet : packets) {
+    packet->CopyPartialFramesTo(0, packet->frames(), dest_start_frame,
+                                destination.get());
+    dest_start_frame += packet->frames();
+  }
+  return frames;
+}
+
+// Decodes directly into a bus sized from the estimated duration.
+int ReadIntoBus(const uint8_t* data, int64_t size, AudioFileReader* reader) {
+  std::unique_ptr<AudioBus> destination =
+      AudioBus::Create(reader->channels(), reader->GetNumberOfFrames());
+  std::vector<std::unique_ptr<AudioBus>> overflow_packets;
+  return reader->Read(destination.get(), &overflow_packets);
+}
+
+// Decodes in segments, using as many threads as there are processors.
+int ReadIntoBusInParallel(const uint8_t* data,
+                          int64_t size,
+                          AudioFileReader* reader) {
+  std::unique_ptr<AudioBus> destination =
+      AudioBus::Create(reader->channels(), reader->GetNumberOfFrames());
+  std::vector<std::unique_ptr<AudioBus>> overflow_packets;
+  return reader->ReadInParallel(
+      base::BindRepeating(&CreateProtocol, data, size), 8, destination.get(),
+      &overflow_packets);
+}
+
+using ReadFunction = int (*)(const uint8_t*, int64_t, AudioFileReader*);
+
+// Opens and decodes |data| |iterations| times with |read|, and reports the
+// time spent per decode.
+void RunDecodeBenchmark(const std::string& name,
+                        const std::string& trace,
+                        const uint8_t* data,
+                        int64_t size,
+                        int iterations,
+                        ReadFunction read) {
+  int expected_frames = -1;
+  const base::TimeTicks start = base::TimeTicks::Now();
+  for (int i = 0; i < iterations; ++i) {
+    InMemoryUrlProtocol protocol(data, size, false);
+    AudioFileReader reader(&protocol);
+    ASSERT_TRUE(reader.Open());
+    const int frames = read(data, size, &reader);
+    ASSERT_GT(frames, 0);
+    if (expected_frames >= 0)
+      ASSERT_EQ(expected_frames, frames);
+    expected_frames = frames;
+  }
+  const base::TimeDelta elapsed = base::TimeTicks::Now() - start;
+
+  perf_test::PrintResult("audio_file_reader", trace, name,
+                         elapsed.InMillisecondsF() / iterations, "ms", true);
+}
+
+}  // namespace
+
+TEST(AudioFileReaderPerfTest, ShortFiles) {
+  const char* const kFiles[] = {
+#if BUILDFLAG(USE_PROPRIETARY_CODECS)
+      "sfx.mp3",       "sfx.m4a",
+#endif
+      "bear-opus.ogg", "bear-flac.ogg", "sfx_s16le.wav",
+  };
+  for (const char* file : kFiles) {
+    scoped_refptr<DecoderBuffer> buffer = ReadTestDataFile(file);
+    RunDecodeBenchmark(file, "_packets", buffer->data(), buffer->data_size(),
+                       kShortFileIterations, &ReadPackets);
+    RunDecodeBenchmark(file, "_into_bus", buffer->data(), buffer->data_size(),
+                       kShortFileIterations, &ReadIntoBus);
+  }
+}
+
+TEST(AudioFileReaderPerfTest, LongFile) {
+  base::test::ScopedTaskEnvironment scoped_task_environment;
+  // The test data has no long files.
+  const std::vector<uint8_t> wave = CreateWaveFileForTest(
+      kLongFileChannels, kLongFileSampleRate, kLongFileSeconds);
+  RunDecodeBenchmark("wav_180s", "_packets", wave.data(), wave.size(),
+                     kLongFileIterations, &ReadPackets);
+  RunDecodeBenchmark("wav_180s", "_into_bus", wave.data(), wave.size(),
+                     kLongFileIterations, &ReadIntoBus);
+  RunDecodeBenchmark("wav_180s", "_parallel", wave.data(), wave.size(),
+                     kLongFileIterations, &ReadIntoBusInParallel);
+}
+
+}  // namespace media
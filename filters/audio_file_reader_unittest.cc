@@ -4,16 +4,25 @@
 
 #include "media/filters/audio_file_reader.h"
 
+#include <stdint.h>
+
+#include <algorithm>
 #include <memory>
+#include <string>
+#include <vector>
 
+#include "base/bind.h"
 #include "base/logging.h"
 #include "base/macros.h"
 #include "base/md5.h"
+#include "base/sys_info.h"
+#include "base/test/scoped_task_environment.h"
 #include "build/build_config.h"
 #include "media/base/audio_bus.h"
 #include "media/base/audio_hash.h"
 #include "media/base/decoder_buffer.h"
 #include "media/base/test_data_util.h"
+#include "media/base/test_helpers.h"
 #include "media/ffmpeg/ffmpeg_common.h"
 #include "media/filters/in_memory_url_protocol.h"
 #include "media/media_features.h"
@@ -21,6 +30,23 @@
 
 namespace media {
 
+namespace {
+
+std::unique_ptr<FFmpegURLProtocol> CreateProtocol(const uint8_t* data,
+                                                  int64_t size) {
+  return std::unique_ptr<FFmpegURLProtocol>(
+      new InMemoryUrlProtocol(data, size, false));
+}
+
+std::unique_ptr<FFmpegURLProtocol> CreateCountedProtocol(const uint8_t* data,
+                                                         int64_t size,
+                                                         int* count) {
+  ++*count;
+  return CreateProtocol(data, size);
+}
+
+}  // namespace
+
 class AudioFileReaderTest : public testing::Test {
  public:
   AudioFileReaderTest() : packet_verification_disabled_(false) {}
@@ -111,6 +137,42 @@ class AudioFileReaderTest : public testing::Test {
     if (!packet_verification_disabled_)
       ASSERT_NO_FATAL_FAILURE(VerifyPackets());
     ReadAndVerify(hash, expected_frames);
+    ReadIntoBusAndVerify(hash, expected_frames);
+  }
+
+  // Reads the entire file provided to Initialize() again with a new reader,
+  // directly into a bus sized from the estimated duration.
+  void ReadIntoBusAndVerify(const char* expected_audio_hash,
+                            int expected_frames) {
+    protocol_.reset(
+        new InMemoryUrlProtocol(data_->data(), data_->data_size(), false));
+    reader_.reset(new AudioFileReader(protocol_.get()));
+    ASSERT_TRUE(reader_->Open());
+
+    // Without a duration estimate, most of the audio ends up in overflow.
+    std::unique_ptr<AudioBus> destination = AudioBus::Create(
+        reader_->channels(),
+        reader_->HasKnownDuration() ? reader_->GetNumberOfFrames() : 1024);
+    std::vector<std::unique_ptr<AudioBus>> overflow_packets;
+    const int actual_frames =
+        reader_->Read(destination.get(), &overflow_packets);
+    ASSERT_EQ(expected_frames, actual_frames);
+    EXPECT_EQ(expected_audio_hash, HashBusAndOverflow(*destination,
+                                                      overflow_packets,
+                                                      actual_frames));
+  }
+
+  // Returns the hash of the first |frames| sample-frames of |destination|
+  // followed by |overflow_packets|.
+  std::string HashBusAndOverflow(
+      const AudioBus& destination,
+      const std::vector<std::unique_ptr<AudioBus>>& overflow_packets,
+      int frames) {
+    AudioHash audio_hash;
+    audio_hash.Update(&destination, std::min(frames, destination.frames()));
+    for (const auto& packet : overflow_packets)
+      audio_hash.Update(packet.get(), packet->frames());
+    return audio_hash.ToString();
   }
 
   void RunTestFailingDemux(const char* fn) {
@@ -135,6 +197,8 @@ class AudioFileReaderTest : public testing::Test {
   std::unique_ptr<AudioFileReader> reader_;
   bool packet_verification_disabled_;
 
+  base::test::ScopedTaskEnvironment scoped_task_environment_;
+
   DISALLOW_COPY_AND_ASSIGN(AudioFileReaderTest);
 };
 
@@ -249,4 +313,61 @@ TEST_F(AudioFileReaderTest, WaveValidFourChannelLayout) {
           4410);
 }
 
+TEST_F(AudioFileReaderTest, ParallelReadMatchesSerialRead) {
+  const std::vector<uint8_t> wave = CreateWaveFileForTest(2, 8000, 60);
+
+  InMemoryUrlProtocol serial_protocol(wave.data(), wave.size(), false);
+  AudioFileReader serial_reader(&serial_protocol);
+  ASSERT_TRUE(serial_reader.Open());
+  std::unique_ptr<AudioBus> serial_destination =
+      AudioBus::Create(2, serial_reader.GetNumberOfFrames());
+  std::vector<std::unique_ptr<AudioBus>> serial_overflow;
+  const int serial_frames =
+      serial_reader.Read(serial_destination.get(), &serial_overflow);
+  EXPECT_EQ(8000 * 60, serial_frames);
+
+  InMemoryUrlProtocol parallel_protocol(wave.data(), wave.size(), false);
+  AudioFileReader parallel_reader(&parallel_protocol);
+  ASSERT_TRUE(parallel_reader.Open());
+  EXPECT_TRUE(parallel_reader.CanReadInParallel());
+  std::unique_ptr<AudioBus> parallel_destination =
+      AudioBus::Create(2, parallel_reader.GetNumberOfFrames());
+  std::vector<std::unique_ptr<AudioBus>> parallel_overflow;
+  int num_protocols_created = 0;
+  const int parallel_frames = parallel_reader.ReadInParallel(
+      base::BindRepeating(&CreateCountedProtocol, wave.data(), wave.size(),
+                          &num_protocols_created),
+      4, parallel_destination.get(), &parallel_overflow);
+
+  // The 60 seconds are long enough for 4 segments, unless there are fewer
+  // processors to decode them on.
+  const int expected_segments =
+      std::min(4, base::SysInfo::NumberOfProcessors());
+  EXPECT_EQ(expected_segments, parallel_reader.num_segments_read_for_testing());
+  EXPECT_EQ(expected_segments - 1, num_protocols_created);
+
+  ASSERT_EQ(serial_frames, parallel_frames);
+  EXPECT_EQ(
+      HashBusAndOverflow(*serial_destination, serial_overflow, serial_frames),
+      HashBusAndOverflow(*parallel_destination, parallel_overflow,
+                         parallel_frames));
+}
+
+TEST_F(AudioFileReaderTest, ParallelReadFallsBackForVorbis) {
+  Initialize("sfx.ogg");
+  ASSERT_TRUE(reader_->Open());
+  EXPECT_FALSE(reader_->CanReadInParallel());
+
+  std::unique_ptr<AudioBus> destination =
+      AudioBus::Create(reader_->channels(), reader_->GetNumberOfFrames());
+  std::vector<std::unique_ptr<AudioBus>> overflow_packets;
+  const int frames = reader_->ReadInParallel(
+      base::BindRepeating(&CreateProtocol, data_->data(), data_->data_size()),
+      4, destination.get(), &overflow_packets);
+  EXPECT_EQ(1, reader_->num_segments_read_for_testing());
+  ASSERT_EQ(15936, frames);
+  EXPECT_EQ("2.17,3.31,5.15,6.33,5.97,4.35,",
+            HashBusAndOverflow(*destination, overflow_packets, frames));
+}
+
 }  // namespace media
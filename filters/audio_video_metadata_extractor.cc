@@ -4,13 +4,21 @@
 
 #include "media/filters/audio_video_metadata_extractor.h"
 
+#include <algorithm>
+#include <cmath>
+
 #include "base/bind.h"
 #include "base/strings/string_number_conversions.h"
 #include "base/strings/string_util.h"
 #include "base/time/time.h"
+#include "media/base/video_frame.h"
 #include "media/ffmpeg/ffmpeg_common.h"
+#include "media/ffmpeg/ffmpeg_decoding_loop.h"
 #include "media/filters/blocking_url_protocol.h"
 #include "media/filters/ffmpeg_glue.h"
+#include "third_party/libyuv/include/libyuv/scale.h"
+#include "ui/gfx/geometry/rect.h"
+#include "ui/gfx/geometry/size.h"
 
 namespace media {
 
@@ -52,6 +60,49 @@ bool ExtractInt(AVDictionaryEntry* tag,
 // Set attached image size limit to 4MB. Chosen arbitrarily.
 const int kAttachedImageSizeLimit = 4 * 1024 * 1024;
 
+// Thumbnails are taken this far into the duration of the file, and give up
+// after reading this many packets without decoding a frame.
+const double kThumbnailPosition = 0.1;
+const int kMaxThumbnailPackets = 256;
+
+// Scales |frame| down into an I420 |thumbnail| no larger than |max_size|, if
+// there is no thumbnail yet. Only 4:2:0 frames are supported.
+bool CreateThumbnail(const gfx::Size& max_size,
+                     scoped_refptr<VideoFrame>* thumbnail,
+                     AVFrame* frame) {
+  if (*thumbnail)
+    return true;
+  if ((frame->format != AV_PIX_FMT_YUV420P &&
+       frame->format != AV_PIX_FMT_YUVJ420P) ||
+      frame->width <= 0 || frame->height <= 0) {
+    return false;
+  }
+
+  const double scale =
+      std::min({1.0, static_cast<double>(max_size.width()) / frame->width,
+                static_cast<double>(max_size.height()) / frame->height});
+  const gfx::Size size(
+      std::max(2, static_cast<int>(std::lround(frame->width * scale)) & ~1),
+      std::max(2, static_cast<int>(std::lround(frame->height * scale)) & ~1));
+  scoped_refptr<VideoFrame> result = VideoFrame::CreateFrame(
+      PIXEL_FORMAT_I420, size, gfx::Rect(size), size, base::TimeDelta());
+  if (!result)
+    return false;
+
+  libyuv::I420Scale(
+      frame->data[0], frame->linesize[0], frame->data[1], frame->linesize[1],
+      frame->data[2], frame->linesize[2], frame->width, frame->height,
+      result->visible_data(VideoFrame::kYPlane),
+      result->stride(VideoFrame::kYPlane),
+      result->visible_data(VideoFrame::kUPlane),
+      result->stride(VideoFrame::kUPlane),
+      result->visible_data(VideoFrame::kVPlane),
+      result->stride(VideoFrame::kVPlane), size.width(), size.height(),
+      libyuv::kFilterBox);
+  *thumbnail = result;
+  return true;
+}
+
 }  // namespace
 
 AudioVideoMetadataExtractor::StreamInfo::StreamInfo() {}
@@ -75,6 +126,12 @@ AudioVideoMetadataExtractor::~AudioVideoMetadataExtractor() {}
 
 bool AudioVideoMetadataExtractor::Extract(DataSource* source,
                                           bool extract_attached_images) {
+  return Extract(source, extract_attached_images, gfx::Size());
+}
+
+bool AudioVideoMetadataExtractor::Extract(DataSource* source,
+                                          bool extract_attached_images,
+                                          const gfx::Size& max_thumbnail_size) {
   DCHECK(!extracted_);
 
   bool read_ok = true;
@@ -104,6 +161,8 @@ bool AudioVideoMetadataExtractor::Extract(DataSource* source,
   container_info.type = format_context->iformat->name;
   ExtractDictionary(format_context->metadata, &container_info.tags);
 
+  int thumbnail_stream_index = -1;
+  int thumbnail_stream_area = 0;
   for (unsigned int i = 0; i < format_context->nb_streams; ++i) {
     stream_infos_.push_back(StreamInfo());
     StreamInfo& info = stream_infos_.back();
@@ -128,6 +187,17 @@ bool AudioVideoMetadataExtractor::Extract(DataSource* source,
       height_ = stream->codecpar->height;
     }
 
+    // Take the thumbnail from the largest video stream, which unlike the
+    // dimensions above must not be an attached image.
+    if (stream->codecpar->codec_type == AVMEDIA_TYPE_VIDEO &&
+        !(stream->disposition & AV_DISPOSITION_ATTACHED_PIC) &&
+        stream->codecpar->width * stream->codecpar->height >
+            thumbnail_stream_area) {
+      thumbnail_stream_index = i;
+      thumbnail_stream_area =
+          stream->codecpar->width * stream->codecpar->height;
+    }
+
     // Extract attached image if requested.
     if (extract_attached_images &&
         stream->disposition == AV_DISPOSITION_ATTACHED_PIC &&
@@ -141,6 +211,12 @@ bool AudioVideoMetadataExtractor::Extract(DataSource* source,
     }
   }
 
+  if (!max_thumbnail_size.IsEmpty() && thumbnail_stream_index >= 0 &&
+      read_ok) {
+    ExtractThumbnail(format_context, thumbnail_stream_index,
+                     max_thumbnail_size);
+  }
+
   extracted_ = true;
   return true;
 }
@@ -243,6 +319,70 @@ AudioVideoMetadataExtractor::attached_images_bytes() const {
   return attached_images_bytes_;
 }
 
+const scoped_refptr<VideoFrame>& AudioVideoMetadataExtractor::thumbnail()
+    const {
+  DCHECK(extracted_);
+  return thumbnail_;
+}
+
+void AudioVideoMetadataExtractor::ExtractThumbnail(
+    AVFormatContext* format_context,
+    int stream_index,
+    const gfx::Size& max_thumbnail_size) {
+  AVStream* stream = format_context->streams[stream_index];
+  auto codec_context = AVStreamToAVCodecContext(stream);
+  if (!codec_context)
+    return;
+  AVCodec* codec = avcodec_find_decoder(codec_context->codec_id);
+  if (!codec || avcodec_open2(codec_context.get(), codec, nullptr) < 0)
+    return;
+
+  // If the seek fails decoding continues from wherever probing the streams
+  // left off, which is close to the start.
+  if (has_duration_) {
+    const int64_t start_time =
+        stream->start_time != AV_NOPTS_VALUE ? stream->start_time : 0;
+    av_seek_frame(format_context, stream_index,
+                  start_time + ConvertToTimeBase(
+                                   stream->time_base,
+                                   base::TimeDelta::FromSecondsD(
+                                       duration_ * kThumbnailPosition)),
+                  AVSEEK_FLAG_BACKWARD);
+  }
+
+  FFmpegDecodingLoop decode_loop(codec_context.get());
+  auto frame_ready_cb =
+      base::BindRepeating(&CreateThumbnail, max_thumbnail_size, &thumbnail_);
+
+  bool found_keyframe = false;
+  AVPacket packet;
+  for (int i = 0; i < kMaxThumbnailPackets && !thumbnail_; ++i) {
+    if (av_read_frame(format_context, &packet) < 0)
+      break;
+
+    // Frames before the first keyframe can't be decoded.
+    FFmpegDecodingLoop::DecodeStatus status =
+        FFmpegDecodingLoop::DecodeStatus::kOkay;
+    if (packet.stream_index == stream_index) {
+      found_keyframe |= (packet.flags & AV_PKT_FLAG_KEY) != 0;
+      if (found_keyframe)
+        status = decode_loop.DecodePacket(&packet, frame_ready_cb);
+    }
+    av_packet_unref(&packet);
+
+    if (status != FFmpegDecodingLoop::DecodeStatus::kOkay)
+      return;
+  }
+
+  // Decoders which delay their output may still hold the frame.
+  if (!thumbnail_ && found_keyframe) {
+    av_init_packet(&packet);
+    packet.data = nullptr;
+    packet.size = 0;
+    decode_loop.DecodePacket(&packet, frame_ready_cb);
+  }
+}
+
 void AudioVideoMetadataExtractor::ExtractDictionary(AVDictionary* metadata,
                                                     TagDictionary* raw_tags) {
   if (!metadata)
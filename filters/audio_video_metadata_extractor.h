@@ -10,13 +10,20 @@
 #include <vector>
 
 #include "base/macros.h"
+#include "base/memory/ref_counted.h"
 #include "media/base/media_export.h"
 
 struct AVDictionary;
+struct AVFormatContext;
+
+namespace gfx {
+class Size;
+}
 
 namespace media {
 
 class DataSource;
+class VideoFrame;
 
 // This class extracts a string dictionary of metadata tags for audio and video
 // files. It also provides the format name.
@@ -41,6 +48,14 @@ class MEDIA_EXPORT AudioVideoMetadataExtractor {
   // be called once.
   bool Extract(DataSource* source, bool extract_attached_pics);
 
+  // Same as above, but also decodes a representative keyframe of the largest
+  // video stream into a thumbnail no larger than |max_thumbnail_size|, unless
+  // that is empty. The thumbnail is an I420 frame, which can be converted with
+  // PaintCanvasVideoRenderer::ConvertVideoFrameToRGBPixels().
+  bool Extract(DataSource* source,
+               bool extract_attached_pics,
+               const gfx::Size& max_thumbnail_size);
+
   // Returns whether or not duration information was extracted. Do not call
   // duration() if this returns false.
   bool has_duration() const;
@@ -77,9 +92,19 @@ class MEDIA_EXPORT AudioVideoMetadataExtractor {
   // images were found.
   const std::vector<std::string>& attached_images_bytes() const;
 
+  // Null if the Extract call did not request a thumbnail, or if no thumbnail
+  // could be decoded.
+  const scoped_refptr<VideoFrame>& thumbnail() const;
+
  private:
   void ExtractDictionary(AVDictionary* metadata, TagDictionary* raw_tags);
 
+  // Decodes |thumbnail_| from the first keyframe of stream |stream_index| a
+  // little into the file, to skip over any fade in from black.
+  void ExtractThumbnail(AVFormatContext* format_context,
+                        int stream_index,
+                        const gfx::Size& max_thumbnail_size);
+
   bool extracted_;
 
   bool has_duration_;
@@ -105,6 +130,8 @@ class MEDIA_EXPORT AudioVideoMetadataExtractor {
 
   std::vector<std::string> attached_images_bytes_;
 
+  scoped_refptr<VideoFrame> thumbnail_;
+
   DISALLOW_COPY_AND_ASSIGN(AudioVideoMetadataExtractor);
 };
 
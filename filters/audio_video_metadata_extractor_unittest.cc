@@ -10,9 +10,11 @@
 #include "base/sha1.h"
 #include "build/build_config.h"
 #include "media/base/test_data_util.h"
+#include "media/base/video_frame.h"
 #include "media/filters/file_data_source.h"
 #include "media/media_features.h"
 #include "testing/gtest/include/gtest/gtest.h"
+#include "ui/gfx/geometry/size.h"
 
 namespace media {
 
@@ -146,6 +148,34 @@ TEST(AudioVideoMetadataExtractorTest, VideoWebM) {
   EXPECT_EQ(0u, extractor->attached_images_bytes().size());
 }
 
+TEST(AudioVideoMetadataExtractorTest, VideoThumbnail) {
+  FileDataSource source;
+  ASSERT_TRUE(source.Initialize(GetTestDataFilePath("bear.ogv")));
+
+  AudioVideoMetadataExtractor extractor;
+  ASSERT_TRUE(extractor.Extract(&source, false, gfx::Size(64, 64)));
+  EXPECT_EQ(320, extractor.width());
+  EXPECT_EQ(240, extractor.height());
+
+  ASSERT_TRUE(extractor.thumbnail());
+  EXPECT_EQ(PIXEL_FORMAT_I420, extractor.thumbnail()->format());
+  EXPECT_EQ(gfx::Size(64, 48), extractor.thumbnail()->visible_rect().size());
+}
+
+TEST(AudioVideoMetadataExtractorTest, NoThumbnail) {
+  // Thumbnails are only decoded when asked for.
+  std::unique_ptr<AudioVideoMetadataExtractor> extractor = GetExtractor(
+      "bear-320x240-multitrack.webm", true, true, 2.744, 320, 240);
+  EXPECT_FALSE(extractor->thumbnail());
+
+  // Audio files have none.
+  FileDataSource source;
+  ASSERT_TRUE(source.Initialize(GetTestDataFilePath("sfx.flac")));
+  AudioVideoMetadataExtractor audio_extractor;
+  ASSERT_TRUE(audio_extractor.Extract(&source, false, gfx::Size(64, 64)));
+  EXPECT_FALSE(audio_extractor.thumbnail());
+}
+
 #if BUILDFLAG(USE_PROPRIETARY_CODECS)
 TEST(AudioVideoMetadataExtractorTest, AndroidRotatedMP4Video) {
   std::unique_ptr<AudioVideoMetadataExtractor> extractor =
@@ -0,0 +1,129 @@
+// Copyright 2017 The Chromium Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#include "media/filters/batch_metadata_extractor.h"
+
+#include <utility>
+
+#include "base/bind.h"
+#include "base/callback_helpers.h"
+#include "base/location.h"
+#include "base/metrics/histogram_macros.h"
+#include "base/sys_info.h"
+#include "base/task_runner.h"
+#include "base/task_runner_util.h"
+#include "base/task_scheduler/post_task.h"
+#include "media/filters/audio_video_metadata_extractor.h"
+#include "media/filters/file_data_source.h"
+
+namespace media {
+
+namespace {
+
+// Opens and extracts |path| on the task scheduler.
+std::unique_ptr<BatchMetadataExtractor::Result> ExtractFile(
+    const BatchMetadataExtractor::Options& options,
+    const base::FilePath& path) {
+  const base::TimeTicks start = base::TimeTicks::Now();
+  auto result = std::make_unique<BatchMetadataExtractor::Result>();
+  result->path = path;
+
+  FileDataSource source;
+  if (source.Initialize(path)) {
+    auto extractor = std::make_unique<AudioVideoMetadataExtractor>();
+    if (extractor->Extract(&source, options.extract_attached_images,
+                           options.max_thumbnail_size)) {
+      result->extractor = std::move(extractor);
+    }
+  }
+
+  result->latency = base::TimeTicks::Now() - start;
+  if (options.max_thumbnail_size.IsEmpty()) {
+    UMA_HISTOGRAM_TIMES("Media.BatchMetadataExtractor.FileLatency",
+                        result->latency);
+  } else {
+    UMA_HISTOGRAM_TIMES(
+        "Media.BatchMetadataExtractor.FileLatencyWithThumbnail",
+        result->latency);
+  }
+  return result;
+}
+
+}  // namespace
+
+BatchMetadataExtractor::Options::Options() {}
+
+BatchMetadataExtractor::Options::~Options() {}
+
+BatchMetadataExtractor::Result::Result() {}
+
+BatchMetadataExtractor::Result::~Result() {}
+
+BatchMetadataExtractor::BatchMetadataExtractor(const Options& options)
+    : options_(options),
+      max_concurrent_files_(options.max_concurrent_files > 0
+                                ? options.max_concurrent_files
+                                : base::SysInfo::NumberOfProcessors()),
+      task_runner_(base::CreateTaskRunnerWithTraits(
+          {base::MayBlock(), base::TaskPriority::BACKGROUND})),
+      weak_factory_(this) {}
+
+BatchMetadataExtractor::~BatchMetadataExtractor() {
+  DCHECK_CALLED_ON_VALID_SEQUENCE(sequence_checker_);
+}
+
+void BatchMetadataExtractor::Start(std::vector<base::FilePath> files,
+                                   const ResultCB& result_cb,
+                                   const base::Closure& done_cb) {
+  DCHECK_CALLED_ON_VALID_SEQUENCE(sequence_checker_);
+  DCHECK(done_cb_.is_null()) << "Start() called before the last batch ended";
+
+  files_ = std::move(files);
+  next_file_ = 0;
+  result_cb_ = result_cb;
+  done_cb_ = done_cb;
+
+  if (files_.empty()) {
+    base::ResetAndReturn(&done_cb_).Run();
+    return;
+  }
+
+  while (files_in_flight_ < max_concurrent_files_ &&
+         next_file_ < files_.size()) {
+    ExtractNextFile();
+  }
+}
+
+void BatchMetadataExtractor::ExtractNextFile() {
+  DCHECK_LT(next_file_, files_.size());
+  ++files_in_flight_;
+  base::PostTaskAndReplyWithResult(
+      task_runner_.get(), FROM_HERE,
+      base::Bind(&ExtractFile, options_, files_[next_file_++]),
+      base::Bind(&BatchMetadataExtractor::OnFileExtracted,
+                 weak_factory_.GetWeakPtr()));
+}
+
+void BatchMetadataExtractor::OnFileExtracted(std::unique_ptr<Result> result) {
+  DCHECK_CALLED_ON_VALID_SEQUENCE(sequence_checker_);
+  --files_in_flight_;
+
+  // Keep the workers busy while the client handles |result|.
+  if (next_file_ < files_.size())
+    ExtractNextFile();
+
+  // The client may destroy |this| when handed its result.
+  base::WeakPtr<BatchMetadataExtractor> weak_this = weak_factory_.GetWeakPtr();
+  result_cb_.Run(std::move(result));
+  if (!weak_this)
+    return;
+
+  if (files_in_flight_ == 0 && next_file_ == files_.size()) {
+    files_.clear();
+    result_cb_.Reset();
+    base::ResetAndReturn(&done_cb_).Run();
+  }
+}
+
+}  // namespace media
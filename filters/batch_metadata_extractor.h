@@ -0,0 +1,101 @@
+// Copyright 2017 The Chromium Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#ifndef MEDIA_FILTERS_BATCH_METADATA_EXTRACTOR_H_
+#define MEDIA_FILTERS_BATCH_METADATA_EXTRACTOR_H_
+
+#include <stddef.h>
+
+#include <memory>
+#include <vector>
+
+#include "base/callback.h"
+#include "base/files/file_path.h"
+#include "base/macros.h"
+#include "base/memory/ref_counted.h"
+#include "base/memory/weak_ptr.h"
+#include "base/sequence_checker.h"
+#include "base/time/time.h"
+#include "media/base/media_export.h"
+#include "ui/gfx/geometry/size.h"
+
+namespace base {
+class TaskRunner;
+}
+
+namespace media {
+
+class AudioVideoMetadataExtractor;
+
+// Extracts the metadata, and optionally a thumbnail, of many files with
+// AudioVideoMetadataExtractor, e.g. to index a media library. Files are
+// opened and extracted in parallel on the task scheduler, and the results are
+// returned in order of completion on the sequence Start() was called on. The
+// time spent on each file is reported to UMA.
+class MEDIA_EXPORT BatchMetadataExtractor {
+ public:
+  struct MEDIA_EXPORT Options {
+    Options();
+    ~Options();
+
+    // The number of files extracted in parallel. If 0, the number of
+    // processors is used.
+    int max_concurrent_files = 0;
+
+    bool extract_attached_images = false;
+
+    // A thumbnail is decoded for each video file unless this is empty.
+    gfx::Size max_thumbnail_size;
+  };
+
+  struct MEDIA_EXPORT Result {
+    Result();
+    ~Result();
+
+    base::FilePath path;
+
+    // Null if |path| could not be opened or is not a media file.
+    std::unique_ptr<AudioVideoMetadataExtractor> extractor;
+
+    // The wall-clock time spent opening and extracting |path|.
+    base::TimeDelta latency;
+  };
+
+  using ResultCB = base::Callback<void(std::unique_ptr<Result> result)>;
+
+  explicit BatchMetadataExtractor(const Options& options);
+  ~BatchMetadataExtractor();
+
+  // Extracts every file of |files|, running |result_cb| once for each and
+  // then |done_cb|. Must not be called again before |done_cb| has run.
+  // Destroying the BatchMetadataExtractor cancels the remaining callbacks.
+  void Start(std::vector<base::FilePath> files,
+             const ResultCB& result_cb,
+             const base::Closure& done_cb);
+
+ private:
+  // Posts the extraction of the next file, if any.
+  void ExtractNextFile();
+  void OnFileExtracted(std::unique_ptr<Result> result);
+
+  const Options options_;
+  const int max_concurrent_files_;
+  const scoped_refptr<base::TaskRunner> task_runner_;
+
+  std::vector<base::FilePath> files_;
+  size_t next_file_ = 0;
+  int files_in_flight_ = 0;
+  ResultCB result_cb_;
+  base::Closure done_cb_;
+
+  SEQUENCE_CHECKER(sequence_checker_);
+
+  base::WeakPtrFactory<BatchMetadataExtractor> weak_factory_;
+
+  DISALLOW_COPY_AND_ASSIGN(BatchMetadataExtractor);
+};
+
+}  // namespace media
+
+#endif  // MEDIA_FILTERS_BATCH_METADATA_EXTRACTOR_H_
@@ -0,0 +1,121 @@
+// Copyright 2017 The Chromium Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#include <stddef.h>
+
+#include <algorithm>
+#include <memory>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "base/bind.h"
+#include "base/files/file_enumerator.h"
+#include "base/files/file_path.h"
+#include "base/run_loop.h"
+#include "base/test/scoped_task_environment.h"
+#include "base/time/time.h"
+#include "media/base/test_data_util.h"
+#include "media/filters/audio_video_metadata_extractor.h"
+#include "media/filters/batch_metadata_extractor.h"
+#include "media/filters/file_data_source.h"
+#include "testing/gtest/include/gtest/gtest.h"
+#include "testing/perf/perf_test.h"
+#include "ui/gfx/geometry/size.h"
+
+namespace media {
+
+namespace {
+
+// A typical size for the thumbnails of a media library grid view.
+const int kThumbnailSize = 160;
+
+std::vector<base::FilePath> GetTestDataFiles() {
+  std::vector<base::FilePath> files;
+  base::FileEnumerator enumerator(GetTestDataFilePath("bear.ogv").DirName(),
+                                  false, base::FileEnumerator::FILES);
+  for (base::FilePath path = enumerator.Next(); !path.empty();
+       path = enumerator.Next()) {
+    files.push_back(path);
+  }
+  return files;
+}
+
+void OnResult(std::vector<base::TimeDelta>* latencies,
+              std::unique_ptr<BatchMetadataExtractor::Result> result) {
+  latencies->push_back(result->latency);
+}
+
+// Reports the throughput of extracting |files| in |elapsed|, and the
+// distribution of the per-file |latencies|.
+void PrintResults(const std::string& trace,
+                  const std::vector<base::FilePath>& files,
+                  base::TimeDelta elapsed,
+                  std::vector<base::TimeDelta> latencies) {
+  ASSERT_EQ(files.size(), latencies.size());
+  std::sort(latencies.begin(), latencies.end());
+  perf_test::PrintResult("metadata_extraction", trace, "throughput",
+                         files.size() / elapsed.InSecondsF(), "files/s", true);
+  perf_test::PrintResult("metadata_extraction", trace, "latency_p50",
+                         latencies[latencies.size() / 2].InMillisecondsF(),
+                         "ms", true);
+  perf_test::PrintResult(
+      "metadata_extraction", trace, "latency_p95",
+      latencies[latencies.size() * 95 / 100].InMillisecondsF(), "ms", true);
+  perf_test::PrintResult("metadata_extraction", trace, "latency_max",
+                         latencies.back().InMillisecondsF(), "ms", true);
+}
+
+// Extracts |files| one after the other on this thread, as a file at a time
+// with AudioVideoMetadataExtractor.
+void RunSerialBenchmark(const std::string& trace,
+                        const std::vector<base::FilePath>& files,
+                        const gfx::Size& max_thumbnail_size) {
+  std::vector<base::TimeDelta> latencies;
+  const base::TimeTicks start = base::TimeTicks::Now();
+  for (const base::FilePath& path : files) {
+    const base::TimeTicks file_start = base::TimeTicks::Now();
+    FileDataSource source;
+    if (source.Initialize(path)) {
+      AudioVideoMetadataExtractor extractor;
+      extractor.Extract(&source, false, max_thumbnail_size);
+    }
+    latencies.push_back(base::TimeTicks::Now() - file_start);
+  }
+  PrintResults(trace, files, base::TimeTicks::Now() - start,
+               std::move(latencies));
+}
+
+void RunBatchBenchmark(const std::string& trace,
+                       const std::vector<base::FilePath>& files,
+                       const gfx::Size& max_thumbnail_size) {
+  BatchMetadataExtractor::Options options;
+  options.max_thumbnail_size = max_thumbnail_size;
+  BatchMetadataExtractor extractor(options);
+
+  std::vector<base::TimeDelta> latencies;
+  base::RunLoop run_loop;
+  const base::TimeTicks start = base::TimeTicks::Now();
+  extractor.Start(files, base::Bind(&OnResult, &latencies),
+                  run_loop.QuitClosure());
+  run_loop.Run();
+  PrintResults(trace, files, base::TimeTicks::Now() - start,
+               std::move(latencies));
+}
+
+}  // namespace
+
+TEST(BatchMetadataExtractorPerfTest, TestDataCorpus) {
+  base::test::ScopedTaskEnvironment scoped_task_environment;
+  const std::vector<base::FilePath> files = GetTestDataFiles();
+  ASSERT_FALSE(files.empty());
+
+  const gfx::Size thumbnail_size(kThumbnailSize, kThumbnailSize);
+  RunSerialBenchmark("_serial", files, gfx::Size());
+  RunBatchBenchmark("_batch", files, gfx::Size());
+  RunSerialBenchmark("_serial_thumbnails", files, thumbnail_size);
+  RunBatchBenchmark("_batch_thumbnails", files, thumbnail_size);
+}
+
+}  // namespace media
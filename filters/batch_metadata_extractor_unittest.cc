@@ -0,0 +1,100 @@
+// Copyright 2017 The Chromium Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#include "media/filters/batch_metadata_extractor.h"
+
+#include <map>
+#include <memory>
+#include <utility>
+#include <vector>
+
+#include "base/bind.h"
+#include "base/files/file_path.h"
+#include "base/macros.h"
+#include "base/run_loop.h"
+#include "base/test/scoped_task_environment.h"
+#include "media/base/test_data_util.h"
+#include "media/base/video_frame.h"
+#include "media/filters/audio_video_metadata_extractor.h"
+#include "testing/gtest/include/gtest/gtest.h"
+
+namespace media {
+
+class BatchMetadataExtractorTest : public testing::Test {
+ public:
+  BatchMetadataExtractorTest() {}
+  ~BatchMetadataExtractorTest() override {}
+
+  // Extracts |filenames| and waits for the batch to end.
+  void ExtractAll(const BatchMetadataExtractor::Options& options,
+                  const std::vector<std::string>& filenames) {
+    std::vector<base::FilePath> files;
+    for (const std::string& filename : filenames)
+      files.push_back(GetTestDataFilePath(filename));
+
+    BatchMetadataExtractor extractor(options);
+    base::RunLoop run_loop;
+    extractor.Start(std::move(files),
+                    base::Bind(&BatchMetadataExtractorTest::OnResult,
+                               base::Unretained(this)),
+                    run_loop.QuitClosure());
+    run_loop.Run();
+  }
+
+  void OnResult(std::unique_ptr<BatchMetadataExtractor::Result> result) {
+    EXPECT_FALSE(results_.count(result->path.BaseName().MaybeAsASCII()));
+    results_[result->path.BaseName().MaybeAsASCII()] = std::move(result);
+  }
+
+ protected:
+  base::test::ScopedTaskEnvironment scoped_task_environment_;
+  std::map<std::string, std::unique_ptr<BatchMetadataExtractor::Result>>
+      results_;
+
+ private:
+  DISALLOW_COPY_AND_ASSIGN(BatchMetadataExtractorTest);
+};
+
+TEST_F(BatchMetadataExtractorTest, EmptyBatch) {
+  ExtractAll(BatchMetadataExtractor::Options(), std::vector<std::string>());
+  EXPECT_TRUE(results_.empty());
+}
+
+TEST_F(BatchMetadataExtractorTest, ExtractsEveryFile) {
+  BatchMetadataExtractor::Options options;
+  options.max_concurrent_files = 2;
+  ExtractAll(options, {"sfx.flac", "9ch.ogg", "ten_byte_file",
+                       "bear-320x240-multitrack.webm", "sfx_u8.wav"});
+  ASSERT_EQ(5u, results_.size());
+
+  EXPECT_FALSE(results_["ten_byte_file"]->extractor);
+
+  ASSERT_TRUE(results_["9ch.ogg"]->extractor);
+  EXPECT_EQ("Processed by SoX", results_["9ch.ogg"]->extractor->comment());
+
+  const AudioVideoMetadataExtractor* video =
+      results_["bear-320x240-multitrack.webm"]->extractor.get();
+  ASSERT_TRUE(video);
+  EXPECT_EQ(320, video->width());
+  EXPECT_EQ(240, video->height());
+  EXPECT_FALSE(video->thumbnail());
+}
+
+TEST_F(BatchMetadataExtractorTest, Thumbnails) {
+  BatchMetadataExtractor::Options options;
+  options.max_thumbnail_size = gfx::Size(64, 64);
+  ExtractAll(options, {"bear.ogv", "sfx.flac"});
+  ASSERT_EQ(2u, results_.size());
+
+  const AudioVideoMetadataExtractor* video =
+      results_["bear.ogv"]->extractor.get();
+  ASSERT_TRUE(video);
+  ASSERT_TRUE(video->thumbnail());
+  EXPECT_EQ(gfx::Size(64, 48), video->thumbnail()->visible_rect().size());
+
+  ASSERT_TRUE(results_["sfx.flac"]->extractor);
+  EXPECT_FALSE(results_["sfx.flac"]->extractor->thumbnail());
+}
+
+}  // namespace media
@@ -6,6 +6,7 @@
 
 #include "base/bind.h"
 #include "base/callback_helpers.h"
+#include "base/feature_list.h"
 #include "base/location.h"
 #include "base/logging.h"
 #include "base/single_thread_task_runner.h"
@@ -13,10 +14,15 @@
 #include "media/base/bind_to_current_loop.h"
 #include "media/base/decoder_buffer.h"
 #include "media/base/media_log.h"
+#include "media/base/media_switches.h"
 #include "media/base/media_util.h"
 
 namespace media {
 
+// A few buffers are enough to hide decryption latency behind decoding, while
+// keeping the amount of decrypted data that a Reset() throws away small.
+const size_t DecryptingDemuxerStream::kMaxDecryptAheadBuffers = 3;
+
 static bool IsStreamValid(DemuxerStream* stream) {
   return ((stream->type() == DemuxerStream::AUDIO &&
            stream->audio_decoder_config().IsValidConfig()) ||
@@ -34,6 +40,10 @@ DecryptingDemuxerStream::DecryptingDemuxerStream(
       waiting_for_decryption_key_cb_(waiting_for_decryption_key_cb),
       demuxer_stream_(NULL),
       decryptor_(NULL),
+      max_ready_buffers_(base::FeatureList::IsEnabled(kDecryptAhead)
+                             ? kMaxDecryptAheadBuffers
+                             : 0),
+      read_ahead_paused_(false),
       key_added_while_decrypt_pending_(false),
       weak_factory_(this) {}
 
@@ -78,14 +88,38 @@ void DecryptingDemuxerStream::Initialize(DemuxerStream* stream,
 void DecryptingDemuxerStream::Read(const ReadCB& read_cb) {
   DVLOG(3) << __func__;
   DCHECK(task_runner_->BelongsToCurrentThread());
-  DCHECK_EQ(state_, kIdle) << state_;
+  DCHECK(state_ != kUninitialized) << state_;
+  DCHECK(reset_cb_.is_null());
   DCHECK(!read_cb.is_null());
   CHECK(read_cb_.is_null()) << "Overlapping reads are not supported.";
 
   read_cb_ = BindToCurrentLoop(read_cb);
-  state_ = kPendingDemuxerRead;
-  demuxer_stream_->Read(
-      base::Bind(&DecryptingDemuxerStream::DecryptBuffer, weak_this_));
+
+  if (!ready_buffers_.empty()) {
+    ReturnReadyBuffer();
+    MaybeReadAhead();
+    return;
+  }
+
+  // Any end of stream, config change or failure has been returned by now, so
+  // reading ahead may resume.
+  read_ahead_paused_ = false;
+
+  if (state_ == kIdle) {
+    ReadFromDemuxerStream();
+    return;
+  }
+
+  // The wait for a key started while reading ahead, and it only blocks the
+  // caller from now on.
+  if (state_ == kWaitingForKey) {
+    waiting_for_decryption_key_cb_.Run();
+    return;
+  }
+
+  // Otherwise the result of the pending demuxer read or decryption will
+  // satisfy |read_cb_|.
+  DCHECK(state_ == kPendingDemuxerRead || state_ == kPendingDecrypt) << state_;
 }
 
 void DecryptingDemuxerStream::Reset(const base::Closure& closure) {
@@ -98,22 +132,28 @@ void DecryptingDemuxerStream::Reset(const base::Closure& closure) {
 
   decryptor_->CancelDecrypt(GetDecryptorStreamType());
 
-  // Reset() cannot complete if the read callback is still pending.
+  // Drop the buffers decrypted ahead. A config change must still reach the
+  // decoder though, as for a config change that completes a pending demuxer
+  // read below.
+  const bool has_pending_config_change =
+      !ready_buffers_.empty() && ready_buffers_.back().first == kConfigChanged;
+  ready_buffers_.clear();
+  if (has_pending_config_change)
+    ready_buffers_.push_back(ReadResult(kConfigChanged, nullptr));
+
+  // Reset() cannot complete while a demuxer read or decryption is pending.
   // Defer the resetting process in this case. The |reset_cb_| will be fired
-  // after the read callback is fired - see DoDecryptBuffer() and
-  // DoDeliverBuffer().
-  if (state_ == kPendingDemuxerRead || state_ == kPendingDecrypt) {
-    DCHECK(!read_cb_.is_null());
+  // after the pending operation completes - see DecryptBuffer() and
+  // DeliverBuffer().
+  if (state_ == kPendingDemuxerRead || state_ == kPendingDecrypt)
     return;
-  }
 
-  if (state_ == kWaitingForKey) {
-    DCHECK(!read_cb_.is_null());
+  if (state_ == kWaitingForKey)
     pending_buffer_to_decrypt_ = NULL;
+
+  if (!read_cb_.is_null())
     base::ResetAndReturn(&read_cb_).Run(kAborted, NULL);
-  }
 
-  DCHECK(read_cb_.is_null());
   DoReset();
 }
 
@@ -165,6 +205,14 @@ DecryptingDemuxerStream::~DecryptingDemuxerStream() {
   if (!reset_cb_.is_null())
     base::ResetAndReturn(&reset_cb_).Run();
   pending_buffer_to_decrypt_ = NULL;
+  ready_buffers_.clear();
+}
+
+void DecryptingDemuxerStream::ReadFromDemuxerStream() {
+  DCHECK_EQ(state_, kIdle) << state_;
+  state_ = kPendingDemuxerRead;
+  demuxer_stream_->Read(
+      base::Bind(&DecryptingDemuxerStream::DecryptBuffer, weak_this_));
 }
 
 void DecryptingDemuxerStream::DecryptBuffer(
@@ -173,7 +221,6 @@ void DecryptingDemuxerStream::DecryptBuffer(
   DVLOG(3) << __func__ << ": status = " << status;
   DCHECK(task_runner_->BelongsToCurrentThread());
   DCHECK_EQ(state_, kPendingDemuxerRead) << state_;
-  DCHECK(!read_cb_.is_null());
   DCHECK_EQ(buffer.get() != NULL, status == kOk) << status;
 
   // Even when |!reset_cb_.is_null()|, we need to pass |kConfigChanged| back to
@@ -183,19 +230,15 @@ void DecryptingDemuxerStream::DecryptBuffer(
     DCHECK_EQ(demuxer_stream_->type() == AUDIO, audio_config_.IsValidConfig());
     DCHECK_EQ(demuxer_stream_->type() == VIDEO, video_config_.IsValidConfig());
 
-    // Update the decoder config, which the decoder will use when it is notified
-    // of kConfigChanged.
-    InitializeDecoderConfig();
-
-    state_ = kIdle;
-    base::ResetAndReturn(&read_cb_).Run(kConfigChanged, NULL);
+    CompleteRead(kConfigChanged, NULL);
     if (!reset_cb_.is_null())
       DoReset();
     return;
   }
 
   if (!reset_cb_.is_null()) {
-    base::ResetAndReturn(&read_cb_).Run(kAborted, NULL);
+    if (!read_cb_.is_null())
+      base::ResetAndReturn(&read_cb_).Run(kAborted, NULL);
     DoReset();
     return;
   }
@@ -205,8 +248,7 @@ void DecryptingDemuxerStream::DecryptBuffer(
       MEDIA_LOG(ERROR, media_log_)
           << GetDisplayName() << ": demuxer stream read error.";
     }
-    state_ = kIdle;
-    base::ResetAndReturn(&read_cb_).Run(status, nullptr);
+    CompleteRead(status, nullptr);
     return;
   }
 
@@ -214,8 +256,7 @@ void DecryptingDemuxerStream::DecryptBuffer(
 
   if (buffer->end_of_stream()) {
     DVLOG(2) << "DoDecryptBuffer() - EOS buffer.";
-    state_ = kIdle;
-    base::ResetAndReturn(&read_cb_).Run(kOk, buffer);
+    CompleteRead(kOk, buffer);
     return;
   }
 
@@ -223,8 +264,7 @@ void DecryptingDemuxerStream::DecryptBuffer(
   // See http://crbug.com/675003
   if (!buffer->decrypt_config()) {
     DVLOG(2) << "DoDecryptBuffer() - clear buffer in clear stream.";
-    state_ = kIdle;
-    base::ResetAndReturn(&read_cb_).Run(kOk, buffer);
+    CompleteRead(kOk, buffer);
     return;
   }
 
@@ -237,8 +277,7 @@ void DecryptingDemuxerStream::DecryptBuffer(
     if (buffer->is_key_frame())
       decrypted->set_is_key_frame(true);
 
-    state_ = kIdle;
-    base::ResetAndReturn(&read_cb_).Run(kOk, decrypted);
+    CompleteRead(kOk, decrypted);
     return;
   }
 
@@ -264,7 +303,6 @@ void DecryptingDemuxerStream::DeliverBuffer(
   DCHECK(task_runner_->BelongsToCurrentThread());
   DCHECK_EQ(state_, kPendingDecrypt) << state_;
   DCHECK_NE(status, Decryptor::kNeedMoreData);
-  DCHECK(!read_cb_.is_null());
   DCHECK(pending_buffer_to_decrypt_.get());
 
   bool need_to_try_again_if_nokey = key_added_while_decrypt_pending_;
@@ -272,7 +310,8 @@ void DecryptingDemuxerStream::DeliverBuffer(
 
   if (!reset_cb_.is_null()) {
     pending_buffer_to_decrypt_ = NULL;
-    base::ResetAndReturn(&read_cb_).Run(kAborted, NULL);
+    if (!read_cb_.is_null())
+      base::ResetAndReturn(&read_cb_).Run(kAborted, NULL);
     DoReset();
     return;
   }
@@ -283,8 +322,7 @@ void DecryptingDemuxerStream::DeliverBuffer(
     DVLOG(2) << "DoDeliverBuffer() - kError";
     MEDIA_LOG(ERROR, media_log_) << GetDisplayName() << ": decrypt error";
     pending_buffer_to_decrypt_ = NULL;
-    state_ = kIdle;
-    base::ResetAndReturn(&read_cb_).Run(kError, nullptr);
+    CompleteRead(kError, nullptr);
     return;
   }
 
@@ -304,7 +342,11 @@ void DecryptingDemuxerStream::DeliverBuffer(
     }
 
     state_ = kWaitingForKey;
-    waiting_for_decryption_key_cb_.Run();
+
+    // When decrypting ahead, playback is not blocked until the next Read();
+    // the wait is reported then.
+    if (!read_cb_.is_null())
+      waiting_for_decryption_key_cb_.Run();
     return;
   }
 
@@ -316,8 +358,53 @@ void DecryptingDemuxerStream::DeliverBuffer(
     decrypted_buffer->set_is_key_frame(true);
 
   pending_buffer_to_decrypt_ = NULL;
+  CompleteRead(kOk, decrypted_buffer);
+}
+
+void DecryptingDemuxerStream::CompleteRead(
+    Status status,
+    const scoped_refptr<DecoderBuffer>& buffer) {
+  DCHECK(task_runner_->BelongsToCurrentThread());
+  DCHECK(read_cb_.is_null() || ready_buffers_.empty());
+
   state_ = kIdle;
-  base::ResetAndReturn(&read_cb_).Run(kOk, decrypted_buffer);
+  ready_buffers_.push_back(ReadResult(status, buffer));
+
+  // Do not read past anything that the caller must act on first.
+  if (status != kOk || buffer->end_of_stream())
+    read_ahead_paused_ = true;
+
+  if (!read_cb_.is_null())
+    ReturnReadyBuffer();
+  MaybeReadAhead();
+}
+
+void DecryptingDemuxerStream::ReturnReadyBuffer() {
+  DCHECK(!read_cb_.is_null());
+  DCHECK(!ready_buffers_.empty());
+
+  const ReadResult result = ready_buffers_.front();
+  ready_buffers_.pop_front();
+
+  // Update the decoder config, which the decoder will use when it is notified
+  // of kConfigChanged. This waits until the change is returned, so that the
+  // config always matches the buffers returned so far.
+  if (result.first == kConfigChanged)
+    InitializeDecoderConfig();
+
+  base::ResetAndReturn(&read_cb_).Run(result.first, result.second);
+}
+
+void DecryptingDemuxerStream::MaybeReadAhead() {
+  if (state_ != kIdle || !reset_cb_.is_null())
+    return;
+
+  if (read_cb_.is_null() &&
+      (read_ahead_paused_ || ready_buffers_.size() >= max_ready_buffers_)) {
+    return;
+  }
+
+  ReadFromDemuxerStream();
 }
 
 void DecryptingDemuxerStream::OnKeyAdded() {
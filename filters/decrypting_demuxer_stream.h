@@ -5,6 +5,9 @@
 #ifndef MEDIA_FILTERS_DECRYPTING_DEMUXER_STREAM_H_
 #define MEDIA_FILTERS_DECRYPTING_DEMUXER_STREAM_H_
 
+#include <deque>
+#include <utility>
+
 #include "base/callback.h"
 #include "base/macros.h"
 #include "base/memory/ref_counted.h"
@@ -29,8 +32,18 @@ class MediaLog;
 // encrypted demuxer stream to a clear demuxer stream.
 // All public APIs and callbacks are trampolined to the |task_runner_| so
 // that no locks are required for thread safety.
+//
+// When the kDecryptAhead feature is enabled, up to kMaxDecryptAheadBuffers
+// buffers are read and decrypted before the decoder asks for them, so that a
+// Read() is usually satisfied without waiting for the demuxer or decryptor.
+// Reading ahead stops at end of stream, config changes, errors and while
+// waiting for a key, and decrypted buffers are dropped on Reset().
 class MEDIA_EXPORT DecryptingDemuxerStream : public DemuxerStream {
  public:
+  // Maximum number of buffers that are read and decrypted before the decoder
+  // asks for them, when decrypt-ahead is enabled.
+  static const size_t kMaxDecryptAheadBuffers;
+
   DecryptingDemuxerStream(
       const scoped_refptr<base::SingleThreadTaskRunner>& task_runner,
       MediaLog* media_log,
@@ -48,6 +61,8 @@ class MEDIA_EXPORT DecryptingDemuxerStream : public DemuxerStream {
   // kPendingDemuxerRead or kPendingDecrypt state, waits for the pending
   // operation to finish before satisfying |closure|. Sets the state to
   // kUninitialized if |this| hasn't been initialized, or to kIdle otherwise.
+  // Buffers decrypted ahead are dropped, except for a pending config change,
+  // which is still returned by the next Read().
   void Reset(const base::Closure& closure);
 
   // Returns the name of this class for logging purpose.
@@ -75,6 +90,12 @@ class MEDIA_EXPORT DecryptingDemuxerStream : public DemuxerStream {
     kWaitingForKey
   };
 
+  // A finished read, in the form it is returned to the caller of Read().
+  using ReadResult = std::pair<Status, scoped_refptr<DecoderBuffer>>;
+
+  // Reads the next buffer from |demuxer_stream_|.
+  void ReadFromDemuxerStream();
+
   // Callback for DemuxerStream::Read().
   void DecryptBuffer(DemuxerStream::Status status,
                      const scoped_refptr<DecoderBuffer>& buffer);
@@ -85,6 +106,18 @@ class MEDIA_EXPORT DecryptingDemuxerStream : public DemuxerStream {
   void DeliverBuffer(Decryptor::Status status,
                      const scoped_refptr<DecoderBuffer>& decrypted_buffer);
 
+  // Queues the result of the current read, returns it if a Read() is pending
+  // and reads ahead if there is room.
+  void CompleteRead(Status status, const scoped_refptr<DecoderBuffer>& buffer);
+
+  // Satisfies |read_cb_| with the oldest queued result.
+  void ReturnReadyBuffer();
+
+  // Starts reading the next buffer if a Read() is pending, or if decrypt-ahead
+  // is enabled and neither the queue is full nor the stream is at a point
+  // where it must not be read past.
+  void MaybeReadAhead();
+
   // Callback for the |decryptor_| to notify this object that a new key has been
   // added.
   void OnKeyAdded();
@@ -121,6 +154,17 @@ class MEDIA_EXPORT DecryptingDemuxerStream : public DemuxerStream {
   // The buffer returned by the demuxer that needs to be decrypted.
   scoped_refptr<media::DecoderBuffer> pending_buffer_to_decrypt_;
 
+  // Results read and decrypted ahead of Read(), oldest first. Only the last
+  // result may be an end of stream, a config change or a failure.
+  std::deque<ReadResult> ready_buffers_;
+
+  // Maximum size of |ready_buffers_|; zero when decrypt-ahead is disabled.
+  const size_t max_ready_buffers_;
+
+  // Set when an end of stream, config change or failure has been read, until
+  // the caller has read it.
+  bool read_ahead_paused_;
+
   // Indicates the situation where new key is added during pending decryption
   // (in other words, this variable can only be set in state kPendingDecrypt).
   // If this variable is true and kNoKey is returned then we need to try
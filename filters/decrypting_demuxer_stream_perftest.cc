@@ -0,0 +1,179 @@
+// Copyright 2017 The Chromium Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#include <stdint.h>
+
+#include <string>
+#include <vector>
+
+#include "base/bind.h"
+#include "base/bind_helpers.h"
+#include "base/location.h"
+#include "base/macros.h"
+#include "base/memory/ptr_util.h"
+#include "base/message_loop/message_loop.h"
+#include "base/run_loop.h"
+#include "base/single_thread_task_runner.h"
+#include "base/test/scoped_feature_list.h"
+#include "base/threading/thread_task_runner_handle.h"
+#include "base/time/time.h"
+#include "media/base/cdm_callback_promise.h"
+#include "media/base/decoder_buffer.h"
+#include "media/base/decrypt_config.h"
+#include "media/base/demuxer_stream.h"
+#include "media/base/media_log.h"
+#include "media/base/media_switches.h"
+#include "media/base/mock_filters.h"
+#include "media/base/test_helpers.h"
+#include "media/cdm/aes_decryptor.h"
+#include "media/cdm/json_web_key.h"
+#include "media/filters/decrypting_demuxer_stream.h"
+#include "testing/gmock/include/gmock/gmock.h"
+#include "testing/gtest/include/gtest/gtest.h"
+#include "testing/perf/perf_test.h"
+
+namespace media {
+
+namespace {
+
+const uint8_t kKeyId[] = {0x00, 0x01, 0x02, 0x03};
+const uint8_t kKey[] = {0x04, 0x05, 0x06, 0x07, 0x08, 0x09, 0x0a, 0x0b,
+                        0x0c, 0x0d, 0x0e, 0x0f, 0x10, 0x11, 0x12, 0x13};
+const char kIv[] = "0123456789abcdef";
+
+// Roughly the size of a 4K video frame at a typical streaming bitrate.
+const size_t kSampleSize = 512 * 1024;
+const int kReads = 500;
+
+// An encrypted video stream which returns the same sample on every read. The
+// sample is returned asynchronously, as a demuxer does.
+class EncryptedDemuxerStream : public DemuxerStream {
+ public:
+  EncryptedDemuxerStream() : sample_(new DecoderBuffer(kSampleSize)) {
+    for (size_t i = 0; i < kSampleSize; ++i)
+      sample_->writable_data()[i] = static_cast<uint8_t>(i * 31);
+    sample_->set_decrypt_config(base::MakeUnique<DecryptConfig>(
+        std::string(reinterpret_cast<const char*>(kKeyId), arraysize(kKeyId)),
+        std::string(kIv, DecryptConfig::kDecryptionKeySize),
+        std::vector<SubsampleEntry>()));
+  }
+
+  // DemuxerStream implementation.
+  void Read(const ReadCB& read_cb) override {
+    base::ThreadTaskRunnerHandle::Get()->PostTask(
+        FROM_HERE, base::Bind(read_cb, kOk, sample_));
+  }
+  AudioDecoderConfig audio_decoder_config() override {
+    NOTREACHED();
+    return AudioDecoderConfig();
+  }
+  VideoDecoderConfig video_decoder_config() override {
+    return TestVideoConfig::NormalEncrypted();
+  }
+  Type type() const override { return VIDEO; }
+  bool SupportsConfigChanges() override { return false; }
+
+ private:
+  const scoped_refptr<DecoderBuffer> sample_;
+
+  DISALLOW_COPY_AND_ASSIGN(EncryptedDemuxerStream);
+};
+
+void OnSessionCreated(std::string* session_id_out,
+                      const std::string& session_id) {
+  *session_id_out = session_id;
+}
+
+void OnPromiseRejected(CdmPromise::Exception exception_code,
+                       uint32_t system_code,
+                       const std::string& error_message) {
+  FAIL() << "Unexpectedly rejected with message: " << error_message;
+}
+
+// Creates an AesDecryptor holding |kKey| for |kKeyId|, which reports its
+// session events to |cdm_client|.
+scoped_refptr<AesDecryptor> CreateDecryptor(MockCdmClient* cdm_client) {
+  scoped_refptr<AesDecryptor> decryptor(new AesDecryptor(
+      base::Bind(&MockCdmClient::OnSessionMessage,
+                 base::Unretained(cdm_client)),
+      base::Bind(&MockCdmClient::OnSessionClosed, base::Unretained(cdm_client)),
+      base::Bind(&MockCdmClient::OnSessionKeysChange,
+                 base::Unretained(cdm_client)),
+      base::Bind(&MockCdmClient::OnSessionExpirationUpdate,
+                 base::Unretained(cdm_client))));
+
+  std::string session_id;
+  decryptor->CreateSessionAndGenerateRequest(
+      CdmSessionType::TEMPORARY_SESSION, EmeInitDataType::WEBM,
+      std::vector<uint8_t>(kKeyId, kKeyId + arraysize(kKeyId)),
+      std::unique_ptr<NewSessionCdmPromise>(
+          new CdmCallbackPromise<std::string>(
+              base::Bind(&OnSessionCreated, &session_id),
+              base::Bind(&OnPromiseRejected))));
+  const std::string jwk_set = GenerateJWKSet(kKey, arraysize(kKey), kKeyId,
+                                             arraysize(kKeyId));
+  decryptor->UpdateSession(
+      session_id, std::vector<uint8_t>(jwk_set.begin(), jwk_set.end()),
+      std::unique_ptr<SimpleCdmPromise>(new CdmCallbackPromise<>(
+          base::Bind(&base::DoNothing), base::Bind(&OnPromiseRejected))));
+  return decryptor;
+}
+
+void OnInitialized(PipelineStatus status) {
+  ASSERT_EQ(PIPELINE_OK, status);
+}
+
+void OnBufferReady(const base::Closure& quit_closure,
+                   DemuxerStream::Status status,
+                   const scoped_refptr<DecoderBuffer>& buffer) {
+  ASSERT_EQ(DemuxerStream::kOk, status);
+  quit_closure.Run();
+}
+
+// Reads |kReads| buffers through a DecryptingDemuxerStream backed by an
+// AesDecryptor, and reports how long the decoder waits on each read. Between
+// reads the media thread is left idle, as it is while a decoder works on the
+// previous buffer.
+void RunReadBenchmark(bool decrypt_ahead) {
+  base::test::ScopedFeatureList scoped_feature_list;
+  if (decrypt_ahead)
+    scoped_feature_list.InitAndEnableFeature(kDecryptAhead);
+  else
+    scoped_feature_list.InitAndDisableFeature(kDecryptAhead);
+
+  base::MessageLoop message_loop;
+  testing::NiceMock<MockCdmClient> cdm_client;
+  scoped_refptr<AesDecryptor> decryptor = CreateDecryptor(&cdm_client);
+  EncryptedDemuxerStream input_stream;
+  MediaLog media_log;
+  DecryptingDemuxerStream stream(message_loop.task_runner(), &media_log,
+                                 base::Bind(&base::DoNothing));
+  stream.Initialize(&input_stream, decryptor->GetCdmContext(),
+                    base::Bind(&OnInitialized));
+  base::RunLoop().RunUntilIdle();
+
+  base::TimeDelta read_time;
+  for (int i = 0; i < kReads; ++i) {
+    base::RunLoop run_loop;
+    const base::TimeTicks start = base::TimeTicks::Now();
+    stream.Read(base::Bind(&OnBufferReady, run_loop.QuitClosure()));
+    run_loop.Run();
+    read_time += base::TimeTicks::Now() - start;
+    base::RunLoop().RunUntilIdle();
+  }
+
+  perf_test::PrintResult("decrypting_demuxer_stream",
+                         decrypt_ahead ? "_decrypt_ahead" : "_on_demand",
+                         "read_latency", read_time.InMicrosecondsF() / kReads,
+                         "us", true);
+}
+
+}  // namespace
+
+TEST(DecryptingDemuxerStreamPerfTest, ReadLatency) {
+  RunReadBenchmark(false);
+  RunReadBenchmark(true);
+}
+
+}  // namespace media
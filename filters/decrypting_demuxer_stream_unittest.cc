@@ -12,9 +12,11 @@
 #include "base/macros.h"
 #include "base/message_loop/message_loop.h"
 #include "base/run_loop.h"
+#include "base/test/scoped_feature_list.h"
 #include "media/base/decoder_buffer.h"
 #include "media/base/decrypt_config.h"
 #include "media/base/gmock_callback_support.h"
+#include "media/base/media_switches.h"
 #include "media/base/media_util.h"
 #include "media/base/mock_filters.h"
 #include "media/base/mock_media_log.h"
@@ -26,6 +28,7 @@ using ::testing::_;
 using ::testing::HasSubstr;
 using ::testing::IsNull;
 using ::testing::InSequence;
+using ::testing::Mock;
 using ::testing::Return;
 using ::testing::SaveArg;
 using ::testing::StrictMock;
@@ -87,6 +90,16 @@ class DecryptingDemuxerStreamTest : public testing::Test {
     base::RunLoop().RunUntilIdle();
   }
 
+  // Recreates |demuxer_stream_| with the kDecryptAhead feature enabled. Must be
+  // called before Initialize().
+  void EnableDecryptAhead() {
+    scoped_feature_list_.InitAndEnableFeature(kDecryptAhead);
+    demuxer_stream_.reset(new DecryptingDemuxerStream(
+        message_loop_.task_runner(), &media_log_,
+        base::Bind(&DecryptingDemuxerStreamTest::OnWaitingForDecryptionKey,
+                   base::Unretained(this))));
+  }
+
   void OnInitialized(PipelineStatus expected_status, PipelineStatus status) {
     EXPECT_EQ(expected_status, status);
     is_initialized_ = status == PIPELINE_OK;
@@ -259,6 +272,7 @@ class DecryptingDemuxerStreamTest : public testing::Test {
   MOCK_METHOD0(OnWaitingForDecryptionKey, void(void));
 
   base::MessageLoop message_loop_;
+  base::test::ScopedFeatureList scoped_feature_list_;
   StrictMock<MockMediaLog> media_log_;
   std::unique_ptr<DecryptingDemuxerStream> demuxer_stream_;
   std::unique_ptr<StrictMock<MockCdmContext>> cdm_context_;
@@ -502,6 +516,124 @@ TEST_F(DecryptingDemuxerStreamTest, Reset_DuringConfigChangedDemuxerRead) {
   base::RunLoop().RunUntilIdle();
 }
 
+// Test that with decrypt-ahead, the first read is followed by reading and
+// decrypting the upcoming buffers, and later reads are satisfied from those.
+TEST_F(DecryptingDemuxerStreamTest, DecryptAhead_DecryptsUpcomingBuffers) {
+  EnableDecryptAhead();
+  Initialize();
+
+  const int kBuffersRead = 1 + DecryptingDemuxerStream::kMaxDecryptAheadBuffers;
+  EXPECT_CALL(*input_audio_stream_, Read(_))
+      .Times(kBuffersRead)
+      .WillRepeatedly(ReturnBuffer(encrypted_buffer_));
+  EXPECT_CALL(*decryptor_, Decrypt(_, encrypted_buffer_, _))
+      .Times(kBuffersRead)
+      .WillRepeatedly(RunCallback<2>(Decryptor::kSuccess, decrypted_buffer_));
+  ReadAndExpectBufferReadyWith(DemuxerStream::kOk, decrypted_buffer_);
+  Mock::VerifyAndClearExpectations(input_audio_stream_.get());
+  Mock::VerifyAndClearExpectations(decryptor_.get());
+
+  // Each read returns a decrypted buffer and tops the queue up again.
+  EXPECT_CALL(*input_audio_stream_, Read(_))
+      .WillOnce(ReturnBuffer(encrypted_buffer_));
+  EXPECT_CALL(*decryptor_, Decrypt(_, encrypted_buffer_, _))
+      .WillOnce(RunCallback<2>(Decryptor::kSuccess, decrypted_buffer_));
+  ReadAndExpectBufferReadyWith(DemuxerStream::kOk, decrypted_buffer_);
+}
+
+// Test that decrypt-ahead does not read past the end of stream.
+TEST_F(DecryptingDemuxerStreamTest, DecryptAhead_StopsAtEndOfStream) {
+  EnableDecryptAhead();
+  Initialize();
+
+  EXPECT_CALL(*input_audio_stream_, Read(_))
+      .WillOnce(ReturnBuffer(encrypted_buffer_))
+      .WillOnce(ReturnBuffer(DecoderBuffer::CreateEOSBuffer()));
+  EXPECT_CALL(*decryptor_, Decrypt(_, encrypted_buffer_, _))
+      .WillOnce(RunCallback<2>(Decryptor::kSuccess, decrypted_buffer_));
+  ReadAndExpectBufferReadyWith(DemuxerStream::kOk, decrypted_buffer_);
+
+  ReadAndExpectBufferReadyWith(DemuxerStream::kOk,
+                               DecoderBuffer::CreateEOSBuffer());
+}
+
+// Test that a missing key found while decrypting ahead is only reported once
+// a read is blocked on it.
+TEST_F(DecryptingDemuxerStreamTest, DecryptAhead_WaitingForKeyReportedOnRead) {
+  EnableDecryptAhead();
+  Initialize();
+
+  EXPECT_CALL(*input_audio_stream_, Read(_))
+      .WillRepeatedly(ReturnBuffer(encrypted_buffer_));
+  EXPECT_CALL(*decryptor_, Decrypt(_, encrypted_buffer_, _))
+      .WillOnce(RunCallback<2>(Decryptor::kSuccess, decrypted_buffer_))
+      .WillOnce(RunCallback<2>(Decryptor::kNoKey,
+                               scoped_refptr<DecoderBuffer>()));
+  EXPECT_MEDIA_LOG(HasSubstr("DecryptingDemuxerStream: no key for key ID"));
+  EXPECT_CALL(*this, OnWaitingForDecryptionKey()).Times(0);
+  ReadAndExpectBufferReadyWith(DemuxerStream::kOk, decrypted_buffer_);
+  Mock::VerifyAndClearExpectations(this);
+
+  EXPECT_CALL(*this, OnWaitingForDecryptionKey());
+  demuxer_stream_->Read(base::Bind(&DecryptingDemuxerStreamTest::BufferReady,
+                                   base::Unretained(this)));
+  base::RunLoop().RunUntilIdle();
+
+  EXPECT_MEDIA_LOG(
+      HasSubstr("DecryptingDemuxerStream: key was added, resuming decrypt"));
+  EXPECT_CALL(*decryptor_, Decrypt(_, encrypted_buffer_, _))
+      .WillRepeatedly(RunCallback<2>(Decryptor::kSuccess, decrypted_buffer_));
+  EXPECT_CALL(*this, BufferReady(DemuxerStream::kOk, decrypted_buffer_));
+  key_added_cb_.Run();
+  base::RunLoop().RunUntilIdle();
+}
+
+// Test that resetting drops the buffers decrypted ahead.
+TEST_F(DecryptingDemuxerStreamTest, DecryptAhead_ResetDropsDecryptedBuffers) {
+  EnableDecryptAhead();
+  Initialize();
+
+  const int kBuffersRead = 1 + DecryptingDemuxerStream::kMaxDecryptAheadBuffers;
+  EXPECT_CALL(*input_audio_stream_, Read(_))
+      .Times(2 * kBuffersRead)
+      .WillRepeatedly(ReturnBuffer(encrypted_buffer_));
+  EXPECT_CALL(*decryptor_, Decrypt(_, encrypted_buffer_, _))
+      .Times(2 * kBuffersRead)
+      .WillRepeatedly(RunCallback<2>(Decryptor::kSuccess, decrypted_buffer_));
+  ReadAndExpectBufferReadyWith(DemuxerStream::kOk, decrypted_buffer_);
+  Reset();
+  ReadAndExpectBufferReadyWith(DemuxerStream::kOk, decrypted_buffer_);
+}
+
+// Test that a config change read ahead only updates the output config when it
+// is returned, after the buffers that precede it.
+TEST_F(DecryptingDemuxerStreamTest, DecryptAhead_ConfigChangedWhenReturned) {
+  EnableDecryptAhead();
+  Initialize();
+
+  AudioDecoderConfig new_config(kCodecVorbis, kSampleFormatPlanarF32,
+                                CHANNEL_LAYOUT_STEREO, 88200, EmptyExtraData(),
+                                AesCtrEncryptionScheme());
+  input_audio_stream_->set_audio_decoder_config(new_config);
+
+  EXPECT_CALL(*input_audio_stream_, Read(_))
+      .WillOnce(ReturnBuffer(encrypted_buffer_))
+      .WillOnce(ReturnBuffer(encrypted_buffer_))
+      .WillOnce(RunCallback<0>(DemuxerStream::kConfigChanged,
+                               scoped_refptr<DecoderBuffer>()));
+  EXPECT_CALL(*decryptor_, Decrypt(_, encrypted_buffer_, _))
+      .Times(2)
+      .WillRepeatedly(RunCallback<2>(Decryptor::kSuccess, decrypted_buffer_));
+  ReadAndExpectBufferReadyWith(DemuxerStream::kOk, decrypted_buffer_);
+  ReadAndExpectBufferReadyWith(DemuxerStream::kOk, decrypted_buffer_);
+  EXPECT_EQ(44100,
+            demuxer_stream_->audio_decoder_config().samples_per_second());
+
+  ReadAndExpectBufferReadyWith(DemuxerStream::kConfigChanged, NULL);
+  EXPECT_EQ(88200,
+            demuxer_stream_->audio_decoder_config().samples_per_second());
+}
+
 // The following tests test destruction in various scenarios. The destruction
 // happens in DecryptingDemuxerStreamTest's dtor.
 
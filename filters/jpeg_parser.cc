@@ -270,62 +270,73 @@ static bool ParseSOS(const char* buffer,
   return true;
 }
 
+// Returns a pointer to the first marker prefix in [|ptr|, |end|) that starts
+// a real marker, i.e. one that is neither a stuffed zero byte (0xFF00) nor a
+// restart marker, or |end| if there is none. Entropy-coded data is dominated
+// by stuffed bytes, so they are skipped here without going back through a
+// BigEndianReader for every 0xFF found.
+static const char* FindNextSegmentMarker(const char* ptr, const char* end) {
+  while (ptr < end) {
+    const char* prefix = static_cast<const char*>(
+        memchr(ptr, JPEG_MARKER_PREFIX, end - ptr));
+    if (!prefix)
+      return end;
+
+    // Skip fill bytes.
+    const char* next = prefix + 1;
+    while (next < end && static_cast<uint8_t>(*next) == JPEG_MARKER_PREFIX)
+      ++next;
+    if (next == end)
+      return end;
+
+    const uint8_t marker = static_cast<uint8_t>(*next);
+    if (marker != 0x00 && !InRange(marker, JPEG_RST0, JPEG_RST7))
+      return prefix;
+    ptr = next + 1;
+  }
+  return end;
+}
+
 // |eoi_ptr| will point to the end of image (after EOI marker) after search
 // succeeds. Returns true on EOI marker found, or false.
 static bool SearchEOI(const char* buffer, size_t length, const char** eoi_ptr) {
   DCHECK(buffer);
   DCHECK(eoi_ptr);
-  BigEndianReader reader(buffer, length);
+  const char* const end = buffer + length;
+  const char* ptr = buffer;
   uint8_t marker2;
 
-  while (reader.remaining() > 0) {
-    const char* marker1_ptr = static_cast<const char*>(
-        memchr(reader.ptr(), JPEG_MARKER_PREFIX, reader.remaining()));
-    if (!marker1_ptr)
+  while (ptr < end) {
+    const char* marker1_ptr = FindNextSegmentMarker(ptr, end);
+    if (marker1_ptr == end)
       return false;
-    reader.Skip(marker1_ptr - reader.ptr() + 1);
+    BigEndianReader reader(marker1_ptr + 1, end - marker1_ptr - 1);
 
     do {
       READ_U8_OR_RETURN_FALSE(&marker2);
     } while (marker2 == JPEG_MARKER_PREFIX);  // skip fill bytes
 
-    switch (marker2) {
-      // Compressed data escape.
-      case 0x00:
-        break;
-      // Restart
-      case JPEG_RST0:
-      case JPEG_RST1:
-      case JPEG_RST2:
-      case JPEG_RST3:
-      case JPEG_RST4:
-      case JPEG_RST5:
-      case JPEG_RST6:
-      case JPEG_RST7:
-        break;
-      case JPEG_EOI:
-        *eoi_ptr = reader.ptr();
-        return true;
-      default:
-        // Skip for other markers.
-        uint16_t size;
-        READ_U16_OR_RETURN_FALSE(&size);
-        if (size < sizeof(size)) {
-          DLOG(ERROR) << "Ill-formed JPEG. Segment size (" << size
-                      << ") is smaller than size field (" << sizeof(size)
-                      << ")";
-          return false;
-        }
-        size -= sizeof(size);
+    if (marker2 == JPEG_EOI) {
+      *eoi_ptr = reader.ptr();
+      return true;
+    }
 
-        if (!reader.Skip(size)) {
-          DLOG(ERROR) << "Ill-formed JPEG. Remaining size ("
-                      << reader.remaining()
-                      << ") is smaller than header specified (" << size << ")";
-          return false;
-        }
-        break;
+    // Skip for other markers.
+    uint16_t size;
+    READ_U16_OR_RETURN_FALSE(&size);
+    if (size < sizeof(size)) {
+      DLOG(ERROR) << "Ill-formed JPEG. Segment size (" << size
+                  << ") is smaller than size field (" << sizeof(size) << ")";
+      return false;
+    }
+    size -= sizeof(size);
+
+    if (!reader.Skip(size)) {
+      DLOG(ERROR) << "Ill-formed JPEG. Remaining size (" << reader.remaining()
+                  << ") is smaller than header specified (" << size << ")";
+      return false;
     }
+    ptr = reader.ptr();
   }
   return false;
 }
@@ -0,0 +1,59 @@
+// Copyright 2017 The Chromium Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include <string>
+
+#include "base/files/memory_mapped_file.h"
+#include "base/time/time.h"
+#include "media/base/test_data_util.h"
+#include "media/filters/jpeg_parser.h"
+#include "testing/gtest/include/gtest/gtest.h"
+#include "testing/perf/perf_test.h"
+
+namespace media {
+
+static const int kBenchmarkIterations = 200;
+
+// Splits a recorded motion JPEG stream into frames the same way the MJPEG
+// capture and file capture paths do, and reports the parsing throughput.  Only
+// the marker and header parsing is timed; no image data is decoded.
+static void RunJpegStreamParserBenchmark(const std::string& filename) {
+  base::MemoryMappedFile stream;
+  ASSERT_TRUE(stream.Initialize(GetTestDataFilePath(filename)));
+
+  int num_frames = 0;
+  const base::TimeTicks start = base::TimeTicks::Now();
+  for (int i = 0; i < kBenchmarkIterations; ++i) {
+    size_t offset = 0;
+    while (offset < stream.length()) {
+      JpegParseResult result;
+      ASSERT_TRUE(ParseJpegStream(stream.data() + offset,
+                                  stream.length() - offset, &result));
+      offset += result.image_size;
+      ++num_frames;
+    }
+  }
+  const double elapsed_seconds =
+      (base::TimeTicks::Now() - start).InSecondsF();
+
+  perf_test::PrintResult("jpeg_parser", "", filename,
+                         num_frames / elapsed_seconds, "frames/s", true);
+  perf_test::PrintResult(
+      "jpeg_parser", "", filename,
+      kBenchmarkIterations * stream.length() / elapsed_seconds / (1 << 20),
+      "MB/s", true);
+}
+
+TEST(JpegParserPerfTest, ParseMjpegStream) {
+  RunJpegStreamParserBenchmark("bear.mjpeg");
+}
+
+TEST(JpegParserPerfTest, ParseSingleImage) {
+  RunJpegStreamParserBenchmark("pixel-1280x720.jpg");
+}
+
+}  // namespace media
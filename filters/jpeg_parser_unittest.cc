@@ -4,8 +4,11 @@
 
 #include <stdint.h>
 
+#include <vector>
+
 #include "base/at_exit.h"
 #include "base/files/memory_mapped_file.h"
+#include "base/macros.h"
 #include "base/path_service.h"
 #include "media/base/test_data_util.h"
 #include "media/filters/jpeg_parser.h"
@@ -106,6 +109,92 @@ TEST(JpegParserTest, CodedSizeNotEqualVisibleSize) {
   EXPECT_EQ(2, result.frame_header.components[0].vertical_sampling_factor);
 }
 
+TEST(JpegParserTest, ParseStream) {
+  base::FilePath data_dir;
+  ASSERT_TRUE(PathService::Get(base::DIR_SOURCE_ROOT, &data_dir));
+
+  base::FilePath file_path = data_dir.AppendASCII("media")
+                                 .AppendASCII("test")
+                                 .AppendASCII("data")
+                                 .AppendASCII("pixel-1280x720.jpg");
+
+  base::MemoryMappedFile stream;
+  ASSERT_TRUE(stream.Initialize(file_path))
+      << "Couldn't open stream file: " << file_path.MaybeAsASCII();
+
+  JpegParseResult result;
+  ASSERT_TRUE(ParseJpegStream(stream.data(), stream.length(), &result));
+  EXPECT_EQ(121150u, result.data_size);
+  EXPECT_EQ(stream.length(), result.image_size);
+}
+
+TEST(JpegParserTest, ParseConcatenatedStream) {
+  base::FilePath data_dir;
+  ASSERT_TRUE(PathService::Get(base::DIR_SOURCE_ROOT, &data_dir));
+
+  // Motion JPEG file made of 30 back-to-back JPEG images.
+  base::FilePath file_path = data_dir.AppendASCII("media")
+                                 .AppendASCII("test")
+                                 .AppendASCII("data")
+                                 .AppendASCII("bear.mjpeg");
+
+  base::MemoryMappedFile stream;
+  ASSERT_TRUE(stream.Initialize(file_path))
+      << "Couldn't open stream file: " << file_path.MaybeAsASCII();
+
+  size_t offset = 0;
+  int num_frames = 0;
+  while (offset < stream.length()) {
+    JpegParseResult result;
+    ASSERT_TRUE(ParseJpegStream(stream.data() + offset,
+                                stream.length() - offset, &result));
+    ASSERT_GT(result.image_size, 0u);
+    // Every image must end right after its EOI marker.
+    EXPECT_EQ(JPEG_MARKER_PREFIX,
+              stream.data()[offset + result.image_size - 2]);
+    EXPECT_EQ(JPEG_EOI, stream.data()[offset + result.image_size - 1]);
+    offset += result.image_size;
+    ++num_frames;
+  }
+  EXPECT_EQ(stream.length(), offset);
+  EXPECT_EQ(30, num_frames);
+}
+
+TEST(JpegParserTest, SearchEOISkipsStuffedBytesAndRestartMarkers) {
+  base::FilePath data_dir;
+  ASSERT_TRUE(PathService::Get(base::DIR_SOURCE_ROOT, &data_dir));
+
+  base::FilePath file_path = data_dir.AppendASCII("media")
+                                 .AppendASCII("test")
+                                 .AppendASCII("data")
+                                 .AppendASCII("blank-1x1.jpg");
+
+  base::MemoryMappedFile stream;
+  ASSERT_TRUE(stream.Initialize(file_path))
+      << "Couldn't open stream file: " << file_path.MaybeAsASCII();
+
+  JpegParseResult result;
+  ASSERT_TRUE(ParseJpegPicture(stream.data(), stream.length(), &result));
+  const size_t header_size = result.image_size - result.data_size;
+
+  // Replace the scan data with stuffed bytes, fill bytes and restart markers,
+  // none of which may terminate the search.
+  const uint8_t kScanData[] = {0x12, 0xFF, 0x00, 0x34, 0xFF, 0xD0, 0xFF,
+                               0xFF, 0x00, 0x56, 0xFF, 0xD7, 0xFF, 0xD9};
+  std::vector<uint8_t> data(stream.data(), stream.data() + header_size);
+  data.insert(data.end(), kScanData, kScanData + arraysize(kScanData));
+  // Trailing garbage must not be included in the image.
+  data.push_back(0xAB);
+
+  ASSERT_TRUE(ParseJpegStream(data.data(), data.size(), &result));
+  EXPECT_EQ(arraysize(kScanData), result.data_size);
+  EXPECT_EQ(data.size() - 1, result.image_size);
+
+  // Without the EOI marker, the search must fail.
+  data.resize(data.size() - 3);
+  EXPECT_FALSE(ParseJpegStream(data.data(), data.size(), &result));
+}
+
 TEST(JpegParserTest, ParsingFail) {
   const uint8_t data[] = {0, 1, 2, 3};  // not jpeg
   JpegParseResult result;
@@ -6,11 +6,18 @@
 
 #include <stddef.h>
 #include <stdint.h>
+#include <algorithm>
 #include <map>
 #include <memory>
 #include <utility>
 
 #include "base/bind.h"
+#include "base/location.h"
+#include "base/sequenced_task_runner.h"
+#include "base/synchronization/atomic_flag.h"
+#include "base/synchronization/waitable_event.h"
+#include "base/task_scheduler/post_task.h"
+#include "base/task_scheduler/task_scheduler.h"
 #include "base/time/time.h"
 #include "media/ffmpeg/ffmpeg_common.h"
 #include "media/ffmpeg/ffmpeg_decoding_loop.h"
@@ -23,6 +30,15 @@ namespace media {
 
 static const int64_t kMaxCheckTimeInSeconds = 5;
 
+// The number of places spread across the file at which sampled streams are
+// decoded, and how much is decoded at each of them. When the duration of the
+// file is unknown, a sample is taken every |kUnknownDurationSampleInterval|.
+static const int kNumSamples = 4;
+static const int64_t kSampleDurationInSeconds = 1;
+static const int64_t kUnknownDurationSampleIntervalInSeconds = 30;
+
+typedef std::unique_ptr<AVPacket, ScopedPtrAVFreePacket> ScopedAVPacket;
+
 static void OnError(bool* called) {
   *called = false;
 }
@@ -34,14 +50,81 @@ static bool DoNothingWithFrame(AVFrame* frame) {
 struct Decoder {
   std::unique_ptr<AVCodecContext, ScopedPtrAVFreeContext> context;
   std::unique_ptr<FFmpegDecodingLoop> loop;
+  AVRational time_base = {0, 1};
+  bool is_audio = false;
+
+  // Sampling state, see ShouldDecodePacket().
+  bool in_sample = false;
+  base::TimeDelta sample_end_time;
+  base::TimeDelta next_sample_time;
 };
 
-MediaFileChecker::MediaFileChecker(base::File file) : file_(std::move(file)) {}
+// Returns whether |packet| is decoded in |mode|. A sample starts at the first
+// keyframe at or after the time of the next sample, and lasts until the first
+// keyframe at least |kSampleDurationInSeconds| later, so that whole groups of
+// pictures are decoded. |starts_sample| is set if the decoder should be
+// flushed first, since its state from the previous sample is of no use.
+static bool ShouldDecodePacket(MediaFileChecker::Mode mode,
+                               base::TimeDelta sample_interval,
+                               const AVPacket& packet,
+                               Decoder* decoder,
+                               bool* starts_sample) {
+  *starts_sample = false;
+  const bool is_keyframe = (packet.flags & AV_PKT_FLAG_KEY) != 0;
+  if (mode == MediaFileChecker::Mode::kFullDecode)
+    return true;
+  if (mode == MediaFileChecker::Mode::kKeyframesOnly && !decoder->is_audio)
+    return is_keyframe;
 
-MediaFileChecker::~MediaFileChecker() {}
+  const int64_t timestamp =
+      packet.pts != AV_NOPTS_VALUE ? packet.pts : packet.dts;
+  if (timestamp == AV_NOPTS_VALUE)
+    return decoder->in_sample;
+  const base::TimeDelta time =
+      ConvertFromTimeBase(decoder->time_base, timestamp);
 
-bool MediaFileChecker::Start(base::TimeDelta check_time) {
-  media::FileDataSource source(std::move(file_));
+  if (decoder->in_sample) {
+    if (!is_keyframe || time < decoder->sample_end_time)
+      return true;
+    decoder->in_sample = false;
+  }
+
+  if (!is_keyframe || time < decoder->next_sample_time)
+    return false;
+
+  *starts_sample = true;
+  decoder->in_sample = true;
+  decoder->sample_end_time =
+      time + base::TimeDelta::FromSeconds(kSampleDurationInSeconds);
+  decoder->next_sample_time = time + sample_interval;
+  return true;
+}
+
+// Decodes |packet| with |decoder| on the audio sequence, unless an earlier
+// packet has failed or the check is over.
+static void DecodePacketOnSequence(Decoder* decoder,
+                                   base::TimeTicks deadline,
+                                   base::AtomicFlag* failed,
+                                   bool flush,
+                                   ScopedAVPacket packet) {
+  if (failed->IsSet() || base::TimeTicks::Now() >= deadline)
+    return;
+  if (flush)
+    avcodec_flush_buffers(decoder->context.get());
+  if (decoder->loop->DecodePacket(packet.get(),
+                                  base::BindRepeating(&DoNothingWithFrame)) !=
+      FFmpegDecodingLoop::DecodeStatus::kOkay) {
+    failed->Set();
+  }
+}
+
+// Checks |file| as MediaFileChecker::Start() describes. The audio is only
+// decoded in parallel with the video if |allow_parallel_audio| is set.
+static bool CheckFile(base::File file,
+                      base::TimeDelta check_time,
+                      MediaFileChecker::Mode mode,
+                      bool allow_parallel_audio) {
+  media::FileDataSource source(std::move(file));
   bool read_ok = true;
   media::BlockingUrlProtocol protocol(&source, base::Bind(&OnError, &read_ok));
   media::FFmpegGlue glue(&protocol);
@@ -55,6 +138,8 @@ bool MediaFileChecker::Start(base::TimeDelta check_time) {
 
   // Remember the codec context for any decodable audio or video streams.
   bool found_streams = false;
+  bool found_audio = false;
+  bool found_video = false;
   std::vector<Decoder> stream_contexts(format_context->nb_streams);
   for (size_t i = 0; i < format_context->nb_streams; ++i) {
     AVCodecParameters* cp = format_context->streams[i]->codecpar;
@@ -67,8 +152,14 @@ bool MediaFileChecker::Start(base::TimeDelta check_time) {
       AVCodec* codec = avcodec_find_decoder(cp->codec_id);
       if (codec && avcodec_open2(context.get(), codec, nullptr) >= 0) {
         auto loop = std::make_unique<FFmpegDecodingLoop>(context.get());
-        stream_contexts[i] = {std::move(context), std::move(loop)};
+        Decoder& decoder = stream_contexts[i];
+        decoder.context = std::move(context);
+        decoder.loop = std::move(loop);
+        decoder.time_base = format_context->streams[i]->time_base;
+        decoder.is_audio = cp->codec_type == AVMEDIA_TYPE_AUDIO;
         found_streams = true;
+        found_audio |= decoder.is_audio;
+        found_video |= !decoder.is_audio;
       }
     }
   }
@@ -76,6 +167,25 @@ bool MediaFileChecker::Start(base::TimeDelta check_time) {
   if (!found_streams)
     return false;
 
+  const base::TimeDelta sample_interval =
+      format_context->duration != AV_NOPTS_VALUE
+          ? std::max(ConvertFromTimeBase(AVRational{1, AV_TIME_BASE},
+                                         format_context->duration) /
+                         kNumSamples,
+                     base::TimeDelta::FromSeconds(kSampleDurationInSeconds))
+          : base::TimeDelta::FromSeconds(
+                kUnknownDurationSampleIntervalInSeconds);
+
+  // Audio is decoded on a sequence of its own if there is video to decode in
+  // parallel on this thread.
+  scoped_refptr<base::SequencedTaskRunner> audio_task_runner;
+  if (allow_parallel_audio && found_audio && found_video &&
+      base::TaskScheduler::GetInstance()) {
+    audio_task_runner = base::CreateSequencedTaskRunnerWithTraits(
+        {base::TaskPriority::USER_VISIBLE});
+  }
+  base::AtomicFlag audio_failed;
+
   AVPacket packet;
   int result = 0;
 
@@ -90,18 +200,60 @@ bool MediaFileChecker::Start(base::TimeDelta check_time) {
       break;
 
     auto& decoder = stream_contexts[packet.stream_index];
-    if (decoder.loop) {
-      result = decoder.loop->DecodePacket(&packet, do_nothing_cb) ==
-                       FFmpegDecodingLoop::DecodeStatus::kOkay
-                   ? 0
-                   : -1;
+    bool starts_sample = false;
+    if (decoder.loop && ShouldDecodePacket(mode, sample_interval, packet,
+                                           &decoder, &starts_sample)) {
+      if (audio_task_runner && decoder.is_audio) {
+        // |packet| is only valid until the next av_read_frame().
+        ScopedAVPacket audio_packet(new AVPacket());
+        result = av_packet_ref(audio_packet.get(), &packet);
+        if (result >= 0) {
+          audio_task_runner->PostTask(
+              FROM_HERE,
+              base::BindOnce(&DecodePacketOnSequence, &decoder, deadline,
+                             &audio_failed, starts_sample,
+                             std::move(audio_packet)));
+        }
+      } else {
+        if (starts_sample)
+          avcodec_flush_buffers(decoder.context.get());
+        result = decoder.loop->DecodePacket(&packet, do_nothing_cb) ==
+                         FFmpegDecodingLoop::DecodeStatus::kOkay
+                     ? 0
+                     : -1;
+      }
     }
 
     av_packet_unref(&packet);
-  } while (base::TimeTicks::Now() < deadline && read_ok && result >= 0);
+  } while (base::TimeTicks::Now() < deadline && read_ok && result >= 0 &&
+           !audio_failed.IsSet());
+
+  // The audio decoder and |audio_failed| must outlive the posted decodes.
+  if (audio_task_runner) {
+    base::WaitableEvent audio_done(
+        base::WaitableEvent::ResetPolicy::MANUAL,
+        base::WaitableEvent::InitialState::NOT_SIGNALED);
+    audio_task_runner->PostTask(
+        FROM_HERE, base::BindOnce(&base::WaitableEvent::Signal,
+                                  base::Unretained(&audio_done)));
+    audio_done.Wait();
+  }
 
   stream_contexts.clear();
-  return read_ok && (result == AVERROR_EOF || result >= 0);
+  return read_ok && !audio_failed.IsSet() &&
+         (result == AVERROR_EOF || result >= 0);
+}
+
+MediaFileChecker::MediaFileChecker(base::File file) : file_(std::move(file)) {}
+
+MediaFileChecker::~MediaFileChecker() {}
+
+bool MediaFileChecker::Start(base::TimeDelta check_time) {
+  return CheckFile(std::move(file_), check_time, Mode::kFullDecode, false);
+}
+
+bool MediaFileChecker::Start(base::TimeDelta check_time, Mode mode) {
+  return CheckFile(std::move(file_), check_time, mode, true);
 }
 
 }  // namespace media
@@ -20,14 +20,34 @@ namespace media {
 // file safe to use in the browser process.
 class MEDIA_EXPORT MediaFileChecker {
  public:
+  // How much of the audio/video data Start() decodes. The container is parsed
+  // in full in every mode, as long as |check_time| allows.
+  enum class Mode {
+    // Every packet is decoded.
+    kFullDecode,
+    // Only video keyframes are decoded. Since every audio packet is a
+    // keyframe, audio is sampled as in kSampledDecode.
+    kKeyframesOnly,
+    // A few groups of pictures, or seconds of audio, spread across the file
+    // are decoded from each stream.
+    kSampledDecode,
+  };
+
   explicit MediaFileChecker(base::File file);
   ~MediaFileChecker();
 
   // After opening |file|, up to |check_time| amount of wall-clock time is spent
   // decoding the file. The amount of audio/video data decoded will depend on
-  // the bitrate of the file and the speed of the CPU.
+  // the bitrate of the file and the speed of the CPU. Everything is decoded on
+  // the calling thread.
   bool Start(base::TimeDelta check_time);
 
+  // Same as above, but decodes only the data selected by |mode|, which lets
+  // much more of a large file be checked within |check_time|. If the file has
+  // both audio and video, the audio is decoded in parallel on the task
+  // scheduler, when there is one.
+  bool Start(base::TimeDelta check_time, Mode mode);
+
  private:
   base::File file_;
 
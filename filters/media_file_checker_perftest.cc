@@ -0,0 +1,73 @@
+// Copyright 2017 The Chromium Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "base/files/file.h"
+#include "base/files/file_enumerator.h"
+#include "base/files/file_path.h"
+#include "base/test/scoped_task_environment.h"
+#include "base/time/time.h"
+#include "media/base/test_data_util.h"
+#include "media/filters/media_file_checker.h"
+#include "testing/gtest/include/gtest/gtest.h"
+#include "testing/perf/perf_test.h"
+
+namespace media {
+
+namespace {
+
+// The time a media library scanner might allow for each file.
+const int kCheckTimeInSeconds = 1;
+
+std::vector<base::FilePath> GetTestDataFiles() {
+  std::vector<base::FilePath> files;
+  base::FileEnumerator enumerator(GetTestDataFilePath("bear.ogv").DirName(),
+                                  false, base::FileEnumerator::FILES);
+  for (base::FilePath path = enumerator.Next(); !path.empty();
+       path = enumerator.Next()) {
+    files.push_back(path);
+  }
+  return files;
+}
+
+// Checks every file of |files| in |mode| and reports how many files are
+// checked per second, and how many of them are found valid.
+void RunCheckBenchmark(const std::string& trace,
+                       const std::vector<base::FilePath>& files,
+                       MediaFileChecker::Mode mode) {
+  int valid_files = 0;
+  const base::TimeTicks start = base::TimeTicks::Now();
+  for (const base::FilePath& path : files) {
+    base::File file(path, base::File::FLAG_OPEN | base::File::FLAG_READ);
+    ASSERT_TRUE(file.IsValid());
+    MediaFileChecker checker(std::move(file));
+    if (checker.Start(base::TimeDelta::FromSeconds(kCheckTimeInSeconds), mode))
+      ++valid_files;
+  }
+  const base::TimeDelta elapsed = base::TimeTicks::Now() - start;
+
+  perf_test::PrintResult("media_file_checker", trace, "throughput",
+                         files.size() / elapsed.InSecondsF(), "files/s", true);
+  perf_test::PrintResult("media_file_checker", trace, "valid_files",
+                         valid_files, "files", true);
+}
+
+}  // namespace
+
+TEST(MediaFileCheckerPerfTest, TestDataCorpus) {
+  base::test::ScopedTaskEnvironment scoped_task_environment;
+  const std::vector<base::FilePath> files = GetTestDataFiles();
+  ASSERT_FALSE(files.empty());
+
+  RunCheckBenchmark("_full_decode", files, MediaFileChecker::Mode::kFullDecode);
+  RunCheckBenchmark("_keyframes_only", files,
+                    MediaFileChecker::Mode::kKeyframesOnly);
+  RunCheckBenchmark("_sampled_decode", files,
+                    MediaFileChecker::Mode::kSampledDecode);
+}
+
+}  // namespace media
@@ -8,6 +8,7 @@
 
 #include "base/files/file.h"
 #include "base/logging.h"
+#include "base/test/scoped_task_environment.h"
 #include "build/build_config.h"
 #include "media/base/test_data_util.h"
 #include "media/media_features.h"
@@ -15,6 +16,19 @@
 
 namespace media {
 
+static void RunMediaFileChecker(const std::string& filename,
+                                MediaFileChecker::Mode mode,
+                                bool expectation) {
+  base::File file(GetTestDataFilePath(filename),
+                  base::File::FLAG_OPEN | base::File::FLAG_READ);
+  ASSERT_TRUE(file.IsValid());
+
+  MediaFileChecker checker(std::move(file));
+  const base::TimeDelta check_time = base::TimeDelta::FromMilliseconds(100);
+  bool result = checker.Start(check_time, mode);
+  EXPECT_EQ(expectation, result);
+}
+
 static void RunMediaFileChecker(const std::string& filename, bool expectation) {
   base::File file(GetTestDataFilePath(filename),
                   base::File::FLAG_OPEN | base::File::FLAG_READ);
@@ -44,4 +58,40 @@ TEST(MediaFileCheckerTest, MP3) {
 }
 #endif
 
+TEST(MediaFileCheckerTest, KeyframesOnly) {
+  RunMediaFileChecker("ten_byte_file", MediaFileChecker::Mode::kKeyframesOnly,
+                      false);
+  RunMediaFileChecker("bear-320x240.webm",
+                      MediaFileChecker::Mode::kKeyframesOnly, true);
+  RunMediaFileChecker("sfx.ogg", MediaFileChecker::Mode::kKeyframesOnly, true);
+}
+
+TEST(MediaFileCheckerTest, SampledDecode) {
+  RunMediaFileChecker("ten_byte_file", MediaFileChecker::Mode::kSampledDecode,
+                      false);
+  RunMediaFileChecker("bear-320x240.webm",
+                      MediaFileChecker::Mode::kSampledDecode, true);
+  RunMediaFileChecker("sfx.ogg", MediaFileChecker::Mode::kSampledDecode, true);
+}
+
+// With a mode, audio is decoded on a sequence of its own when there is a task
+// scheduler.
+TEST(MediaFileCheckerTest, ParallelAudioAndVideo) {
+  base::test::ScopedTaskEnvironment scoped_task_environment;
+  RunMediaFileChecker("bear.ogv", MediaFileChecker::Mode::kFullDecode, true);
+  RunMediaFileChecker("bear-320x240.webm",
+                      MediaFileChecker::Mode::kSampledDecode, true);
+}
+
+// Without a mode, everything is decoded on the calling thread even when there
+// is a task scheduler. The queued task environment does not run its tasks
+// before RunUntilIdle(), so Start() would hang if it posted any.
+TEST(MediaFileCheckerTest, StartWithoutModeDecodesSerially) {
+  base::test::ScopedTaskEnvironment scoped_task_environment(
+      base::test::ScopedTaskEnvironment::MainThreadType::DEFAULT,
+      base::test::ScopedTaskEnvironment::ExecutionMode::QUEUED);
+  RunMediaFileChecker("bear.ogv", true);
+  RunMediaFileChecker("bear-320x240.webm", true);
+}
+
 }  // namespace media
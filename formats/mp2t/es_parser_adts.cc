@@ -213,9 +213,10 @@ bool EsParserAdts::ParseFromEsQueue() {
       if (base_decrypt_config) {
         std::vector<SubsampleEntry> subsamples;
         CalculateSubsamplesForAdtsFrame(adts_frame, &subsamples);
-        std::unique_ptr<DecryptConfig> decrypt_config(
-            new DecryptConfig(base_decrypt_config->key_id(),
-                              base_decrypt_config->iv(), subsamples));
+        std::unique_ptr<DecryptConfig> decrypt_config(new DecryptConfig(
+            base_decrypt_config->key_id(), base_decrypt_config->iv(),
+            subsamples, EncryptionScheme(EncryptionScheme::CIPHER_MODE_AES_CBC,
+                                         EncryptionScheme::Pattern())));
         stream_parser_buffer->set_decrypt_config(std::move(decrypt_config));
       }
     }
@@ -889,7 +889,8 @@ void Mp2tStreamParser::RegisterEncryptionScheme(
 
 void Mp2tStreamParser::RegisterDecryptConfig(const DecryptConfig& config) {
   decrypt_config_.reset(
-      new DecryptConfig(config.key_id(), config.iv(), config.subsamples()));
+      new DecryptConfig(config.key_id(), config.iv(), config.subsamples(),
+                        config.encryption_scheme()));
 }
 
 void Mp2tStreamParser::RegisterPsshBoxes(
@@ -32,7 +32,14 @@
 #if BUILDFLAG(ENABLE_HLS_SAMPLE_AES)
 #include <openssl/aes.h>
 #include <openssl/evp.h>
+#include "base/memory/ptr_util.h"
 #include "crypto/openssl_util.h"
+#include "media/base/cdm_callback_promise.h"
+#include "media/base/decryptor.h"
+#include "media/base/mock_filters.h"
+#include "media/cdm/aes_decryptor.h"
+#include "media/cdm/json_web_key.h"
+#include "testing/gmock/include/gmock/gmock.h"
 #endif
 
 namespace media {
@@ -148,6 +155,59 @@ std::string DecryptBuffer(const StreamParserBuffer& buffer,
   }
   return result;
 }
+
+void OnSessionCreated(std::string* session_id_out,
+                      const std::string& session_id) {
+  *session_id_out = session_id;
+}
+
+void OnPromiseRejected(CdmPromise::Exception exception_code,
+                       uint32_t system_code,
+                       const std::string& error_message) {
+  FAIL() << "Unexpectedly rejected with message: " << error_message;
+}
+
+void OnDecrypted(scoped_refptr<DecoderBuffer>* decrypted_out,
+                 Decryptor::Status status,
+                 const scoped_refptr<DecoderBuffer>& decrypted) {
+  EXPECT_EQ(Decryptor::kSuccess, status);
+  *decrypted_out = decrypted;
+}
+
+// Gives |decryptor| the test key for |key_id|, in a new session.
+void AddTestKey(AesDecryptor* decryptor, const std::string& key_id) {
+  std::string key;
+  ASSERT_TRUE(LookupTestKeyString(key_id, false, &key));
+
+  std::string session_id;
+  decryptor->CreateSessionAndGenerateRequest(
+      CdmSessionType::TEMPORARY_SESSION, EmeInitDataType::WEBM,
+      std::vector<uint8_t>(key_id.begin(), key_id.end()),
+      base::MakeUnique<CdmCallbackPromise<std::string>>(
+          base::Bind(&OnSessionCreated, &session_id),
+          base::Bind(&OnPromiseRejected)));
+  const std::string jwk_set = GenerateJWKSet(
+      reinterpret_cast<const uint8_t*>(key.data()), key.size(),
+      reinterpret_cast<const uint8_t*>(key_id.data()), key_id.size());
+  decryptor->UpdateSession(
+      session_id, std::vector<uint8_t>(jwk_set.begin(), jwk_set.end()),
+      base::MakeUnique<CdmCallbackPromise<>>(base::Bind(&base::DoNothing),
+                                             base::Bind(&OnPromiseRejected)));
+}
+
+// Decrypts |buffer| with |decryptor|, using the scheme in its DecryptConfig.
+std::string DecryptBufferWithAesDecryptor(
+    AesDecryptor* decryptor,
+    Decryptor::StreamType stream_type,
+    const scoped_refptr<StreamParserBuffer>& buffer) {
+  scoped_refptr<DecoderBuffer> decrypted;
+  decryptor->Decrypt(stream_type, buffer,
+                     base::Bind(&OnDecrypted, &decrypted));
+  if (!decrypted)
+    return std::string();
+  return std::string(reinterpret_cast<const char*>(decrypted->data()),
+                     decrypted->data_size());
+}
 #endif
 
 }  // namespace
@@ -505,6 +565,58 @@ TEST_F(Mp2tStreamParserTest, HLSSampleAES) {
   }
 }
 
+TEST_F(Mp2tStreamParserTest, HLSSampleAESBuffersCarryEncryptionScheme) {
+  InitializeParser();
+  capture_buffers = true;
+  ParseMpeg2TsFile("bear-1280x720-hls-sample-aes.ts", 2048);
+  parser_->Flush();
+  ASSERT_FALSE(video_buffer_capture_.empty());
+  ASSERT_FALSE(audio_buffer_capture_.empty());
+
+  // SAMPLE-AES encrypts H.264 slices with the 'cbcs' 1:9 pattern, and ADTS
+  // frames with unpatterned AES-CBC.
+  const EncryptionScheme video_scheme(EncryptionScheme::CIPHER_MODE_AES_CBC,
+                                      EncryptionScheme::Pattern(1, 9));
+  const EncryptionScheme audio_scheme(EncryptionScheme::CIPHER_MODE_AES_CBC,
+                                      EncryptionScheme::Pattern());
+  EXPECT_TRUE(current_video_config_.encryption_scheme().Matches(video_scheme));
+  EXPECT_TRUE(current_audio_config_.encryption_scheme().Matches(audio_scheme));
+
+  ::testing::NiceMock<MockCdmClient> cdm_client;
+  scoped_refptr<AesDecryptor> decryptor(new AesDecryptor(
+      base::Bind(&MockCdmClient::OnSessionMessage,
+                 base::Unretained(&cdm_client)),
+      base::Bind(&MockCdmClient::OnSessionClosed,
+                 base::Unretained(&cdm_client)),
+      base::Bind(&MockCdmClient::OnSessionKeysChange,
+                 base::Unretained(&cdm_client)),
+      base::Bind(&MockCdmClient::OnSessionExpirationUpdate,
+                 base::Unretained(&cdm_client))));
+  AddTestKey(decryptor.get(),
+             video_buffer_capture_.front()->decrypt_config()->key_id());
+  AddTestKey(decryptor.get(),
+             audio_buffer_capture_.front()->decrypt_config()->key_id());
+
+  // AesDecryptor, going by the scheme on each buffer alone, must match the
+  // reference SAMPLE-AES decryption.
+  for (const auto& buffer : video_buffer_capture_) {
+    ASSERT_TRUE(buffer->decrypt_config());
+    EXPECT_TRUE(
+        buffer->decrypt_config()->encryption_scheme().Matches(video_scheme));
+    EXPECT_EQ(DecryptBuffer(*buffer, video_scheme),
+              DecryptBufferWithAesDecryptor(decryptor.get(), Decryptor::kVideo,
+                                            buffer));
+  }
+  for (const auto& buffer : audio_buffer_capture_) {
+    ASSERT_TRUE(buffer->decrypt_config());
+    EXPECT_TRUE(
+        buffer->decrypt_config()->encryption_scheme().Matches(audio_scheme));
+    EXPECT_EQ(DecryptBuffer(*buffer, audio_scheme),
+              DecryptBufferWithAesDecryptor(decryptor.get(), Decryptor::kAudio,
+                                            buffer));
+  }
+}
+
 TEST_F(Mp2tStreamParserTest, PrepareForHLSSampleAES) {
   InitializeParser();
   ParseMpeg2TsFile("bear-1280x720-hls-with-CAT.bin", 2048);
@@ -0,0 +1,94 @@
+// Copyright 2017 The Chromium Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#include "media/formats/mp4/box_writer.h"
+
+#include <limits>
+
+#include "base/logging.h"
+
+namespace media {
+namespace mp4 {
+
+BoxWriter::BoxWriter(std::vector<uint8_t>* buffer) : buffer_(buffer) {
+  DCHECK(buffer_);
+}
+
+BoxWriter::~BoxWriter() {
+  DCHECK(open_boxes_.empty());
+}
+
+// Internal implementation of multi-byte writes.
+template <typename T>
+void BoxWriter::Write(T v) {
+  for (size_t i = sizeof(T); i > 0; --i)
+    buffer_->push_back(static_cast<uint8_t>(v >> (8 * (i - 1))));
+}
+
+void BoxWriter::Write1(uint8_t v) {
+  buffer_->push_back(v);
+}
+
+void BoxWriter::Write2(uint16_t v) {
+  Write(v);
+}
+
+void BoxWriter::Write2s(int16_t v) {
+  Write(static_cast<uint16_t>(v));
+}
+
+void BoxWriter::Write4(uint32_t v) {
+  Write(v);
+}
+
+void BoxWriter::Write4s(int32_t v) {
+  Write(static_cast<uint32_t>(v));
+}
+
+void BoxWriter::Write8(uint64_t v) {
+  Write(v);
+}
+
+void BoxWriter::WriteFourCC(FourCC v) {
+  Write4(static_cast<uint32_t>(v));
+}
+
+void BoxWriter::WriteBytes(const uint8_t* data, size_t size) {
+  buffer_->insert(buffer_->end(), data, data + size);
+}
+
+void BoxWriter::WriteZeros(size_t count) {
+  buffer_->resize(buffer_->size() + count, 0);
+}
+
+void BoxWriter::Rewrite4(size_t offset, uint32_t v) {
+  DCHECK_LE(offset + 4, buffer_->size());
+  for (size_t i = 0; i < 4; ++i)
+    (*buffer_)[offset + i] = static_cast<uint8_t>(v >> (8 * (3 - i)));
+}
+
+void BoxWriter::StartBox(FourCC type) {
+  open_boxes_.push_back(buffer_->size());
+  Write4(0);  // Filled in by EndBox().
+  WriteFourCC(type);
+}
+
+void BoxWriter::StartFullBox(FourCC type, uint8_t version, uint32_t flags) {
+  DCHECK_EQ(0u, flags & 0xff000000);
+  StartBox(type);
+  Write4((static_cast<uint32_t>(version) << 24) | flags);
+}
+
+void BoxWriter::EndBox() {
+  DCHECK(!open_boxes_.empty());
+  const size_t start = open_boxes_.back();
+  open_boxes_.pop_back();
+  // Boxes written here are never large enough to need a 64-bit size.
+  const size_t box_size = buffer_->size() - start;
+  CHECK_LE(box_size, std::numeric_limits<uint32_t>::max());
+  Rewrite4(start, static_cast<uint32_t>(box_size));
+}
+
+}  // namespace mp4
+}  // namespace media
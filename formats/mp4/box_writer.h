@@ -0,0 +1,69 @@
+// Copyright 2017 The Chromium Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#ifndef MEDIA_FORMATS_MP4_BOX_WRITER_H_
+#define MEDIA_FORMATS_MP4_BOX_WRITER_H_
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include <vector>
+
+#include "base/macros.h"
+#include "media/base/media_export.h"
+#include "media/formats/mp4/fourccs.h"
+
+namespace media {
+namespace mp4 {
+
+// Serializes ISO BMFF boxes, the counterpart of BoxReader. Values are appended
+// to a caller-owned buffer in big-endian order; boxes may be nested, and the
+// size of each is filled in by EndBox(). The buffer is only appended to, so a
+// caller writing many boxes can clear() and reuse it without reallocating.
+class MEDIA_EXPORT BoxWriter {
+ public:
+  explicit BoxWriter(std::vector<uint8_t>* buffer);
+  ~BoxWriter();
+
+  void Write1(uint8_t v);
+  void Write2(uint16_t v);
+  void Write2s(int16_t v);
+  void Write4(uint32_t v);
+  void Write4s(int32_t v);
+  void Write8(uint64_t v);
+  void WriteFourCC(FourCC v);
+  void WriteBytes(const uint8_t* data, size_t size);
+  void WriteZeros(size_t count);
+
+  // Overwrites the four bytes at |offset|, which must have been written
+  // already, e.g. to fill in an offset only known once later boxes are written.
+  void Rewrite4(size_t offset, uint32_t v);
+
+  // Starts a box of |type|, or a full box which additionally has a |version|
+  // and 24 bits of |flags|. Every box must be closed with EndBox(), innermost
+  // first.
+  void StartBox(FourCC type);
+  void StartFullBox(FourCC type, uint8_t version, uint32_t flags);
+  void EndBox();
+
+  // Returns the number of bytes in the buffer, i.e. the offset of the next
+  // value to be written.
+  size_t size() const { return buffer_->size(); }
+
+ private:
+  template <typename T>
+  void Write(T v);
+
+  std::vector<uint8_t>* const buffer_;
+
+  // Offsets of the boxes started but not ended yet.
+  std::vector<size_t> open_boxes_;
+
+  DISALLOW_COPY_AND_ASSIGN(BoxWriter);
+};
+
+}  // namespace mp4
+}  // namespace media
+
+#endif  // MEDIA_FORMATS_MP4_BOX_WRITER_H_
@@ -0,0 +1,118 @@
+// Copyright 2017 The Chromium Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#include "media/formats/mp4/box_writer.h"
+
+#include <stdint.h>
+
+#include <memory>
+#include <vector>
+
+#include "media/base/media_log.h"
+#include "media/formats/mp4/box_definitions.h"
+#include "media/formats/mp4/box_reader.h"
+#include "testing/gtest/include/gtest/gtest.h"
+
+namespace media {
+namespace mp4 {
+
+class BoxWriterTest : public testing::Test {
+ public:
+  BoxWriterTest() {}
+
+ protected:
+  // Reads |buffer_| back as a single top-level box.
+  std::unique_ptr<BoxReader> ReadTopLevelBox() {
+    std::unique_ptr<BoxReader> reader;
+    EXPECT_EQ(ParseResult::kOk,
+              BoxReader::ReadTopLevelBox(buffer_.data(), buffer_.size(),
+                                         &media_log_, &reader));
+    return reader;
+  }
+
+  MediaLog media_log_;
+  std::vector<uint8_t> buffer_;
+};
+
+TEST_F(BoxWriterTest, WritesBigEndianValues) {
+  BoxWriter writer(&buffer_);
+  writer.Write1(0x01);
+  writer.Write2(0x0203);
+  writer.Write2s(-2);
+  writer.Write4(0x04050607);
+  writer.Write4s(-4);
+  writer.Write8(0x08090a0b0c0d0e0fULL);
+  writer.WriteFourCC(FOURCC_MOOV);
+  writer.WriteZeros(2);
+
+  const uint8_t kExpected[] = {
+      0x01, 0x02, 0x03, 0xff, 0xfe, 0x04, 0x05, 0x06, 0x07, 0xff, 0xff, 0xff,
+      0xfc, 0x08, 0x09, 0x0a, 0x0b, 0x0c, 0x0d, 0x0e, 0x0f, 'm',  'o',  'o',
+      'v',  0x00, 0x00};
+  EXPECT_EQ(std::vector<uint8_t>(kExpected, kExpected + sizeof(kExpected)),
+            buffer_);
+  EXPECT_EQ(sizeof(kExpected), writer.size());
+
+  writer.Rewrite4(1, 0xdeadbeef);
+  EXPECT_EQ(0xde, buffer_[1]);
+  EXPECT_EQ(0xef, buffer_[4]);
+  EXPECT_EQ(0x07, buffer_[8]);
+}
+
+TEST_F(BoxWriterTest, NestedBoxes) {
+  // Something already in the buffer is left alone.
+  buffer_.push_back(0xff);
+  {
+    BoxWriter writer(&buffer_);
+    writer.StartBox(FOURCC_MOOF);
+    writer.StartFullBox(FOURCC_MFHD, 0, 0);
+    writer.Write4(7);
+    writer.EndBox();
+    writer.StartBox(FOURCC_TRAF);
+    writer.EndBox();
+    writer.EndBox();
+  }
+  ASSERT_EQ(0xff, buffer_[0]);
+  buffer_.erase(buffer_.begin());
+
+  std::unique_ptr<BoxReader> reader = ReadTopLevelBox();
+  ASSERT_TRUE(reader);
+  EXPECT_EQ(FOURCC_MOOF, reader->type());
+  EXPECT_EQ(buffer_.size(), reader->box_size());
+
+  ASSERT_TRUE(reader->ScanChildren());
+  MovieFragmentHeader mfhd;
+  ASSERT_TRUE(reader->ReadChild(&mfhd));
+  EXPECT_EQ(7u, mfhd.sequence_number);
+}
+
+TEST_F(BoxWriterTest, TrackFragmentRunRoundTrip) {
+  BoxWriter writer(&buffer_);
+  // Data offset, sample durations, sizes and flags present.
+  writer.StartFullBox(FOURCC_TRUN, 0, 0x1 | 0x100 | 0x200 | 0x400);
+  writer.Write4(2);  // sample_count
+  const size_t data_offset_position = writer.size();
+  writer.Write4(0);
+  for (uint32_t i = 0; i < 2; ++i) {
+    writer.Write4(1000);             // duration
+    writer.Write4(100 + i);          // size
+    writer.Write4(i ? 0x10000 : 0);  // flags
+  }
+  writer.EndBox();
+  writer.Rewrite4(data_offset_position, writer.size() + 8);
+
+  std::unique_ptr<BoxReader> reader(BoxReader::ReadConcatentatedBoxes(
+      buffer_.data(), buffer_.size(), &media_log_));
+  ASSERT_TRUE(reader->ScanChildren());
+  TrackFragmentRun trun;
+  ASSERT_TRUE(reader->ReadChild(&trun));
+  EXPECT_EQ(2u, trun.sample_count);
+  EXPECT_EQ(buffer_.size() + 8, trun.data_offset);
+  EXPECT_EQ(std::vector<uint32_t>({1000, 1000}), trun.sample_durations);
+  EXPECT_EQ(std::vector<uint32_t>({100, 101}), trun.sample_sizes);
+  EXPECT_EQ(std::vector<uint32_t>({0, 0x10000}), trun.sample_flags);
+}
+
+}  // namespace mp4
+}  // namespace media
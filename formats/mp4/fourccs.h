@@ -28,6 +28,7 @@ enum FourCC {
   FOURCC_CTTS = 0x63747473,
   FOURCC_DFLA = 0x64664c61,  // "dfLa"
   FOURCC_DINF = 0x64696e66,
+  FOURCC_DREF = 0x64726566,
 #if BUILDFLAG(ENABLE_DOLBY_VISION_DEMUXING)
   FOURCC_DVA1 = 0x64766131,
   FOURCC_DVAV = 0x64766176,
@@ -55,6 +56,8 @@ enum FourCC {
   FOURCC_HVCC = 0x68766343,
 #endif
   FOURCC_IODS = 0x696f6473,
+  FOURCC_ISO6 = 0x69736f36,
+  FOURCC_ISOM = 0x69736f6d,
   FOURCC_MDAT = 0x6d646174,
   FOURCC_MDHD = 0x6d646864,
   FOURCC_MDIA = 0x6d646961,
@@ -66,6 +69,7 @@ enum FourCC {
   FOURCC_MINF = 0x6d696e66,
   FOURCC_MOOF = 0x6d6f6f66,
   FOURCC_MOOV = 0x6d6f6f76,
+  FOURCC_MP41 = 0x6d703431,
   FOURCC_MP4A = 0x6d703461,
   FOURCC_MP4V = 0x6d703476,
   FOURCC_MVEX = 0x6d766578,
@@ -109,6 +113,7 @@ enum FourCC {
   FOURCC_TREX = 0x74726578,
   FOURCC_TRUN = 0x7472756e,
   FOURCC_UDTA = 0x75647461,
+  FOURCC_URL = 0x75726c20,  // "url "
   FOURCC_UUID = 0x75756964,
   FOURCC_VIDE = 0x76696465,
   FOURCC_VMHD = 0x766d6864,
@@ -741,10 +741,17 @@ ParseResult MP4StreamParser::EnqueueSample(BufferQueueMap* buffers) {
   }
 
   if (decrypt_config) {
-    if (!subsamples.empty()) {
-      // Create a new config with the updated subsamples.
+    const EncryptionScheme scheme =
+        GetEncryptionScheme(audio ? runs_->audio_description().sinf
+                                  : runs_->video_description().sinf);
+    if (!subsamples.empty() ||
+        !scheme.Matches(decrypt_config->encryption_scheme())) {
+      // Create a new config with the updated subsamples and the track's
+      // encryption scheme, which is needed to decrypt pattern encrypted
+      // samples.
       decrypt_config.reset(new DecryptConfig(decrypt_config->key_id(),
-                                             decrypt_config->iv(), subsamples));
+                                             decrypt_config->iv(), subsamples,
+                                             scheme));
     }
     // else, use the existing config.
   } else if (is_track_encrypted_[runs_->track_id()]) {
@@ -0,0 +1,105 @@
+// Copyright 2017 The Chromium Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#include "media/midi/fake_midi_manager.h"
+
+#include "base/logging.h"
+#include "base/run_loop.h"
+#include "testing/gtest/include/gtest/gtest.h"
+
+namespace midi {
+
+using mojom::PortState;
+using mojom::Result;
+
+FakeMidiManager::FakeMidiManager(MidiService* service)
+    : MidiManager(service),
+      start_initialization_is_called_(false),
+      finalize_is_called_(false) {}
+
+FakeMidiManager::~FakeMidiManager() {}
+
+void FakeMidiManager::StartInitialization() {
+  start_initialization_is_called_ = true;
+}
+
+void FakeMidiManager::Finalize() {
+  finalize_is_called_ = true;
+}
+
+void FakeMidiManager::DispatchSendMidiData(MidiManagerClient* client,
+                                           uint32_t port_index,
+                                           const std::vector<uint8_t>& data,
+                                           double timestamp) {}
+
+void FakeMidiManager::CallCompleteInitialization(Result result) {
+  CompleteInitialization(result);
+}
+
+size_t FakeMidiManager::GetClientCount() const {
+  return clients_size_for_testing();
+}
+
+size_t FakeMidiManager::GetPendingClientCount() const {
+  return pending_clients_size_for_testing();
+}
+
+FakeMidiManagerFactory::FakeMidiManagerFactory() = default;
+
+FakeMidiManagerFactory::~FakeMidiManagerFactory() = default;
+
+std::unique_ptr<MidiManager> FakeMidiManagerFactory::Create(
+    MidiService* service) {
+  std::unique_ptr<FakeMidiManager> manager =
+      std::make_unique<FakeMidiManager>(service);
+  manager_ = manager.get();
+  return manager;
+}
+
+FakeMidiManager* FakeMidiManagerFactory::GetCreatedManager() {
+  DCHECK(manager_);
+  return manager_;
+}
+
+FakeMidiManagerClient::FakeMidiManagerClient()
+    : result_(Result::NOT_SUPPORTED), wait_for_result_(true), bytes_sent_(0) {}
+
+FakeMidiManagerClient::~FakeMidiManagerClient() {}
+
+void FakeMidiManagerClient::AddInputPort(const MidiPortInfo& info) {}
+
+void FakeMidiManagerClient::AddOutputPort(const MidiPortInfo& info) {}
+
+void FakeMidiManagerClient::SetInputPortState(uint32_t port_index,
+                                              PortState state) {}
+
+void FakeMidiManagerClient::SetOutputPortState(uint32_t port_index,
+                                               PortState state) {}
+
+void FakeMidiManagerClient::CompleteStartSession(Result result) {
+  EXPECT_TRUE(wait_for_result_);
+  result_ = result;
+  wait_for_result_ = false;
+}
+
+void FakeMidiManagerClient::ReceiveMidiData(uint32_t port_index,
+                                            const uint8_t* data,
+                                            size_t size,
+                                            double timestamp) {}
+
+void FakeMidiManagerClient::AccumulateMidiBytesSent(size_t size) {
+  bytes_sent_ += size;
+}
+
+void FakeMidiManagerClient::Detach() {}
+
+Result FakeMidiManagerClient::WaitForResult() {
+  while (wait_for_result_) {
+    base::RunLoop run_loop;
+    run_loop.RunUntilIdle();
+  }
+  return result();
+}
+
+}  // namespace midi
@@ -0,0 +1,104 @@
+// Copyright 2017 The Chromium Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#ifndef MEDIA_MIDI_FAKE_MIDI_MANAGER_H_
+#define MEDIA_MIDI_FAKE_MIDI_MANAGER_H_
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include <memory>
+#include <vector>
+
+#include "base/macros.h"
+#include "media/midi/midi_manager.h"
+#include "media/midi/midi_service.h"
+
+namespace midi {
+
+// A MidiManager without a backend. Initialization only completes when the test
+// calls CallCompleteInitialization(), and sent data is dropped.
+class FakeMidiManager : public MidiManager {
+ public:
+  explicit FakeMidiManager(MidiService* service);
+  ~FakeMidiManager() override;
+
+  // MidiManager implementation.
+  void StartInitialization() override;
+  void Finalize() override;
+  void DispatchSendMidiData(MidiManagerClient* client,
+                            uint32_t port_index,
+                            const std::vector<uint8_t>& data,
+                            double timestamp) override;
+
+  // Utility functions for testing.
+  void CallCompleteInitialization(mojom::Result result);
+  size_t GetClientCount() const;
+  size_t GetPendingClientCount() const;
+
+  bool start_initialization_is_called_;
+  bool finalize_is_called_;
+
+ private:
+  DISALLOW_COPY_AND_ASSIGN(FakeMidiManager);
+};
+
+// Creates a FakeMidiManager for the MidiService it is given to.
+class FakeMidiManagerFactory : public MidiService::ManagerFactory {
+ public:
+  FakeMidiManagerFactory();
+  ~FakeMidiManagerFactory() override;
+
+  // MidiService::ManagerFactory implementation.
+  std::unique_ptr<MidiManager> Create(MidiService* service) override;
+
+  // Returns the manager created last. It is owned by the MidiService, and
+  // valid until the MidiService is shut down or destructed.
+  FakeMidiManager* GetCreatedManager();
+
+ private:
+  FakeMidiManager* manager_ = nullptr;
+
+  DISALLOW_COPY_AND_ASSIGN(FakeMidiManagerFactory);
+};
+
+// A MidiManagerClient that records the result of its session and the number
+// of bytes acknowledged as sent.
+class FakeMidiManagerClient : public MidiManagerClient {
+ public:
+  FakeMidiManagerClient();
+  ~FakeMidiManagerClient() override;
+
+  // MidiManagerClient implementation.
+  void AddInputPort(const MidiPortInfo& info) override;
+  void AddOutputPort(const MidiPortInfo& info) override;
+  void SetInputPortState(uint32_t port_index, mojom::PortState state) override;
+  void SetOutputPortState(uint32_t port_index,
+                          mojom::PortState state) override;
+  void CompleteStartSession(mojom::Result result) override;
+  void ReceiveMidiData(uint32_t port_index,
+                       const uint8_t* data,
+                       size_t size,
+                       double timestamp) override;
+  void AccumulateMidiBytesSent(size_t size) override;
+  void Detach() override;
+
+  mojom::Result result() const { return result_; }
+  size_t bytes_sent() const { return bytes_sent_; }
+
+  // Runs the current message loop until CompleteStartSession() is called, and
+  // returns its result.
+  mojom::Result WaitForResult();
+
+ private:
+  mojom::Result result_;
+  bool wait_for_result_;
+  size_t bytes_sent_;
+
+  DISALLOW_COPY_AND_ASSIGN(FakeMidiManagerClient);
+};
+
+}  // namespace midi
+
+#endif  // MEDIA_MIDI_FAKE_MIDI_MANAGER_H_
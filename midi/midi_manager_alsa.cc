@@ -173,6 +173,7 @@ MidiManagerAlsa::~MidiManagerAlsa() {
   CHECK(!decoder_);
   CHECK(!udev_);
   CHECK(!udev_monitor_);
+  CHECK(!scheduler_);
 }
 
 void MidiManagerAlsa::StartInitialization() {
@@ -278,6 +279,9 @@ void MidiManagerAlsa::StartInitialization() {
   decoder_.reset(decoder.release());
   udev_.reset(udev.release());
   udev_monitor_.reset(udev_monitor.release());
+  scheduler_ = base::MakeUnique<MidiScheduler>(
+      this, base::BindRepeating(&MidiManagerAlsa::PostSendMidiData,
+                                base::Unretained(this)));
 
   // Generate hotplug events for existing ports.
   // TODO(agoode): Check the return value for failure.
@@ -311,6 +315,7 @@ void MidiManagerAlsa::Finalize() {
 
   // Destruct the other stuff we initialized in StartInitialization().
   base::AutoLock lock(lazy_init_member_lock_);
+  scheduler_.reset();
   udev_monitor_.reset();
   udev_.reset();
   decoder_.reset();
@@ -321,11 +326,9 @@ void MidiManagerAlsa::DispatchSendMidiData(MidiManagerClient* client,
                                            uint32_t port_index,
                                            const std::vector<uint8_t>& data,
                                            double timestamp) {
-  service()->task_service()->PostBoundDelayedTask(
-      kSendTaskRunner,
-      base::BindOnce(&MidiManagerAlsa::SendMidiData, base::Unretained(this),
-                     client, port_index, data),
-      MidiService::TimestampToTimeDeltaDelay(timestamp));
+  base::AutoLock lock(lazy_init_member_lock_);
+  if (scheduler_)
+    scheduler_->PostSendData(client, port_index, data, timestamp);
 }
 
 MidiManagerAlsa::MidiPort::Id::Id() = default;
@@ -842,31 +845,60 @@ std::string MidiManagerAlsa::AlsaCard::ExtractManufacturerString(
   return "";
 }
 
-void MidiManagerAlsa::SendMidiData(MidiManagerClient* client,
-                                   uint32_t port_index,
-                                   const std::vector<uint8_t>& data) {
+void MidiManagerAlsa::PostSendMidiData(
+    uint32_t port_index,
+    const std::vector<uint8_t>& data,
+    const MidiScheduler::ClientBytes& bytes_sent) {
+  service()->task_service()->PostBoundTask(
+      kSendTaskRunner,
+      base::BindOnce(&MidiManagerAlsa::SendMidiData, base::Unretained(this),
+                     port_index, data, bytes_sent));
+}
+
+void MidiManagerAlsa::SendMidiData(
+    uint32_t port_index,
+    const std::vector<uint8_t>& data,
+    const MidiScheduler::ClientBytes& bytes_sent) {
   ScopedSndMidiEventPtr encoder = CreateScopedSndMidiEventPtr(kSendBufferSize);
-  for (const auto datum : data) {
-    snd_seq_event_t event;
-    int result = snd_midi_event_encode_byte(encoder.get(), datum, &event);
-    if (result == 1) {
-      // Full event, send it.
-      base::AutoLock lock(out_ports_lock_);
-      auto it = out_ports_.find(port_index);
-      if (it != out_ports_.end()) {
-        base::AutoLock lock(out_client_lock_);
-        if (!out_client_)
-          return;
-        snd_seq_ev_set_source(&event, it->second);
-        snd_seq_ev_set_subs(&event);
-        snd_seq_ev_set_direct(&event);
-        snd_seq_event_output_direct(out_client_.get(), &event);
+
+  {
+    base::AutoLock ports_lock(out_ports_lock_);
+    auto it = out_ports_.find(port_index);
+    if (it != out_ports_.end()) {
+      base::AutoLock client_lock(out_client_lock_);
+      if (!out_client_)
+        return;
+
+      // Queue every full event in the output buffer, which is flushed whenever
+      // it fills up, and write out what remains at the end, rather than making
+      // a write call per event.
+      bool has_output = false;
+      for (const auto datum : data) {
+        snd_seq_event_t event;
+        int result = snd_midi_event_encode_byte(encoder.get(), datum, &event);
+        if (result == 1) {
+          snd_seq_ev_set_source(&event, it->second);
+          snd_seq_ev_set_subs(&event);
+          snd_seq_ev_set_direct(&event);
+          int err = snd_seq_event_output(out_client_.get(), &event);
+          if (err < 0) {
+            VLOG(1) << "snd_seq_event_output fails: " << snd_strerror(err);
+            break;
+          }
+          has_output = true;
+        }
+      }
+      if (has_output) {
+        int err = snd_seq_drain_output(out_client_.get());
+        if (err < 0)
+          VLOG(1) << "snd_seq_drain_output fails: " << snd_strerror(err);
       }
     }
   }
 
   // Acknowledge send.
-  AccumulateMidiBytesSent(client, data.size());
+  for (const auto& client_bytes : bytes_sent)
+    AccumulateMidiBytesSent(client_bytes.first, client_bytes.second);
 }
 
 void MidiManagerAlsa::EventLoop() {
@@ -22,6 +22,7 @@
 #include "device/udev_linux/scoped_udev.h"
 #include "media/midi/midi_export.h"
 #include "media/midi/midi_manager.h"
+#include "media/midi/midi_scheduler.h"
 
 namespace midi {
 
@@ -368,10 +369,18 @@ class MIDI_EXPORT MidiManagerAlsa final : public MidiManager {
   using ScopedSndMidiEventPtr =
       std::unique_ptr<snd_midi_event_t, SndMidiEventDeleter>;
 
-  // An internal callback that runs on MidiSendThread.
-  void SendMidiData(MidiManagerClient* client,
-                    uint32_t port_index,
-                    const std::vector<uint8_t>& data);
+  // Called by |scheduler_| with the messages due for |port_index|, which are
+  // handed over to SendMidiData() in a single task.
+  void PostSendMidiData(uint32_t port_index,
+                        const std::vector<uint8_t>& data,
+                        const MidiScheduler::ClientBytes& bytes_sent);
+
+  // An internal callback that runs on MidiSendThread. Writes all events
+  // encoded from |data| to the output buffer, drains it once, and then
+  // acknowledges |bytes_sent| to their clients.
+  void SendMidiData(uint32_t port_index,
+                    const std::vector<uint8_t>& data,
+                    const MidiScheduler::ClientBytes& bytes_sent);
 
   void EventLoop();
   void ProcessSingleEvent(snd_seq_event_t* event, double timestamp);
@@ -440,6 +449,9 @@ class MIDI_EXPORT MidiManagerAlsa final : public MidiManager {
   device::ScopedUdevPtr udev_;
   device::ScopedUdevMonitorPtr udev_monitor_;
 
+  // Batches outgoing messages per port by their timestamps.
+  std::unique_ptr<MidiScheduler> scheduler_;
+
   DISALLOW_COPY_AND_ASSIGN(MidiManagerAlsa);
 };
 
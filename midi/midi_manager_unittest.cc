@@ -10,13 +10,12 @@
 #include <memory>
 #include <vector>
 
-#include "base/bind.h"
-#include "base/logging.h"
 #include "base/macros.h"
 #include "base/message_loop/message_loop.h"
 #include "base/run_loop.h"
 #include "base/system_monitor/system_monitor.h"
 #include "build/build_config.h"
+#include "media/midi/fake_midi_manager.h"
 #include "media/midi/midi_service.h"
 #include "testing/gtest/include/gtest/gtest.h"
 
@@ -24,114 +23,8 @@ namespace midi {
 
 namespace {
 
-using mojom::PortState;
 using mojom::Result;
 
-class FakeMidiManager : public MidiManager {
- public:
-  explicit FakeMidiManager(MidiService* service)
-      : MidiManager(service),
-        start_initialization_is_called_(false),
-        finalize_is_called_(false) {}
-  ~FakeMidiManager() override {}
-
-  // MidiManager implementation.
-  void StartInitialization() override {
-    start_initialization_is_called_ = true;
-  }
-
-  void Finalize() override { finalize_is_called_ = true; }
-
-  void DispatchSendMidiData(MidiManagerClient* client,
-                            uint32_t port_index,
-                            const std::vector<uint8_t>& data,
-                            double timestamp) override {}
-
-  // Utility functions for testing.
-  void CallCompleteInitialization(Result result) {
-    CompleteInitialization(result);
-  }
-
-  size_t GetClientCount() const {
-    return clients_size_for_testing();
-  }
-
-  size_t GetPendingClientCount() const {
-    return pending_clients_size_for_testing();
-  }
-
-  bool start_initialization_is_called_;
-  bool finalize_is_called_;
-
- private:
-  DISALLOW_COPY_AND_ASSIGN(FakeMidiManager);
-};
-
-class FakeMidiManagerFactory : public MidiService::ManagerFactory {
- public:
-  FakeMidiManagerFactory() = default;
-  ~FakeMidiManagerFactory() override = default;
-  std::unique_ptr<MidiManager> Create(MidiService* service) override {
-    std::unique_ptr<FakeMidiManager> manager =
-        std::make_unique<FakeMidiManager>(service);
-    // |manaegr| will be owned by the caller MidiService instance, and valid
-    // while the MidiService instance is running.
-    // MidiService::Shutdown() or destructor will destruct it, and |manager_|
-    // get to be invalid after that.
-    manager_ = manager.get();
-    return manager;
-  }
-  FakeMidiManager* GetCreatedManager() {
-    DCHECK(manager_);
-    return manager_;
-  }
-
- private:
-  FakeMidiManager* manager_ = nullptr;
-};
-
-class FakeMidiManagerClient : public MidiManagerClient {
- public:
-  FakeMidiManagerClient()
-      : result_(Result::NOT_SUPPORTED), wait_for_result_(true) {}
-  ~FakeMidiManagerClient() override {}
-
-  // MidiManagerClient implementation.
-  void AddInputPort(const MidiPortInfo& info) override {}
-  void AddOutputPort(const MidiPortInfo& info) override {}
-  void SetInputPortState(uint32_t port_index, PortState state) override {}
-  void SetOutputPortState(uint32_t port_index, PortState state) override {}
-
-  void CompleteStartSession(Result result) override {
-    EXPECT_TRUE(wait_for_result_);
-    result_ = result;
-    wait_for_result_ = false;
-  }
-
-  void ReceiveMidiData(uint32_t port_index,
-                       const uint8_t* data,
-                       size_t size,
-                       double timestamp) override {}
-  void AccumulateMidiBytesSent(size_t size) override {}
-  void Detach() override {}
-
-  Result result() const { return result_; }
-
-  Result WaitForResult() {
-    while (wait_for_result_) {
-      base::RunLoop run_loop;
-      run_loop.RunUntilIdle();
-    }
-    return result();
-  }
-
- private:
-  Result result_;
-  bool wait_for_result_;
-
-  DISALLOW_COPY_AND_ASSIGN(FakeMidiManagerClient);
-};
-
 class MidiManagerTest : public ::testing::Test {
  public:
   MidiManagerTest() : message_loop_(std::make_unique<base::MessageLoop>()) {
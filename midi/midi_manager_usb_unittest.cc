@@ -553,10 +553,7 @@ TEST_F(MidiManagerUsbTest, Receive) {
   EXPECT_EQ(
       "UsbMidiDevice::GetDescriptors\n"
       "MidiManagerClient::ReceiveMidiData usb:port_index = 0 "
-      "data = 0x90 0x45 0x7f\n"
-      "MidiManagerClient::ReceiveMidiData usb:port_index = 0 "
-      "data = 0xf0 0x00 0x01\n"
-      "MidiManagerClient::ReceiveMidiData usb:port_index = 0 data = 0xf7\n",
+      "data = 0x90 0x45 0x7f 0xf0 0x00 0x01 0xf7\n",
       logger_.TakeLog());
 }
 
@@ -11,22 +11,63 @@
 
 namespace midi {
 
+namespace {
+
+// Returns the length of the complete MIDI message at the beginning of |data|
+// if it has no bytes that need to be dropped or reordered, or 0 otherwise.
+size_t GetIntactMessageLength(const uint8_t* data, size_t size) {
+  DCHECK_GT(size, 0u);
+  const uint8_t status_byte = data[0];
+  if (status_byte == kSysExByte) {
+    for (size_t i = 1; i < size; ++i) {
+      if (data[i] == kEndOfSysExByte)
+        return i + 1;
+      if (!IsDataByte(data[i]))
+        return 0;
+    }
+    return 0;
+  }
+  const size_t target_len = GetMessageLength(status_byte);
+  if (target_len == 0 || target_len > size)
+    return 0;
+  for (size_t i = 1; i < target_len; ++i) {
+    if (!IsDataByte(data[i]))
+      return 0;
+  }
+  return target_len;
+}
+
+}  // namespace
+
 MidiMessageQueue::MidiMessageQueue(bool allow_running_status)
-    : allow_running_status_(allow_running_status) {}
+    : read_position_(0), allow_running_status_(allow_running_status) {}
 
 MidiMessageQueue::~MidiMessageQueue() {}
 
 void MidiMessageQueue::Add(const std::vector<uint8_t>& data) {
-  queue_.insert(queue_.end(), data.begin(), data.end());
+  Add(data.data(), data.size());
 }
 
 void MidiMessageQueue::Add(const uint8_t* data, size_t length) {
-  queue_.insert(queue_.end(), data, data + length);
+  // Drop the consumed bytes once they outweigh the unparsed ones, so that
+  // compaction costs amortized O(1) per byte and |buffer_| stops growing.
+  if (read_position_ > 0 && read_position_ >= buffer_.size() - read_position_) {
+    buffer_.erase(buffer_.begin(), buffer_.begin() + read_position_);
+    read_position_ = 0;
+  }
+  buffer_.insert(buffer_.end(), data, data + length);
 }
 
 void MidiMessageQueue::Get(std::vector<uint8_t>* message) {
-  message->clear();
+  const uint8_t* data;
+  size_t length;
+  if (GetNext(&data, &length))
+    message->assign(data, data + length);
+  else
+    message->clear();
+}
 
+bool MidiMessageQueue::GetNext(const uint8_t** message, size_t* length) {
   while (true) {
     // Check if |next_message_| is already a complete MIDI message or not.
     if (!next_message_.empty()) {
@@ -36,14 +77,16 @@ void MidiMessageQueue::Get(std::vector<uint8_t>* message) {
         DCHECK_EQ(kSysExByte, status_byte);
         if (next_message_.back() == kEndOfSysExByte) {
           // OK, this is a complete SysEx message.
-          std::swap(*message, next_message_);
-          DCHECK(next_message_.empty());
-          return;
+          std::swap(message_, next_message_);
+          next_message_.clear();
+          *message = message_.data();
+          *length = message_.size();
+          return true;
         }
       } else if (next_message_.size() == target_len) {
         // OK, this is a complete non-SysEx message.
-        std::swap(*message, next_message_);
-        DCHECK(next_message_.empty());
+        std::swap(message_, next_message_);
+        next_message_.clear();
         if (allow_running_status_ && !IsSystemMessage(status_byte)) {
           // Speculatively keep the status byte in case of running status.
           // If this assumption is not true, |next_message_| will be cleared
@@ -51,27 +94,42 @@ void MidiMessageQueue::Get(std::vector<uint8_t>* message) {
           // running status.
           next_message_.push_back(status_byte);
         }
-        return;
+        *message = message_.data();
+        *length = message_.size();
+        return true;
       } else if (next_message_.size() > target_len) {
         NOTREACHED();
       }
     }
 
-    if (queue_.empty())
-      return;
+    if (read_position_ == buffer_.size())
+      return false;
 
     // "System Real Time Messages" is a special MIDI message, which can appear
     // at an arbitrary byte position of MIDI stream. Here we reorder
     // "System Real Time Messages" prior to |next_message_| so that each message
     // can be clearly separated as a complete MIDI message.
-    const uint8_t next = queue_.front();
+    const uint8_t next = buffer_[read_position_];
     if (IsSystemRealTimeMessage(next)) {
-      message->push_back(next);
-      queue_.pop_front();
-      return;
+      *message = &buffer_[read_position_];
+      *length = 1;
+      ++read_position_;
+      return true;
     }
 
     if (next_message_.empty()) {
+      // Fast path: a message that arrived intact is returned in place.
+      const size_t intact_len = GetIntactMessageLength(
+          &buffer_[read_position_], buffer_.size() - read_position_);
+      if (intact_len > 0) {
+        *message = &buffer_[read_position_];
+        *length = intact_len;
+        read_position_ += intact_len;
+        if (allow_running_status_ && !IsSystemMessage(next))
+          next_message_.push_back(next);
+        return true;
+      }
+
       const size_t target_len = GetMessageLength(next);
       // If |target_len| is zero, it means either |next| is not a valid status
       // byte or |next| is a valid status byte but the message length is
@@ -83,7 +141,7 @@ void MidiMessageQueue::Get(std::vector<uint8_t>* message) {
       // that |next| is just corrupted data, or a data byte followed by
       // reserved message, which we are unable to understand and deal with
       // anyway.
-      queue_.pop_front();
+      ++read_position_;
       continue;
     }
 
@@ -99,9 +157,22 @@ void MidiMessageQueue::Get(std::vector<uint8_t>* message) {
       continue;
     }
 
-    // OK to consume this byte.
-    next_message_.push_back(next);
-    queue_.pop_front();
+    // OK to consume this byte, together with the data bytes right after it
+    // that still belong to the pending message.
+    size_t end = read_position_ + 1;
+    if (IsDataByte(next)) {
+      const size_t target_len = GetMessageLength(status_byte);
+      const size_t limit =
+          target_len == 0
+              ? buffer_.size()
+              : std::min(buffer_.size(),
+                         read_position_ + target_len - next_message_.size());
+      while (end < limit && IsDataByte(buffer_[end]))
+        ++end;
+    }
+    next_message_.insert(next_message_.end(), buffer_.begin() + read_position_,
+                         buffer_.begin() + end);
+    read_position_ = end;
   }
 }
 
@@ -10,7 +10,6 @@
 
 #include <vector>
 
-#include "base/containers/circular_deque.h"
 #include "base/macros.h"
 #include "media/midi/midi_export.h"
 
@@ -41,6 +40,12 @@ namespace midi {
 //         dispatch(next_message);
 //     }
 //   }
+//
+// GetNext() is an allocation-free alternative to Get() for high-rate input:
+//   const uint8_t* message;
+//   size_t length;
+//   while (queue.GetNext(&message, &length))
+//     dispatch(message, length);
 class MIDI_EXPORT MidiMessageQueue {
  public:
   // Initializes the queue. Set true to |allow_running_status| to enable
@@ -63,9 +68,23 @@ class MIDI_EXPORT MidiMessageQueue {
   // |message| is empty if there is no complete MIDI message any more.
   void Get(std::vector<uint8_t>* message);
 
+  // Same as Get(), but points |message| at the next complete MIDI message
+  // instead of copying it out. Messages that arrived intact are returned
+  // straight from the internal buffer, and reassembled ones from a buffer that
+  // is reused, so no memory is allocated once the buffers have grown to the
+  // size of the stream's bursts. Returns false if there is no complete MIDI
+  // message any more. |*message| stays valid until the next call to Add(),
+  // Get() or GetNext().
+  bool GetNext(const uint8_t** message, size_t* length);
+
  private:
-  base::circular_deque<uint8_t> queue_;
+  // Bytes added but not parsed yet are |buffer_[read_position_:]|. Consumed
+  // bytes are discarded lazily by Add() so that the storage is reused.
+  std::vector<uint8_t> buffer_;
+  size_t read_position_;
+  // The message being reassembled, and the last one returned from it.
   std::vector<uint8_t> next_message_;
+  std::vector<uint8_t> message_;
   const bool allow_running_status_;
   DISALLOW_COPY_AND_ASSIGN(MidiMessageQueue);
 };
@@ -0,0 +1,151 @@
+// Copyright 2017 The Chromium Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include <algorithm>
+#include <string>
+#include <vector>
+
+#include "base/macros.h"
+#include "base/time/time.h"
+#include "media/midi/midi_message_queue.h"
+#include "testing/gtest/include/gtest/gtest.h"
+#include "testing/perf/perf_test.h"
+
+namespace midi {
+
+namespace {
+
+// Each stream is fed to the queue in chunks the size of a full-speed USB bulk
+// transfer, |kNumIterations| times over.
+const size_t kChunkSize = 64;
+const int kNumIterations = 200;
+const size_t kStreamSize = 64 * 1024;
+
+// MPE controller output: note on, pitch bend and channel pressure on rotating
+// member channels, with a timing clock every few messages.
+std::vector<uint8_t> CreateMpeStream() {
+  std::vector<uint8_t> stream;
+  for (int i = 0; stream.size() < kStreamSize; ++i) {
+    const uint8_t channel = 1 + i % 15;
+    const uint8_t value = i % 128;
+    const uint8_t messages[] = {
+        static_cast<uint8_t>(0x90 | channel), value, 0x7f,
+        static_cast<uint8_t>(0xe0 | channel), value, 0x40,
+        static_cast<uint8_t>(0xd0 | channel), value,
+    };
+    stream.insert(stream.end(), messages, messages + arraysize(messages));
+    if (i % 4 == 0)
+      stream.push_back(0xf8);
+  }
+  return stream;
+}
+
+// Control changes on one channel, using running status.
+std::vector<uint8_t> CreateRunningStatusStream() {
+  std::vector<uint8_t> stream = {0xb0};
+  for (int i = 0; stream.size() < kStreamSize; ++i) {
+    stream.push_back(i % 120);
+    stream.push_back(i % 128);
+  }
+  return stream;
+}
+
+// A patch dump of 1 KiB SysEx messages, optionally interleaved with timing
+// clocks that have to be reordered out of them.
+std::vector<uint8_t> CreateSysExStream(bool with_timing_clock) {
+  std::vector<uint8_t> stream;
+  while (stream.size() < kStreamSize) {
+    stream.push_back(0xf0);
+    for (int i = 0; i < 1022; ++i) {
+      if (with_timing_clock && i % 256 == 0)
+        stream.push_back(0xf8);
+      stream.push_back(i % 128);
+    }
+    stream.push_back(0xf7);
+  }
+  return stream;
+}
+
+class MidiMessageQueuePerfTest : public ::testing::Test {
+ public:
+  MidiMessageQueuePerfTest() {}
+
+  // Splits |stream| into messages |kNumIterations| times and reports the
+  // throughput. |use_get_next| selects GetNext() over Get().
+  void RunBenchmark(const std::string& trace,
+                    const std::vector<uint8_t>& stream,
+                    bool allow_running_status,
+                    bool use_get_next) {
+    MidiMessageQueue queue(allow_running_status);
+    std::vector<uint8_t> message;
+    size_t messages = 0;
+    size_t bytes = 0;
+
+    const base::TimeTicks start = base::TimeTicks::Now();
+    for (int i = 0; i < kNumIterations; ++i) {
+      for (size_t offset = 0; offset < stream.size(); offset += kChunkSize) {
+        queue.Add(&stream[offset],
+                  std::min(kChunkSize, stream.size() - offset));
+        if (use_get_next) {
+          const uint8_t* data;
+          size_t length;
+          while (queue.GetNext(&data, &length)) {
+            ++messages;
+            bytes += length;
+          }
+        } else {
+          while (true) {
+            queue.Get(&message);
+            if (message.empty())
+              break;
+            ++messages;
+            bytes += message.size();
+          }
+        }
+      }
+    }
+    const base::TimeDelta elapsed = base::TimeTicks::Now() - start;
+
+    ASSERT_GT(messages, 0u);
+    perf_test::PrintResult("midi_message_queue", trace, "throughput",
+                           bytes / elapsed.InSecondsF() / 1e6, "MB/s", true);
+    perf_test::PrintResult("midi_message_queue", trace, "messages",
+                           messages / elapsed.InSecondsF(), "messages/s",
+                           true);
+  }
+
+ private:
+  DISALLOW_COPY_AND_ASSIGN(MidiMessageQueuePerfTest);
+};
+
+}  // namespace
+
+TEST_F(MidiMessageQueuePerfTest, Mpe) {
+  const std::vector<uint8_t> stream = CreateMpeStream();
+  RunBenchmark("_mpe_get", stream, true, false);
+  RunBenchmark("_mpe_get_next", stream, true, true);
+}
+
+TEST_F(MidiMessageQueuePerfTest, RunningStatus) {
+  const std::vector<uint8_t> stream = CreateRunningStatusStream();
+  RunBenchmark("_running_status_get", stream, true, false);
+  RunBenchmark("_running_status_get_next", stream, true, true);
+}
+
+TEST_F(MidiMessageQueuePerfTest, SysEx) {
+  const std::vector<uint8_t> stream = CreateSysExStream(false);
+  RunBenchmark("_sysex_get", stream, false, false);
+  RunBenchmark("_sysex_get_next", stream, false, true);
+}
+
+TEST_F(MidiMessageQueuePerfTest, SysExWithTimingClock) {
+  const std::vector<uint8_t> stream = CreateSysExStream(true);
+  RunBenchmark("_sysex_with_clock_get", stream, false, false);
+  RunBenchmark("_sysex_with_clock_get_next", stream, false, true);
+}
+
+}  // namespace midi
@@ -568,5 +568,52 @@ TEST(MidiMessageQueueTest, ReservedMessageInjectedInSysExMessage) {
   EXPECT_TRUE(message.empty());
 }
 
+TEST(MidiMessageQueueTest, GetNext) {
+  MidiMessageQueue queue(true);
+  const uint8_t* message;
+  size_t length;
+
+  EXPECT_FALSE(queue.GetNext(&message, &length));
+
+  Add(&queue, kGMOn);
+  Add(&queue, kPartialNoteOn1st);
+  Add(&queue, kTimingClock);
+  Add(&queue, kPartialNoteOn2nd);
+  Add(&queue, kPartialNoteOn3rd);
+  Add(&queue, kNoteOnWithRunningStatus);
+
+  ASSERT_TRUE(queue.GetNext(&message, &length));
+  EXPECT_MESSAGE(kGMOn, std::vector<uint8_t>(message, message + length));
+  ASSERT_TRUE(queue.GetNext(&message, &length));
+  EXPECT_MESSAGE(kTimingClock,
+                 std::vector<uint8_t>(message, message + length));
+  for (size_t i = 0; i < 4; ++i) {
+    ASSERT_TRUE(queue.GetNext(&message, &length));
+    EXPECT_MESSAGE(kNoteOn, std::vector<uint8_t>(message, message + length));
+  }
+  EXPECT_FALSE(queue.GetNext(&message, &length));
+}
+
+TEST(MidiMessageQueueTest, GetNextReusesBuffer) {
+  MidiMessageQueue queue(false);
+  const uint8_t* message;
+  size_t length;
+
+  Add(&queue, kNoteOn);
+  ASSERT_TRUE(queue.GetNext(&message, &length));
+  const uint8_t* const first_message = message;
+  EXPECT_FALSE(queue.GetNext(&message, &length));
+
+  // Consumed bytes are dropped by Add(), so the storage is reused rather than
+  // growing with the total amount of data.
+  for (size_t i = 0; i < 100; ++i) {
+    Add(&queue, kNoteOn);
+    ASSERT_TRUE(queue.GetNext(&message, &length));
+    EXPECT_EQ(first_message, message);
+    EXPECT_MESSAGE(kNoteOn, std::vector<uint8_t>(message, message + length));
+    EXPECT_FALSE(queue.GetNext(&message, &length));
+  }
+}
+
 }  // namespace
 }  // namespace midi
@@ -5,19 +5,54 @@
 #include "media/midi/midi_scheduler.h"
 
 #include <algorithm>
+#include <utility>
 
 #include "base/bind.h"
 #include "base/location.h"
+#include "base/memory/ptr_util.h"
 #include "base/threading/thread_task_runner_handle.h"
+#include "base/time/default_tick_clock.h"
 #include "base/time/time.h"
 #include "media/midi/midi_manager.h"
 #include "media/midi/midi_service.h"
 
 namespace midi {
 
+namespace {
+
+// Returns the time at which data with |timestamp| should be sent; data with
+// no timestamp, or one in the past, is sent |now|.
+base::TimeTicks TimestampToSendTime(double timestamp, base::TimeTicks now) {
+  if (timestamp == 0.0)
+    return now;
+  return std::max(now, base::TimeTicks() +
+                           base::TimeDelta::FromMicroseconds(
+                               timestamp * base::Time::kMicrosecondsPerSecond));
+}
+
+}  // namespace
+
+MidiScheduler::PendingData::PendingData(MidiManagerClient* client,
+                                        const std::vector<uint8_t>& data)
+    : client(client), data(data) {}
+
+MidiScheduler::PendingData::PendingData(PendingData&& other) = default;
+
+MidiScheduler::PendingData::~PendingData() = default;
+
+MidiScheduler::PortQueue::PortQueue() = default;
+
+MidiScheduler::PortQueue::~PortQueue() = default;
+
 MidiScheduler::MidiScheduler(MidiManager* manager)
+    : MidiScheduler(manager, SendBatchCallback()) {}
+
+MidiScheduler::MidiScheduler(MidiManager* manager,
+                             const SendBatchCallback& send_batch_callback)
     : manager_(manager),
       task_runner_(base::ThreadTaskRunnerHandle::Get()),
+      send_batch_callback_(send_batch_callback),
+      tick_clock_(base::MakeUnique<base::DefaultTickClock>()),
       weak_factory_(this) {}
 
 MidiScheduler::~MidiScheduler() {
@@ -42,6 +77,29 @@ void MidiScheduler::PostSendDataTask(MidiManagerClient* client,
       MidiService::TimestampToTimeDeltaDelay(timestamp));
 }
 
+void MidiScheduler::PostSendData(MidiManagerClient* client,
+                                 uint32_t port_index,
+                                 const std::vector<uint8_t>& data,
+                                 double timestamp) {
+  DCHECK(client);
+  DCHECK(!send_batch_callback_.is_null());
+
+  // Messages with a timestamp in the past are sent as soon as possible, after
+  // those queued before them, as PostSendDataTask() would.
+  const base::TimeTicks send_time =
+      TimestampToSendTime(timestamp, tick_clock_->NowTicks());
+
+  base::AutoLock lock(lock_);
+  PortQueue* queue = &port_queues_[port_index];
+  queue->pending.emplace(send_time, PendingData(client, data));
+  ScheduleSendLocked(port_index, queue, send_time);
+}
+
+void MidiScheduler::SetTickClockForTesting(
+    std::unique_ptr<base::TickClock> tick_clock) {
+  tick_clock_ = std::move(tick_clock);
+}
+
 void MidiScheduler::InvokeClosure(MidiManagerClient* client,
                                   size_t length,
                                   base::OnceClosure closure) {
@@ -50,4 +108,56 @@ void MidiScheduler::InvokeClosure(MidiManagerClient* client,
   manager_->AccumulateMidiBytesSent(client, length);
 }
 
+void MidiScheduler::ScheduleSendLocked(uint32_t port_index,
+                                       PortQueue* queue,
+                                       base::TimeTicks send_time) {
+  lock_.AssertAcquired();
+  if (!queue->next_send_time.is_null() && queue->next_send_time <= send_time)
+    return;
+
+  // A task posted for a later time is not cancelled; if it still runs before
+  // anything else is due, SendDueData() does nothing.
+  queue->next_send_time = send_time;
+  task_runner_->PostDelayedTask(
+      FROM_HERE,
+      base::BindOnce(&MidiScheduler::SendDueData, weak_factory_.GetWeakPtr(),
+                     port_index),
+      std::max(send_time - tick_clock_->NowTicks(), base::TimeDelta()));
+}
+
+void MidiScheduler::SendDueData(uint32_t port_index) {
+  DCHECK(thread_checker_.CalledOnValidThread());
+
+  std::vector<uint8_t> batch;
+  ClientBytes bytes_sent;
+  {
+    base::AutoLock lock(lock_);
+    auto queue_it = port_queues_.find(port_index);
+    if (queue_it == port_queues_.end())
+      return;
+    PortQueue* queue = &queue_it->second;
+
+    const auto due_end = queue->pending.upper_bound(tick_clock_->NowTicks());
+    for (auto it = queue->pending.begin(); it != due_end; ++it) {
+      const PendingData& pending = it->second;
+      batch.insert(batch.end(), pending.data.begin(), pending.data.end());
+      if (!bytes_sent.empty() && bytes_sent.back().first == pending.client)
+        bytes_sent.back().second += pending.data.size();
+      else
+        bytes_sent.emplace_back(pending.client, pending.data.size());
+    }
+    queue->pending.erase(queue->pending.begin(), due_end);
+
+    queue->next_send_time = base::TimeTicks();
+    if (queue->pending.empty())
+      port_queues_.erase(queue_it);
+    else
+      ScheduleSendLocked(port_index, queue, queue->pending.begin()->first);
+  }
+
+  if (batch.empty())
+    return;
+  send_batch_callback_.Run(port_index, batch, bytes_sent);
+}
+
 }  // namespace midi
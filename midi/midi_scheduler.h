@@ -6,12 +6,21 @@
 #define MEDIA_MIDI_MIDI_SCHEDULER_H_
 
 #include <stddef.h>
+#include <stdint.h>
+
+#include <map>
+#include <memory>
+#include <utility>
+#include <vector>
 
 #include "base/callback.h"
 #include "base/macros.h"
 #include "base/memory/weak_ptr.h"
 #include "base/single_thread_task_runner.h"
+#include "base/synchronization/lock.h"
 #include "base/threading/thread_checker.h"
+#include "base/time/tick_clock.h"
+#include "base/time/time.h"
 #include "media/midi/midi_export.h"
 
 namespace midi {
@@ -23,10 +32,26 @@ class MidiManagerClient;
 // TODO(crbug.com/467442): Make tasks cancelable per client.
 class MIDI_EXPORT MidiScheduler final {
  public:
+  // The number of bytes of a batch that came from each client, in the order
+  // they were queued. Consecutive messages of a client are counted together.
+  using ClientBytes = std::vector<std::pair<MidiManagerClient*, size_t>>;
+
+  // Writes |data|, one or more complete MIDI messages, to the output port
+  // |port_index| in a single backend operation. Since the write may complete
+  // on another thread, the callback is responsible for acknowledging it: once
+  // |data| is written, it must call MidiManager::AccumulateMidiBytesSent() for
+  // each client of |bytes_sent|.
+  using SendBatchCallback =
+      base::RepeatingCallback<void(uint32_t port_index,
+                                   const std::vector<uint8_t>& data,
+                                   const ClientBytes& bytes_sent)>;
+
   // Both constructor and destructor should be run on the same thread. The
   // instance is bound to the TaskRunner of the constructing thread, on which
-  // InvokeClosure() is run.
+  // InvokeClosure() and |send_batch_callback| are run.
   explicit MidiScheduler(MidiManager* manager);
+  MidiScheduler(MidiManager* manager,
+                const SendBatchCallback& send_batch_callback);
   ~MidiScheduler();
 
   // Post |closure| to |task_runner_| safely. The |closure| will not be invoked
@@ -39,17 +64,72 @@ class MIDI_EXPORT MidiScheduler final {
                         double timestamp,
                         base::OnceClosure closure);
 
+  // Queues |data| to be sent to |port_index| at |timestamp| through the
+  // SendBatchCallback given on construction. Instead of a task per message,
+  // each port has a timer for its earliest message; when it fires, every
+  // message of the port that is due is sent in one batch, in timestamp order,
+  // and in the order they were queued for equal timestamps. Unlike with
+  // PostSendDataTask(), AccumulateMidiBytesSent() of |client| is left to the
+  // SendBatchCallback, to be called once the batch is written.
+  // May be called on any thread, with the same restriction as above.
+  void PostSendData(MidiManagerClient* client,
+                    uint32_t port_index,
+                    const std::vector<uint8_t>& data,
+                    double timestamp);
+
+  // Replaces the clock that tells when queued data is due. Must be called
+  // before any data is queued.
+  void SetTickClockForTesting(std::unique_ptr<base::TickClock> tick_clock);
+
  private:
+  struct PendingData {
+    PendingData(MidiManagerClient* client, const std::vector<uint8_t>& data);
+    PendingData(PendingData&& other);
+    ~PendingData();
+
+    MidiManagerClient* client;
+    std::vector<uint8_t> data;
+  };
+
+  // Messages waiting to be sent to a port, ordered by the time they are due.
+  // std::multimap keeps messages due at the same time in insertion order.
+  struct PortQueue {
+    PortQueue();
+    ~PortQueue();
+
+    std::multimap<base::TimeTicks, PendingData> pending;
+    // Time of the earliest SendDueData() task posted for the port, or null if
+    // none is pending.
+    base::TimeTicks next_send_time;
+  };
+
   void InvokeClosure(MidiManagerClient* client,
                      size_t length,
                      base::OnceClosure closure);
 
+  // Posts a SendDueData() task for |port_index| at |send_time|, unless one is
+  // already pending for that time or earlier. |lock_| must be held.
+  void ScheduleSendLocked(uint32_t port_index,
+                          PortQueue* queue,
+                          base::TimeTicks send_time);
+
+  // Sends every message for |port_index| that is due.
+  void SendDueData(uint32_t port_index);
+
   // MidiManager should own the MidiScheduler and be alive longer.
   MidiManager* manager_;
 
   // The TaskRunner of the thread on which the instance is constructed.
   scoped_refptr<base::SingleThreadTaskRunner> task_runner_;
 
+  const SendBatchCallback send_batch_callback_;
+
+  std::unique_ptr<base::TickClock> tick_clock_;
+
+  // Guards |port_queues_|, since PostSendData() may be called on any thread.
+  base::Lock lock_;
+  std::map<uint32_t, PortQueue> port_queues_;
+
   // Ensures |weak_factory_| is destructed, and WeakPtrs are dereferenced on the
   // same thread.
   base::ThreadChecker thread_checker_;
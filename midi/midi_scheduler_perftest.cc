@@ -0,0 +1,146 @@
+// Copyright 2017 The Chromium Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include <algorithm>
+#include <memory>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "base/bind.h"
+#include "base/macros.h"
+#include "base/message_loop/message_loop.h"
+#include "base/run_loop.h"
+#include "base/time/time.h"
+#include "media/midi/fake_midi_manager.h"
+#include "media/midi/midi_scheduler.h"
+#include "media/midi/midi_service.h"
+#include "testing/gtest/include/gtest/gtest.h"
+#include "testing/perf/perf_test.h"
+
+namespace midi {
+
+namespace {
+
+// Dense sequencer output: three-byte messages at 4000 messages per second.
+const int kNumMessages = 4000;
+const int kMessagesPerSecond = 4000;
+const size_t kMessageSize = 3;
+
+}  // namespace
+
+// Schedules |kNumMessages| messages ahead of time, as a sequencer does, and
+// measures how late a fake backend receives them and how many writes it gets.
+class MidiSchedulerPerfTest : public ::testing::Test {
+ public:
+  MidiSchedulerPerfTest()
+      : message_loop_(std::make_unique<base::MessageLoop>()),
+        messages_sent_(0),
+        backend_writes_(0) {
+    std::unique_ptr<FakeMidiManagerFactory> factory =
+        std::make_unique<FakeMidiManagerFactory>();
+    FakeMidiManagerFactory* factory_ptr = factory.get();
+    service_ = std::make_unique<MidiService>(std::move(factory));
+    manager_ = factory_ptr->GetCreatedManager();
+  }
+  ~MidiSchedulerPerfTest() override {
+    manager_->Shutdown();
+    base::RunLoop().RunUntilIdle();
+  }
+
+  void RunBenchmark(const std::string& trace, bool batched) {
+    MidiScheduler scheduler(
+        manager_, base::BindRepeating(&MidiSchedulerPerfTest::OnSendBatch,
+                                      base::Unretained(this)));
+    messages_sent_ = 0;
+    backend_writes_ = 0;
+    lateness_.clear();
+    due_times_.clear();
+
+    const base::TimeTicks start =
+        base::TimeTicks::Now() + base::TimeDelta::FromMilliseconds(10);
+    for (int i = 0; i < kNumMessages; ++i) {
+      due_times_.push_back(start + base::TimeDelta::FromMicroseconds(
+                                       i * base::Time::kMicrosecondsPerSecond /
+                                       kMessagesPerSecond));
+      const double timestamp =
+          (due_times_.back() - base::TimeTicks()).InSecondsF();
+      const std::vector<uint8_t> message = {
+          0x90, static_cast<uint8_t>(i % 128), 0x7f};
+      if (batched) {
+        scheduler.PostSendData(&client_, 0, message, timestamp);
+      } else {
+        scheduler.PostSendDataTask(
+            &client_, message.size(), timestamp,
+            base::BindOnce(&MidiSchedulerPerfTest::OnSendBatch,
+                           base::Unretained(this), 0u, message,
+                           MidiScheduler::ClientBytes()));
+      }
+    }
+
+    base::RunLoop run_loop;
+    quit_closure_ = run_loop.QuitClosure();
+    run_loop.Run();
+
+    ASSERT_EQ(static_cast<size_t>(kNumMessages), lateness_.size());
+    std::sort(lateness_.begin(), lateness_.end());
+    base::TimeDelta total;
+    for (const auto& lateness : lateness_)
+      total += lateness;
+    perf_test::PrintResult("midi_scheduler", trace, "mean_lateness",
+                           total.InMillisecondsF() / kNumMessages, "ms", true);
+    perf_test::PrintResult(
+        "midi_scheduler", trace, "p99_lateness",
+        lateness_[kNumMessages * 99 / 100].InMillisecondsF(), "ms", true);
+    perf_test::PrintResult("midi_scheduler", trace, "max_lateness",
+                           lateness_.back().InMillisecondsF(), "ms", true);
+    perf_test::PrintResult(
+        "midi_scheduler", trace, "backend_writes",
+        static_cast<double>(backend_writes_) / kNumMessages, "writes/message",
+        true);
+  }
+
+ private:
+  // The fake backend. Messages arrive in the order they are due, so the
+  // number of messages received so far identifies them. PostSendDataTask()
+  // acknowledges the bytes itself and passes no |bytes_sent|.
+  void OnSendBatch(uint32_t port_index,
+                   const std::vector<uint8_t>& data,
+                   const MidiScheduler::ClientBytes& bytes_sent) {
+    const base::TimeTicks now = base::TimeTicks::Now();
+    ++backend_writes_;
+    for (size_t i = 0; i < data.size() / kMessageSize; ++i)
+      lateness_.push_back(now - due_times_[messages_sent_++]);
+    if (messages_sent_ == kNumMessages)
+      std::move(quit_closure_).Run();
+    for (const auto& client_bytes : bytes_sent)
+      manager_->AccumulateMidiBytesSent(client_bytes.first, client_bytes.second);
+  }
+
+  std::unique_ptr<base::MessageLoop> message_loop_;
+  std::unique_ptr<MidiService> service_;
+  FakeMidiManager* manager_;  // Owned by |service_|.
+  FakeMidiManagerClient client_;
+
+  std::vector<base::TimeTicks> due_times_;
+  std::vector<base::TimeDelta> lateness_;
+  int messages_sent_;
+  int backend_writes_;
+  base::OnceClosure quit_closure_;
+
+  DISALLOW_COPY_AND_ASSIGN(MidiSchedulerPerfTest);
+};
+
+TEST_F(MidiSchedulerPerfTest, TaskPerMessage) {
+  RunBenchmark("_task_per_message", false);
+}
+
+TEST_F(MidiSchedulerPerfTest, Batched) {
+  RunBenchmark("_batched", true);
+}
+
+}  // namespace midi
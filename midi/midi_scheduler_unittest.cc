@@ -0,0 +1,152 @@
+// Copyright 2017 The Chromium Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#include "media/midi/midi_scheduler.h"
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include <memory>
+#include <utility>
+#include <vector>
+
+#include "base/bind.h"
+#include "base/macros.h"
+#include "base/message_loop/message_loop.h"
+#include "base/test/scoped_mock_time_message_loop_task_runner.h"
+#include "base/test/test_mock_time_task_runner.h"
+#include "base/time/time.h"
+#include "media/midi/fake_midi_manager.h"
+#include "media/midi/midi_service.h"
+#include "testing/gtest/include/gtest/gtest.h"
+
+namespace midi {
+
+using mojom::Result;
+
+class MidiSchedulerTest : public ::testing::Test {
+ public:
+  MidiSchedulerTest() : message_loop_(std::make_unique<base::MessageLoop>()) {
+    mock_time_task_runner_ =
+        std::make_unique<base::ScopedMockTimeMessageLoopTaskRunner>();
+    // Leaves room for timestamps in the past.
+    task_runner()->FastForwardBy(base::TimeDelta::FromSeconds(1));
+
+    std::unique_ptr<FakeMidiManagerFactory> factory =
+        std::make_unique<FakeMidiManagerFactory>();
+    FakeMidiManagerFactory* factory_ptr = factory.get();
+    service_ = std::make_unique<MidiService>(std::move(factory));
+    manager_ = factory_ptr->GetCreatedManager();
+    manager_->StartSession(&client_);
+    manager_->CallCompleteInitialization(Result::OK);
+    task_runner()->RunUntilIdle();
+    EXPECT_EQ(Result::OK, client_.result());
+
+    scheduler_ = std::make_unique<MidiScheduler>(
+        manager_, base::BindRepeating(&MidiSchedulerTest::SendBatch,
+                                      base::Unretained(this)));
+    scheduler_->SetTickClockForTesting(task_runner()->GetMockTickClock());
+  }
+  ~MidiSchedulerTest() override {
+    scheduler_.reset();
+    manager_->EndSession(&client_);
+    manager_->Shutdown();
+    task_runner()->RunUntilIdle();
+  }
+
+ protected:
+  struct Batch {
+    uint32_t port_index;
+    std::vector<uint8_t> data;
+  };
+
+  // The fake backend, which acknowledges the batch right away.
+  void SendBatch(uint32_t port_index,
+                 const std::vector<uint8_t>& data,
+                 const MidiScheduler::ClientBytes& bytes_sent) {
+    batches_.push_back({port_index, data});
+    for (const auto& client_bytes : bytes_sent)
+      manager_->AccumulateMidiBytesSent(client_bytes.first,
+                                        client_bytes.second);
+  }
+
+  // Returns the Web MIDI timestamp |delay| from the mock time.
+  double TimestampAfter(base::TimeDelta delay) {
+    return (task_runner()->NowTicks() + delay - base::TimeTicks())
+        .InSecondsF();
+  }
+
+  base::TestMockTimeTaskRunner* task_runner() {
+    return mock_time_task_runner_->task_runner();
+  }
+
+  FakeMidiManagerClient client_;
+  FakeMidiManager* manager_;  // Owned by |service_|.
+  std::unique_ptr<MidiScheduler> scheduler_;
+  std::vector<Batch> batches_;
+
+ private:
+  std::unique_ptr<base::MessageLoop> message_loop_;
+  std::unique_ptr<base::ScopedMockTimeMessageLoopTaskRunner>
+      mock_time_task_runner_;
+  std::unique_ptr<MidiService> service_;
+
+  DISALLOW_COPY_AND_ASSIGN(MidiSchedulerTest);
+};
+
+TEST_F(MidiSchedulerTest, BatchesDueDataPerPort) {
+  scheduler_->PostSendData(&client_, 0, {0x90, 0x3c, 0x7f}, 0.0);
+  scheduler_->PostSendData(&client_, 1, {0xc0, 0x01}, 0.0);
+  scheduler_->PostSendData(&client_, 0, {0x80, 0x3c, 0x00}, 0.0);
+  scheduler_->PostSendData(&client_, 0, {0xf8}, 0.0);
+  EXPECT_TRUE(batches_.empty());
+
+  task_runner()->RunUntilIdle();
+  ASSERT_EQ(2u, batches_.size());
+  EXPECT_EQ(0u, batches_[0].port_index);
+  EXPECT_EQ(std::vector<uint8_t>({0x90, 0x3c, 0x7f, 0x80, 0x3c, 0x00, 0xf8}),
+            batches_[0].data);
+  EXPECT_EQ(1u, batches_[1].port_index);
+  EXPECT_EQ(std::vector<uint8_t>({0xc0, 0x01}), batches_[1].data);
+  EXPECT_EQ(9u, client_.bytes_sent());
+}
+
+TEST_F(MidiSchedulerTest, SendsInTimestampOrder) {
+  const double later = TimestampAfter(base::TimeDelta::FromMilliseconds(40));
+  const double sooner = TimestampAfter(base::TimeDelta::FromMilliseconds(20));
+  scheduler_->PostSendData(&client_, 0, {0xfa}, later);
+  scheduler_->PostSendData(&client_, 0, {0xf8}, sooner);
+  scheduler_->PostSendData(&client_, 0, {0xf9}, sooner);
+  // Timestamps in the past are sent right away.
+  scheduler_->PostSendData(&client_, 0, {0xfe},
+                           TimestampAfter(-base::TimeDelta::FromSeconds(1)));
+
+  task_runner()->RunUntilIdle();
+  ASSERT_EQ(1u, batches_.size());
+  EXPECT_EQ(std::vector<uint8_t>({0xfe}), batches_[0].data);
+
+  task_runner()->FastForwardBy(base::TimeDelta::FromMilliseconds(19));
+  EXPECT_EQ(1u, batches_.size());
+  task_runner()->FastForwardBy(base::TimeDelta::FromMilliseconds(1));
+  ASSERT_EQ(2u, batches_.size());
+  EXPECT_EQ(std::vector<uint8_t>({0xf8, 0xf9}), batches_[1].data);
+
+  task_runner()->FastForwardBy(base::TimeDelta::FromMilliseconds(20));
+  ASSERT_EQ(3u, batches_.size());
+  EXPECT_EQ(std::vector<uint8_t>({0xfa}), batches_[2].data);
+  EXPECT_EQ(4u, client_.bytes_sent());
+}
+
+TEST_F(MidiSchedulerTest, DropsPendingDataOnDestruction) {
+  scheduler_->PostSendData(&client_, 0, {0xf8},
+                           TimestampAfter(base::TimeDelta::FromSeconds(10)));
+  scheduler_->PostSendData(&client_, 0, {0xfe}, 0.0);
+  scheduler_.reset();
+
+  task_runner()->FastForwardUntilNoTasksRemain();
+  EXPECT_TRUE(batches_.empty());
+  EXPECT_EQ(0u, client_.bytes_sent());
+}
+
+}  // namespace midi
@@ -35,7 +35,7 @@ bool UsbMidiInputStream::JackUniqueKey::operator<(
 }
 
 UsbMidiInputStream::UsbMidiInputStream(Delegate* delegate)
-    : delegate_(delegate) {}
+    : pending_jack_index_(0), delegate_(delegate) {}
 
 UsbMidiInputStream::~UsbMidiInputStream() {}
 
@@ -55,11 +55,13 @@ void UsbMidiInputStream::OnReceivedData(UsbMidiDevice* device,
                                         size_t size,
                                         base::TimeTicks time) {
   DCHECK_EQ(0u, size % kPacketSize);
+  DCHECK(pending_data_.empty());
   size_t current = 0;
   while (current + kPacketSize <= size) {
     ProcessOnePacket(device, endpoint_number, &data[current], time);
     current += kPacketSize;
   }
+  FlushPendingData(time);
 }
 
 void UsbMidiInputStream::ProcessOnePacket(UsbMidiDevice* device,
@@ -83,8 +85,21 @@ void UsbMidiInputStream::ProcessOnePacket(UsbMidiDevice* device,
       jack_dictionary_.find(JackUniqueKey(device,
                                           endpoint_number,
                                           cable_number));
-  if (it != jack_dictionary_.end())
-    delegate_->OnReceivedData(it->second, &packet[1], packet_size, time);
+  if (it == jack_dictionary_.end())
+    return;
+  if (it->second != pending_jack_index_)
+    FlushPendingData(time);
+  pending_jack_index_ = it->second;
+  pending_data_.insert(pending_data_.end(), &packet[1],
+                       &packet[1] + packet_size);
+}
+
+void UsbMidiInputStream::FlushPendingData(base::TimeTicks time) {
+  if (pending_data_.empty())
+    return;
+  delegate_->OnReceivedData(pending_jack_index_, pending_data_.data(),
+                            pending_data_.size(), time);
+  pending_data_.clear();
 }
 
 }  // namespace midi
@@ -55,7 +55,8 @@ class USB_MIDI_EXPORT UsbMidiInputStream {
 
   // This function should be called when some data arrives to a USB-MIDI
   // endpoint. This function converts the data to MIDI data and call
-  // |delegate->OnReceivedData| with it.
+  // |delegate->OnReceivedData| with it. Consecutive packets for the same jack
+  // are delivered in one call.
   // |size| must be a multiple of |kPacketSize|.
   void OnReceivedData(UsbMidiDevice* device,
                       int endpoint_number,
@@ -73,11 +74,18 @@ class USB_MIDI_EXPORT UsbMidiInputStream {
                         int endpoint_number,
                         const uint8_t* packet,
                         base::TimeTicks time);
+  // Delivers |pending_data_| to the delegate, if any.
+  void FlushPendingData(base::TimeTicks time);
 
   std::vector<UsbMidiJack> jacks_;
   // A map from UsbMidiJack to its index in |jacks_|.
   std::map<JackUniqueKey, size_t> jack_dictionary_;
 
+  // MIDI data converted for |pending_jack_index_| but not delivered yet. The
+  // storage is reused across calls to OnReceivedData().
+  std::vector<uint8_t> pending_data_;
+  size_t pending_jack_index_;
+
   // Not owned
   Delegate* delegate_;
 
@@ -106,9 +106,7 @@ TEST_F(UsbMidiInputStreamTest, SystemCommonMessage) {
   };
 
   stream_->OnReceivedData(&device1_, 7, data, arraysize(data), TimeTicks());
-  EXPECT_EQ("0xf8 \n"
-            "0xf3 0x22 \n"
-            "0xf2 0x33 0x44 \n", delegate_.received_data());
+  EXPECT_EQ("0xf8 0xf3 0x22 0xf2 0x33 0x44 \n", delegate_.received_data());
 }
 
 TEST_F(UsbMidiInputStreamTest, SystemExclusiveMessage) {
@@ -118,10 +116,8 @@ TEST_F(UsbMidiInputStreamTest, SystemExclusiveMessage) {
   };
 
   stream_->OnReceivedData(&device1_, 7, data, arraysize(data), TimeTicks());
-  EXPECT_EQ("0xf0 0x11 0x22 \n"
-            "0xf7 \n"
-            "0xf0 0xf7 \n"
-            "0xf0 0x33 0xf7 \n", delegate_.received_data());
+  EXPECT_EQ("0xf0 0x11 0x22 0xf7 0xf0 0xf7 0xf0 0x33 0xf7 \n",
+            delegate_.received_data());
 }
 
 TEST_F(UsbMidiInputStreamTest, ChannelMessage) {
@@ -132,13 +128,9 @@ TEST_F(UsbMidiInputStreamTest, ChannelMessage) {
   };
 
   stream_->OnReceivedData(&device1_, 7, data, arraysize(data), TimeTicks());
-  EXPECT_EQ("0x80 0x11 0x22 \n"
-            "0x90 0x33 0x44 \n"
-            "0xa0 0x55 0x66 \n"
-            "0xb0 0x77 0x88 \n"
-            "0xc0 0x99 \n"
-            "0xd0 0xaa \n"
-            "0xe0 0xbb 0xcc \n", delegate_.received_data());
+  EXPECT_EQ("0x80 0x11 0x22 0x90 0x33 0x44 0xa0 0x55 0x66 0xb0 0x77 0x88 "
+            "0xc0 0x99 0xd0 0xaa 0xe0 0xbb 0xcc \n",
+            delegate_.received_data());
 }
 
 TEST_F(UsbMidiInputStreamTest, SingleByteMessage) {
@@ -166,6 +158,25 @@ TEST_F(UsbMidiInputStreamTest, DispatchForDevice2) {
   EXPECT_EQ("0xf8 \n", delegate_.received_data());
 }
 
+TEST_F(UsbMidiInputStreamTest, SplitDeliveryWhenCableChanges) {
+  uint8_t data[] = {
+      0x49, 0x90, 0x11, 0x22, 0x49, 0x90, 0x33, 0x44, 0x59, 0x90, 0x55, 0x66,
+      0x6f, 0xfb, 0x00, 0x00, 0x5f, 0xf8, 0x00, 0x00, 0x49, 0x90, 0x77, 0x00,
+  };
+
+  stream_->OnReceivedData(&device1_, 7, data, arraysize(data), TimeTicks());
+  EXPECT_EQ("0x90 0x11 0x22 0x90 0x33 0x44 \n"
+            "0x90 0x55 0x66 0xf8 \n"
+            "0x90 0x77 0x00 \n", delegate_.received_data());
+
+  // Nothing is carried over to the next call.
+  stream_->OnReceivedData(&device1_, 7, data, 4, TimeTicks());
+  EXPECT_EQ("0x90 0x11 0x22 0x90 0x33 0x44 \n"
+            "0x90 0x55 0x66 0xf8 \n"
+            "0x90 0x77 0x00 \n"
+            "0x90 0x11 0x22 \n", delegate_.received_data());
+}
+
 }  // namespace
 
 }  // namespace midi
@@ -5,6 +5,7 @@
 #include "media/mojo/clients/mojo_media_log_service.h"
 
 #include <memory>
+#include <utility>
 
 #include "base/logging.h"
 #include "base/memory/ptr_util.h"
@@ -37,4 +38,18 @@ void MojoMediaLogService::AddEvent(const media::MediaLogEvent& event) {
   media_log_->AddEvent(std::move(modified_event));
 }
 
+void MojoMediaLogService::AddEvents(
+    const std::vector<media::MediaLogEvent>& events) {
+  DVLOG(1) << __func__ << ": " << events.size();
+
+  std::vector<std::unique_ptr<media::MediaLogEvent>> modified_events;
+  modified_events.reserve(events.size());
+  for (const auto& event : events) {
+    modified_events.push_back(base::MakeUnique<media::MediaLogEvent>(event));
+    modified_events.back()->id = media_log_->id();
+  }
+
+  media_log_->AddEvents(std::move(modified_events));
+}
+
 }  // namespace media
@@ -7,6 +7,8 @@
 
 #include <stdint.h>
 
+#include <vector>
+
 #include "base/macros.h"
 #include "media/base/media_log.h"
 #include "media/mojo/interfaces/media_log.mojom.h"
@@ -21,6 +23,7 @@ class MojoMediaLogService : public mojom::MediaLog {
 
   // mojom::MediaLog implementation
   void AddEvent(const media::MediaLogEvent& event) final;
+  void AddEvents(const std::vector<media::MediaLogEvent>& events) final;
 
  private:
   media::MediaLog* media_log_;
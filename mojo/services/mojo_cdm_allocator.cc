@@ -11,7 +11,6 @@
 #include "base/compiler_specific.h"
 #include "base/memory/ptr_util.h"
 #include "base/numerics/safe_conversions.h"
-#include "base/numerics/safe_math.h"
 #include "media/cdm/api/content_decryption_module.h"
 #include "media/cdm/cdm_helpers.h"
 #include "media/mojo/common/mojo_shared_buffer_video_frame.h"
@@ -160,31 +159,39 @@ class MojoCdmVideoFrame : public VideoFrameImpl {
 
 }  // namespace
 
-MojoCdmAllocator::MojoCdmAllocator() : weak_ptr_factory_(this) {}
+MojoCdmAllocator::MojoCdmAllocator()
+    : buffers_allocated_(0), buffers_reused_(0), weak_ptr_factory_(this) {}
 
 MojoCdmAllocator::~MojoCdmAllocator() {}
 
-// Creates a cdm::Buffer, reusing an existing buffer if one is available.
-// If not, a new buffer is created using AllocateNewBuffer(). The caller is
-// responsible for calling Destroy() on the buffer when it is no longer needed.
+// Creates a cdm::Buffer, reusing an existing buffer if one of a similar size
+// is available. If not, a new buffer is created using AllocateNewBuffer(). The
+// caller is responsible for calling Destroy() on the buffer when it is no
+// longer needed.
 cdm::Buffer* MojoCdmAllocator::CreateCdmBuffer(size_t capacity) {
   DCHECK(thread_checker_.CalledOnValidThread());
 
   if (!capacity)
     return nullptr;
 
-  // Reuse a buffer in the free map if there is one that fits |capacity|.
-  // Otherwise, create a new one.
+  // Reuse a buffer in the free map if there is one that fits |capacity|
+  // without wasting too much memory. Otherwise, create a new one, rounded up
+  // to its bucket size so that it can be reused if requested sizes fluctuate
+  // slightly.
+  capacity = GetBucketSize(capacity);
   mojo::ScopedSharedBufferHandle buffer;
   auto found = available_buffers_.lower_bound(capacity);
-  if (found == available_buffers_.end()) {
-    buffer = AllocateNewBuffer(&capacity);
+  if (found == available_buffers_.end() ||
+      !CanReuseBuffer(found->first, capacity)) {
+    buffer = AllocateNewBuffer(capacity);
     if (!buffer.is_valid())
       return nullptr;
+    ++buffers_allocated_;
   } else {
     capacity = found->first;
     buffer = std::move(found->second);
     available_buffers_.erase(found);
+    ++buffers_reused_;
   }
 
   // Ownership of the SharedBufferHandle is passed to MojoCdmBuffer. When it is
@@ -204,34 +211,24 @@ std::unique_ptr<VideoFrameImpl> MojoCdmAllocator::CreateCdmVideoFrame() {
                  weak_ptr_factory_.GetWeakPtr()));
 }
 
-mojo::ScopedSharedBufferHandle MojoCdmAllocator::AllocateNewBuffer(
-    size_t* capacity) {
+CdmAllocator::Stats MojoCdmAllocator::GetStats() const {
   DCHECK(thread_checker_.CalledOnValidThread());
+  Stats stats;
+  stats.buffers_allocated = buffers_allocated_;
+  stats.buffers_reused = buffers_reused_;
+  stats.free_buffers = available_buffers_.size();
+  for (const auto& entry : available_buffers_)
+    stats.free_bytes += entry.first;
+  return stats;
+}
 
-  // Always pad new allocated buffer so that we don't need to reallocate
-  // buffers frequently if requested sizes fluctuate slightly.
-  static const size_t kBufferPadding = 512;
-
-  // Maximum number of free buffers we can keep when allocating new buffers.
-  static const size_t kFreeLimit = 3;
-
-  // Destroy the smallest buffer before allocating a new bigger buffer if the
-  // number of free buffers exceeds a limit. This mechanism helps avoid ending
-  // up with too many small buffers, which could happen if the size to be
-  // allocated keeps increasing.
-  if (available_buffers_.size() >= kFreeLimit)
-    available_buffers_.erase(available_buffers_.begin());
+mojo::ScopedSharedBufferHandle MojoCdmAllocator::AllocateNewBuffer(
+    size_t capacity) {
+  DCHECK(thread_checker_.CalledOnValidThread());
 
   // Creation of shared memory may be expensive if it involves synchronous IPC
   // calls. That's why we try to avoid AllocateNewBuffer() as much as we can.
-  base::CheckedNumeric<size_t> requested_capacity(*capacity);
-  requested_capacity += kBufferPadding;
-  mojo::ScopedSharedBufferHandle handle =
-      mojo::SharedBufferHandle::Create(requested_capacity.ValueOrDie());
-  if (!handle.is_valid())
-    return handle;
-  *capacity = requested_capacity.ValueOrDie();
-  return handle;
+  return mojo::SharedBufferHandle::Create(capacity);
 }
 
 void MojoCdmAllocator::AddBufferToAvailableMap(
@@ -239,6 +236,13 @@ void MojoCdmAllocator::AddBufferToAvailableMap(
     size_t capacity) {
   DCHECK(thread_checker_.CalledOnValidThread());
   available_buffers_.insert(std::make_pair(capacity, std::move(buffer)));
+
+  // Destroy the smallest buffers if the number of free buffers exceeds a
+  // limit. This avoids holding on to buffers that are no longer needed, e.g.
+  // after a resolution change, and ending up with too many small buffers if
+  // the size to be allocated keeps increasing.
+  while (available_buffers_.size() > kMaxFreeBuffers)
+    available_buffers_.erase(available_buffers_.begin());
 }
 
 MojoHandle MojoCdmAllocator::GetHandleForTesting(cdm::Buffer* buffer) {
@@ -21,7 +21,8 @@
 namespace media {
 
 // This is a CdmAllocator that creates buffers using mojo shared memory.
-// The internal logic is similar to ppapi_cdm_buffer.cc.
+// The shared memory of destroyed buffers is recycled: it is kept, bucketed by
+// size, for a later CreateCdmBuffer() call of a similar size.
 class MEDIA_MOJO_EXPORT MojoCdmAllocator : public CdmAllocator {
  public:
   MojoCdmAllocator();
@@ -30,6 +31,7 @@ class MEDIA_MOJO_EXPORT MojoCdmAllocator : public CdmAllocator {
   // CdmAllocator implementation.
   cdm::Buffer* CreateCdmBuffer(size_t capacity) final;
   std::unique_ptr<VideoFrameImpl> CreateCdmVideoFrame() final;
+  Stats GetStats() const final;
 
  private:
   friend class MojoCdmAllocatorTest;
@@ -40,13 +42,12 @@ class MEDIA_MOJO_EXPORT MojoCdmAllocator : public CdmAllocator {
   using AvailableBufferMap =
       std::multimap<size_t, mojo::ScopedSharedBufferHandle>;
 
-  // Allocates a mojo::SharedBufferHandle of at least |capacity| bytes.
-  // |capacity| will be changed to reflect the actual size of the buffer
-  // allocated.
-  mojo::ScopedSharedBufferHandle AllocateNewBuffer(size_t* capacity);
+  // Allocates a mojo::SharedBufferHandle of |capacity| bytes.
+  mojo::ScopedSharedBufferHandle AllocateNewBuffer(size_t capacity);
 
   // Returns |buffer| to the map of available buffers, ready to be used the
-  // next time CreateCdmBuffer() is called.
+  // next time CreateCdmBuffer() is called. At most kMaxFreeBuffers are kept,
+  // the smallest ones are destroyed.
   void AddBufferToAvailableMap(mojo::ScopedSharedBufferHandle buffer,
                                size_t capacity);
 
@@ -59,6 +60,10 @@ class MEDIA_MOJO_EXPORT MojoCdmAllocator : public CdmAllocator {
   // Map of available, already allocated buffers.
   AvailableBufferMap available_buffers_;
 
+  // Counters of allocated and reused buffers.
+  size_t buffers_allocated_;
+  size_t buffers_reused_;
+
   // Confirms single-threaded access.
   base::ThreadChecker thread_checker_;
 
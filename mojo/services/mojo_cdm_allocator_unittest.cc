@@ -39,6 +39,8 @@ class MojoCdmAllocatorTest : public testing::Test {
     return allocator_.GetAvailableBufferCountForTesting();
   }
 
+  CdmAllocator::Stats GetStats() { return allocator_.GetStats(); }
+
  private:
   MojoCdmAllocator allocator_;
   DISALLOW_COPY_AND_ASSIGN(MojoCdmAllocatorTest);
@@ -64,6 +66,7 @@ TEST_F(MojoCdmAllocatorTest, ReuseCdmBuffer) {
   // just freed.
   cdm::Buffer* new_buffer = CreateCdmBuffer(kRandomDataSize);
   EXPECT_EQ(handle, GetHandle(new_buffer));
+  EXPECT_EQ(1u, GetStats().buffers_reused);
   new_buffer->Destroy();
 }
 
@@ -4,19 +4,36 @@
 
 #include "media/mojo/services/mojo_media_log.h"
 
+#include <utility>
+
+#include "base/bind.h"
 #include "base/logging.h"
 
 namespace media {
 
+namespace {
+
+const int kFlushIntervalMs = 100;
+
+// Enough for the properties a busy decoder sets in |kFlushIntervalMs|.
+const size_t kEventRingCapacity = 256;
+
+}  // namespace
+
 // TODO(sandersd): Do we need to respond to the channel closing?
 MojoMediaLog::MojoMediaLog(
     mojo::AssociatedInterfacePtr<mojom::MediaLog> remote_media_log)
     : remote_media_log_(std::move(remote_media_log)) {
   DVLOG(1) << __func__;
+  EnableEventRing(kEventRingCapacity);
+  flush_timer_.Start(
+      FROM_HERE, base::TimeDelta::FromMilliseconds(kFlushIntervalMs),
+      base::Bind(&MojoMediaLog::FlushEventRing, base::Unretained(this)));
 }
 
 MojoMediaLog::~MojoMediaLog() {
   DVLOG(1) << __func__;
+  FlushEventRing();
 }
 
 void MojoMediaLog::AddEvent(std::unique_ptr<MediaLogEvent> event) {
@@ -25,4 +42,14 @@ void MojoMediaLog::AddEvent(std::unique_ptr<MediaLogEvent> event) {
   remote_media_log_->AddEvent(*event);
 }
 
+void MojoMediaLog::AddEvents(
+    std::vector<std::unique_ptr<MediaLogEvent>> events) {
+  DVLOG(1) << __func__ << ": " << events.size();
+  std::vector<MediaLogEvent> remote_events;
+  remote_events.reserve(events.size());
+  for (const auto& event : events)
+    remote_events.push_back(*event);
+  remote_media_log_->AddEvents(remote_events);
+}
+
 }  // namespace media
@@ -6,14 +6,18 @@
 #define MEDIA_MOJO_SERVICES_MOJO_MEDIA_LOG_H_
 
 #include <memory>
+#include <vector>
 
 #include "base/macros.h"
+#include "base/timer/timer.h"
 #include "media/base/media_log.h"
 #include "media/mojo/interfaces/media_log.mojom.h"
 #include "mojo/public/cpp/bindings/associated_interface_ptr.h"
 
 namespace media {
 
+// Property changes are recorded into an event ring, which is flushed to the
+// remote MediaLog in a single message every 100 ms.
 class MojoMediaLog final : public MediaLog {
  public:
   // TODO(sandersd): Template on Ptr type to support non-associated.
@@ -23,10 +27,13 @@ class MojoMediaLog final : public MediaLog {
 
   // MediaLog implementation.
   void AddEvent(std::unique_ptr<MediaLogEvent> event) override;
+  void AddEvents(std::vector<std::unique_ptr<MediaLogEvent>> events) override;
 
  private:
   mojo::AssociatedInterfacePtr<mojom::MediaLog> remote_media_log_;
 
+  base::RepeatingTimer flush_timer_;
+
   DISALLOW_COPY_AND_ASSIGN(MojoMediaLog);
 };
 
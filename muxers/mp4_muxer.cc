@@ -0,0 +1,827 @@
+// Copyright 2017 The Chromium Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#include "media/muxers/mp4_muxer.h"
+
+#include <algorithm>
+#include <utility>
+
+#include "base/logging.h"
+#include "base/macros.h"
+#include "base/memory/ptr_util.h"
+#include "base/numerics/safe_conversions.h"
+#include "base/numerics/safe_math.h"
+#include "media/base/audio_parameters.h"
+#include "media/base/limits.h"
+#include "media/formats/mp4/box_writer.h"
+#include "media/formats/mp4/es_descriptor.h"
+#include "media/formats/mpeg/adts_constants.h"
+#include "media/video/h264_parser.h"
+
+namespace media {
+
+namespace {
+
+// Size of a box header without a 64-bit size, and of the NALU lengths that
+// replace the Annex B start codes of H.264 samples.
+const size_t kBoxHeaderSize = 8;
+const size_t kNaluLengthSize = 4;
+
+// Samples up to this size are coalesced with the boxes before them before
+// being passed to the WriteDataCB; larger ones are passed on as they are.
+const size_t kMaxBufferedSampleSize = 512;
+
+const uint32_t kMovieTimescale = 1000;
+const uint32_t kVideoTimescale = 90000;
+
+// Audio-only recordings are cut into fragments of about this duration.
+const uint32_t kAudioFragmentDurationInSeconds = 1;
+
+// Sample flags, ISO/IEC 14496-12 8.8.3.1: key frames do not depend on other
+// samples; other frames do, and are not sync samples.
+const uint32_t kKeySampleFlags = 0x02000000;
+const uint32_t kNonKeySampleFlags = 0x01000000 | mp4::kSampleIsNonSyncSample;
+
+// Track run flags: data offset, and per sample durations, sizes and flags.
+const uint32_t kTrackRunFlags = 0x1 | 0x100 | 0x200 | 0x400;
+
+// Track fragment header flag: data offsets are relative to the moof.
+const uint32_t kDefaultBaseIsMoof = 0x020000;
+
+// Track header flags: the track is enabled and used in the presentation.
+const uint32_t kTrackEnabledAndInMovie = 0x3;
+
+// Packed ISO 639-2/T code for "und".
+const uint16_t kUndeterminedLanguage = 0x55c4;
+
+const uint8_t kAacLcObjectType = 2;
+
+// Descriptor tags, ISO/IEC 14496-1 7.2.2.1.
+const uint8_t kESDescrTag = 0x03;
+const uint8_t kDecoderConfigDescrTag = 0x04;
+const uint8_t kDecoderSpecificInfoTag = 0x05;
+const uint8_t kSLConfigDescrTag = 0x06;
+
+// VP9 level 1, 8 bit 4:2:0 with BT.709 colour, as produced by MediaRecorder.
+const uint8_t kVp9Level = 10;
+const uint8_t kVp9BitDepth = 8;
+const uint8_t kVp9ChromaSubsampling420 = 1;
+const uint8_t kBt709 = 1;
+
+const int32_t kUnityMatrix[] = {0x00010000, 0, 0, 0, 0x00010000,
+                                0, 0, 0, 0x40000000};
+
+double GetFrameRate(const Mp4Muxer::VideoParameters& params) {
+  const double kDefaultFrameRate = 30.0;
+  if (params.frame_rate <= 0.0 ||
+      params.frame_rate > media::limits::kMaxFramesPerSecond) {
+    return kDefaultFrameRate;
+  }
+  return params.frame_rate;
+}
+
+// Replaces the Annex B start codes in the H.264 access unit |data| with the
+// NALU lengths MP4 uses instead. This is done in place if every start code is
+// four bytes long, as is the case for encoder output. Returns false if |data|
+// cannot be parsed.
+bool ConvertAnnexBToLengthPrefixed(std::unique_ptr<std::string>* data) {
+  const uint8_t* const start =
+      reinterpret_cast<const uint8_t*>((*data)->data());
+  std::vector<H264NALU> nalus;
+  if (!H264Parser::ParseNALUs(start, (*data)->size(), &nalus) ||
+      nalus.empty()) {
+    return false;
+  }
+
+  size_t converted_size = 0;
+  bool in_place = true;
+  for (const H264NALU& nalu : nalus) {
+    in_place &= static_cast<size_t>(nalu.data - start) ==
+                converted_size + kNaluLengthSize;
+    converted_size += kNaluLengthSize + nalu.size;
+  }
+  in_place &= converted_size == (*data)->size();
+
+  if (in_place) {
+    for (const H264NALU& nalu : nalus) {
+      const size_t offset = nalu.data - start - kNaluLengthSize;
+      for (size_t i = 0; i < kNaluLengthSize; ++i)
+        (**data)[offset + i] = static_cast<char>(nalu.size >> (24 - 8 * i));
+    }
+    return true;
+  }
+
+  std::unique_ptr<std::string> converted = base::MakeUnique<std::string>();
+  converted->reserve(converted_size);
+  for (const H264NALU& nalu : nalus) {
+    for (size_t i = 0; i < kNaluLengthSize; ++i)
+      converted->push_back(static_cast<char>(nalu.size >> (24 - 8 * i)));
+    converted->append(reinterpret_cast<const char*>(nalu.data), nalu.size);
+  }
+  *data = std::move(converted);
+  return true;
+}
+
+void WriteBox(const mp4::FileType& ftyp, mp4::BoxWriter* writer) {
+  writer->StartBox(ftyp.BoxType());
+  writer->WriteFourCC(ftyp.major_brand);
+  writer->Write4(ftyp.minor_version);
+  // Compatible brands; 'iso6' covers the 'tfdt' box and 'default-base-is-moof'.
+  writer->WriteFourCC(mp4::FOURCC_ISOM);
+  writer->WriteFourCC(mp4::FOURCC_ISO6);
+  writer->WriteFourCC(mp4::FOURCC_MP41);
+  writer->EndBox();
+}
+
+void WriteMatrix(mp4::BoxWriter* writer) {
+  for (int32_t value : kUnityMatrix)
+    writer->Write4s(value);
+}
+
+void WriteBox(const mp4::MovieHeader& mvhd, mp4::BoxWriter* writer) {
+  writer->StartFullBox(mvhd.BoxType(), 1, 0);
+  writer->Write8(mvhd.creation_time);
+  writer->Write8(mvhd.modification_time);
+  writer->Write4(mvhd.timescale);
+  writer->Write8(mvhd.duration);
+  writer->Write4s(mvhd.rate);
+  writer->Write2s(mvhd.volume);
+  writer->WriteZeros(10);  // reserved
+  WriteMatrix(writer);
+  writer->WriteZeros(24);  // predefined zero
+  writer->Write4(mvhd.next_track_id);
+  writer->EndBox();
+}
+
+void WriteBox(const mp4::TrackHeader& tkhd, mp4::BoxWriter* writer) {
+  writer->StartFullBox(tkhd.BoxType(), 1, kTrackEnabledAndInMovie);
+  writer->Write8(tkhd.creation_time);
+  writer->Write8(tkhd.modification_time);
+  writer->Write4(tkhd.track_id);
+  writer->WriteZeros(4);  // reserved
+  writer->Write8(tkhd.duration);
+  writer->WriteZeros(8);  // reserved
+  writer->Write2s(tkhd.layer);
+  writer->Write2s(tkhd.alternate_group);
+  writer->Write2s(tkhd.volume);
+  writer->WriteZeros(2);  // reserved
+  WriteMatrix(writer);
+  // Width and height are 16.16 fixed-point values.
+  writer->Write4(tkhd.width << 16);
+  writer->Write4(tkhd.height << 16);
+  writer->EndBox();
+}
+
+void WriteBox(const mp4::MediaHeader& mdhd, mp4::BoxWriter* writer) {
+  writer->StartFullBox(mdhd.BoxType(), 1, 0);
+  writer->Write8(mdhd.creation_time);
+  writer->Write8(mdhd.modification_time);
+  writer->Write4(mdhd.timescale);
+  writer->Write8(mdhd.duration);
+  writer->Write2(mdhd.language_code);
+  writer->WriteZeros(2);  // predefined
+  writer->EndBox();
+}
+
+void WriteBox(const mp4::HandlerReference& hdlr, mp4::BoxWriter* writer) {
+  DCHECK(hdlr.type == mp4::kVideo || hdlr.type == mp4::kAudio);
+  writer->StartFullBox(hdlr.BoxType(), 0, 0);
+  writer->WriteZeros(4);  // predefined
+  writer->WriteFourCC(hdlr.type == mp4::kVideo ? mp4::FOURCC_VIDE
+                                               : mp4::FOURCC_SOUN);
+  writer->WriteZeros(12);  // reserved
+  // |name| is a zero-terminated string.
+  writer->WriteBytes(reinterpret_cast<const uint8_t*>(hdlr.name.c_str()),
+                     hdlr.name.size() + 1);
+  writer->EndBox();
+}
+
+void WriteBox(const mp4::AVCDecoderConfigurationRecord& avcc,
+              mp4::BoxWriter* writer) {
+  writer->StartBox(avcc.BoxType());
+  writer->Write1(avcc.version);
+  writer->Write1(avcc.profile_indication);
+  writer->Write1(avcc.profile_compatibility);
+  writer->Write1(avcc.avc_level);
+  // Reserved bits are all set.
+  writer->Write1(0xfc | (avcc.length_size - 1));
+  writer->Write1(0xe0 | static_cast<uint8_t>(avcc.sps_list.size()));
+  for (const auto& sps : avcc.sps_list) {
+    writer->Write2(base::checked_cast<uint16_t>(sps.size()));
+    writer->WriteBytes(sps.data(), sps.size());
+  }
+  writer->Write1(base::checked_cast<uint8_t>(avcc.pps_list.size()));
+  for (const auto& pps : avcc.pps_list) {
+    writer->Write2(base::checked_cast<uint16_t>(pps.size()));
+    writer->WriteBytes(pps.data(), pps.size());
+  }
+  writer->EndBox();
+}
+
+void WriteBox(const mp4::VPCodecConfigurationRecord& vpcc,
+              mp4::BoxWriter* writer) {
+  writer->StartFullBox(vpcc.BoxType(), 1, 0);
+  writer->Write1(vpcc.profile - VP9PROFILE_MIN);
+  writer->Write1(kVp9Level);
+  // Bit depth, chroma subsampling and video full range flag.
+  writer->Write1(kVp9BitDepth << 4 | kVp9ChromaSubsampling420 << 1);
+  // Colour primaries, transfer characteristics and matrix coefficients.
+  writer->Write1(kBt709);
+  writer->Write1(kBt709);
+  writer->Write1(kBt709);
+  writer->Write2(0);  // codecInitializationDataSize
+  writer->EndBox();
+}
+
+// Writes the fields common to all visual sample entries; the caller starts the
+// box, writes the codec configuration and ends the box.
+void WriteVideoSampleEntryFields(const mp4::VideoSampleEntry& entry,
+                                 mp4::BoxWriter* writer) {
+  writer->WriteZeros(6);  // reserved
+  writer->Write2(entry.data_reference_index);
+  writer->WriteZeros(16);  // predefined and reserved
+  writer->Write2(entry.width);
+  writer->Write2(entry.height);
+  writer->Write4(0x00480000);  // horizontal resolution, 72 dpi
+  writer->Write4(0x00480000);  // vertical resolution, 72 dpi
+  writer->WriteZeros(4);       // reserved
+  writer->Write2(1);           // frame count
+  writer->WriteZeros(32);      // compressor name
+  writer->Write2(0x0018);      // depth
+  writer->Write2s(-1);         // predefined
+}
+
+// Writes an ES_Descriptor, ISO/IEC 14496-1 7.2.6.5, for |esds.object_type|
+// with |decoder_specific_info|. All descriptors are small enough for their
+// sizes to fit in a single byte.
+void WriteBox(const mp4::ElementaryStreamDescriptor& esds,
+              const std::vector<uint8_t>& decoder_specific_info,
+              mp4::BoxWriter* writer) {
+  const uint8_t kAudioStreamType = 0x05;
+  const size_t decoder_config_size = 13 + 2 + decoder_specific_info.size();
+  const size_t es_size = 3 + 2 + decoder_config_size + 3;
+  DCHECK_LT(es_size, 0x80u);
+
+  writer->StartFullBox(esds.BoxType(), 0, 0);
+  writer->Write1(kESDescrTag);
+  writer->Write1(static_cast<uint8_t>(es_size));
+  writer->Write2(0);  // ES_ID
+  writer->Write1(0);  // No dependency, URL or OCR stream; lowest priority.
+
+  writer->Write1(kDecoderConfigDescrTag);
+  writer->Write1(static_cast<uint8_t>(decoder_config_size));
+  writer->Write1(esds.object_type);
+  writer->Write1(kAudioStreamType << 2 | 1);  // upStream 0, reserved 1
+  writer->WriteZeros(3);                      // bufferSizeDB
+  writer->Write4(0);                          // maxBitrate
+  writer->Write4(0);                          // avgBitrate
+
+  writer->Write1(kDecoderSpecificInfoTag);
+  writer->Write1(static_cast<uint8_t>(decoder_specific_info.size()));
+  writer->WriteBytes(decoder_specific_info.data(),
+                     decoder_specific_info.size());
+
+  // SLConfigDescriptor with the predefined value for MP4 files.
+  writer->Write1(kSLConfigDescrTag);
+  writer->Write1(1);
+  writer->Write1(2);
+  writer->EndBox();
+}
+
+void WriteBox(const mp4::AudioSampleEntry& entry,
+              const std::vector<uint8_t>& decoder_specific_info,
+              mp4::BoxWriter* writer) {
+  writer->StartBox(entry.format);
+  writer->WriteZeros(6);  // reserved
+  writer->Write2(entry.data_reference_index);
+  writer->WriteZeros(8);  // reserved
+  writer->Write2(entry.channelcount);
+  writer->Write2(entry.samplesize);
+  writer->WriteZeros(4);  // predefined and reserved
+  // The sample rate is a 16.16 fixed-point value; higher rates are only
+  // signalled in the decoder specific info.
+  writer->Write4(entry.samplerate <= 0xffff ? entry.samplerate << 16 : 0);
+  WriteBox(entry.esds, decoder_specific_info, writer);
+  writer->EndBox();
+}
+
+void WriteBox(const mp4::TrackExtends& trex, mp4::BoxWriter* writer) {
+  writer->StartFullBox(trex.BoxType(), 0, 0);
+  writer->Write4(trex.track_id);
+  writer->Write4(trex.default_sample_description_index);
+  writer->Write4(trex.default_sample_duration);
+  writer->Write4(trex.default_sample_size);
+  writer->Write4(trex.default_sample_flags);
+  writer->EndBox();
+}
+
+void WriteBox(const mp4::MovieFragmentHeader& mfhd, mp4::BoxWriter* writer) {
+  writer->StartFullBox(mfhd.BoxType(), 0, 0);
+  writer->Write4(mfhd.sequence_number);
+  writer->EndBox();
+}
+
+void WriteBox(const mp4::TrackFragmentHeader& tfhd, mp4::BoxWriter* writer) {
+  writer->StartFullBox(tfhd.BoxType(), 0, kDefaultBaseIsMoof);
+  writer->Write4(tfhd.track_id);
+  writer->EndBox();
+}
+
+void WriteBox(const mp4::TrackFragmentDecodeTime& tfdt,
+              mp4::BoxWriter* writer) {
+  writer->StartFullBox(tfdt.BoxType(), 1, 0);
+  writer->Write8(tfdt.decode_time);
+  writer->EndBox();
+}
+
+// Returns the offset of the data offset field, which the caller fills in once
+// the size of the moof is known.
+size_t WriteBox(const mp4::TrackFragmentRun& trun, mp4::BoxWriter* writer) {
+  DCHECK_EQ(trun.sample_count, trun.sample_durations.size());
+  DCHECK_EQ(trun.sample_count, trun.sample_sizes.size());
+  DCHECK_EQ(trun.sample_count, trun.sample_flags.size());
+  writer->StartFullBox(trun.BoxType(), 0, kTrackRunFlags);
+  writer->Write4(trun.sample_count);
+  const size_t data_offset_position = writer->size();
+  writer->Write4(trun.data_offset);
+  for (uint32_t i = 0; i < trun.sample_count; ++i) {
+    writer->Write4(trun.sample_durations[i]);
+    writer->Write4(trun.sample_sizes[i]);
+    writer->Write4(trun.sample_flags[i]);
+  }
+  writer->EndBox();
+  return data_offset_position;
+}
+
+}  // anonymous namespace
+
+Mp4Muxer::Track::Track()
+    : track_id(0),
+      timescale(0),
+      default_duration(0),
+      pending_decode_time(0),
+      pending_is_key_frame(false),
+      fragment_decode_time(0) {}
+
+Mp4Muxer::Track::~Track() {}
+
+Mp4Muxer::Mp4Muxer(VideoCodec video_codec,
+                   AudioCodec audio_codec,
+                   bool has_video,
+                   bool has_audio,
+                   const WriteDataCB& write_data_callback)
+    : video_codec_(video_codec),
+      audio_codec_(audio_codec),
+      has_video_(has_video),
+      has_audio_(has_audio),
+      write_data_callback_(write_data_callback),
+      init_segment_written_(false),
+      sequence_number_(0) {
+  DCHECK(has_video_ || has_audio_);
+  DCHECK(!write_data_callback_.is_null());
+  DCHECK(!has_video_ || video_codec == kCodecH264 || video_codec == kCodecVP9)
+      << " Unsupported video codec: " << GetCodecName(video_codec);
+  DCHECK(!has_audio_ || audio_codec == kCodecAAC)
+      << " Unsupported audio codec: " << GetCodecName(audio_codec);
+
+  // Track IDs are one-based.
+  uint32_t next_track_id = 1;
+  if (has_video_)
+    video_track_.track_id = next_track_id++;
+  if (has_audio_)
+    audio_track_.track_id = next_track_id++;
+
+  // Creation is done on a different thread than main activities.
+  thread_checker_.DetachFromThread();
+}
+
+Mp4Muxer::~Mp4Muxer() {
+  DCHECK(thread_checker_.CalledOnValidThread());
+  for (Track* track : {&video_track_, &audio_track_}) {
+    if (track->pending_data)
+      CompletePendingSample(track, track->default_duration);
+  }
+  WriteFragment(true /* is_last_fragment */);
+}
+
+bool Mp4Muxer::OnEncodedVideo(const VideoParameters& params,
+                              std::unique_ptr<std::string> encoded_data,
+                              std::unique_ptr<std::string> encoded_alpha,
+                              base::TimeTicks timestamp,
+                              bool is_key_frame) {
+  DVLOG(1) << __func__ << " - " << encoded_data->size() << "B";
+  DCHECK(thread_checker_.CalledOnValidThread());
+  DCHECK(has_video_);
+
+  if (encoded_data->empty()) {
+    DLOG(WARNING) << __func__ << ": zero size encoded frame, skipping";
+    return true;
+  }
+
+  if (!video_track_.timescale) {
+    if (!is_key_frame) {
+      DVLOG(1) << __func__ << ": dropping frame before the first key frame.";
+      return true;
+    }
+    if (!ConfigureVideoTrack(params, *encoded_data))
+      return false;
+    video_track_.first_timestamp = timestamp;
+  }
+
+  if (video_codec_ == kCodecH264 &&
+      !ConvertAnnexBToLengthPrefixed(&encoded_data)) {
+    DLOG(ERROR) << __func__ << ": invalid H.264 Annex B data.";
+    return false;
+  }
+
+  AddSample(&video_track_, std::move(encoded_data), timestamp, is_key_frame);
+  return true;
+}
+
+bool Mp4Muxer::OnEncodedAudio(const media::AudioParameters& params,
+                              std::unique_ptr<std::string> encoded_data,
+                              base::TimeTicks timestamp) {
+  DVLOG(2) << __func__ << " - " << encoded_data->size() << "B";
+  DCHECK(thread_checker_.CalledOnValidThread());
+  DCHECK(has_audio_);
+
+  if (!audio_track_.timescale) {
+    if (!ConfigureAudioTrack(params))
+      return false;
+    audio_track_.first_timestamp = timestamp;
+  }
+
+  AddSample(&audio_track_, std::move(encoded_data), timestamp,
+            true /* is_key_frame -- always true for audio */);
+  return true;
+}
+
+void Mp4Muxer::Pause() {
+  DVLOG(1) << __func__;
+  DCHECK(thread_checker_.CalledOnValidThread());
+  if (!elapsed_time_in_pause_)
+    elapsed_time_in_pause_.reset(new base::ElapsedTimer());
+}
+
+void Mp4Muxer::Resume() {
+  DVLOG(1) << __func__;
+  DCHECK(thread_checker_.CalledOnValidThread());
+  if (elapsed_time_in_pause_) {
+    total_time_in_pause_ += elapsed_time_in_pause_->Elapsed();
+    elapsed_time_in_pause_.reset();
+  }
+}
+
+bool Mp4Muxer::ConfigureVideoTrack(const VideoParameters& params,
+                                   const std::string& key_frame) {
+  DCHECK(!video_track_.timescale);
+
+  if (video_codec_ == kCodecH264) {
+    // The parameter sets of the first key frame go in the avcC box. They are
+    // left in the samples too, so that they can change mid-stream.
+    avc_config_.sps_list.clear();
+    avc_config_.pps_list.clear();
+    std::vector<H264NALU> nalus;
+    if (!H264Parser::ParseNALUs(
+            reinterpret_cast<const uint8_t*>(key_frame.data()),
+            key_frame.size(), &nalus)) {
+      DLOG(ERROR) << __func__ << ": invalid H.264 Annex B data.";
+      return false;
+    }
+    for (const H264NALU& nalu : nalus) {
+      if (nalu.nal_unit_type == H264NALU::kSPS &&
+          avc_config_.sps_list.empty()) {
+        avc_config_.sps_list.emplace_back(nalu.data, nalu.data + nalu.size);
+      } else if (nalu.nal_unit_type == H264NALU::kPPS &&
+                 avc_config_.pps_list.empty()) {
+        avc_config_.pps_list.emplace_back(nalu.data, nalu.data + nalu.size);
+      }
+    }
+    // The SPS starts with the NALU header, profile, constraint flags and
+    // level.
+    if (avc_config_.sps_list.empty() || avc_config_.pps_list.empty() ||
+        avc_config_.sps_list[0].size() < 4) {
+      DLOG(ERROR) << __func__ << ": key frame without SPS and PPS.";
+      return false;
+    }
+    const std::vector<uint8_t>& sps = avc_config_.sps_list[0];
+    avc_config_.version = 1;
+    avc_config_.profile_indication = sps[1];
+    avc_config_.profile_compatibility = sps[2];
+    avc_config_.avc_level = sps[3];
+    avc_config_.length_size = kNaluLengthSize;
+    video_sample_entry_.format = mp4::FOURCC_AVC3;
+  } else {
+    // MediaRecorder only produces VP9 profile 0.
+    vp_config_.profile = VP9PROFILE_PROFILE0;
+    video_sample_entry_.format = mp4::FOURCC_VP09;
+  }
+
+  video_sample_entry_.data_reference_index = 1;
+  video_sample_entry_.width =
+      base::checked_cast<uint16_t>(params.visible_rect_size.width());
+  video_sample_entry_.height =
+      base::checked_cast<uint16_t>(params.visible_rect_size.height());
+
+  video_track_.timescale = kVideoTimescale;
+  video_track_.default_duration =
+      static_cast<uint32_t>(kVideoTimescale / GetFrameRate(params));
+  return true;
+}
+
+bool Mp4Muxer::ConfigureAudioTrack(const media::AudioParameters& params) {
+  DCHECK(!audio_track_.timescale);
+
+  // AudioSpecificConfig, ISO/IEC 14496-3 1.6.2.1, for AAC-LC.
+  const int* const frequencies_end =
+      kADTSFrequencyTable + kADTSFrequencyTableSize;
+  const int* const frequency =
+      std::find(kADTSFrequencyTable, frequencies_end, params.sample_rate());
+  uint8_t channel_configuration = 0;
+  if (params.channels() >= 1 && params.channels() <= 6)
+    channel_configuration = params.channels();
+  else if (params.channels() == 8)
+    channel_configuration = 7;
+  if (frequency == frequencies_end || !channel_configuration) {
+    DLOG(ERROR) << __func__ << ": unsupported AAC configuration "
+                << params.AsHumanReadableString();
+    return false;
+  }
+  const uint8_t frequency_index = frequency - kADTSFrequencyTable;
+  audio_specific_config_ = {
+      static_cast<uint8_t>(kAacLcObjectType << 3 | frequency_index >> 1),
+      static_cast<uint8_t>((frequency_index & 1) << 7 |
+                           channel_configuration << 3)};
+
+  audio_sample_entry_.format = mp4::FOURCC_MP4A;
+  audio_sample_entry_.data_reference_index = 1;
+  audio_sample_entry_.channelcount = params.channels();
+  audio_sample_entry_.samplesize = 16;
+  audio_sample_entry_.samplerate = params.sample_rate();
+  audio_sample_entry_.esds.object_type = mp4::kISO_14496_3;
+
+  audio_track_.timescale = params.sample_rate();
+  audio_track_.default_duration = kSamplesPerAACFrame;
+  return true;
+}
+
+void Mp4Muxer::AddSample(Track* track,
+                         std::unique_ptr<std::string> data,
+                         base::TimeTicks timestamp,
+                         bool is_key_frame) {
+  const base::TimeDelta elapsed =
+      timestamp - track->first_timestamp - total_time_in_pause_;
+  // Rounded to the nearest tick, since audio frame durations are seldom a
+  // whole number of microseconds.
+  uint64_t decode_time =
+      elapsed > base::TimeDelta()
+          ? (static_cast<uint64_t>(elapsed.InMicroseconds()) *
+                 track->timescale +
+             base::Time::kMicrosecondsPerSecond / 2) /
+                base::Time::kMicrosecondsPerSecond
+          : 0;
+
+  if (track->pending_data) {
+    // Decode times must not go backwards.
+    decode_time = std::max(decode_time, track->pending_decode_time);
+    const uint32_t duration = base::saturated_cast<uint32_t>(
+        decode_time - track->pending_decode_time);
+    if (duration)
+      track->default_duration = duration;
+    CompletePendingSample(track, duration);
+  }
+
+  // Video fragments start at key frames; audio-only ones are about a second
+  // long.
+  const bool starts_fragment =
+      track == &video_track_
+          ? is_key_frame
+          : !has_video_ && track->run.sample_count &&
+                decode_time - track->fragment_decode_time >=
+                    track->timescale * kAudioFragmentDurationInSeconds;
+  if (starts_fragment)
+    WriteFragment(false /* is_last_fragment */);
+
+  track->pending_data = std::move(data);
+  track->pending_decode_time = decode_time;
+  track->pending_is_key_frame = is_key_frame;
+}
+
+void Mp4Muxer::CompletePendingSample(Track* track, uint32_t duration) {
+  DCHECK(track->pending_data);
+  mp4::TrackFragmentRun* const run = &track->run;
+  if (!run->sample_count)
+    track->fragment_decode_time = track->pending_decode_time;
+
+  ++run->sample_count;
+  run->sample_durations.push_back(duration);
+  run->sample_sizes.push_back(
+      base::checked_cast<uint32_t>(track->pending_data->size()));
+  run->sample_flags.push_back(track->pending_is_key_frame ? kKeySampleFlags
+                                                          : kNonKeySampleFlags);
+  track->fragment_data.push_back(std::move(track->pending_data));
+}
+
+void Mp4Muxer::WriteFragment(bool is_last_fragment) {
+  if (!video_track_.run.sample_count && !audio_track_.run.sample_count)
+    return;
+
+  if (!init_segment_written_) {
+    const bool all_tracks_configured =
+        (!has_video_ || video_track_.timescale) &&
+        (!has_audio_ || audio_track_.timescale);
+    if (!all_tracks_configured && !is_last_fragment) {
+      DVLOG(1) << __func__ << ": delaying until all tracks are configured.";
+      return;
+    }
+  }
+
+  mp4::BoxWriter writer(&output_buffer_);
+  if (!init_segment_written_) {
+    WriteInitSegment(&writer);
+    init_segment_written_ = true;
+  }
+
+  const size_t moof_offset = writer.size();
+  writer.StartBox(mp4::FOURCC_MOOF);
+  mp4::MovieFragmentHeader mfhd;
+  mfhd.sequence_number = ++sequence_number_;
+  WriteBox(mfhd, &writer);
+
+  Track* const tracks[] = {&video_track_, &audio_track_};
+  size_t data_offset_positions[arraysize(tracks)] = {};
+  for (size_t i = 0; i < arraysize(tracks); ++i) {
+    const Track& track = *tracks[i];
+    if (!track.run.sample_count)
+      continue;
+    writer.StartBox(mp4::FOURCC_TRAF);
+    mp4::TrackFragmentHeader tfhd;
+    tfhd.track_id = track.track_id;
+    WriteBox(tfhd, &writer);
+    mp4::TrackFragmentDecodeTime tfdt;
+    tfdt.decode_time = track.fragment_decode_time;
+    WriteBox(tfdt, &writer);
+    data_offset_positions[i] = WriteBox(track.run, &writer);
+    writer.EndBox();
+  }
+  writer.EndBox();
+
+  // The samples of each track follow one another in the mdat, in the order of
+  // the track fragments; data offsets are relative to the start of the moof.
+  const size_t moof_size = writer.size() - moof_offset;
+  base::CheckedNumeric<uint32_t> mdat_size = kBoxHeaderSize;
+  for (size_t i = 0; i < arraysize(tracks); ++i) {
+    if (!tracks[i]->run.sample_count)
+      continue;
+    writer.Rewrite4(data_offset_positions[i],
+                    (mdat_size + moof_size).ValueOrDie());
+    for (uint32_t sample_size : tracks[i]->run.sample_sizes)
+      mdat_size += sample_size;
+  }
+  writer.Write4(mdat_size.ValueOrDie());
+  writer.WriteFourCC(mp4::FOURCC_MDAT);
+
+  for (Track* track : tracks) {
+    for (const auto& data : track->fragment_data) {
+      if (data->size() <= kMaxBufferedSampleSize) {
+        writer.WriteBytes(reinterpret_cast<const uint8_t*>(data->data()),
+                          data->size());
+        continue;
+      }
+      FlushOutputBuffer();
+      write_data_callback_.Run(*data);
+    }
+
+    track->fragment_data.clear();
+    track->run.sample_count = 0;
+    track->run.sample_durations.clear();
+    track->run.sample_sizes.clear();
+    track->run.sample_flags.clear();
+  }
+  FlushOutputBuffer();
+}
+
+void Mp4Muxer::WriteInitSegment(mp4::BoxWriter* writer) const {
+  mp4::FileType ftyp;
+  ftyp.major_brand = mp4::FOURCC_ISOM;
+  ftyp.minor_version = 0x200;
+  WriteBox(ftyp, writer);
+
+  writer->StartBox(mp4::FOURCC_MOOV);
+  // The duration is unknown, as for a live stream.
+  mp4::MovieHeader mvhd;
+  mvhd.timescale = kMovieTimescale;
+  mvhd.rate = 0x00010000;
+  mvhd.volume = 0x0100;
+  mvhd.next_track_id =
+      std::max(video_track_.track_id, audio_track_.track_id) + 1;
+  WriteBox(mvhd, writer);
+
+  // Tracks which never received a frame are left out.
+  const Track* const tracks[] = {&video_track_, &audio_track_};
+  for (const Track* track : tracks) {
+    if (track->timescale)
+      WriteTrack(*track, writer);
+  }
+
+  writer->StartBox(mp4::FOURCC_MVEX);
+  for (const Track* track : tracks) {
+    if (!track->timescale)
+      continue;
+    mp4::TrackExtends trex;
+    trex.track_id = track->track_id;
+    trex.default_sample_description_index = 1;
+    WriteBox(trex, writer);
+  }
+  writer->EndBox();
+  writer->EndBox();
+}
+
+void Mp4Muxer::WriteTrack(const Track& track, mp4::BoxWriter* writer) const {
+  const bool is_video = &track == &video_track_;
+  writer->StartBox(mp4::FOURCC_TRAK);
+
+  mp4::TrackHeader tkhd;
+  tkhd.track_id = track.track_id;
+  tkhd.layer = 0;
+  tkhd.alternate_group = 0;
+  tkhd.volume = is_video ? 0 : 0x0100;
+  tkhd.width = is_video ? video_sample_entry_.width : 0;
+  tkhd.height = is_video ? video_sample_entry_.height : 0;
+  WriteBox(tkhd, writer);
+
+  writer->StartBox(mp4::FOURCC_MDIA);
+  mp4::MediaHeader mdhd;
+  mdhd.timescale = track.timescale;
+  mdhd.language_code = kUndeterminedLanguage;
+  WriteBox(mdhd, writer);
+
+  mp4::HandlerReference hdlr;
+  hdlr.type = is_video ? mp4::kVideo : mp4::kAudio;
+  hdlr.name = is_video ? "VideoHandler" : "SoundHandler";
+  WriteBox(hdlr, writer);
+
+  writer->StartBox(mp4::FOURCC_MINF);
+  if (is_video) {
+    writer->StartFullBox(mp4::FOURCC_VMHD, 0, 1);
+    writer->WriteZeros(8);  // graphics mode and opcolor
+  } else {
+    writer->StartFullBox(mp4::FOURCC_SMHD, 0, 0);
+    writer->WriteZeros(4);  // balance and reserved
+  }
+  writer->EndBox();
+
+  // A single data reference, flagged as being this file.
+  writer->StartBox(mp4::FOURCC_DINF);
+  writer->StartFullBox(mp4::FOURCC_DREF, 0, 0);
+  writer->Write4(1);
+  writer->StartFullBox(mp4::FOURCC_URL, 0, 1);
+  writer->EndBox();
+  writer->EndBox();
+  writer->EndBox();
+
+  writer->StartBox(mp4::FOURCC_STBL);
+  writer->StartFullBox(mp4::FOURCC_STSD, 0, 0);
+  writer->Write4(1);
+  if (is_video) {
+    writer->StartBox(video_sample_entry_.format);
+    WriteVideoSampleEntryFields(video_sample_entry_, writer);
+    if (video_codec_ == kCodecH264)
+      WriteBox(avc_config_, writer);
+    else
+      WriteBox(vp_config_, writer);
+    writer->EndBox();
+  } else {
+    WriteBox(audio_sample_entry_, audio_specific_config_, writer);
+  }
+  writer->EndBox();
+
+  // Samples are only described in the movie fragments.
+  for (mp4::FourCC type :
+       {mp4::FOURCC_STTS, mp4::FOURCC_STSC, mp4::FOURCC_STCO}) {
+    writer->StartFullBox(type, 0, 0);
+    writer->Write4(0);  // entry count
+    writer->EndBox();
+  }
+  writer->StartFullBox(mp4::FOURCC_STSZ, 0, 0);
+  writer->Write4(0);  // sample size
+  writer->Write4(0);  // sample count
+  writer->EndBox();
+  writer->EndBox();  // stbl
+
+  writer->EndBox();  // minf
+  writer->EndBox();  // mdia
+  writer->EndBox();  // trak
+}
+
+void Mp4Muxer::FlushOutputBuffer() {
+  if (output_buffer_.empty())
+    return;
+  write_data_callback_.Run(
+      base::StringPiece(reinterpret_cast<const char*>(output_buffer_.data()),
+                        output_buffer_.size()));
+  output_buffer_.clear();
+}
+
+}  // namespace media
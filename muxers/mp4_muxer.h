@@ -0,0 +1,166 @@
+// Copyright 2017 The Chromium Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#ifndef MEDIA_MUXERS_MP4_MUXER_H_
+#define MEDIA_MUXERS_MP4_MUXER_H_
+
+#include <stdint.h>
+
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "base/macros.h"
+#include "base/strings/string_piece.h"
+#include "base/threading/thread_checker.h"
+#include "base/time/time.h"
+#include "base/timer/elapsed_timer.h"
+#include "media/base/audio_codecs.h"
+#include "media/base/media_export.h"
+#include "media/base/video_codecs.h"
+#include "media/formats/mp4/box_definitions.h"
+#include "media/muxers/webm_muxer.h"
+
+namespace media {
+
+class AudioParameters;
+
+namespace mp4 {
+class BoxWriter;
+}  // namespace mp4
+
+// Mp4Muxer is a fragmented MP4 [1] muxer with the same interface as WebmMuxer,
+// so that recordings can be made in either container without remuxing.
+// It writes an initialization segment (ftyp and moov) followed by a movie
+// fragment (moof and mdat) per video GOP, or per second of an audio-only
+// recording, which can be appended to a MediaSource SourceBuffer as soon as
+// the WriteDataCB is run with it.
+// Clients push H.264 or VP9 video frames and AAC audio frames one by one via
+// OnEncoded{Video|Audio}(). H.264 is expected in Annex B format with SPS and
+// PPS before each key frame, and AAC as raw access units.
+// Mp4Muxer is designed for use on a single thread.
+// [1] ISO/IEC 14496-12 and ISO/IEC 14496-15.
+class MEDIA_EXPORT Mp4Muxer {
+ public:
+  using WriteDataCB = WebmMuxer::WriteDataCB;
+  using VideoParameters = WebmMuxer::VideoParameters;
+
+  // |video_codec| should coincide with whatever is sent in OnEncodedVideo(),
+  // and the same applies to audio.
+  Mp4Muxer(VideoCodec video_codec,
+           AudioCodec audio_codec,
+           bool has_video,
+           bool has_audio,
+           const WriteDataCB& write_data_callback);
+  // Writes out the last, incomplete, fragment.
+  ~Mp4Muxer();
+
+  // Functions to add video and audio frames with |encoded_data.data()| to the
+  // current fragment. Either one returns true on success. Video frames before
+  // the first key frame are dropped, since a fragment must start with one.
+  // |encoded_alpha| is not supported by MP4 and is ignored.
+  bool OnEncodedVideo(const VideoParameters& params,
+                      std::unique_ptr<std::string> encoded_data,
+                      std::unique_ptr<std::string> encoded_alpha,
+                      base::TimeTicks timestamp,
+                      bool is_key_frame);
+  bool OnEncodedAudio(const media::AudioParameters& params,
+                      std::unique_ptr<std::string> encoded_data,
+                      base::TimeTicks timestamp);
+
+  void Pause();
+  void Resume();
+
+ private:
+  friend class Mp4MuxerTest;
+
+  // Per track state. A sample's duration is only known once the next sample
+  // of the same track arrives, so the latest sample is held as pending until
+  // then, and is added to the current fragment with that duration.
+  struct Track {
+    Track();
+    ~Track();
+
+    // Zero if the track is not expected.
+    uint32_t track_id;
+    // Zero until the first frame of the track configures it.
+    uint32_t timescale;
+    // Duration given to the last sample of the recording.
+    uint32_t default_duration;
+    base::TimeTicks first_timestamp;
+
+    std::unique_ptr<std::string> pending_data;
+    uint64_t pending_decode_time;
+    bool pending_is_key_frame;
+
+    // The samples in the current fragment, and the time of the first one.
+    mp4::TrackFragmentRun run;
+    std::vector<std::unique_ptr<std::string>> fragment_data;
+    uint64_t fragment_decode_time;
+  };
+
+  // Set up the tracks from their first frame. Return false if the codec
+  // configuration cannot be signalled in MP4.
+  bool ConfigureVideoTrack(const VideoParameters& params,
+                           const std::string& key_frame);
+  bool ConfigureAudioTrack(const media::AudioParameters& params);
+
+  // Adds |data| as the pending sample of |track|, completing the previous one
+  // and, if |data| starts a new fragment, writing out the current one first.
+  void AddSample(Track* track,
+                 std::unique_ptr<std::string> data,
+                 base::TimeTicks timestamp,
+                 bool is_key_frame);
+  void CompletePendingSample(Track* track, uint32_t duration);
+
+  // Writes the samples in the current fragment, preceded by the
+  // initialization segment the first time. Unless |is_last_fragment|, nothing
+  // is written until all expected tracks are configured, since the
+  // initialization segment describes every track.
+  void WriteFragment(bool is_last_fragment);
+  void WriteInitSegment(mp4::BoxWriter* writer) const;
+  void WriteTrack(const Track& track, mp4::BoxWriter* writer) const;
+
+  // Runs |write_data_callback_| with the contents of |output_buffer_|.
+  void FlushOutputBuffer();
+
+  // Used to DCHECK that we are called on the correct thread.
+  base::ThreadChecker thread_checker_;
+
+  // Video and audio codecs configured on construction.
+  const VideoCodec video_codec_;
+  const AudioCodec audio_codec_;
+
+  const bool has_video_;
+  const bool has_audio_;
+
+  const WriteDataCB write_data_callback_;
+
+  Track video_track_;
+  Track audio_track_;
+
+  // Codec configuration, set by Configure{Video|Audio}Track().
+  mp4::VideoSampleEntry video_sample_entry_;
+  mp4::AVCDecoderConfigurationRecord avc_config_;
+  mp4::VPCodecConfigurationRecord vp_config_;
+  mp4::AudioSampleEntry audio_sample_entry_;
+  std::vector<uint8_t> audio_specific_config_;
+
+  bool init_segment_written_;
+  uint32_t sequence_number_;
+
+  // Variables to measure and accumulate, respectively, the time in pause state.
+  std::unique_ptr<base::ElapsedTimer> elapsed_time_in_pause_;
+  base::TimeDelta total_time_in_pause_;
+
+  // Boxes and small samples waiting to be passed to |write_data_callback_|.
+  // Its capacity is kept between fragments.
+  std::vector<uint8_t> output_buffer_;
+
+  DISALLOW_COPY_AND_ASSIGN(Mp4Muxer);
+};
+
+}  // namespace media
+
+#endif  // MEDIA_MUXERS_MP4_MUXER_H_
@@ -0,0 +1,158 @@
+// Copyright 2017 The Chromium Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include <memory>
+#include <string>
+
+#include "base/bind.h"
+#include "base/macros.h"
+#include "base/memory/ptr_util.h"
+#include "base/strings/string_piece.h"
+#include "base/time/time.h"
+#include "media/base/audio_parameters.h"
+#include "media/base/channel_layout.h"
+#include "media/base/video_frame.h"
+#include "media/muxers/mp4_muxer.h"
+#include "testing/gtest/include/gtest/gtest.h"
+#include "testing/perf/perf_test.h"
+#include "ui/gfx/geometry/size.h"
+
+namespace media {
+
+namespace {
+
+const int kNumFrames = 3000;
+const int kKeyFrameInterval = 100;
+const int kSampleRate = 48000;
+
+// Typical sizes of a 720p frame at ~2.5 Mbps and 30 fps, and of an AAC frame
+// at ~64 kbps.
+const size_t kVideoFrameSize = 10000;
+const size_t kAudioFrameSize = 170;
+
+// Annex B H.264 frame of |kVideoFrameSize| bytes, with an SPS and PPS in front
+// of the slice of key frames.
+std::string CreateH264Frame(bool is_key_frame) {
+  const char kStartCode[] = {0, 0, 0, 1};
+  const char kSps[] = {0x67, 0x42, static_cast<char>(0xc0), 0x1e,
+                       static_cast<char>(0xda), 0x02, static_cast<char>(0x80)};
+  const char kPps[] = {0x68, static_cast<char>(0xce), 0x3c,
+                       static_cast<char>(0x80)};
+  std::string frame;
+  if (is_key_frame) {
+    frame.append(kStartCode, sizeof(kStartCode));
+    frame.append(kSps, sizeof(kSps));
+    frame.append(kStartCode, sizeof(kStartCode));
+    frame.append(kPps, sizeof(kPps));
+  }
+  frame.append(kStartCode, sizeof(kStartCode));
+  frame.push_back(is_key_frame ? 0x65 : 0x41);
+  frame.resize(kVideoFrameSize, 'v');
+  return frame;
+}
+
+class Mp4MuxerPerfTest : public testing::Test {
+ public:
+  Mp4MuxerPerfTest()
+      : video_frame_(VideoFrame::CreateBlackFrame(gfx::Size(1280, 720))),
+        audio_params_(AudioParameters::AUDIO_PCM_LOW_LATENCY,
+                      CHANNEL_LAYOUT_STEREO,
+                      kSampleRate,
+                      16,
+                      1024),
+        bytes_written_(0),
+        write_calls_(0) {}
+
+  // Muxes |kNumFrames| video and/or audio frames and reports the throughput
+  // and the number of WriteDataCB calls per frame.
+  void RunBenchmark(const std::string& trace,
+                    VideoCodec video_codec,
+                    bool has_video,
+                    bool has_audio) {
+    bytes_written_ = 0;
+    write_calls_ = 0;
+    const std::string key_frame = video_codec == kCodecH264
+                                      ? CreateH264Frame(true)
+                                      : std::string(kVideoFrameSize, 'k');
+    const std::string delta_frame = video_codec == kCodecH264
+                                        ? CreateH264Frame(false)
+                                        : std::string(kVideoFrameSize, 'd');
+    const std::string audio_data(kAudioFrameSize, 'a');
+
+    const base::TimeTicks start = base::TimeTicks::Now();
+    {
+      Mp4Muxer muxer(video_codec, kCodecAAC, has_video, has_audio,
+                     base::Bind(&Mp4MuxerPerfTest::OnWrite,
+                                base::Unretained(this)));
+      const base::TimeTicks first_timestamp = base::TimeTicks::Now();
+      for (int i = 0; i < kNumFrames; ++i) {
+        if (has_audio) {
+          ASSERT_TRUE(muxer.OnEncodedAudio(
+              audio_params_, base::MakeUnique<std::string>(audio_data),
+              first_timestamp + base::TimeDelta::FromMicroseconds(
+                                    i * 1024 *
+                                    base::Time::kMicrosecondsPerSecond /
+                                    kSampleRate)));
+        }
+        if (has_video) {
+          const bool is_key_frame = i % kKeyFrameInterval == 0;
+          ASSERT_TRUE(muxer.OnEncodedVideo(
+              Mp4Muxer::VideoParameters(video_frame_),
+              base::MakeUnique<std::string>(is_key_frame ? key_frame
+                                                         : delta_frame),
+              nullptr,
+              first_timestamp + base::TimeDelta::FromMilliseconds(33 * i),
+              is_key_frame));
+        }
+      }
+    }
+    const base::TimeDelta elapsed = base::TimeTicks::Now() - start;
+
+    const int frames = (has_video + has_audio) * kNumFrames;
+    perf_test::PrintResult("mp4_muxer", trace, "throughput",
+                           bytes_written_ / elapsed.InSecondsF() / 1e6, "MB/s",
+                           true);
+    perf_test::PrintResult("mp4_muxer", trace, "frames",
+                           frames / elapsed.InSecondsF(), "frames/s", true);
+    perf_test::PrintResult("mp4_muxer", trace, "write_calls",
+                           static_cast<double>(write_calls_) / frames,
+                           "calls/frame", true);
+  }
+
+ private:
+  void OnWrite(base::StringPiece data) {
+    bytes_written_ += data.size();
+    ++write_calls_;
+  }
+
+  const scoped_refptr<VideoFrame> video_frame_;
+  const AudioParameters audio_params_;
+  int64_t bytes_written_;
+  int64_t write_calls_;
+
+  DISALLOW_COPY_AND_ASSIGN(Mp4MuxerPerfTest);
+};
+
+}  // namespace
+
+TEST_F(Mp4MuxerPerfTest, H264Video) {
+  RunBenchmark("_h264", kCodecH264, true, false);
+}
+
+TEST_F(Mp4MuxerPerfTest, Vp9Video) {
+  RunBenchmark("_vp9", kCodecVP9, true, false);
+}
+
+TEST_F(Mp4MuxerPerfTest, Audio) {
+  RunBenchmark("_aac", kUnknownVideoCodec, false, true);
+}
+
+TEST_F(Mp4MuxerPerfTest, AudioVideo) {
+  RunBenchmark("_h264_aac", kCodecH264, true, true);
+}
+
+}  // namespace media
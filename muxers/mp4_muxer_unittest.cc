@@ -0,0 +1,367 @@
+// Copyright 2017 The Chromium Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#include "media/muxers/mp4_muxer.h"
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "base/bind.h"
+#include "base/macros.h"
+#include "base/memory/ptr_util.h"
+#include "media/base/audio_codecs.h"
+#include "media/base/audio_decoder_config.h"
+#include "media/base/audio_parameters.h"
+#include "media/base/channel_layout.h"
+#include "media/base/media_log.h"
+#include "media/base/media_track.h"
+#include "media/base/media_tracks.h"
+#include "media/base/stream_parser_buffer.h"
+#include "media/base/text_track_config.h"
+#include "media/base/video_codecs.h"
+#include "media/base/video_decoder_config.h"
+#include "media/base/video_frame.h"
+#include "media/formats/mp4/es_descriptor.h"
+#include "media/formats/mp4/mp4_stream_parser.h"
+#include "testing/gtest/include/gtest/gtest.h"
+#include "ui/gfx/geometry/size.h"
+
+namespace media {
+
+namespace {
+
+// Larger than the samples Mp4Muxer coalesces with the boxes before them.
+const size_t kLargeFrameSize = 1024;
+
+const int kWidth = 320;
+const int kHeight = 240;
+// The frame rate Mp4Muxer assumes for frames which do not specify one.
+const int kFrameRate = 30;
+const int kSampleRate = 48000;
+
+// Baseline profile, level 3.0, SPS and PPS, only used for their headers.
+const uint8_t kSps[] = {0x67, 0x42, 0xc0, 0x1e, 0xda, 0x02, 0x80};
+const uint8_t kPps[] = {0x68, 0xce, 0x3c, 0x80};
+
+const char kStartCode[] = {0, 0, 0, 1};
+
+void AppendNalu(const uint8_t* nalu, size_t size, std::string* frame) {
+  frame->append(kStartCode, sizeof(kStartCode));
+  frame->append(reinterpret_cast<const char*>(nalu), size);
+}
+
+// Returns an Annex B access unit with a slice NALU of |slice_size| bytes,
+// preceded by the SPS and PPS for key frames.
+std::unique_ptr<std::string> CreateH264Frame(bool is_key_frame,
+                                             size_t slice_size) {
+  std::unique_ptr<std::string> frame(new std::string());
+  if (is_key_frame) {
+    AppendNalu(kSps, sizeof(kSps), frame.get());
+    AppendNalu(kPps, sizeof(kPps), frame.get());
+  }
+  std::vector<uint8_t> slice(slice_size, 0xab);
+  slice[0] = is_key_frame ? 0x65 : 0x41;
+  AppendNalu(slice.data(), slice.size(), frame.get());
+  return frame;
+}
+
+base::TimeDelta VideoFrameTimestamp(int index) {
+  return base::TimeDelta::FromMicroseconds(
+      index * base::Time::kMicrosecondsPerSecond / kFrameRate);
+}
+
+base::TimeDelta AudioFrameTimestamp(int index) {
+  return base::TimeDelta::FromMicroseconds(
+      index * 1024 * base::Time::kMicrosecondsPerSecond / kSampleRate);
+}
+
+}  // namespace
+
+class Mp4MuxerTest : public testing::Test {
+ public:
+  Mp4MuxerTest()
+      : video_params_(VideoFrame::CreateBlackFrame(gfx::Size(kWidth, kHeight))),
+        audio_params_(AudioParameters::AUDIO_PCM_LOW_LATENCY,
+                      CHANNEL_LAYOUT_STEREO,
+                      kSampleRate,
+                      16,
+                      1024),
+        start_(base::TimeTicks::Now()),
+        write_calls_(0),
+        video_track_id_(-1),
+        audio_track_id_(-1) {}
+
+  void CreateMuxer(VideoCodec video_codec,
+                   AudioCodec audio_codec,
+                   bool has_video,
+                   bool has_audio) {
+    muxer_ = base::MakeUnique<Mp4Muxer>(
+        video_codec, audio_codec, has_video, has_audio,
+        base::Bind(&Mp4MuxerTest::WriteCallback, base::Unretained(this)));
+  }
+
+  void WriteCallback(base::StringPiece data) {
+    ++write_calls_;
+    data.AppendToString(&output_);
+  }
+
+  bool AddVideoFrame(std::unique_ptr<std::string> data,
+                     int index,
+                     bool is_key_frame) {
+    return muxer_->OnEncodedVideo(video_params_, std::move(data), nullptr,
+                                  start_ + VideoFrameTimestamp(index),
+                                  is_key_frame);
+  }
+
+  bool AddAudioFrame(int index) {
+    return muxer_->OnEncodedAudio(
+        audio_params_, base::MakeUnique<std::string>(200, 'a'),
+        start_ + AudioFrameTimestamp(index));
+  }
+
+  // Destroys the muxer so that the last fragment is written, and parses
+  // everything it wrote back with MP4StreamParser.
+  bool FinishAndParse() {
+    muxer_.reset();
+
+    mp4::MP4StreamParser parser({mp4::kISO_14496_3}, false, false);
+    parser.Init(
+        base::Bind(&Mp4MuxerTest::OnInit, base::Unretained(this)),
+        base::Bind(&Mp4MuxerTest::OnNewConfig, base::Unretained(this)),
+        base::Bind(&Mp4MuxerTest::OnNewBuffers, base::Unretained(this)), true,
+        StreamParser::EncryptedMediaInitDataCB(),
+        base::Bind(&Mp4MuxerTest::OnNewSegment, base::Unretained(this)),
+        base::Bind(&Mp4MuxerTest::OnEndOfSegment, base::Unretained(this)),
+        &media_log_);
+    return parser.Parse(reinterpret_cast<const uint8_t*>(output_.data()),
+                        output_.size());
+  }
+
+ protected:
+  void OnInit(const StreamParser::InitParameters& params) {}
+
+  bool OnNewConfig(std::unique_ptr<MediaTracks> tracks,
+                   const StreamParser::TextTrackConfigMap& text_configs) {
+    for (const auto& track : tracks->tracks()) {
+      const StreamParser::TrackId track_id = track->bytestream_track_id();
+      if (track->type() == MediaTrack::Audio) {
+        audio_track_id_ = track_id;
+        audio_config_ = tracks->getAudioConfig(track_id);
+      } else if (track->type() == MediaTrack::Video) {
+        video_track_id_ = track_id;
+        video_config_ = tracks->getVideoConfig(track_id);
+      }
+    }
+    return true;
+  }
+
+  bool OnNewBuffers(const StreamParser::BufferQueueMap& buffer_queue_map) {
+    for (const auto& it : buffer_queue_map) {
+      auto* buffers = it.first == video_track_id_ ? &video_buffers_
+                                                  : &audio_buffers_;
+      buffers->insert(buffers->end(), it.second.begin(), it.second.end());
+    }
+    return true;
+  }
+
+  void OnNewSegment() {}
+  void OnEndOfSegment() {}
+
+  const Mp4Muxer::VideoParameters video_params_;
+  const AudioParameters audio_params_;
+  const base::TimeTicks start_;
+
+  std::unique_ptr<Mp4Muxer> muxer_;
+  std::string output_;
+  int write_calls_;
+
+  MediaLog media_log_;
+  StreamParser::TrackId video_track_id_;
+  StreamParser::TrackId audio_track_id_;
+  VideoDecoderConfig video_config_;
+  AudioDecoderConfig audio_config_;
+  std::vector<scoped_refptr<StreamParserBuffer>> video_buffers_;
+  std::vector<scoped_refptr<StreamParserBuffer>> audio_buffers_;
+
+ private:
+  DISALLOW_COPY_AND_ASSIGN(Mp4MuxerTest);
+};
+
+TEST_F(Mp4MuxerTest, H264RoundTrip) {
+  CreateMuxer(kCodecH264, kUnknownAudioCodec, true, false);
+
+  // Frames before the first key frame are dropped.
+  EXPECT_TRUE(AddVideoFrame(CreateH264Frame(false, 100), 0, false));
+  EXPECT_EQ(0, write_calls_);
+
+  // Three GOPs of three frames.
+  const int kNumFrames = 9;
+  const int kGopSize = 3;
+  std::vector<std::string> frames;
+  for (int i = 0; i < kNumFrames; ++i) {
+    const bool is_key_frame = i % kGopSize == 0;
+    std::unique_ptr<std::string> frame = CreateH264Frame(is_key_frame, 100);
+    frames.push_back(*frame);
+    EXPECT_TRUE(AddVideoFrame(std::move(frame), i, is_key_frame));
+  }
+  // The first two GOPs are written as soon as the next key frame arrives.
+  EXPECT_GT(write_calls_, 0);
+
+  ASSERT_TRUE(FinishAndParse());
+  ASSERT_TRUE(video_config_.IsValidConfig());
+  EXPECT_EQ(kCodecH264, video_config_.codec());
+  EXPECT_EQ(gfx::Size(kWidth, kHeight), video_config_.coded_size());
+  EXPECT_FALSE(audio_config_.IsValidConfig());
+
+  ASSERT_EQ(static_cast<size_t>(kNumFrames), video_buffers_.size());
+  for (int i = 0; i < kNumFrames; ++i) {
+    const StreamParserBuffer& buffer = *video_buffers_[i];
+    EXPECT_EQ(i % kGopSize == 0, buffer.is_key_frame()) << i;
+    EXPECT_EQ(VideoFrameTimestamp(i), buffer.timestamp()) << i;
+    // The parser converts samples back to Annex B, adding the parameter sets
+    // to key frames in front of those already there.
+    const std::string data(reinterpret_cast<const char*>(buffer.data()),
+                           buffer.data_size());
+    if (buffer.is_key_frame()) {
+      EXPECT_EQ(frames[i], data.substr(data.size() - frames[i].size())) << i;
+    } else {
+      EXPECT_EQ(frames[i], data) << i;
+    }
+  }
+}
+
+TEST_F(Mp4MuxerTest, H264WithShortStartCodes) {
+  CreateMuxer(kCodecH264, kUnknownAudioCodec, true, false);
+
+  std::unique_ptr<std::string> frame = CreateH264Frame(true, 100);
+  // Drop the leading zero of the slice's start code.
+  const size_t slice_offset = frame->size() - 100 - sizeof(kStartCode);
+  frame->erase(slice_offset, 1);
+  EXPECT_TRUE(AddVideoFrame(std::move(frame), 0, true));
+  EXPECT_TRUE(AddVideoFrame(CreateH264Frame(false, 100), 1, false));
+
+  ASSERT_TRUE(FinishAndParse());
+  ASSERT_EQ(2u, video_buffers_.size());
+  EXPECT_EQ(CreateH264Frame(false, 100)->size(),
+            video_buffers_[1]->data_size());
+}
+
+TEST_F(Mp4MuxerTest, H264KeyFrameWithoutParameterSets) {
+  CreateMuxer(kCodecH264, kUnknownAudioCodec, true, false);
+
+  std::unique_ptr<std::string> frame(new std::string());
+  const uint8_t kIdrSlice[] = {0x65, 0x88, 0x84};
+  AppendNalu(kIdrSlice, sizeof(kIdrSlice), frame.get());
+  EXPECT_FALSE(AddVideoFrame(std::move(frame), 0, true));
+}
+
+TEST_F(Mp4MuxerTest, Vp9RoundTrip) {
+  CreateMuxer(kCodecVP9, kUnknownAudioCodec, true, false);
+
+  const int kNumFrames = 6;
+  std::vector<std::string> frames;
+  for (int i = 0; i < kNumFrames; ++i) {
+    // Mix large frames, passed on as they are, with small ones.
+    std::string frame(i % 2 ? 100 : kLargeFrameSize, static_cast<char>(i));
+    frames.push_back(frame);
+    EXPECT_TRUE(
+        AddVideoFrame(base::MakeUnique<std::string>(frame), i, i % 3 == 0));
+  }
+
+  ASSERT_TRUE(FinishAndParse());
+  ASSERT_TRUE(video_config_.IsValidConfig());
+  EXPECT_EQ(kCodecVP9, video_config_.codec());
+  EXPECT_EQ(VP9PROFILE_PROFILE0, video_config_.profile());
+
+  ASSERT_EQ(static_cast<size_t>(kNumFrames), video_buffers_.size());
+  for (int i = 0; i < kNumFrames; ++i) {
+    const StreamParserBuffer& buffer = *video_buffers_[i];
+    EXPECT_EQ(i % 3 == 0, buffer.is_key_frame()) << i;
+    EXPECT_EQ(VideoFrameTimestamp(i), buffer.timestamp()) << i;
+    EXPECT_EQ(frames[i], std::string(reinterpret_cast<const char*>(
+                                         buffer.data()),
+                                     buffer.data_size()))
+        << i;
+  }
+}
+
+TEST_F(Mp4MuxerTest, AacRoundTrip) {
+  CreateMuxer(kUnknownVideoCodec, kCodecAAC, false, true);
+
+  // Long enough for several fragments.
+  const int kNumFrames = 150;
+  for (int i = 0; i < kNumFrames; ++i)
+    EXPECT_TRUE(AddAudioFrame(i));
+  EXPECT_GT(write_calls_, 0);
+
+  ASSERT_TRUE(FinishAndParse());
+  ASSERT_TRUE(audio_config_.IsValidConfig());
+  EXPECT_EQ(kCodecAAC, audio_config_.codec());
+  EXPECT_EQ(kSampleRate, audio_config_.samples_per_second());
+  EXPECT_EQ(CHANNEL_LAYOUT_STEREO, audio_config_.channel_layout());
+  EXPECT_FALSE(video_config_.IsValidConfig());
+
+  ASSERT_EQ(static_cast<size_t>(kNumFrames), audio_buffers_.size());
+  for (int i = 0; i < kNumFrames; ++i) {
+    EXPECT_TRUE(audio_buffers_[i]->is_key_frame()) << i;
+    EXPECT_NEAR(AudioFrameTimestamp(i).InMicroseconds(),
+                audio_buffers_[i]->timestamp().InMicroseconds(), 1)
+        << i;
+  }
+}
+
+TEST_F(Mp4MuxerTest, UnsupportedAudioSampleRate) {
+  CreateMuxer(kUnknownVideoCodec, kCodecAAC, false, true);
+  const AudioParameters params(AudioParameters::AUDIO_PCM_LOW_LATENCY,
+                               CHANNEL_LAYOUT_STEREO, 12345, 16, 1024);
+  EXPECT_FALSE(muxer_->OnEncodedAudio(params,
+                                      base::MakeUnique<std::string>(10, 'a'),
+                                      start_));
+}
+
+TEST_F(Mp4MuxerTest, AudioAndVideoRoundTrip) {
+  CreateMuxer(kCodecH264, kCodecAAC, true, true);
+
+  // Audio starts before video; nothing is written until both tracks are
+  // configured, since the initialization segment describes both.
+  const int kNumAudioFrames = 50;
+  const int kNumVideoFrames = 30;
+  int audio_frame = 0;
+  EXPECT_TRUE(AddAudioFrame(audio_frame++));
+  for (int i = 0; i < kNumVideoFrames; ++i) {
+    EXPECT_TRUE(AddVideoFrame(CreateH264Frame(i % 10 == 0, kLargeFrameSize),
+                              i, i % 10 == 0));
+    while (audio_frame < kNumAudioFrames &&
+           AudioFrameTimestamp(audio_frame) <= VideoFrameTimestamp(i)) {
+      EXPECT_TRUE(AddAudioFrame(audio_frame++));
+    }
+  }
+  while (audio_frame < kNumAudioFrames)
+    EXPECT_TRUE(AddAudioFrame(audio_frame++));
+
+  ASSERT_TRUE(FinishAndParse());
+  EXPECT_EQ(4u, output_.find("ftyp"));
+  EXPECT_TRUE(video_config_.IsValidConfig());
+  EXPECT_TRUE(audio_config_.IsValidConfig());
+  EXPECT_EQ(static_cast<size_t>(kNumVideoFrames), video_buffers_.size());
+  EXPECT_EQ(static_cast<size_t>(kNumAudioFrames), audio_buffers_.size());
+}
+
+TEST_F(Mp4MuxerTest, LastFragmentWrittenWithoutAllTracks) {
+  CreateMuxer(kCodecH264, kCodecAAC, true, true);
+  for (int i = 0; i < 10; ++i)
+    EXPECT_TRUE(AddAudioFrame(i));
+  EXPECT_EQ(0, write_calls_);
+
+  ASSERT_TRUE(FinishAndParse());
+  EXPECT_FALSE(video_config_.IsValidConfig());
+  EXPECT_TRUE(audio_config_.IsValidConfig());
+  EXPECT_EQ(10u, audio_buffers_.size());
+}
+
+}  // namespace media
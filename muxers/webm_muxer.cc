@@ -68,6 +68,10 @@ static double GetFrameRate(const WebmMuxer::VideoParameters& params) {
   return frame_rate;
 }
 
+// Writes up to this size, i.e. all but the frame data of all but the smallest
+// frames, are coalesced before being passed to the WriteDataCB.
+const size_t kMaxBufferedWriteSize = 512;
+
 static const char kH264CodecId[] = "V_MPEG4/ISO/AVC";
 static const char kPcmCodecId[] = "A_PCM/FLOAT/IEEE";
 
@@ -136,6 +140,7 @@ WebmMuxer::~WebmMuxer() {
   // stream, but is a good practice.
   DCHECK(thread_checker_.CalledOnValidThread());
   segment_.Finalize();
+  FlushBufferedData();
 }
 
 bool WebmMuxer::OnEncodedVideo(const VideoParameters& params,
@@ -175,7 +180,8 @@ bool WebmMuxer::OnEncodedVideo(const VideoParameters& params,
   // Any saved encoded video frames must have been dumped in OnEncodedAudio();
   DCHECK(encoded_frames_queue_.empty());
 
-  return AddFrame(std::move(encoded_data), std::move(encoded_alpha),
+  return AddFrame(*encoded_data,
+                  encoded_alpha ? *encoded_alpha : base::StringPiece(),
                   video_track_index_, timestamp - first_frame_timestamp_video_,
                   is_key_frame);
 }
@@ -201,20 +207,17 @@ bool WebmMuxer::OnEncodedAudio(const media::AudioParameters& params,
 
   // Dump all saved encoded video frames if any.
   while (!encoded_frames_queue_.empty()) {
+    const EncodedVideoFrame& frame = *encoded_frames_queue_.front();
     const bool res = AddFrame(
-        base::MakeUnique<std::string>(*encoded_frames_queue_.front()->data),
-        encoded_frames_queue_.front()->alpha_data
-            ? base::MakeUnique<std::string>(
-                  *encoded_frames_queue_.front()->alpha_data)
-            : nullptr,
-        video_track_index_,
-        encoded_frames_queue_.front()->timestamp - first_frame_timestamp_video_,
-        encoded_frames_queue_.front()->is_keyframe);
+        *frame.data,
+        frame.alpha_data ? *frame.alpha_data : base::StringPiece(),
+        video_track_index_, frame.timestamp - first_frame_timestamp_video_,
+        frame.is_keyframe);
     if (!res)
       return false;
     encoded_frames_queue_.pop_front();
   }
-  return AddFrame(std::move(encoded_data), nullptr, audio_track_index_,
+  return AddFrame(*encoded_data, base::StringPiece(), audio_track_index_,
                   timestamp - first_frame_timestamp_audio_,
                   true /* is_key_frame -- always true for audio */);
 }
@@ -317,12 +320,28 @@ void WebmMuxer::AddAudioTrack(const media::AudioParameters& params) {
 mkvmuxer::int32 WebmMuxer::Write(const void* buf, mkvmuxer::uint32 len) {
   DCHECK(thread_checker_.CalledOnValidThread());
   DCHECK(buf);
-  write_data_callback_.Run(
-      base::StringPiece(reinterpret_cast<const char*>(buf), len));
   position_ += len;
+
+  const char* const data = reinterpret_cast<const char*>(buf);
+  if (len <= kMaxBufferedWriteSize) {
+    buffered_data_.append(data, len);
+    return 0;
+  }
+
+  // Large writes are frame data: pass them on as they are, in order.
+  FlushBufferedData();
+  write_data_callback_.Run(base::StringPiece(data, len));
   return 0;
 }
 
+void WebmMuxer::FlushBufferedData() {
+  DCHECK(thread_checker_.CalledOnValidThread());
+  if (buffered_data_.empty())
+    return;
+  write_data_callback_.Run(buffered_data_);
+  buffered_data_.clear();
+}
+
 mkvmuxer::int64 WebmMuxer::Position() const {
   return position_.ValueOrDie();
 }
@@ -343,8 +362,8 @@ void WebmMuxer::ElementStartNotify(mkvmuxer::uint64 element_id,
       << "Can't go back in a live WebM stream.";
 }
 
-bool WebmMuxer::AddFrame(std::unique_ptr<std::string> encoded_data,
-                         std::unique_ptr<std::string> encoded_alpha,
+bool WebmMuxer::AddFrame(base::StringPiece encoded_data,
+                         base::StringPiece encoded_alpha,
                          uint8_t track_index,
                          base::TimeDelta timestamp,
                          bool is_key_frame) {
@@ -361,25 +380,29 @@ bool WebmMuxer::AddFrame(std::unique_ptr<std::string> encoded_data,
     return false;
   }
 
-  DCHECK(encoded_data->data());
-  if (!encoded_alpha || encoded_alpha->empty()) {
-    return segment_.AddFrame(
-        reinterpret_cast<const uint8_t*>(encoded_data->data()),
-        encoded_data->size(), track_index,
+  DCHECK(encoded_data.data());
+  bool result;
+  if (encoded_alpha.empty()) {
+    result = segment_.AddFrame(
+        reinterpret_cast<const uint8_t*>(encoded_data.data()),
+        encoded_data.size(), track_index,
+        most_recent_timestamp_.InMicroseconds() *
+            base::Time::kNanosecondsPerMicrosecond,
+        is_key_frame);
+  } else {
+    result = segment_.AddFrameWithAdditional(
+        reinterpret_cast<const uint8_t*>(encoded_data.data()),
+        encoded_data.size(),
+        reinterpret_cast<const uint8_t*>(encoded_alpha.data()),
+        encoded_alpha.size(), 1 /* add_id */, track_index,
         most_recent_timestamp_.InMicroseconds() *
             base::Time::kNanosecondsPerMicrosecond,
         is_key_frame);
   }
 
-  DCHECK(encoded_alpha->data());
-  return segment_.AddFrameWithAdditional(
-      reinterpret_cast<const uint8_t*>(encoded_data->data()),
-      encoded_data->size(),
-      reinterpret_cast<const uint8_t*>(encoded_alpha->data()),
-      encoded_alpha->size(), 1 /* add_id */, track_index,
-      most_recent_timestamp_.InMicroseconds() *
-          base::Time::kNanosecondsPerMicrosecond,
-      is_key_frame);
+  // libwebm has written everything it will for this frame.
+  FlushBufferedData();
+  return result;
 }
 
 WebmMuxer::EncodedVideoFrame::EncodedVideoFrame(
@@ -8,6 +8,7 @@
 #include <stdint.h>
 
 #include <memory>
+#include <string>
 
 #include "base/callback.h"
 #include "base/containers/circular_deque.h"
@@ -39,7 +40,9 @@ class AudioParameters;
 // Trailer.
 // Clients will push encoded VPx or AV1 video frames and Opus or PCM audio
 // frames one by one via OnEncoded{Video|Audio}(). libwebm will eventually ping
-// the WriteDataCB passed on contructor with the wrapped encoded data.
+// the WriteDataCB passed on contructor with the wrapped encoded data. The many
+// small writes libwebm makes for element headers are coalesced and passed on
+// once per frame, while large frame payloads are passed on without a copy.
 // WebmMuxer is designed for use on a single thread.
 // [1] http://www.webmproject.org/docs/container/
 // [2] http://www.matroska.org/technical/specs/index.html
@@ -68,7 +71,9 @@ class MEDIA_EXPORT WebmMuxer : public mkvmuxer::IMkvWriter {
   ~WebmMuxer() override;
 
   // Functions to add video and audio frames with |encoded_data.data()|
-  // to WebM Segment. Either one returns true on success.
+  // to WebM Segment. Either one returns true on success. Ownership of the
+  // encoded data is taken so that it can be held, without a copy, while video
+  // waits for the first audio frame.
   // |encoded_alpha| represents the encode output of alpha channel when
   // available, can be nullptr otherwise.
   bool OnEncodedVideo(const VideoParameters& params,
@@ -96,7 +101,8 @@ class MEDIA_EXPORT WebmMuxer : public mkvmuxer::IMkvWriter {
   void AddVideoTrack(const gfx::Size& frame_size, double frame_rate);
   void AddAudioTrack(const media::AudioParameters& params);
 
-  // IMkvWriter interface.
+  // IMkvWriter interface. Writes no larger than |kMaxBufferedWriteSize| are
+  // buffered until FlushBufferedData().
   mkvmuxer::int32 Write(const void* buf, mkvmuxer::uint32 len) override;
   mkvmuxer::int64 Position() const override;
   mkvmuxer::int32 Position(mkvmuxer::int64 position) override;
@@ -104,9 +110,13 @@ class MEDIA_EXPORT WebmMuxer : public mkvmuxer::IMkvWriter {
   void ElementStartNotify(mkvmuxer::uint64 element_id,
                           mkvmuxer::int64 position) override;
 
-  // Helper to simplify saving frames. Returns true on success.
-  bool AddFrame(std::unique_ptr<std::string> encoded_data,
-                std::unique_ptr<std::string> encoded_alpha_data,
+  // Runs |write_data_callback_| with any data buffered by Write().
+  void FlushBufferedData();
+
+  // Helper to simplify saving frames. |encoded_alpha_data| may be empty.
+  // Returns true on success.
+  bool AddFrame(base::StringPiece encoded_data,
+                base::StringPiece encoded_alpha_data,
                 uint8_t track_index,
                 base::TimeDelta timestamp,
                 bool is_key_frame);
@@ -140,9 +150,14 @@ class MEDIA_EXPORT WebmMuxer : public mkvmuxer::IMkvWriter {
   // Callback to dump written data as being called by libwebm.
   const WriteDataCB write_data_callback_;
 
-  // Rolling counter of the position in bytes of the written goo.
+  // Rolling counter of the position in bytes of the written goo, including
+  // |buffered_data_|.
   base::CheckedNumeric<mkvmuxer::int64> position_;
 
+  // Small writes not yet passed to |write_data_callback_|. Its capacity is
+  // kept between flushes.
+  std::string buffered_data_;
+
   // The MkvMuxer active element.
   mkvmuxer::Segment segment_;
   // Flag to force the next call to a |segment_| method to return false.
@@ -0,0 +1,119 @@
+// Copyright 2017 The Chromium Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include <memory>
+#include <string>
+
+#include "base/bind.h"
+#include "base/macros.h"
+#include "base/memory/ptr_util.h"
+#include "base/strings/string_piece.h"
+#include "base/time/time.h"
+#include "media/base/audio_parameters.h"
+#include "media/base/channel_layout.h"
+#include "media/base/video_frame.h"
+#include "media/muxers/webm_muxer.h"
+#include "testing/gtest/include/gtest/gtest.h"
+#include "testing/perf/perf_test.h"
+#include "ui/gfx/geometry/size.h"
+
+namespace media {
+
+namespace {
+
+const int kNumFrames = 3000;
+const int kKeyFrameInterval = 100;
+
+// Typical sizes of a 720p VP8 frame at ~2.5 Mbps and 30 fps, and of a 20 ms
+// Opus packet at ~64 kbps.
+const size_t kVideoFrameSize = 10000;
+const size_t kAudioFrameSize = 160;
+
+class WebmMuxerPerfTest : public testing::Test {
+ public:
+  WebmMuxerPerfTest()
+      : video_frame_(VideoFrame::CreateBlackFrame(gfx::Size(1280, 720))),
+        audio_params_(AudioParameters::AUDIO_PCM_LOW_LATENCY,
+                      CHANNEL_LAYOUT_STEREO,
+                      48000,
+                      16,
+                      960),
+        bytes_written_(0),
+        write_calls_(0) {}
+
+  // Muxes |kNumFrames| video and/or audio frames and reports the throughput
+  // and the number of WriteDataCB calls per frame.
+  void RunBenchmark(const std::string& trace, bool has_video, bool has_audio) {
+    bytes_written_ = 0;
+    write_calls_ = 0;
+    const std::string video_data(kVideoFrameSize, 'v');
+    const std::string audio_data(kAudioFrameSize, 'a');
+
+    const base::TimeTicks start = base::TimeTicks::Now();
+    {
+      WebmMuxer muxer(kCodecVP8, kCodecOpus, has_video, has_audio,
+                      base::Bind(&WebmMuxerPerfTest::OnWrite,
+                                 base::Unretained(this)));
+      const base::TimeTicks first_timestamp = base::TimeTicks::Now();
+      for (int i = 0; i < kNumFrames; ++i) {
+        const base::TimeTicks timestamp =
+            first_timestamp + base::TimeDelta::FromMilliseconds(20 * i);
+        if (has_audio) {
+          ASSERT_TRUE(muxer.OnEncodedAudio(
+              audio_params_, base::MakeUnique<std::string>(audio_data),
+              timestamp));
+        }
+        if (has_video) {
+          ASSERT_TRUE(muxer.OnEncodedVideo(
+              WebmMuxer::VideoParameters(video_frame_),
+              base::MakeUnique<std::string>(video_data), nullptr, timestamp,
+              i % kKeyFrameInterval == 0));
+        }
+      }
+    }
+    const base::TimeDelta elapsed = base::TimeTicks::Now() - start;
+
+    const int frames = (has_video + has_audio) * kNumFrames;
+    perf_test::PrintResult("webm_muxer", trace, "throughput",
+                           bytes_written_ / elapsed.InSecondsF() / 1e6, "MB/s",
+                           true);
+    perf_test::PrintResult("webm_muxer", trace, "frames",
+                           frames / elapsed.InSecondsF(), "frames/s", true);
+    perf_test::PrintResult("webm_muxer", trace, "write_calls",
+                           static_cast<double>(write_calls_) / frames,
+                           "calls/frame", true);
+  }
+
+ private:
+  void OnWrite(base::StringPiece data) {
+    bytes_written_ += data.size();
+    ++write_calls_;
+  }
+
+  const scoped_refptr<VideoFrame> video_frame_;
+  const AudioParameters audio_params_;
+  int64_t bytes_written_;
+  int64_t write_calls_;
+
+  DISALLOW_COPY_AND_ASSIGN(WebmMuxerPerfTest);
+};
+
+}  // namespace
+
+TEST_F(WebmMuxerPerfTest, Video) {
+  RunBenchmark("_video", true, false);
+}
+
+TEST_F(WebmMuxerPerfTest, Audio) {
+  RunBenchmark("_audio", false, true);
+}
+
+TEST_F(WebmMuxerPerfTest, AudioVideo) {
+  RunBenchmark("_audio_video", true, true);
+}
+
+}  // namespace media
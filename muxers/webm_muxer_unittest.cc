@@ -35,6 +35,10 @@ using ::testing::WithArgs;
 
 namespace media {
 
+// Larger than the writes WebmMuxer coalesces, so that frames of this size are
+// passed to the WriteCallback on their own.
+const size_t kLargeFrameSize = 1024;
+
 struct TestParams {
   VideoCodec video_codec;
   AudioCodec audio_codec;
@@ -78,6 +82,8 @@ class WebmMuxerTest : public TestWithParam<TestParams> {
     return webm_muxer_.Write(buf, len);
   }
 
+  void WebmMuxerFlush() { webm_muxer_.FlushBufferedData(); }
+
   WebmMuxer webm_muxer_;
 
   size_t last_encoded_length_;
@@ -92,10 +98,25 @@ class WebmMuxerTest : public TestWithParam<TestParams> {
 TEST_P(WebmMuxerTest, Write) {
   const base::StringPiece encoded_data("abcdefghijklmnopqrstuvwxyz");
 
-  EXPECT_CALL(*this, WriteCallback(encoded_data));
+  // Small writes are buffered until flushed, but counted right away.
+  EXPECT_CALL(*this, WriteCallback(_)).Times(0);
   WebmMuxerWrite(encoded_data.data(), encoded_data.size());
-
   EXPECT_EQ(GetWebmMuxerPosition(), static_cast<int64_t>(encoded_data.size()));
+  Mock::VerifyAndClearExpectations(this);
+
+  EXPECT_CALL(*this, WriteCallback(encoded_data));
+  WebmMuxerFlush();
+  Mock::VerifyAndClearExpectations(this);
+
+  // Large writes are passed on as they are, after any buffered data.
+  const std::string large_data(kLargeFrameSize, 'a');
+  InSequence s;
+  EXPECT_CALL(*this, WriteCallback(encoded_data));
+  EXPECT_CALL(*this, WriteCallback(Eq(large_data)));
+  WebmMuxerWrite(encoded_data.data(), encoded_data.size());
+  WebmMuxerWrite(large_data.data(), large_data.size());
+  EXPECT_EQ(GetWebmMuxerPosition(),
+            static_cast<int64_t>(2 * encoded_data.size() + large_data.size()));
 }
 
 // This test sends two frames and checks that the WriteCallback is called with
@@ -107,7 +128,7 @@ TEST_P(WebmMuxerTest, OnEncodedVideoTwoFrames) {
   const gfx::Size frame_size(160, 80);
   const scoped_refptr<VideoFrame> video_frame =
       VideoFrame::CreateBlackFrame(frame_size);
-  const std::string encoded_data("abcdefghijklmnopqrstuvwxyz");
+  const std::string encoded_data(kLargeFrameSize, 'a');
 
   EXPECT_CALL(*this, WriteCallback(_))
       .Times(AtLeast(1))
@@ -219,7 +240,7 @@ TEST_P(WebmMuxerTest, OnEncodedAudioTwoFrames) {
       media::CHANNEL_LAYOUT_MONO, sample_rate, bits_per_sample,
       frames_per_buffer);
 
-  const std::string encoded_data("abcdefghijklmnopqrstuvwxyz");
+  const std::string encoded_data(kLargeFrameSize, 'a');
 
   EXPECT_CALL(*this, WriteCallback(_))
       .Times(AtLeast(1))
@@ -272,7 +293,7 @@ TEST_P(WebmMuxerTest, VideoIsStoredWhileWaitingForAudio) {
   const gfx::Size frame_size(160, 80);
   const scoped_refptr<VideoFrame> video_frame =
       VideoFrame::CreateBlackFrame(frame_size);
-  const std::string encoded_video("thisisanencodedvideopacket");
+  const std::string encoded_video(kLargeFrameSize, 'v');
   EXPECT_TRUE(webm_muxer_.OnEncodedVideo(
       WebmMuxer::VideoParameters(video_frame),
       base::WrapUnique(new std::string(encoded_video)), nullptr,
@@ -293,7 +314,7 @@ TEST_P(WebmMuxerTest, VideoIsStoredWhileWaitingForAudio) {
       media::AudioParameters::Format::AUDIO_PCM_LOW_LATENCY,
       media::CHANNEL_LAYOUT_MONO, sample_rate, bits_per_sample,
       frames_per_buffer);
-  const std::string encoded_audio("thisisanencodedaudiopacket");
+  const std::string encoded_audio(kLargeFrameSize, 'a');
 
   // Force one libwebm error and verify OnEncodedAudio() fails.
   webm_muxer_.ForceOneLibWebmErrorForTesting();
@@ -316,6 +337,41 @@ TEST_P(WebmMuxerTest, VideoIsStoredWhileWaitingForAudio) {
       base::TimeTicks::Now()));
 }
 
+// This test checks that the headers and payload of a small frame are passed to
+// the WriteCallback in a single call.
+TEST_P(WebmMuxerTest, SmallFrameIsWrittenInOneCall) {
+  if (GetParam().num_audio_tracks > 0)
+    return;
+
+  const gfx::Size frame_size(160, 80);
+  const scoped_refptr<VideoFrame> video_frame =
+      VideoFrame::CreateBlackFrame(frame_size);
+  const std::string encoded_data("abcdefghijklmnopqrstuvwxyz");
+
+  EXPECT_CALL(*this, WriteCallback(_))
+      .Times(1)
+      .WillOnce(WithArgs<0>(Invoke(this, &WebmMuxerTest::SaveEncodedDataLen)));
+  EXPECT_TRUE(webm_muxer_.OnEncodedVideo(
+      WebmMuxer::VideoParameters(video_frame),
+      base::MakeUnique<std::string>(encoded_data), nullptr,
+      base::TimeTicks::Now(), true /* keyframe */));
+  EXPECT_EQ(GetWebmMuxerPosition(), accumulated_position_);
+  Mock::VerifyAndClearExpectations(this);
+
+  EXPECT_CALL(*this, WriteCallback(_))
+      .Times(1)
+      .WillOnce(WithArgs<0>(Invoke(this, &WebmMuxerTest::SaveEncodedDataLen)));
+  EXPECT_TRUE(webm_muxer_.OnEncodedVideo(
+      WebmMuxer::VideoParameters(video_frame),
+      base::MakeUnique<std::string>(encoded_data), nullptr,
+      base::TimeTicks::Now(), false /* keyframe */));
+
+  // A SimpleBlock header of 6B followed by |encoded_data|.
+  const uint32_t kSimpleBlockSize = 6u;
+  EXPECT_EQ(kSimpleBlockSize + encoded_data.size(), last_encoded_length_);
+  EXPECT_EQ(GetWebmMuxerPosition(), accumulated_position_);
+}
+
 const TestParams kTestCases[] = {
     {kCodecVP8, kCodecOpus, 1 /* num_video_tracks */, 0 /*num_audio_tracks*/},
     {kCodecVP8, kCodecOpus, 0, 1},
@@ -130,13 +130,15 @@ void CourierRenderer::Initialize(MediaResource* media_resource,
   // Create audio mojo data pipe handles if audio is available.
   std::unique_ptr<mojo::DataPipe> audio_data_pipe;
   if (audio_demuxer_stream) {
-    audio_data_pipe = base::WrapUnique(DemuxerStreamAdapter::CreateDataPipe());
+    audio_data_pipe = base::WrapUnique(
+        DemuxerStreamAdapter::CreateDataPipe(audio_demuxer_stream));
   }
 
   // Create video mojo data pipe handles if video is available.
   std::unique_ptr<mojo::DataPipe> video_data_pipe;
   if (video_demuxer_stream) {
-    video_data_pipe = base::WrapUnique(DemuxerStreamAdapter::CreateDataPipe());
+    video_data_pipe = base::WrapUnique(
+        DemuxerStreamAdapter::CreateDataPipe(video_demuxer_stream));
   }
 
   // Establish remoting data pipe connection using main thread.
@@ -4,6 +4,10 @@
 
 #include "media/remoting/demuxer_stream_adapter.h"
 
+#include <string.h>
+
+#include <algorithm>
+
 #include "base/base64.h"
 #include "base/bind.h"
 #include "base/callback_helpers.h"
@@ -20,11 +24,54 @@
 namespace media {
 namespace remoting {
 
+namespace {
+
+// Bounds of the data pipe capacity. The lower bound leaves room for the large
+// key frames of low bitrate streams, the upper bound limits the memory held
+// for 4K streams.
+constexpr uint32_t kMinDataPipeCapacity = 128 * 1024;
+constexpr uint32_t kMaxDataPipeCapacity = 4 * 1024 * 1024;
+
+// Rough size of compressed video at 30 FPS, typical of H.264 and VP9 streams.
+constexpr double kVideoBitsPerPixel = 0.1;
+constexpr int kVideoFramesPerSecond = 30;
+
+// Estimates the bitrate of |demuxer_stream| from its decoder config.
+int64_t EstimateBitrate(DemuxerStream* demuxer_stream) {
+  switch (demuxer_stream->type()) {
+    case DemuxerStream::AUDIO: {
+      // The uncompressed bitrate, which bounds that of any audio codec.
+      const AudioDecoderConfig config = demuxer_stream->audio_decoder_config();
+      return static_cast<int64_t>(config.bytes_per_frame()) *
+             config.samples_per_second() * 8;
+    }
+    case DemuxerStream::VIDEO: {
+      const VideoDecoderConfig config = demuxer_stream->video_decoder_config();
+      return static_cast<int64_t>(config.coded_size().GetArea() *
+                                  kVideoFramesPerSecond * kVideoBitsPerPixel);
+    }
+    default:
+      NOTREACHED();
+      return 0;
+  }
+}
+
+}  // namespace
+
 // static
-mojo::DataPipe* DemuxerStreamAdapter::CreateDataPipe() {
-  // Capacity in bytes for Mojo data pipe.
-  constexpr int kMojoDataPipeCapacityInBytes = 512 * 1024;
-  return new mojo::DataPipe(kMojoDataPipeCapacityInBytes);
+uint32_t DemuxerStreamAdapter::GetDataPipeCapacity(int64_t bits_per_second) {
+  const int64_t bytes_per_second = bits_per_second / 8;
+  return static_cast<uint32_t>(
+      std::max<int64_t>(kMinDataPipeCapacity,
+                        std::min<int64_t>(kMaxDataPipeCapacity,
+                                          bytes_per_second)));
+}
+
+// static
+mojo::DataPipe* DemuxerStreamAdapter::CreateDataPipe(
+    DemuxerStream* demuxer_stream) {
+  return new mojo::DataPipe(
+      GetDataPipeCapacity(EstimateBitrate(demuxer_stream)));
 }
 
 DemuxerStreamAdapter::DemuxerStreamAdapter(
@@ -48,8 +95,10 @@ DemuxerStreamAdapter::DemuxerStreamAdapter(
       remote_callback_handle_(RpcBroker::kInvalidHandle),
       read_until_callback_handle_(RpcBroker::kInvalidHandle),
       read_until_count_(0),
+      read_until_bytes_sent_(0),
       last_count_(0),
       pending_flush_(false),
+      pending_frame_size_(0),
       current_pending_frame_offset_(0),
       pending_frame_is_eos_(false),
       write_watcher_(FROM_HERE, mojo::SimpleWatcher::ArmingPolicy::MANUAL),
@@ -99,9 +148,7 @@ base::Optional<uint32_t> DemuxerStreamAdapter::SignalFlush(bool flushing) {
     return base::nullopt;
 
   // Cleans up pending frame data.
-  pending_frame_.clear();
-  current_pending_frame_offset_ = 0;
-  pending_frame_is_eos_ = false;
+  ResetPendingFrame();
   // Invalidates pending Read() tasks.
   request_buffer_weak_factory_.InvalidateWeakPtrs();
 
@@ -237,7 +284,17 @@ void DemuxerStreamAdapter::ReadUntil(std::unique_ptr<pb::RpcMessage> message) {
 
   read_until_count_ = rpc_message.count();
   read_until_callback_handle_ = rpc_message.callback_handle();
-  RequestBuffer();
+  if (rpc_message.has_buffer_headroom())
+    read_until_headroom_ = rpc_message.buffer_headroom();
+  else
+    read_until_headroom_.reset();
+  read_until_bytes_sent_ = 0;
+
+  // A frame held back by the previous request is sent first.
+  if (is_data_pending())
+    TryWriteData(MOJO_RESULT_OK);
+  else
+    RequestBuffer();
 }
 
 void DemuxerStreamAdapter::EnableBitstreamConverter() {
@@ -296,11 +353,25 @@ void DemuxerStreamAdapter::OnNewBuffer(
       return;
     case DemuxerStream::kOk: {
       media_status_ = status;
-      DCHECK(pending_frame_.empty());
+      DCHECK(pending_frame_header_.empty());
       if (!producer_handle_.is_valid())
         return;  // Do not start sending (due to previous fatal error).
-      pending_frame_ = DecoderBufferToByteArray(*input);
+      // Only the header is serialized; the data is later copied into the data
+      // pipe straight from |input|.
+      pending_frame_header_ = DecoderBufferToSegmentHeader(*input);
+      pending_frame_buffer_ = input;
       pending_frame_is_eos_ = input->end_of_stream();
+      pending_frame_size_ = pending_frame_header_.size() +
+                            (pending_frame_is_eos_ ? 0 : input->data_size());
+      pending_frame_ready_time_ = base::TimeTicks::Now();
+      if (!PendingFrameFitsInHeadroom()) {
+        // Holds the frame until the receiver has room for it.
+        DEMUXER_VLOG(3) << "Deferring frame of " << input->data_size()
+                        << " bytes, receiver headroom is exhausted";
+        ++stats_.frames_deferred;
+        SendReadAck();
+        return;
+      }
       TryWriteData(MOJO_RESULT_OK);
     } break;
   }
@@ -316,7 +387,7 @@ void DemuxerStreamAdapter::TryWriteData(MojoResult result) {
     return;
   }
 
-  if (pending_frame_.empty()) {
+  if (pending_frame_header_.empty()) {
     DEMUXER_VLOG(3) << "No data available, waiting for demuxer";
     return;
   }
@@ -326,10 +397,10 @@ void DemuxerStreamAdapter::TryWriteData(MojoResult result) {
     return;
   }
 
-  uint32_t num_bytes = pending_frame_.size() - current_pending_frame_offset_;
-  MojoResult mojo_result = producer_handle_->WriteData(
-      pending_frame_.data() + current_pending_frame_offset_, &num_bytes,
-      MOJO_WRITE_DATA_FLAG_NONE);
+  void* pipe_buffer = nullptr;
+  uint32_t num_bytes = 0;
+  MojoResult mojo_result = producer_handle_->BeginWriteData(
+      &pipe_buffer, &num_bytes, MOJO_WRITE_DATA_FLAG_NONE);
   if (mojo_result != MOJO_RESULT_OK && mojo_result != MOJO_RESULT_SHOULD_WAIT) {
     DEMUXER_VLOG(1) << "Pipe was closed unexpectedly (or a bug). result:"
                     << mojo_result;
@@ -341,13 +412,40 @@ void DemuxerStreamAdapter::TryWriteData(MojoResult result) {
   if (mojo_result != MOJO_RESULT_OK)
     return;
 
+  // Copies as much of the frame as fits directly into the data pipe: the
+  // header first, then the data from |pending_frame_buffer_|.
+  num_bytes =
+      std::min(num_bytes, pending_frame_size_ - current_pending_frame_offset_);
+  uint8_t* destination = static_cast<uint8_t*>(pipe_buffer);
+  uint32_t offset = current_pending_frame_offset_;
+  const uint32_t end_offset = offset + num_bytes;
+  const uint32_t header_size = pending_frame_header_.size();
+  if (offset < header_size) {
+    const uint32_t header_bytes = std::min(end_offset, header_size) - offset;
+    memcpy(destination, pending_frame_header_.data() + offset, header_bytes);
+    destination += header_bytes;
+    offset += header_bytes;
+  }
+  if (offset < end_offset) {
+    memcpy(destination, pending_frame_buffer_->data() + offset - header_size,
+           end_offset - offset);
+  }
+
+  mojo_result = producer_handle_->EndWriteData(num_bytes);
+  if (mojo_result != MOJO_RESULT_OK) {
+    DEMUXER_VLOG(1) << "Pipe was closed unexpectedly (or a bug). result:"
+                    << mojo_result;
+    OnFatalError(MOJO_PIPE_ERROR);
+    return;
+  }
+
   stream_sender_->ConsumeDataChunk(current_pending_frame_offset_, num_bytes,
-                                   pending_frame_.size());
+                                   pending_frame_size_);
   current_pending_frame_offset_ += num_bytes;
   bytes_written_to_pipe_ += num_bytes;
 
   // Checks if all buffer was written to browser process.
-  if (current_pending_frame_offset_ != pending_frame_.size()) {
+  if (current_pending_frame_offset_ != pending_frame_size_) {
     // Returns and wait for mojo watcher to notify to write more data.
     return;
   }
@@ -355,6 +453,14 @@ void DemuxerStreamAdapter::TryWriteData(MojoResult result) {
   // Signal mojo remoting service that all frame buffer is written to data pipe.
   stream_sender_->SendFrame();
 
+  const base::TimeDelta write_latency =
+      base::TimeTicks::Now() - pending_frame_ready_time_;
+  ++stats_.frames_written;
+  stats_.bytes_written += pending_frame_size_;
+  stats_.total_write_latency += write_latency;
+  stats_.max_write_latency = std::max(stats_.max_write_latency, write_latency);
+  read_until_bytes_sent_ += pending_frame_size_ - pending_frame_header_.size();
+
   // Resets frame buffer variables.
   bool pending_frame_is_eos = pending_frame_is_eos_;
   ++last_count_;
@@ -424,9 +530,21 @@ void DemuxerStreamAdapter::SendReadAck() {
 
 void DemuxerStreamAdapter::ResetPendingFrame() {
   DCHECK(media_task_runner_->BelongsToCurrentThread());
+  pending_frame_header_.clear();
+  pending_frame_buffer_ = nullptr;
+  pending_frame_size_ = 0;
   current_pending_frame_offset_ = 0;
-  pending_frame_.clear();
   pending_frame_is_eos_ = false;
+  pending_frame_ready_time_ = base::TimeTicks();
+}
+
+bool DemuxerStreamAdapter::PendingFrameFitsInHeadroom() const {
+  DCHECK(is_data_pending());
+  if (!read_until_headroom_ || read_until_bytes_sent_ == 0)
+    return true;
+  const uint32_t data_size = pending_frame_size_ - pending_frame_header_.size();
+  return read_until_bytes_sent_ < *read_until_headroom_ &&
+         data_size <= *read_until_headroom_ - read_until_bytes_sent_;
 }
 
 void DemuxerStreamAdapter::OnFatalError(StopTrigger stop_trigger) {
@@ -14,6 +14,7 @@
 #include "base/macros.h"
 #include "base/memory/weak_ptr.h"
 #include "base/optional.h"
+#include "base/time/time.h"
 #include "media/base/audio_decoder_config.h"
 #include "media/base/demuxer_stream.h"
 #include "media/base/video_decoder_config.h"
@@ -41,6 +42,19 @@ class DemuxerStreamAdapter {
  public:
   using ErrorCallback = base::Callback<void(StopTrigger)>;
 
+  // Statistics on the frames written to the data pipe.
+  struct Stats {
+    uint64_t frames_written = 0;
+    uint64_t bytes_written = 0;
+    // Number of frames held back until the next RPC_DS_READUNTIL because they
+    // did not fit in the buffer headroom advertised by the receiver.
+    uint64_t frames_deferred = 0;
+    // Time between frames being returned by the demuxer and being completely
+    // written to the data pipe, i.e., spent waiting for the receiver.
+    base::TimeDelta total_write_latency;
+    base::TimeDelta max_write_latency;
+  };
+
   // |main_task_runner|: Task runner to post RPC message on main thread
   // |media_task_runner|: Task runner to run whole class on media thread.
   // |name|: Demuxer stream name. For troubleshooting purposes.
@@ -91,11 +105,17 @@ class DemuxerStreamAdapter {
 
   // Indicates whether there is data waiting to be written to the mojo data
   // pipe.
-  bool is_data_pending() const { return !pending_frame_.empty(); }
+  bool is_data_pending() const { return !pending_frame_header_.empty(); }
+
+  const Stats& stats() const { return stats_; }
+
+  // Returns the data pipe capacity for a stream of |bits_per_second|: enough
+  // to hold about a second of media, within fixed bounds.
+  static uint32_t GetDataPipeCapacity(int64_t bits_per_second);
 
-  // Creates a Mojo data pipe configured appropriately for use with a
-  // DemuxerStreamAdapter.
-  static mojo::DataPipe* CreateDataPipe();
+  // Creates a Mojo data pipe sized for the estimated bitrate of
+  // |demuxer_stream|, for use with a DemuxerStreamAdapter.
+  static mojo::DataPipe* CreateDataPipe(DemuxerStream* demuxer_stream);
 
  private:
   friend class MockDemuxerStreamAdapter;
@@ -116,6 +136,10 @@ class DemuxerStreamAdapter {
   void TryWriteData(MojoResult result);
   void ResetPendingFrame();
 
+  // Returns true if the pending frame can be sent without exceeding the buffer
+  // headroom advertised in the current RPC_DS_READUNTIL.
+  bool PendingFrameFitsInHeadroom() const;
+
   // Callback function when a fatal runtime error occurs.
   void OnFatalError(StopTrigger stop_trigger);
 
@@ -159,6 +183,13 @@ class DemuxerStreamAdapter {
   // sending RPC_DS_READUNTIL_CALLBACK back to receiver.
   uint32_t read_until_count_;
 
+  // Buffer headroom in bytes given by the current RPC_DS_READUNTIL message, or
+  // unset if the receiver did not advertise any, and the number of bytes of
+  // frame data sent since then. A headroom of zero still lets the first frame
+  // of the request through.
+  base::Optional<uint32_t> read_until_headroom_;
+  uint32_t read_until_bytes_sent_;
+
   // Count id of last frame sent.
   uint32_t last_count_;
 
@@ -167,10 +198,14 @@ class DemuxerStreamAdapter {
   bool pending_flush_;
 
   // Frame buffer and its information that is currently in process of writing to
-  // Mojo data pipe.
-  std::vector<uint8_t> pending_frame_;
+  // Mojo data pipe. The frame is the serialized header followed by the data
+  // of |pending_frame_buffer_|, which is not copied until it is written.
+  std::vector<uint8_t> pending_frame_header_;
+  scoped_refptr<DecoderBuffer> pending_frame_buffer_;
+  uint32_t pending_frame_size_;
   uint32_t current_pending_frame_offset_;
   bool pending_frame_is_eos_;
+  base::TimeTicks pending_frame_ready_time_;
 
   // Monitor if data pipe is available to write data.
   mojo::SimpleWatcher write_watcher_;
@@ -186,6 +221,8 @@ class DemuxerStreamAdapter {
   // Tracks the number of bytes written to the pipe.
   int64_t bytes_written_to_pipe_;
 
+  Stats stats_;
+
   // WeakPtrFactory only for reading buffer from demuxer stream. This is used
   // for canceling all read callbacks provided to the |demuxer_stream_| before a
   // flush.
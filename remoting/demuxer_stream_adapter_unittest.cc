@@ -9,6 +9,7 @@
 
 #include "base/callback_helpers.h"
 #include "base/message_loop/message_loop.h"
+#include "base/optional.h"
 #include "base/run_loop.h"
 #include "base/single_thread_task_runner.h"
 #include "media/base/decoder_buffer.h"
@@ -71,6 +72,13 @@ class MockDemuxerStreamAdapter {
 
   // Fake to signal that it's in reading state.
   void FakeReadUntil(int read_until_count, int callback_handle) {
+    FakeReadUntilWithHeadroom(read_until_count, callback_handle,
+                              base::nullopt);
+  }
+  // Same as FakeReadUntil(), but also reports |buffer_headroom| if it is set.
+  void FakeReadUntilWithHeadroom(int read_until_count,
+                                 int callback_handle,
+                                 base::Optional<uint32_t> buffer_headroom) {
     std::unique_ptr<pb::RpcMessage> rpc(new pb::RpcMessage());
     rpc->set_handle(rpc_handle());
     rpc->set_proc(pb::RpcMessage::RPC_DS_READUNTIL);
@@ -78,6 +86,8 @@ class MockDemuxerStreamAdapter {
     read_message->set_callback_handle(
         callback_handle);  // Given an unique callback handle.
     read_message->set_count(read_until_count);  // Request 1 frame
+    if (buffer_headroom)
+      read_message->set_buffer_headroom(*buffer_headroom);
 
     demuxer_stream_adapter_->OnReceivedRpc(std::move(rpc));
   }
@@ -89,6 +99,10 @@ class MockDemuxerStreamAdapter {
 
   pb::RpcMessage* last_received_rpc() const { return last_received_rpc_.get(); }
 
+  const DemuxerStreamAdapter::Stats& stats() const {
+    return demuxer_stream_adapter_->stats();
+  }
+
  private:
   void OnSendMessageToSink(std::unique_ptr<std::vector<uint8_t>> message) {
     last_received_rpc_.reset(new pb::RpcMessage());
@@ -271,6 +285,94 @@ TEST_F(DemuxerStreamAdapterTest, SendFrameAndSignalFlushMix) {
   data_stream_sender_->ResetHistory();
 }
 
+TEST_F(DemuxerStreamAdapterTest, ReadUntilStopsAtBufferHeadroom) {
+  demuxer_stream_->CreateFakeFrame(100, true, 1 /* pts */);
+  demuxer_stream_->CreateFakeFrame(100, false, 2 /* pts */);
+  demuxer_stream_->CreateFakeFrame(100, false, 3 /* pts */);
+
+  // Only the first frame fits in the headroom; the second one is held back.
+  demuxer_stream_adapter_->FakeReadUntilWithHeadroom(3, 100, 150);
+  RunPendingTasks();
+  ASSERT_EQ(data_stream_sender_->send_frame_count(), 1U);
+  ASSERT_TRUE(data_stream_sender_->ValidateFrameBuffer(0, 100, true, 1));
+  pb::RpcMessage* last_rpc = demuxer_stream_adapter_->last_received_rpc();
+  ASSERT_TRUE(last_rpc);
+  ASSERT_EQ(last_rpc->proc(), pb::RpcMessage::RPC_DS_READUNTIL_CALLBACK);
+  ASSERT_EQ(last_rpc->handle(), 100);
+  ASSERT_EQ(last_rpc->demuxerstream_readuntilcb_rpc().count(), 1U);
+  EXPECT_EQ(demuxer_stream_adapter_->stats().frames_deferred, 1U);
+
+  // The held back frame is sent first once the receiver has room again.
+  demuxer_stream_adapter_->FakeReadUntilWithHeadroom(3, 101, 250);
+  RunPendingTasks();
+  ASSERT_EQ(data_stream_sender_->send_frame_count(), 3U);
+  ASSERT_TRUE(data_stream_sender_->ValidateFrameBuffer(1, 100, false, 2));
+  ASSERT_TRUE(data_stream_sender_->ValidateFrameBuffer(2, 100, false, 3));
+  last_rpc = demuxer_stream_adapter_->last_received_rpc();
+  ASSERT_TRUE(last_rpc);
+  ASSERT_EQ(last_rpc->handle(), 101);
+  ASSERT_EQ(last_rpc->demuxerstream_readuntilcb_rpc().count(), 3U);
+
+  const DemuxerStreamAdapter::Stats& stats = demuxer_stream_adapter_->stats();
+  EXPECT_EQ(stats.frames_written, 3U);
+  EXPECT_GT(stats.bytes_written, 300U);
+  EXPECT_EQ(stats.frames_deferred, 1U);
+  EXPECT_GE(stats.total_write_latency, stats.max_write_latency);
+}
+
+TEST_F(DemuxerStreamAdapterTest, FirstFrameIgnoresBufferHeadroom) {
+  demuxer_stream_->CreateFakeFrame(800, true, 1 /* pts */);
+  demuxer_stream_adapter_->FakeReadUntilWithHeadroom(1, 999, 100);
+  RunPendingTasks();
+
+  ASSERT_EQ(data_stream_sender_->send_frame_count(), 1U);
+  ASSERT_TRUE(data_stream_sender_->ValidateFrameBuffer(0, 800, true, 1));
+  EXPECT_EQ(demuxer_stream_adapter_->stats().frames_deferred, 0U);
+}
+
+TEST_F(DemuxerStreamAdapterTest, ZeroBufferHeadroomAllowsOnlyOneFrame) {
+  demuxer_stream_->CreateFakeFrame(100, true, 1 /* pts */);
+  demuxer_stream_->CreateFakeFrame(100, false, 2 /* pts */);
+
+  // A headroom of zero is a limit, not a missing field: only the first frame
+  // of the ReadUntil is sent.
+  demuxer_stream_adapter_->FakeReadUntilWithHeadroom(2, 100, 0);
+  RunPendingTasks();
+  ASSERT_EQ(data_stream_sender_->send_frame_count(), 1U);
+  ASSERT_TRUE(data_stream_sender_->ValidateFrameBuffer(0, 100, true, 1));
+  pb::RpcMessage* last_rpc = demuxer_stream_adapter_->last_received_rpc();
+  ASSERT_TRUE(last_rpc);
+  ASSERT_EQ(last_rpc->demuxerstream_readuntilcb_rpc().count(), 1U);
+  EXPECT_EQ(demuxer_stream_adapter_->stats().frames_deferred, 1U);
+
+  // Without a headroom, there is no limit.
+  demuxer_stream_adapter_->FakeReadUntil(2, 101);
+  RunPendingTasks();
+  ASSERT_EQ(data_stream_sender_->send_frame_count(), 2U);
+  ASSERT_TRUE(data_stream_sender_->ValidateFrameBuffer(1, 100, false, 2));
+}
+
+TEST_F(DemuxerStreamAdapterTest, DataPipeCapacityFollowsBitrate) {
+  const uint32_t kMinCapacity = DemuxerStreamAdapter::GetDataPipeCapacity(0);
+  const uint32_t kMaxCapacity =
+      DemuxerStreamAdapter::GetDataPipeCapacity(1000 * 1000 * 1000);
+  EXPECT_LT(kMinCapacity, kMaxCapacity);
+
+  // In between the bounds, the pipe holds a second of media.
+  const int64_t kBitrate = 8 * 1024 * 1024;
+  EXPECT_EQ(DemuxerStreamAdapter::GetDataPipeCapacity(kBitrate), 1024U * 1024);
+
+  // Pipes are sized from the decoder configs of the streams.
+  FakeDemuxerStream audio_stream(true);
+  FakeDemuxerStream video_stream(false);
+  std::unique_ptr<mojo::DataPipe> audio_pipe(
+      DemuxerStreamAdapter::CreateDataPipe(&audio_stream));
+  std::unique_ptr<mojo::DataPipe> video_pipe(
+      DemuxerStreamAdapter::CreateDataPipe(&video_stream));
+  EXPECT_TRUE(audio_pipe->producer_handle.is_valid());
+  EXPECT_TRUE(video_pipe->producer_handle.is_valid());
+}
+
 TEST_F(DemuxerStreamAdapterTest, DuplicateInitializeCausesFatalError) {
   std::vector<StopTrigger> errors;
   demuxer_stream_adapter_->TakeErrors(&errors);
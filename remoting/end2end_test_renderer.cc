@@ -4,10 +4,13 @@
 
 #include "media/remoting/end2end_test_renderer.h"
 
+#include <algorithm>
+
 #include "base/bind.h"
 #include "base/bind_helpers.h"
 #include "base/callback.h"
 #include "base/threading/thread_task_runner_handle.h"
+#include "media/base/decoder_buffer.h"
 #include "media/mojo/interfaces/remoting.mojom.h"
 #include "media/remoting/courier_renderer.h"
 #include "media/remoting/proto_utils.h"
@@ -20,10 +23,13 @@ namespace remoting {
 
 namespace {
 
+// Receives the frames written to the data pipe by DemuxerStreamAdapter. The
+// header of each frame is read first, then the data is read straight into the
+// DecoderBuffer that the header describes.
 class TestStreamSender final : public mojom::RemotingDataStreamSender {
  public:
   using SendFrameToSinkCallback =
-      base::Callback<void(const std::vector<uint8_t>& data,
+      base::Callback<void(const scoped_refptr<DecoderBuffer>& frame,
                           DemuxerStream::Type type)>;
   TestStreamSender(mojom::RemotingDataStreamSenderRequest request,
                    mojo::ScopedDataPipeConsumerHandle handle,
@@ -32,7 +38,8 @@ class TestStreamSender final : public mojom::RemotingDataStreamSender {
       : binding_(this, std::move(request)),
         consumer_handle_(std::move(handle)),
         type_(type),
-        send_frame_to_sink_cb_(callback) {}
+        send_frame_to_sink_cb_(callback),
+        next_frame_data_offset_(0) {}
 
   ~TestStreamSender() override {}
 
@@ -41,27 +48,71 @@ class TestStreamSender final : public mojom::RemotingDataStreamSender {
   void ConsumeDataChunk(uint32_t offset,
                         uint32_t size,
                         uint32_t total_payload_size) override {
-    next_frame_data_.resize(total_payload_size);
-    MojoResult result =
-        consumer_handle_->ReadData(next_frame_data_.data() + offset, &size,
-                                   MOJO_READ_DATA_FLAG_ALL_OR_NONE);
-    CHECK(result == MOJO_RESULT_OK);
+    while (size) {
+      uint8_t* destination;
+      uint32_t num_bytes;
+      if (!next_frame_) {
+        // The size of the header is known once its prefix has been read.
+        const uint32_t header_size =
+            next_frame_header_.size() < kDecoderBufferSegmentPrefixSize
+                ? kDecoderBufferSegmentPrefixSize
+                : GetDecoderBufferSegmentHeaderSize(next_frame_header_.data());
+        CHECK_GT(header_size, next_frame_header_.size());
+        num_bytes = std::min<uint32_t>(
+            size, header_size - next_frame_header_.size());
+        next_frame_header_.resize(next_frame_header_.size() + num_bytes);
+        destination = next_frame_header_.data() + next_frame_header_.size() -
+                      num_bytes;
+      } else {
+        const uint32_t data_size =
+            next_frame_->end_of_stream() ? 0 : next_frame_->data_size();
+        CHECK_LT(next_frame_data_offset_, data_size);
+        num_bytes = std::min(size, data_size - next_frame_data_offset_);
+        destination = next_frame_->writable_data() + next_frame_data_offset_;
+        next_frame_data_offset_ += num_bytes;
+      }
+
+      MojoResult result = consumer_handle_->ReadData(
+          destination, &num_bytes, MOJO_READ_DATA_FLAG_ALL_OR_NONE);
+      CHECK(result == MOJO_RESULT_OK);
+      size -= num_bytes;
+
+      if (!next_frame_ &&
+          next_frame_header_.size() >= kDecoderBufferSegmentPrefixSize &&
+          next_frame_header_.size() ==
+              GetDecoderBufferSegmentHeaderSize(next_frame_header_.data())) {
+        next_frame_ = SegmentHeaderToDecoderBuffer(next_frame_header_.data(),
+                                                   next_frame_header_.size());
+        CHECK(next_frame_);
+      }
+    }
   }
 
   void SendFrame() override {
     if (!send_frame_to_sink_cb_.is_null())
-      send_frame_to_sink_cb_.Run(next_frame_data_, type_);
-    next_frame_data_.resize(0);
+      send_frame_to_sink_cb_.Run(next_frame_, type_);
+    ResetNextFrame();
   }
 
-  void CancelInFlightData() override { next_frame_data_.resize(0); }
+  void CancelInFlightData() override { ResetNextFrame(); }
 
  private:
+  void ResetNextFrame() {
+    next_frame_header_.clear();
+    next_frame_ = nullptr;
+    next_frame_data_offset_ = 0;
+  }
+
   mojo::Binding<RemotingDataStreamSender> binding_;
   mojo::ScopedDataPipeConsumerHandle consumer_handle_;
   const DemuxerStream::Type type_;
   const SendFrameToSinkCallback send_frame_to_sink_cb_;
-  std::vector<uint8_t> next_frame_data_;
+
+  // The frame being received: its header, and once that is complete, the
+  // DecoderBuffer that its data is read into.
+  std::vector<uint8_t> next_frame_header_;
+  scoped_refptr<DecoderBuffer> next_frame_;
+  uint32_t next_frame_data_offset_;
 
   DISALLOW_COPY_AND_ASSIGN(TestStreamSender);
 };
@@ -206,15 +257,31 @@ void End2EndTestRenderer::SendMessageToSink(
   receiver_rpc_broker_.ProcessMessageFromRemote(std::move(rpc));
 }
 
-void End2EndTestRenderer::SendFrameToSink(const std::vector<uint8_t>& frame,
-                                          DemuxerStream::Type type) {
-  scoped_refptr<DecoderBuffer> decoder_buffer =
-      ByteArrayToDecoderBuffer(frame.data(), frame.size());
-  receiver_->OnReceivedBuffer(type, decoder_buffer);
+void End2EndTestRenderer::SendFrameToSink(
+    const scoped_refptr<DecoderBuffer>& frame,
+    DemuxerStream::Type type) {
+  ++num_frames_received_;
+  receiver_->OnReceivedBuffer(type, frame);
 }
 
 void End2EndTestRenderer::OnMessageFromSink(
     std::unique_ptr<std::vector<uint8_t>> message) {
+  pb::RpcMessage rpc;
+  if (!rpc.ParseFromArray(message->data(), message->size()) ||
+      rpc.proc() != pb::RpcMessage::RPC_DS_READUNTIL) {
+    shared_session_->OnMessageFromSink(*message);
+    return;
+  }
+
+  ++num_read_untils_;
+  auto* read_until = rpc.mutable_demuxerstream_readuntil_rpc();
+  if (max_buffer_headroom_ &&
+      (!read_until->has_buffer_headroom() ||
+       read_until->buffer_headroom() > *max_buffer_headroom_)) {
+    read_until->set_buffer_headroom(*max_buffer_headroom_);
+    message->resize(rpc.ByteSize());
+    CHECK(rpc.SerializeToArray(message->data(), message->size()));
+  }
   shared_session_->OnMessageFromSink(*message);
 }
 
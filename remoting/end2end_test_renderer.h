@@ -8,6 +8,7 @@
 #include <vector>
 
 #include "base/memory/weak_ptr.h"
+#include "base/optional.h"
 #include "media/base/demuxer_stream.h"
 #include "media/base/renderer.h"
 #include "media/remoting/rpc_broker.h"
@@ -38,12 +39,24 @@ class End2EndTestRenderer final : public Renderer {
   void SetVolume(float volume) override;
   base::TimeDelta GetMediaTime() override;
 
+  // Caps the buffer headroom the receiver advertises in its ReadUntil RPC
+  // messages to |max_buffer_headroom|, so that the sender has to hold frames
+  // back.
+  void set_max_buffer_headroom(uint32_t max_buffer_headroom) {
+    max_buffer_headroom_ = max_buffer_headroom;
+  }
+
+  // The number of ReadUntil RPC messages sent by the receiver, and of frames
+  // received by it, over all streams.
+  int num_read_untils() const { return num_read_untils_; }
+  int num_frames_received() const { return num_frames_received_; }
+
  private:
   // Called to send RPC messages to |receiver_|.
   void SendMessageToSink(const std::vector<uint8_t>& message);
 
-  // Called to send frame data to |receiver_|.
-  void SendFrameToSink(const std::vector<uint8_t>& data,
+  // Called to send a frame to |receiver_|.
+  void SendFrameToSink(const scoped_refptr<DecoderBuffer>& frame,
                        DemuxerStream::Type type);
 
   // Called when receives RPC messages from |receiver_|.
@@ -60,6 +73,10 @@ class End2EndTestRenderer final : public Renderer {
   // A receiver that renders media streams.
   std::unique_ptr<Receiver> receiver_;
 
+  base::Optional<uint32_t> max_buffer_headroom_;
+  int num_read_untils_ = 0;
+  int num_frames_received_ = 0;
+
   base::WeakPtrFactory<End2EndTestRenderer> weak_factory_;
 
   DISALLOW_COPY_AND_ASSIGN(End2EndTestRenderer);
@@ -0,0 +1,157 @@
+// Copyright 2017 The Chromium Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#include <stddef.h>
+#include <stdint.h>
+#include <string.h>
+
+#include <memory>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "base/macros.h"
+#include "base/memory/ptr_util.h"
+#include "base/strings/string_number_conversions.h"
+#include "base/time/time.h"
+#include "media/base/decoder_buffer.h"
+#include "media/remoting/end2end_test_renderer.h"
+#include "media/remoting/proto_utils.h"
+#include "media/test/pipeline_integration_test_base.h"
+#include "testing/gtest/include/gtest/gtest.h"
+#include "testing/perf/perf_test.h"
+
+namespace media {
+namespace remoting {
+
+namespace {
+
+const int kPlaybackIterations = 10;
+const int kFramingIterations = 2000;
+const size_t kBufferSizes[] = {4 * 1024, 64 * 1024, 1024 * 1024};
+
+class TestRendererFactory final : public PipelineTestRendererFactory {
+ public:
+  explicit TestRendererFactory(
+      std::unique_ptr<PipelineTestRendererFactory> renderer_factory)
+      : default_renderer_factory_(std::move(renderer_factory)) {}
+  ~TestRendererFactory() override {}
+
+  // PipelineTestRendererFactory implementation.
+  std::unique_ptr<Renderer> CreateRenderer(
+      CreateVideoDecodersCB prepend_video_decoders_cb,
+      CreateAudioDecodersCB prepend_audio_decoders_cb) override {
+    std::unique_ptr<Renderer> renderer_impl =
+        default_renderer_factory_->CreateRenderer(prepend_video_decoders_cb,
+                                                  prepend_audio_decoders_cb);
+    return base::MakeUnique<End2EndTestRenderer>(std::move(renderer_impl));
+  }
+
+ private:
+  std::unique_ptr<PipelineTestRendererFactory> default_renderer_factory_;
+
+  DISALLOW_COPY_AND_ASSIGN(TestRendererFactory);
+};
+
+// A pipeline that plays media through CourierRenderer, the data pipe and
+// Receiver, as MediaRemotingIntegrationTest does.
+class RemotingPipeline : public PipelineIntegrationTestBase {
+ public:
+  RemotingPipeline() {
+    std::unique_ptr<PipelineTestRendererFactory> factory =
+        std::move(renderer_factory_);
+    renderer_factory_.reset(new TestRendererFactory(std::move(factory)));
+  }
+
+ private:
+  DISALLOW_COPY_AND_ASSIGN(RemotingPipeline);
+};
+
+void RunPlaybackBenchmark(const std::string& filename) {
+  base::TimeDelta elapsed;
+  for (int i = 0; i < kPlaybackIterations; ++i) {
+    RemotingPipeline pipeline;
+    ASSERT_EQ(PIPELINE_OK, pipeline.Start(filename));
+
+    const base::TimeTicks start = base::TimeTicks::Now();
+    pipeline.Play();
+    ASSERT_TRUE(pipeline.WaitUntilOnEnded());
+    pipeline.Stop();
+    elapsed += base::TimeTicks::Now() - start;
+  }
+
+  perf_test::PrintResult("remoting_clockless_playback", "", filename,
+                         kPlaybackIterations / elapsed.InSecondsF(), "runs/s",
+                         true);
+}
+
+// Sends |buffer| across a simulated data pipe |wire| as a contiguous byte
+// array, the way frames were sent before they were framed in place.
+scoped_refptr<DecoderBuffer> TransferAsByteArray(const DecoderBuffer& buffer,
+                                                 std::vector<uint8_t>* wire) {
+  const std::vector<uint8_t> frame = DecoderBufferToByteArray(buffer);
+  wire->assign(frame.begin(), frame.end());
+  const std::vector<uint8_t> received(wire->begin(), wire->end());
+  return ByteArrayToDecoderBuffer(received.data(), received.size());
+}
+
+// Sends |buffer| across a simulated data pipe |wire| with the data copied
+// directly from and into DecoderBuffers, as DemuxerStreamAdapter and
+// End2EndTestRenderer do.
+scoped_refptr<DecoderBuffer> TransferInPlace(const DecoderBuffer& buffer,
+                                             std::vector<uint8_t>* wire) {
+  const std::vector<uint8_t> header = DecoderBufferToSegmentHeader(buffer);
+  wire->resize(header.size() + buffer.data_size());
+  memcpy(wire->data(), header.data(), header.size());
+  memcpy(wire->data() + header.size(), buffer.data(), buffer.data_size());
+
+  const uint32_t header_size = GetDecoderBufferSegmentHeaderSize(wire->data());
+  scoped_refptr<DecoderBuffer> received =
+      SegmentHeaderToDecoderBuffer(wire->data(), header_size);
+  memcpy(received->writable_data(), wire->data() + header_size,
+         received->data_size());
+  return received;
+}
+
+void RunFramingBenchmark(
+    const std::string& trace,
+    scoped_refptr<DecoderBuffer> (*transfer)(const DecoderBuffer&,
+                                             std::vector<uint8_t>*)) {
+  for (size_t size : kBufferSizes) {
+    scoped_refptr<DecoderBuffer> buffer(new DecoderBuffer(size));
+    memset(buffer->writable_data(), 0x5a, size);
+    buffer->set_timestamp(base::TimeDelta::FromMilliseconds(33));
+    buffer->set_is_key_frame(true);
+
+    std::vector<uint8_t> wire;
+    const base::TimeTicks start = base::TimeTicks::Now();
+    for (int i = 0; i < kFramingIterations; ++i) {
+      scoped_refptr<DecoderBuffer> received = transfer(*buffer, &wire);
+      ASSERT_TRUE(received);
+      ASSERT_EQ(size, received->data_size());
+    }
+    const base::TimeDelta elapsed = base::TimeTicks::Now() - start;
+
+    perf_test::PrintResult(
+        "remoting_framing",
+        trace + "_" + base::SizeTToString(size / 1024) + "kb", "throughput",
+        size * kFramingIterations / (1024.0 * 1024.0) / elapsed.InSecondsF(),
+        "MB/s", true);
+  }
+}
+
+}  // namespace
+
+TEST(MediaRemotingPerfTest, Framing) {
+  RunFramingBenchmark("_byte_array", &TransferAsByteArray);
+  RunFramingBenchmark("_in_place", &TransferInPlace);
+}
+
+TEST(MediaRemotingPerfTest, ClocklessPlayback) {
+  RunPlaybackBenchmark("bear-320x240.webm");
+  RunPlaybackBenchmark("bear-1280x720.webm");
+}
+
+}  // namespace remoting
+}  // namespace media
@@ -3,6 +3,7 @@
 // found in the LICENSE file.
 
 #include "base/memory/ptr_util.h"
+#include "base/optional.h"
 #include "media/base/test_data_util.h"
 #include "media/remoting/end2end_test_renderer.h"
 #include "media/test/mock_media_source.h"
@@ -30,11 +31,27 @@ class TestRendererFactory final : public PipelineTestRendererFactory {
     std::unique_ptr<Renderer> renderer_impl =
         default_renderer_factory_->CreateRenderer(prepend_video_decoders_cb,
                                                   prepend_audio_decoders_cb);
-    return base::MakeUnique<End2EndTestRenderer>(std::move(renderer_impl));
+    std::unique_ptr<End2EndTestRenderer> renderer =
+        base::MakeUnique<End2EndTestRenderer>(std::move(renderer_impl));
+    if (max_buffer_headroom_)
+      renderer->set_max_buffer_headroom(*max_buffer_headroom_);
+    last_renderer_ = renderer.get();
+    return std::move(renderer);
   }
 
+  // Applies End2EndTestRenderer::set_max_buffer_headroom() to the renderers
+  // created from now on.
+  void set_max_buffer_headroom(uint32_t max_buffer_headroom) {
+    max_buffer_headroom_ = max_buffer_headroom;
+  }
+
+  // The last renderer created. It is owned by the pipeline.
+  End2EndTestRenderer* last_renderer() const { return last_renderer_; }
+
  private:
   std::unique_ptr<PipelineTestRendererFactory> default_renderer_factory_;
+  base::Optional<uint32_t> max_buffer_headroom_;
+  End2EndTestRenderer* last_renderer_ = nullptr;
 
   DISALLOW_COPY_AND_ASSIGN(TestRendererFactory);
 };
@@ -47,9 +64,13 @@ class MediaRemotingIntegrationTest : public testing::Test,
   MediaRemotingIntegrationTest() {
     std::unique_ptr<PipelineTestRendererFactory> factory =
         std::move(renderer_factory_);
-    renderer_factory_.reset(new TestRendererFactory(std::move(factory)));
+    test_renderer_factory_ = new TestRendererFactory(std::move(factory));
+    renderer_factory_.reset(test_renderer_factory_);
   }
 
+ protected:
+  TestRendererFactory* test_renderer_factory_;  // Owned by the base class.
+
  private:
   DISALLOW_COPY_AND_ASSIGN(MediaRemotingIntegrationTest);
 };
@@ -63,6 +84,24 @@ TEST_F(MediaRemotingIntegrationTest, BasicPlayback) {
   EXPECT_EQ("-3.59,-2.06,-0.43,2.15,0.77,-0.95,", GetAudioHash());
 }
 
+TEST_F(MediaRemotingIntegrationTest, BufferHeadroomDefersFrames) {
+  // Without any headroom, each ReadUntil lets a single frame through, and the
+  // sender holds the others back until the receiver asks again.
+  test_renderer_factory_->set_max_buffer_headroom(0);
+  ASSERT_EQ(PIPELINE_OK, Start("bear-320x240.webm", TestTypeFlags::kHashed));
+  Play();
+  ASSERT_TRUE(WaitUntilOnEnded());
+
+  End2EndTestRenderer* const renderer = test_renderer_factory_->last_renderer();
+  ASSERT_TRUE(renderer);
+  EXPECT_GT(renderer->num_frames_received(), 0);
+  EXPECT_LE(renderer->num_frames_received(), renderer->num_read_untils());
+
+  // Deferring frames does not change what is rendered.
+  EXPECT_EQ("f0be120a90a811506777c99a2cdf7cc1", GetVideoHash());
+  EXPECT_EQ("-3.59,-2.06,-0.43,2.15,0.77,-0.95,", GetAudioHash());
+}
+
 TEST_F(MediaRemotingIntegrationTest, BasicPlayback_MediaSource) {
   MockMediaSource source("bear-320x240.webm", kWebM, 219229);
   EXPECT_EQ(PIPELINE_OK, StartPipelineWithMediaSource(&source));
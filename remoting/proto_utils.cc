@@ -22,6 +22,9 @@ namespace {
 constexpr size_t kPayloadVersionFieldSize = sizeof(uint8_t);
 constexpr size_t kProtoBufferHeaderSize = sizeof(uint16_t);
 constexpr size_t kDataBufferHeaderSize = sizeof(uint32_t);
+static_assert(kPayloadVersionFieldSize + kProtoBufferHeaderSize ==
+                  kDecoderBufferSegmentPrefixSize,
+              "Unexpected DecoderBufferSegment prefix size");
 
 std::unique_ptr<DecryptConfig> ConvertProtoToDecryptConfig(
     const pb::DecryptConfig& config_message) {
@@ -143,20 +146,28 @@ void ConvertDecoderBufferToProto(const DecoderBuffer& decoder_buffer,
   }
 }
 
+// Reads the DecoderBufferSegment header from |reader| into |segment| and
+// |buffer_size|, leaving |reader| at the start of the data.
+bool ReadSegmentHeader(base::BigEndianReader* reader,
+                       pb::DecoderBuffer* segment,
+                       uint32_t* buffer_size) {
+  uint8_t payload_version = 0;
+  uint16_t proto_size = 0;
+  return reader->ReadU8(&payload_version) && payload_version == 0 &&
+         reader->ReadU16(&proto_size) &&
+         static_cast<int>(proto_size) < reader->remaining() &&
+         segment->ParseFromArray(reader->ptr(), proto_size) &&
+         reader->Skip(proto_size) && reader->ReadU32(buffer_size);
+}
+
 }  // namespace
 
 scoped_refptr<DecoderBuffer> ByteArrayToDecoderBuffer(const uint8_t* data,
                                                       uint32_t size) {
   base::BigEndianReader reader(reinterpret_cast<const char*>(data), size);
-  uint8_t payload_version = 0;
-  uint16_t proto_size = 0;
   pb::DecoderBuffer segment;
   uint32_t buffer_size = 0;
-  if (reader.ReadU8(&payload_version) && payload_version == 0 &&
-      reader.ReadU16(&proto_size) &&
-      static_cast<int>(proto_size) < reader.remaining() &&
-      segment.ParseFromArray(reader.ptr(), proto_size) &&
-      reader.Skip(proto_size) && reader.ReadU32(&buffer_size) &&
+  if (ReadSegmentHeader(&reader, &segment, &buffer_size) &&
       static_cast<int64_t>(buffer_size) <= reader.remaining()) {
     // Deserialize proto buffer. It passes the pre allocated DecoderBuffer into
     // the function because the proto buffer may overwrite DecoderBuffer since
@@ -173,17 +184,28 @@ scoped_refptr<DecoderBuffer> ByteArrayToDecoderBuffer(const uint8_t* data,
 
 std::vector<uint8_t> DecoderBufferToByteArray(
     const DecoderBuffer& decoder_buffer) {
+  std::vector<uint8_t> buffer = DecoderBufferToSegmentHeader(decoder_buffer);
+  if (!buffer.empty() && !decoder_buffer.end_of_stream() &&
+      decoder_buffer.data_size()) {
+    // DecoderBuffer frame data.
+    buffer.insert(buffer.end(), decoder_buffer.data(),
+                  decoder_buffer.data() + decoder_buffer.data_size());
+  }
+  return buffer;
+}
+
+std::vector<uint8_t> DecoderBufferToSegmentHeader(
+    const DecoderBuffer& decoder_buffer) {
   pb::DecoderBuffer decoder_buffer_message;
   ConvertDecoderBufferToProto(decoder_buffer, &decoder_buffer_message);
 
   size_t decoder_buffer_size =
       decoder_buffer.end_of_stream() ? 0 : decoder_buffer.data_size();
   size_t size = kPayloadVersionFieldSize + kProtoBufferHeaderSize +
-                decoder_buffer_message.ByteSize() + kDataBufferHeaderSize +
-                decoder_buffer_size;
-  std::vector<uint8_t> buffer(size);
-  base::BigEndianWriter writer(reinterpret_cast<char*>(buffer.data()),
-                               buffer.size());
+                decoder_buffer_message.ByteSize() + kDataBufferHeaderSize;
+  std::vector<uint8_t> header(size);
+  base::BigEndianWriter writer(reinterpret_cast<char*>(header.data()),
+                               header.size());
   if (writer.WriteU8(0) &&
       writer.WriteU16(
           static_cast<uint16_t>(decoder_buffer_message.GetCachedSize())) &&
@@ -191,18 +213,41 @@ std::vector<uint8_t> DecoderBufferToByteArray(
           writer.ptr(), decoder_buffer_message.GetCachedSize()) &&
       writer.Skip(decoder_buffer_message.GetCachedSize()) &&
       writer.WriteU32(decoder_buffer_size)) {
-    if (decoder_buffer_size) {
-      // DecoderBuffer frame data.
-      writer.WriteBytes(reinterpret_cast<const void*>(decoder_buffer.data()),
-                        decoder_buffer.data_size());
-    }
-    return buffer;
+    return header;
   }
 
   NOTREACHED();
-  // Reset buffer since serialization of the data failed.
-  buffer.clear();
-  return buffer;
+  // Reset header since serialization of the data failed.
+  header.clear();
+  return header;
+}
+
+uint32_t GetDecoderBufferSegmentHeaderSize(const uint8_t* prefix) {
+  base::BigEndianReader reader(reinterpret_cast<const char*>(prefix),
+                               kDecoderBufferSegmentPrefixSize);
+  uint8_t payload_version = 0;
+  uint16_t proto_size = 0;
+  if (!reader.ReadU8(&payload_version) || payload_version != 0 ||
+      !reader.ReadU16(&proto_size)) {
+    return 0;
+  }
+  return kDecoderBufferSegmentPrefixSize + proto_size + kDataBufferHeaderSize;
+}
+
+scoped_refptr<DecoderBuffer> SegmentHeaderToDecoderBuffer(const uint8_t* data,
+                                                          uint32_t size) {
+  base::BigEndianReader reader(reinterpret_cast<const char*>(data), size);
+  pb::DecoderBuffer segment;
+  uint32_t buffer_size = 0;
+  if (!ReadSegmentHeader(&reader, &segment, &buffer_size) ||
+      reader.remaining() != 0 || (segment.is_eos() && buffer_size)) {
+    return nullptr;
+  }
+
+  // Deserialize proto buffer into a DecoderBuffer whose data is left
+  // uninitialized for the caller to fill in.
+  return ConvertProtoToDecoderBuffer(
+      segment, base::WrapRefCounted(new DecoderBuffer(buffer_size)));
 }
 
 void ConvertEncryptionSchemeToProto(const EncryptionScheme& encryption_scheme,
@@ -61,6 +61,32 @@ std::vector<uint8_t> DecoderBufferToByteArray(
 scoped_refptr<DecoderBuffer> ByteArrayToDecoderBuffer(const uint8_t* data,
                                                       uint32_t size);
 
+// The functions below handle the DecoderBufferSegment header, i.e. all fields
+// up to and including |data_buffer_size|, separately from the data. This lets
+// the data be written to, or read from, the wire directly from the
+// DecoderBuffer instead of being copied into a byte array.
+
+// Size of |payload_version| and |buffer_segment_size|, which determine the
+// size of the rest of the header.
+constexpr uint32_t kDecoderBufferSegmentPrefixSize =
+    sizeof(uint8_t) + sizeof(uint16_t);
+
+// Converts the DecoderBufferSegment header for |decoder_buffer| into byte
+// array. The data of |decoder_buffer| must follow it on the wire.
+std::vector<uint8_t> DecoderBufferToSegmentHeader(
+    const DecoderBuffer& decoder_buffer);
+
+// Returns the size of the DecoderBufferSegment header starting with the
+// kDecoderBufferSegmentPrefixSize bytes in |prefix|, or 0 if the payload
+// version is not supported.
+uint32_t GetDecoderBufferSegmentHeaderSize(const uint8_t* prefix);
+
+// Converts a DecoderBufferSegment header into a DecoderBuffer with room for
+// the data, which the caller reads directly into writable_data(). Returns null
+// if the header is invalid.
+scoped_refptr<DecoderBuffer> SegmentHeaderToDecoderBuffer(const uint8_t* data,
+                                                          uint32_t size);
+
 // Data type conversion between media::AudioDecoderConfig and proto buffer.
 void ConvertAudioDecoderConfigToProto(const AudioDecoderConfig& audio_config,
                                       pb::AudioDecoderConfig* audio_message);
@@ -110,6 +110,49 @@ TEST_F(ProtoUtilsTest, PassValidDecoderBuffer) {
   }
 }
 
+TEST_F(ProtoUtilsTest, PassDecoderBufferWithSeparateData) {
+  const uint8_t buffer[] = {0, 0, 0, 1, 9, 224, 0, 0, 0, 1, 103, 77, 64, 21};
+  const size_t buffer_size = sizeof(buffer) / sizeof(uint8_t);
+  const base::TimeDelta pts = base::TimeDelta::FromMilliseconds(5);
+
+  scoped_refptr<DecoderBuffer> input_buffer =
+      DecoderBuffer::CopyFrom(buffer, buffer_size);
+  input_buffer->set_timestamp(pts);
+  input_buffer->set_is_key_frame(true);
+
+  // The header followed by the data is the same as the whole byte array.
+  std::vector<uint8_t> header = DecoderBufferToSegmentHeader(*input_buffer);
+  std::vector<uint8_t> data = header;
+  data.insert(data.end(), buffer, buffer + buffer_size);
+  ASSERT_EQ(DecoderBufferToByteArray(*input_buffer), data);
+
+  // The header size can be determined from its prefix.
+  ASSERT_GE(header.size(), kDecoderBufferSegmentPrefixSize);
+  ASSERT_EQ(header.size(), GetDecoderBufferSegmentHeaderSize(header.data()));
+
+  scoped_refptr<DecoderBuffer> output_buffer =
+      SegmentHeaderToDecoderBuffer(header.data(), header.size());
+  ASSERT_TRUE(output_buffer);
+  ASSERT_FALSE(output_buffer->end_of_stream());
+  ASSERT_TRUE(output_buffer->is_key_frame());
+  ASSERT_EQ(output_buffer->timestamp(), pts);
+  ASSERT_EQ(output_buffer->data_size(), buffer_size);
+
+  // A truncated header is rejected.
+  ASSERT_FALSE(SegmentHeaderToDecoderBuffer(header.data(), header.size() - 1));
+}
+
+TEST_F(ProtoUtilsTest, PassEOSDecoderBufferWithSeparateData) {
+  std::vector<uint8_t> header =
+      DecoderBufferToSegmentHeader(*DecoderBuffer::CreateEOSBuffer());
+  ASSERT_EQ(header.size(), GetDecoderBufferSegmentHeaderSize(header.data()));
+
+  scoped_refptr<DecoderBuffer> output_buffer =
+      SegmentHeaderToDecoderBuffer(header.data(), header.size());
+  ASSERT_TRUE(output_buffer);
+  ASSERT_TRUE(output_buffer->end_of_stream());
+}
+
 TEST_F(ProtoUtilsTest, AudioDecoderConfigConversionTest) {
   const std::string extra_data = "ACEG";
   const EncryptionScheme encryption_scheme(
@@ -210,7 +210,7 @@ void Receiver::SendMediaTimeUpdate() {
   DVLOG(3) << __func__ << ": Issues RPC_RC_ONTIMEUPDATE message."
            << " media_time = " << media_time.InMicroseconds()
            << " max_time= " << max_time.InMicroseconds();
-  rpc_broker_->SendMessageToRemote(std::move(rpc));
+  rpc_broker_->SendUpdateToRemote(std::move(rpc));
 }
 
 void Receiver::OnReceivedBuffer(DemuxerStream::Type type,
@@ -250,7 +250,7 @@ void Receiver::OnStatisticsUpdate(const PipelineStatistics& stats) {
   message->set_video_frames_dropped(stats.video_frames_dropped);
   message->set_audio_memory_usage(stats.audio_memory_usage);
   message->set_video_memory_usage(stats.video_memory_usage);
-  rpc_broker_->SendMessageToRemote(std::move(rpc));
+  rpc_broker_->SendUpdateToRemote(std::move(rpc));
 }
 
 void Receiver::OnBufferingStateChange(BufferingState state) {
@@ -6,6 +6,7 @@
 
 #include <utility>
 
+#include "base/bind.h"
 #include "base/logging.h"
 #include "media/base/bind_to_current_loop.h"
 
@@ -39,6 +40,50 @@ std::ostream& operator<<(std::ostream& out, const pb::RpcMessage& message) {
   return out;
 }
 
+// How long updates are held to be coalesced with later ones; about a video
+// frame at 30 FPS, over which renderers typically report several statistics
+// updates.
+constexpr base::TimeDelta kUpdateBatchingInterval =
+    base::TimeDelta::FromMilliseconds(33);
+
+bool CanCoalesce(const pb::RpcMessage& message) {
+  return message.proc() == pb::RpcMessage::RPC_RC_ONTIMEUPDATE ||
+         message.proc() == pb::RpcMessage::RPC_RC_ONSTATISTICSUPDATE;
+}
+
+// Merges the later update |from| into |into|, which has the same handle and
+// proc.
+void MergeUpdate(const pb::RpcMessage& from, pb::RpcMessage* into) {
+  if (from.proc() != pb::RpcMessage::RPC_RC_ONSTATISTICSUPDATE) {
+    // Media time updates supersede the earlier ones.
+    *into = from;
+    return;
+  }
+
+  // Statistics are deltas, which add up, except for the average frame
+  // duration.
+  const pb::PipelineStatistics& delta =
+      from.rendererclient_onstatisticsupdate_rpc();
+  pb::PipelineStatistics* total =
+      into->mutable_rendererclient_onstatisticsupdate_rpc();
+  total->set_audio_bytes_decoded(total->audio_bytes_decoded() +
+                                 delta.audio_bytes_decoded());
+  total->set_video_bytes_decoded(total->video_bytes_decoded() +
+                                 delta.video_bytes_decoded());
+  total->set_video_frames_decoded(total->video_frames_decoded() +
+                                  delta.video_frames_decoded());
+  total->set_video_frames_dropped(total->video_frames_dropped() +
+                                  delta.video_frames_dropped());
+  total->set_audio_memory_usage(total->audio_memory_usage() +
+                                delta.audio_memory_usage());
+  total->set_video_memory_usage(total->video_memory_usage() +
+                                delta.video_memory_usage());
+  if (delta.has_video_frame_duration_average_usec()) {
+    total->set_video_frame_duration_average_usec(
+        delta.video_frame_duration_average_usec());
+  }
+}
+
 }  // namespace
 
 RpcBroker::RpcBroker(const SendMessageCallback& send_message_cb)
@@ -88,10 +133,50 @@ void RpcBroker::SendMessageToRemote(std::unique_ptr<pb::RpcMessage> message) {
   DCHECK(thread_checker_.CalledOnValidThread());
   DCHECK(message);
   VLOG(3) << __func__ << ": " << *message;
+  FlushPendingUpdates();
+  SendMessageNow(*message);
+}
+
+void RpcBroker::SendUpdateToRemote(std::unique_ptr<pb::RpcMessage> message) {
+  DCHECK(thread_checker_.CalledOnValidThread());
+  DCHECK(message);
+  if (!CanCoalesce(*message)) {
+    SendMessageToRemote(std::move(message));
+    return;
+  }
+
+  VLOG(3) << __func__ << ": " << *message;
+  for (const auto& pending_update : pending_updates_) {
+    if (pending_update->handle() == message->handle() &&
+        pending_update->proc() == message->proc()) {
+      MergeUpdate(*message, pending_update.get());
+      ++stats_.updates_coalesced;
+      return;
+    }
+  }
+  pending_updates_.push_back(std::move(message));
+  if (!batching_timer_.IsRunning()) {
+    batching_timer_.Start(FROM_HERE, kUpdateBatchingInterval,
+                          base::Bind(&RpcBroker::FlushPendingUpdates,
+                                     base::Unretained(this)));
+  }
+}
+
+void RpcBroker::FlushPendingUpdates() {
+  DCHECK(thread_checker_.CalledOnValidThread());
+  batching_timer_.Stop();
+  std::vector<std::unique_ptr<pb::RpcMessage>> updates;
+  updates.swap(pending_updates_);
+  for (const auto& update : updates)
+    SendMessageNow(*update);
+}
+
+void RpcBroker::SendMessageNow(const pb::RpcMessage& message) {
   std::unique_ptr<std::vector<uint8_t>> serialized_message(
-      new std::vector<uint8_t>(message->ByteSize()));
-  CHECK(message->SerializeToArray(serialized_message->data(),
-                                  serialized_message->size()));
+      new std::vector<uint8_t>(message.ByteSize()));
+  CHECK(message.SerializeToArray(serialized_message->data(),
+                                 serialized_message->size()));
+  ++stats_.messages_sent;
   send_message_cb_.Run(std::move(serialized_message));
 }
 
@@ -5,6 +5,8 @@
 #ifndef MEDIA_REMOTING_RPC_BROKER_H_
 #define MEDIA_REMOTING_RPC_BROKER_H_
 
+#include <stdint.h>
+
 #include <map>
 #include <memory>
 #include <string>
@@ -14,6 +16,7 @@
 #include "base/macros.h"
 #include "base/memory/weak_ptr.h"
 #include "base/threading/thread_checker.h"
+#include "base/timer/timer.h"
 #include "media/remoting/rpc.pb.h"
 
 namespace media {
@@ -34,10 +37,25 @@ namespace remoting {
 // received. RpcBroker will distribute each RPC message to the components based
 // on the handle value in the RPC message.
 //
+// Periodic state updates, such as media time and statistics updates, can be
+// sent with SendUpdateToRemote() instead. They are held for a short batching
+// interval during which later updates with the same handle and proc are
+// coalesced into them, which cuts the message rate on the control channel.
+// All other messages are sent right away, after any pending updates so that
+// the order of the messages is kept.
+//
 // Note this is single-threaded class running on main thread. It provides
 // WeakPtr() for caller to post tasks to the main thread.
 class RpcBroker {
  public:
+  // Counts of the outgoing messages.
+  struct Stats {
+    // Messages actually sent to the remote end point.
+    uint64_t messages_sent = 0;
+    // Updates merged into a pending update instead of being sent.
+    uint64_t updates_coalesced = 0;
+  };
+
   using SendMessageCallback =
       base::Callback<void(std::unique_ptr<std::vector<uint8_t>>)>;
   explicit RpcBroker(const SendMessageCallback& send_message_cb);
@@ -64,6 +82,15 @@ class RpcBroker {
   // SendMessageCallback to RpcBrokwer will receive RPC message to do actual
   // data transmission.
   void SendMessageToRemote(std::unique_ptr<pb::RpcMessage> message);
+  // Sends the RPC_RC_ONTIMEUPDATE or RPC_RC_ONSTATISTICSUPDATE |message| to
+  // the remote end point within a batching interval, coalesced with the later
+  // updates of the same handle. Other messages are sent as by
+  // SendMessageToRemote().
+  void SendUpdateToRemote(std::unique_ptr<pb::RpcMessage> message);
+  // Sends the pending updates right away.
+  void FlushPendingUpdates();
+
+  const Stats& stats() const { return stats_; }
 
   // Gets weak pointer of RpcBroker. This allows callers to post tasks to
   // RpcBroker on the main thread.
@@ -83,6 +110,9 @@ class RpcBroker {
   static constexpr int kFirstHandle = 1;
 
  private:
+  // Serializes and sends |message| to the remote end point.
+  void SendMessageNow(const pb::RpcMessage& message);
+
   // Checks that all method calls occur on the same thread.
   base::ThreadChecker thread_checker_;
 
@@ -95,6 +125,13 @@ class RpcBroker {
   // Callback that is run to send a serialized message.
   SendMessageCallback send_message_cb_;
 
+  // Updates waiting for the end of the batching interval, in the order they
+  // were first sent.
+  std::vector<std::unique_ptr<pb::RpcMessage>> pending_updates_;
+  base::OneShotTimer batching_timer_;
+
+  Stats stats_;
+
   base::WeakPtrFactory<RpcBroker> weak_factory_;
 
   DISALLOW_COPY_AND_ASSIGN(RpcBroker);
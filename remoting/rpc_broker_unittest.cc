@@ -13,6 +13,7 @@
 #include "base/memory/ref_counted.h"
 #include "base/message_loop/message_loop.h"
 #include "base/run_loop.h"
+#include "base/time/time.h"
 #include "media/remoting/rpc.pb.h"
 #include "testing/gmock/include/gmock/gmock.h"
 #include "testing/gtest/include/gtest/gtest.h"
@@ -39,6 +40,7 @@ class FakeMessageSender {
     EXPECT_TRUE(
         received_rpc_->ParseFromArray(message->data(), message->size()));
     has_sent_message_ = true;
+    ++send_count_;
   }
 
   void OnSendMessage(std::unique_ptr<std::vector<uint8_t>> message) {
@@ -86,6 +88,26 @@ class FakeMessageReceiver {
   DISALLOW_COPY_AND_ASSIGN(FakeMessageReceiver);
 };
 
+std::unique_ptr<pb::RpcMessage> CreateTimeUpdate(int handle,
+                                                 int64_t time_usec) {
+  std::unique_ptr<pb::RpcMessage> rpc(new pb::RpcMessage());
+  rpc->set_handle(handle);
+  rpc->set_proc(pb::RpcMessage::RPC_RC_ONTIMEUPDATE);
+  rpc->mutable_rendererclient_ontimeupdate_rpc()->set_time_usec(time_usec);
+  return rpc;
+}
+
+std::unique_ptr<pb::RpcMessage> CreateStatisticsUpdate(int handle) {
+  std::unique_ptr<pb::RpcMessage> rpc(new pb::RpcMessage());
+  rpc->set_handle(handle);
+  rpc->set_proc(pb::RpcMessage::RPC_RC_ONSTATISTICSUPDATE);
+  auto* stats = rpc->mutable_rendererclient_onstatisticsupdate_rpc();
+  stats->set_video_bytes_decoded(1000);
+  stats->set_video_frames_decoded(1);
+  stats->set_video_frame_duration_average_usec(33000);
+  return rpc;
+}
+
 }  // namespace
 
 class RpcBrokerTest : public testing::Test {
@@ -236,5 +258,82 @@ TEST_F(RpcBrokerTest, RpcBrokerProcessMessageWithUnregisteredHandle) {
   rpc_broker->UnregisterMessageReceiverCallback(handle);
 }
 
+TEST_F(RpcBrokerTest, CoalescesUpdatesOfSameHandleAndProc) {
+  base::MessageLoop message_loop;
+  std::unique_ptr<FakeMessageSender> fake_sender(new FakeMessageSender());
+  std::unique_ptr<RpcBroker> rpc_broker(new RpcBroker(base::Bind(
+      &FakeMessageSender::OnSendMessageAndQuit, fake_sender->GetWeakPtr())));
+
+  for (int i = 0; i < 3; ++i)
+    rpc_broker->SendUpdateToRemote(CreateTimeUpdate(2, i * 1000));
+  for (int i = 0; i < 10; ++i)
+    rpc_broker->SendUpdateToRemote(CreateStatisticsUpdate(2));
+  rpc_broker->SendUpdateToRemote(CreateStatisticsUpdate(3));
+  EXPECT_EQ(0, fake_sender->send_count());
+
+  rpc_broker->FlushPendingUpdates();
+  EXPECT_EQ(3, fake_sender->send_count());
+  EXPECT_EQ(3u, rpc_broker->stats().messages_sent);
+  EXPECT_EQ(11u, rpc_broker->stats().updates_coalesced);
+}
+
+TEST_F(RpcBrokerTest, AddsUpCoalescedStatistics) {
+  base::MessageLoop message_loop;
+  std::unique_ptr<FakeMessageSender> fake_sender(new FakeMessageSender());
+  std::unique_ptr<RpcBroker> rpc_broker(new RpcBroker(base::Bind(
+      &FakeMessageSender::OnSendMessageAndQuit, fake_sender->GetWeakPtr())));
+
+  for (int i = 0; i < 5; ++i)
+    rpc_broker->SendUpdateToRemote(CreateStatisticsUpdate(2));
+  rpc_broker->FlushPendingUpdates();
+
+  ASSERT_EQ(1, fake_sender->send_count());
+  const pb::PipelineStatistics& stats =
+      fake_sender->received_rpc()->rendererclient_onstatisticsupdate_rpc();
+  EXPECT_EQ(5000u, stats.video_bytes_decoded());
+  EXPECT_EQ(5u, stats.video_frames_decoded());
+  EXPECT_EQ(33000, stats.video_frame_duration_average_usec());
+}
+
+TEST_F(RpcBrokerTest, ControlMessageFlushesPendingUpdates) {
+  base::MessageLoop message_loop;
+  std::unique_ptr<FakeMessageSender> fake_sender(new FakeMessageSender());
+  std::unique_ptr<RpcBroker> rpc_broker(new RpcBroker(base::Bind(
+      &FakeMessageSender::OnSendMessageAndQuit, fake_sender->GetWeakPtr())));
+
+  rpc_broker->SendUpdateToRemote(CreateTimeUpdate(2, 1000));
+  std::unique_ptr<pb::RpcMessage> rpc(new pb::RpcMessage());
+  rpc->set_handle(2);
+  rpc->set_proc(pb::RpcMessage::RPC_RC_ONENDED);
+  rpc_broker->SendMessageToRemote(std::move(rpc));
+
+  // The pending update goes out first, then the control message.
+  EXPECT_EQ(2, fake_sender->send_count());
+  EXPECT_EQ(pb::RpcMessage::RPC_RC_ONENDED,
+            fake_sender->received_rpc()->proc());
+}
+
+TEST_F(RpcBrokerTest, SendsUpdatesAfterBatchingInterval) {
+  base::MessageLoop message_loop;
+  std::unique_ptr<FakeMessageSender> fake_sender(new FakeMessageSender());
+  std::unique_ptr<RpcBroker> rpc_broker(new RpcBroker(base::Bind(
+      &FakeMessageSender::OnSendMessageAndQuit, fake_sender->GetWeakPtr())));
+
+  rpc_broker->SendUpdateToRemote(CreateTimeUpdate(2, 1000));
+  rpc_broker->SendUpdateToRemote(CreateTimeUpdate(2, 2000));
+  EXPECT_EQ(0, fake_sender->send_count());
+
+  base::RunLoop run_loop;
+  message_loop.task_runner()->PostDelayedTask(
+      FROM_HERE, run_loop.QuitClosure(),
+      base::TimeDelta::FromMilliseconds(100));
+  run_loop.Run();
+
+  ASSERT_EQ(1, fake_sender->send_count());
+  EXPECT_EQ(2000, fake_sender->received_rpc()
+                      ->rendererclient_ontimeupdate_rpc()
+                      .time_usec());
+}
+
 }  // namespace remoting
 }  // namespace media
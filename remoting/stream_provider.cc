@@ -4,6 +4,8 @@
 
 #include "media/remoting/stream_provider.h"
 
+#include <algorithm>
+
 #include "base/bind.h"
 #include "base/callback.h"
 #include "base/callback_helpers.h"
@@ -20,6 +22,12 @@ namespace remoting {
 namespace {
 // The number of frames requested in each ReadUntil RPC message.
 constexpr int kNumFramesInEachReadUntil = 10;
+
+// The number of bytes of frame data buffered at most by each stream. What is
+// left of it is advertised to the sender as the buffer headroom in each
+// ReadUntil RPC message.
+constexpr uint32_t kAudioBufferCapacity = 256 * 1024;
+constexpr uint32_t kVideoBufferCapacity = 4 * 1024 * 1024;
 }
 
 // An implementation of media::DemuxerStream on Media Remoting receiver.
@@ -51,9 +59,19 @@ class MediaStream final : public DemuxerStream {
   void OnInitializeCallback(std::unique_ptr<pb::RpcMessage> message);
   void OnReadUntilCallback(std::unique_ptr<pb::RpcMessage> message);
 
-  // Issues the ReadUntil RPC message when read is pending and buffer is empty.
+  // Issues the ReadUntil RPC message when read is pending and buffer is empty,
+  // or when ShouldPrefetch() returns true.
   void SendReadUntil();
 
+  // Returns true if the buffered frames have drained below half of the buffer
+  // capacity, so that more should be requested before the queue runs empty.
+  // This way the sender learns about the headroom while frames are still
+  // queued, rather than only ever seeing an empty buffer.
+  bool ShouldPrefetch() const;
+
+  // Returns the number of bytes of frame data buffered at most.
+  uint32_t GetBufferCapacity() const;
+
   // Run and reset the read callback.
   void CompleteRead(DemuxerStream::Status status);
 
@@ -95,6 +113,9 @@ class MediaStream final : public DemuxerStream {
 
   base::circular_deque<scoped_refptr<DecoderBuffer>> buffers_;
 
+  // Total data size of the frames in |buffers_|.
+  uint32_t buffered_bytes_ = 0;
+
   // Current audio/video config.
   AudioDecoderConfig audio_decoder_config_;
   VideoDecoderConfig video_decoder_config_;
@@ -225,8 +246,10 @@ void MediaStream::OnReadUntilCallback(std::unique_ptr<pb::RpcMessage> message) {
       CompleteRead(DemuxerStream::kConfigChanged);
     return;
   }
-  if (buffers_.empty() && !read_complete_callback_.is_null())
+  if ((buffers_.empty() && !read_complete_callback_.is_null()) ||
+      ShouldPrefetch()) {
     SendReadUntil();
+  }
 }
 
 void MediaStream::UpdateConfig(const pb::AudioDecoderConfig* audio_message,
@@ -282,14 +305,29 @@ void MediaStream::SendReadUntil() {
   last_read_until_count_ += kNumFramesInEachReadUntil;
   message->set_count(last_read_until_count_);
   message->set_callback_handle(rpc_handle_);
+  const uint32_t buffer_capacity = GetBufferCapacity();
+  message->set_buffer_headroom(
+      buffer_capacity - std::min(buffer_capacity, buffered_bytes_));
   rpc_broker_->SendMessageToRemote(std::move(rpc));
   read_until_sent_ = true;
 }
 
+bool MediaStream::ShouldPrefetch() const {
+  // Nothing more will come after the end of stream.
+  if (buffers_.empty() || buffers_.back()->end_of_stream())
+    return false;
+  return buffered_bytes_ < GetBufferCapacity() / 2;
+}
+
+uint32_t MediaStream::GetBufferCapacity() const {
+  return type_ == AUDIO ? kAudioBufferCapacity : kVideoBufferCapacity;
+}
+
 void MediaStream::FlushUntil(int count) {
   while (!buffers_.empty()) {
     buffers_.pop_front();
   }
+  buffered_bytes_ = 0;
 
   last_read_until_count_ = count;
   if (!read_complete_callback_.is_null())
@@ -343,6 +381,10 @@ void MediaStream::CompleteRead(DemuxerStream::Status status) {
       DCHECK(!buffers_.empty());
       scoped_refptr<DecoderBuffer> frame_data = buffers_.front();
       buffers_.pop_front();
+      if (!frame_data->end_of_stream())
+        buffered_bytes_ -= frame_data->data_size();
+      if (ShouldPrefetch())
+        SendReadUntil();
       base::ResetAndReturn(&read_complete_callback_).Run(status, frame_data);
       return;
   }
@@ -374,6 +416,8 @@ bool MediaStream::SupportsConfigChanges() {
 
 void MediaStream::AppendBuffer(scoped_refptr<DecoderBuffer> buffer) {
   DVLOG(3) << __func__;
+  if (!buffer->end_of_stream())
+    buffered_bytes_ += buffer->data_size();
   buffers_.push_back(buffer);
   if (!read_complete_callback_.is_null())
     CompleteRead(DemuxerStream::kOk);
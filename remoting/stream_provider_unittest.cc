@@ -0,0 +1,183 @@
+// Copyright 2017 The Chromium Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#include "media/remoting/stream_provider.h"
+
+#include <memory>
+#include <vector>
+
+#include "base/bind.h"
+#include "base/macros.h"
+#include "media/base/decoder_buffer.h"
+#include "media/base/demuxer_stream.h"
+#include "media/base/test_helpers.h"
+#include "media/remoting/proto_enum_utils.h"
+#include "media/remoting/proto_utils.h"
+#include "media/remoting/rpc_broker.h"
+#include "testing/gtest/include/gtest/gtest.h"
+
+namespace media {
+namespace remoting {
+
+namespace {
+
+// The RPC handle of the sender side audio DemuxerStreamAdapter.
+constexpr int kRemoteAudioHandle = 42;
+
+}  // namespace
+
+class StreamProviderTest : public testing::Test {
+ public:
+  StreamProviderTest()
+      : rpc_broker_(base::Bind(&StreamProviderTest::OnSendMessage,
+                               base::Unretained(this))),
+        stream_provider_(&rpc_broker_,
+                         base::Bind(&StreamProviderTest::OnError,
+                                    base::Unretained(this))) {}
+
+  void SetUp() override {
+    stream_provider_.Initialize(
+        kRemoteAudioHandle, RpcBroker::kInvalidHandle,
+        base::Bind(&StreamProviderTest::OnInitialized, base::Unretained(this)));
+    ASSERT_EQ(1U, sent_messages_.size());
+    ASSERT_EQ(pb::RpcMessage::RPC_DS_INITIALIZE, sent_messages_[0]->proc());
+    stream_rpc_handle_ = sent_messages_[0]->integer_value();
+    sent_messages_.clear();
+
+    std::unique_ptr<pb::RpcMessage> rpc(new pb::RpcMessage());
+    rpc->set_handle(stream_rpc_handle_);
+    rpc->set_proc(pb::RpcMessage::RPC_DS_INITIALIZE_CALLBACK);
+    auto* message = rpc->mutable_demuxerstream_initializecb_rpc();
+    message->set_type(DemuxerStream::AUDIO);
+    ConvertAudioDecoderConfigToProto(TestAudioConfig::Normal(),
+                                     message->mutable_audio_decoder_config());
+    rpc_broker_.ProcessMessageFromRemote(std::move(rpc));
+    ASSERT_TRUE(initialized_);
+
+    ASSERT_EQ(1U, stream_provider_.GetAllStreams().size());
+    audio_stream_ = stream_provider_.GetAllStreams()[0];
+  }
+
+  void TearDown() override { EXPECT_FALSE(has_error_); }
+
+ protected:
+  // Replies to the last RPC_DS_READUNTIL message as if all of the frames it
+  // asked for were sent.
+  void SendReadUntilCallback() {
+    const pb::RpcMessage* read_until = last_read_until();
+    ASSERT_TRUE(read_until);
+    std::unique_ptr<pb::RpcMessage> rpc(new pb::RpcMessage());
+    rpc->set_handle(stream_rpc_handle_);
+    rpc->set_proc(pb::RpcMessage::RPC_DS_READUNTIL_CALLBACK);
+    auto* message = rpc->mutable_demuxerstream_readuntilcb_rpc();
+    message->set_status(
+        ToProtoDemuxerStreamStatus(DemuxerStream::kOk).value());
+    message->set_count(read_until->demuxerstream_readuntil_rpc().count());
+    rpc_broker_.ProcessMessageFromRemote(std::move(rpc));
+  }
+
+  void Read() {
+    audio_stream_->Read(
+        base::Bind(&StreamProviderTest::OnRead, base::Unretained(this)));
+  }
+
+  int num_read_untils() const {
+    int count = 0;
+    for (const auto& message : sent_messages_) {
+      if (message->proc() == pb::RpcMessage::RPC_DS_READUNTIL)
+        ++count;
+    }
+    return count;
+  }
+
+  const pb::RpcMessage* last_read_until() const {
+    for (auto it = sent_messages_.rbegin(); it != sent_messages_.rend(); ++it) {
+      if ((*it)->proc() == pb::RpcMessage::RPC_DS_READUNTIL)
+        return it->get();
+    }
+    return nullptr;
+  }
+
+  RpcBroker rpc_broker_;
+  StreamProvider stream_provider_;
+  DemuxerStream* audio_stream_ = nullptr;
+  std::vector<scoped_refptr<DecoderBuffer>> read_buffers_;
+
+ private:
+  void OnSendMessage(std::unique_ptr<std::vector<uint8_t>> message) {
+    std::unique_ptr<pb::RpcMessage> rpc(new pb::RpcMessage());
+    ASSERT_TRUE(rpc->ParseFromArray(message->data(), message->size()));
+    EXPECT_EQ(kRemoteAudioHandle, rpc->handle());
+    sent_messages_.push_back(std::move(rpc));
+  }
+
+  void OnInitialized() { initialized_ = true; }
+
+  void OnError() { has_error_ = true; }
+
+  void OnRead(DemuxerStream::Status status,
+              const scoped_refptr<DecoderBuffer>& buffer) {
+    EXPECT_EQ(DemuxerStream::kOk, status);
+    read_buffers_.push_back(buffer);
+  }
+
+  std::vector<std::unique_ptr<pb::RpcMessage>> sent_messages_;
+  int stream_rpc_handle_ = RpcBroker::kInvalidHandle;
+  bool initialized_ = false;
+  bool has_error_ = false;
+
+  DISALLOW_COPY_AND_ASSIGN(StreamProviderTest);
+};
+
+TEST_F(StreamProviderTest, ReadUntilAdvertisesHeadroomWhileFramesQueued) {
+  // Nothing is buffered yet, so the whole capacity is advertised.
+  Read();
+  ASSERT_EQ(1, num_read_untils());
+  ASSERT_TRUE(
+      last_read_until()->demuxerstream_readuntil_rpc().has_buffer_headroom());
+  const uint32_t capacity =
+      last_read_until()->demuxerstream_readuntil_rpc().buffer_headroom();
+  const uint32_t frame_size = capacity / 4;
+
+  // The first frame completes the pending read, the other two are queued,
+  // filling half of the capacity.
+  for (int i = 0; i < 3; ++i) {
+    stream_provider_.AppendBuffer(DemuxerStream::AUDIO,
+                                  new DecoderBuffer(frame_size));
+  }
+  ASSERT_EQ(1U, read_buffers_.size());
+  SendReadUntilCallback();
+  EXPECT_EQ(1, num_read_untils());
+
+  // Once less than half of the capacity is buffered, more frames are requested
+  // while one is still queued, with the headroom that is actually left.
+  Read();
+  ASSERT_EQ(2U, read_buffers_.size());
+  ASSERT_EQ(2, num_read_untils());
+  EXPECT_EQ(capacity - frame_size,
+            last_read_until()->demuxerstream_readuntil_rpc().buffer_headroom());
+
+  // The queued frame is returned without waiting for the sender.
+  Read();
+  EXPECT_EQ(3U, read_buffers_.size());
+  EXPECT_EQ(2, num_read_untils());
+}
+
+TEST_F(StreamProviderTest, NoReadUntilAfterEndOfStream) {
+  Read();
+  ASSERT_EQ(1, num_read_untils());
+  stream_provider_.AppendBuffer(DemuxerStream::AUDIO, new DecoderBuffer(100));
+  stream_provider_.AppendBuffer(DemuxerStream::AUDIO,
+                                DecoderBuffer::CreateEOSBuffer());
+  SendReadUntilCallback();
+
+  // Only the end of stream is queued: nothing more is requested.
+  Read();
+  ASSERT_EQ(2U, read_buffers_.size());
+  EXPECT_TRUE(read_buffers_[1]->end_of_stream());
+  EXPECT_EQ(1, num_read_untils());
+}
+
+}  // namespace remoting
+}  // namespace media
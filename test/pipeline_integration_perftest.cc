@@ -2,11 +2,40 @@
 // Use of this source code is governed by a BSD-style license that can be
 // found in the LICENSE file.
 
+#include <stdint.h>
+
+#include <algorithm>
+#include <memory>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "base/bind.h"
+#include "base/bind_helpers.h"
+#include "base/macros.h"
+#include "base/memory/ptr_util.h"
+#include "base/time/time.h"
+#include "build/build_config.h"
+#include "media/base/audio_decoder.h"
+#include "media/base/cdm_callback_promise.h"
+#include "media/base/cdm_context.h"
+#include "media/base/decryptor.h"
 #include "media/base/test_data_util.h"
+#include "media/base/video_decoder.h"
+#include "media/cdm/aes_decryptor.h"
+#include "media/cdm/json_web_key.h"
+#include "media/filters/ffmpeg_audio_decoder.h"
+#include "media/filters/ffmpeg_video_decoder.h"
 #include "media/media_features.h"
+#include "media/test/fake_encrypted_media.h"
+#include "media/test/mock_media_source.h"
 #include "media/test/pipeline_integration_test_base.h"
 #include "testing/perf/perf_test.h"
 
+#if !defined(MEDIA_DISABLE_LIBVPX)
+#include "media/filters/vpx_video_decoder.h"
+#endif
+
 namespace media {
 
 static const int kBenchmarkIterationsAudio = 200;
@@ -91,4 +120,582 @@ TEST(PipelineIntegrationPerfTest, MP4PlaybackBenchmark) {
 }
 #endif
 
+// Pipeline benchmark suite: plays each entry of a codec, resolution, container
+// and src= vs MSE matrix through PipelineImpl, and breaks the time down per
+// stage.
+
+namespace {
+
+const int kBenchmarkIterationsPipeline = 10;
+
+const char kWebM[] = "video/webm; codecs=\"vp8,vorbis\"";
+const char kWebMVP9[] = "video/webm; codecs=\"vp9\"";
+#if BUILDFLAG(USE_PROPRIETARY_CODECS)
+const char kMP4[] = "video/mp4; codecs=\"avc1.4D4041,mp4a.40.2\"";
+const char kMP4Video[] = "video/mp4; codecs=\"avc1.4D4041\"";
+#endif
+
+struct PipelineBenchmarkParams {
+  const char* filename;
+  // Played through MockMediaSource when set, and with src= otherwise.
+  const char* mime_type;
+  // Whether the file needs the test key, which only MSE playback provides.
+  bool encrypted;
+};
+
+// Wall-clock time spent in the instrumented stages. Each decryption or decode
+// runs from the call to its callback, which the decoders post back through
+// BindToCurrentLoop(); the times therefore include the wait for that task
+// behind the other work queued on the media thread.
+struct PipelineStageTimes {
+  base::TimeDelta decrypt_time;
+  base::TimeDelta audio_decode_time;
+  base::TimeDelta video_decode_time;
+};
+
+// Adds the stage times accumulated from |start| to |end| to |*total|.
+void AddStageTimes(const PipelineStageTimes& start,
+                   const PipelineStageTimes& end,
+                   PipelineStageTimes* total) {
+  total->decrypt_time += end.decrypt_time - start.decrypt_time;
+  total->audio_decode_time += end.audio_decode_time - start.audio_decode_time;
+  total->video_decode_time += end.video_decode_time - start.video_decode_time;
+}
+
+// Totals from one or more runs of PipelineBenchmark::Run().
+struct PipelineBenchmarkResult {
+  base::TimeDelta startup_time;
+  base::TimeDelta playback_time;
+  base::TimeDelta seek_time;
+  // Stage times within each of the windows above. A decryption or decode is
+  // attributed to the window in which its callback runs.
+  PipelineStageTimes startup_stages;
+  PipelineStageTimes playback_stages;
+  PipelineStageTimes seek_stages;
+  // CPU time of the media thread during playback, if ThreadTicks is supported.
+  base::TimeDelta media_thread_cpu_time;
+  uint64_t video_frames_decoded = 0;
+  // Peak demuxed data held by the renderers, in bytes.
+  int64_t peak_memory_usage = 0;
+};
+
+// Adds the time since |start|, including the wait for this callback's task, to
+// |*total_time| and runs |done_cb| before passing |status| on to |decode_cb|.
+void OnDecodeDone(base::TimeTicks start,
+                  base::TimeDelta* total_time,
+                  const base::Closure& done_cb,
+                  const base::Callback<void(DecodeStatus)>& decode_cb,
+                  DecodeStatus status) {
+  *total_time += base::TimeTicks::Now() - start;
+  done_cb.Run();
+  decode_cb.Run(status);
+}
+
+// Same as OnDecodeDone(), for Decryptor::Decrypt().
+void OnDecryptDone(base::TimeTicks start,
+                   base::TimeDelta* total_time,
+                   const base::Closure& done_cb,
+                   const Decryptor::DecryptCB& decrypt_cb,
+                   Decryptor::Status status,
+                   const scoped_refptr<DecoderBuffer>& buffer) {
+  *total_time += base::TimeTicks::Now() - start;
+  done_cb.Run();
+  decrypt_cb.Run(status, buffer);
+}
+
+// Forwards to |decoder| and accumulates the time each decode takes.
+class TimingVideoDecoder : public VideoDecoder {
+ public:
+  TimingVideoDecoder(std::unique_ptr<VideoDecoder> decoder,
+                     base::TimeDelta* decode_time,
+                     const base::Closure& decode_done_cb)
+      : decoder_(std::move(decoder)),
+        decode_time_(decode_time),
+        decode_done_cb_(decode_done_cb) {}
+  ~TimingVideoDecoder() override {}
+
+  // VideoDecoder implementation.
+  std::string GetDisplayName() const override {
+    return decoder_->GetDisplayName();
+  }
+  void Initialize(const VideoDecoderConfig& config,
+                  bool low_delay,
+                  CdmContext* cdm_context,
+                  const InitCB& init_cb,
+                  const OutputCB& output_cb) override {
+    decoder_->Initialize(config, low_delay, cdm_context, init_cb, output_cb);
+  }
+  void Decode(const scoped_refptr<DecoderBuffer>& buffer,
+              const DecodeCB& decode_cb) override {
+    decoder_->Decode(buffer,
+                     base::Bind(&OnDecodeDone, base::TimeTicks::Now(),
+                                decode_time_, decode_done_cb_, decode_cb));
+  }
+  void Reset(const base::Closure& closure) override {
+    decoder_->Reset(closure);
+  }
+  bool NeedsBitstreamConversion() const override {
+    return decoder_->NeedsBitstreamConversion();
+  }
+  bool CanReadWithoutStalling() const override {
+    return decoder_->CanReadWithoutStalling();
+  }
+  int GetMaxDecodeRequests() const override {
+    return decoder_->GetMaxDecodeRequests();
+  }
+
+ private:
+  std::unique_ptr<VideoDecoder> decoder_;
+  base::TimeDelta* decode_time_;
+  const base::Closure decode_done_cb_;
+
+  DISALLOW_COPY_AND_ASSIGN(TimingVideoDecoder);
+};
+
+// Forwards to |decoder| and accumulates the time each decode takes.
+class TimingAudioDecoder : public AudioDecoder {
+ public:
+  TimingAudioDecoder(std::unique_ptr<AudioDecoder> decoder,
+                     base::TimeDelta* decode_time,
+                     const base::Closure& decode_done_cb)
+      : decoder_(std::move(decoder)),
+        decode_time_(decode_time),
+        decode_done_cb_(decode_done_cb) {}
+  ~TimingAudioDecoder() override {}
+
+  // AudioDecoder implementation.
+  std::string GetDisplayName() const override {
+    return decoder_->GetDisplayName();
+  }
+  void Initialize(const AudioDecoderConfig& config,
+                  CdmContext* cdm_context,
+                  const InitCB& init_cb,
+                  const OutputCB& output_cb) override {
+    decoder_->Initialize(config, cdm_context, init_cb, output_cb);
+  }
+  void Decode(const scoped_refptr<DecoderBuffer>& buffer,
+              const DecodeCB& decode_cb) override {
+    decoder_->Decode(buffer,
+                     base::Bind(&OnDecodeDone, base::TimeTicks::Now(),
+                                decode_time_, decode_done_cb_, decode_cb));
+  }
+  void Reset(const base::Closure& closure) override {
+    decoder_->Reset(closure);
+  }
+  bool NeedsBitstreamConversion() const override {
+    return decoder_->NeedsBitstreamConversion();
+  }
+
+ private:
+  std::unique_ptr<AudioDecoder> decoder_;
+  base::TimeDelta* decode_time_;
+  const base::Closure decode_done_cb_;
+
+  DISALLOW_COPY_AND_ASSIGN(TimingAudioDecoder);
+};
+
+// CdmContext whose Decryptor forwards to the one of |cdm_context| and
+// accumulates the time each decryption takes.
+class TimingCdmContext : public CdmContext, public Decryptor {
+ public:
+  TimingCdmContext(CdmContext* cdm_context,
+                   base::TimeDelta* decrypt_time,
+                   const base::Closure& decrypt_done_cb)
+      : cdm_context_(cdm_context),
+        decryptor_(cdm_context->GetDecryptor()),
+        decrypt_time_(decrypt_time),
+        decrypt_done_cb_(decrypt_done_cb) {}
+  ~TimingCdmContext() override {}
+
+  // CdmContext implementation.
+  Decryptor* GetDecryptor() override { return this; }
+  int GetCdmId() const override { return cdm_context_->GetCdmId(); }
+
+  // Decryptor implementation.
+  void RegisterNewKeyCB(StreamType stream_type,
+                        const NewKeyCB& key_added_cb) override {
+    decryptor_->RegisterNewKeyCB(stream_type, key_added_cb);
+  }
+  void Decrypt(StreamType stream_type,
+               const scoped_refptr<DecoderBuffer>& encrypted,
+               const DecryptCB& decrypt_cb) override {
+    decryptor_->Decrypt(
+        stream_type, encrypted,
+        base::Bind(&OnDecryptDone, base::TimeTicks::Now(), decrypt_time_,
+                   decrypt_done_cb_, decrypt_cb));
+  }
+  void CancelDecrypt(StreamType stream_type) override {
+    decryptor_->CancelDecrypt(stream_type);
+  }
+  void InitializeAudioDecoder(const AudioDecoderConfig& config,
+                              const DecoderInitCB& init_cb) override {
+    decryptor_->InitializeAudioDecoder(config, init_cb);
+  }
+  void InitializeVideoDecoder(const VideoDecoderConfig& config,
+                              const DecoderInitCB& init_cb) override {
+    decryptor_->InitializeVideoDecoder(config, init_cb);
+  }
+  void DecryptAndDecodeAudio(const scoped_refptr<DecoderBuffer>& encrypted,
+                             const AudioDecodeCB& audio_decode_cb) override {
+    decryptor_->DecryptAndDecodeAudio(encrypted, audio_decode_cb);
+  }
+  void DecryptAndDecodeVideo(const scoped_refptr<DecoderBuffer>& encrypted,
+                             const VideoDecodeCB& video_decode_cb) override {
+    decryptor_->DecryptAndDecodeVideo(encrypted, video_decode_cb);
+  }
+  void ResetDecoder(StreamType stream_type) override {
+    decryptor_->ResetDecoder(stream_type);
+  }
+  void DeinitializeDecoder(StreamType stream_type) override {
+    decryptor_->DeinitializeDecoder(stream_type);
+  }
+
+ private:
+  CdmContext* cdm_context_;
+  Decryptor* decryptor_;
+  base::TimeDelta* decrypt_time_;
+  const base::Closure decrypt_done_cb_;
+
+  DISALLOW_COPY_AND_ASSIGN(TimingCdmContext);
+};
+
+void OnPromiseRejected(CdmPromise::Exception exception_code,
+                       uint32_t system_code,
+                       const std::string& error_message) {
+  ADD_FAILURE() << "CDM promise rejected: " << error_message;
+}
+
+// Provides the test key in response to the encrypted event.
+class KeyProvidingApp : public FakeEncryptedMedia::AppBase {
+ public:
+  KeyProvidingApp() {}
+  ~KeyProvidingApp() override {}
+
+  // FakeEncryptedMedia::AppBase implementation.
+  void OnSessionMessage(const std::string& session_id,
+                        CdmMessageType message_type,
+                        const std::vector<uint8_t>& message,
+                        AesDecryptor* decryptor) override {
+    // For Clear Key |message| is a JSON object with the requested key ID.
+    KeyIdList key_ids;
+    std::string error_message;
+    ASSERT_TRUE(ExtractKeyIdsFromKeyIdsInitData(
+        std::string(message.begin(), message.end()), &key_ids,
+        &error_message))
+        << error_message;
+    ASSERT_EQ(1u, key_ids.size());
+
+    std::vector<uint8_t> key;
+    ASSERT_TRUE(LookupTestKeyVector(key_ids[0], false, &key));
+    const std::string jwk = GenerateJWKSet(
+        key.data(), key.size(), key_ids[0].data(), key_ids[0].size());
+    decryptor->UpdateSession(
+        session_id, std::vector<uint8_t>(jwk.begin(), jwk.end()),
+        base::MakeUnique<CdmCallbackPromise<>>(
+            base::BindOnce(&base::DoNothing),
+            base::BindOnce(&OnPromiseRejected)));
+  }
+  void OnSessionClosed(const std::string& session_id) override {}
+  void OnSessionKeysChange(const std::string& session_id,
+                           bool has_additional_usable_key,
+                           CdmKeysInfo keys_info) override {}
+  void OnSessionExpirationUpdate(const std::string& session_id,
+                                 base::Time new_expiry_time) override {}
+  void OnEncryptedMediaInitData(EmeInitDataType init_data_type,
+                                const std::vector<uint8_t>& init_data,
+                                AesDecryptor* decryptor) override {
+    // All test files use a single key, so one session is enough.
+    if (session_created_)
+      return;
+    session_created_ = true;
+    decryptor->CreateSessionAndGenerateRequest(
+        CdmSessionType::TEMPORARY_SESSION, init_data_type, init_data,
+        base::MakeUnique<CdmCallbackPromise<std::string>>(
+            base::BindOnce(&KeyProvidingApp::OnSessionCreated),
+            base::BindOnce(&OnPromiseRejected)));
+  }
+
+ private:
+  static void OnSessionCreated(const std::string& session_id) {}
+
+  bool session_created_ = false;
+
+  DISALLOW_COPY_AND_ASSIGN(KeyProvidingApp);
+};
+
+// Creates renderers that try the decoders from |create_video_decoders_cb| and
+// |create_audio_decoders_cb| before the default ones.
+class TimingRendererFactory final : public PipelineTestRendererFactory {
+ public:
+  TimingRendererFactory(
+      std::unique_ptr<PipelineTestRendererFactory> renderer_factory,
+      const CreateVideoDecodersCB& create_video_decoders_cb,
+      const CreateAudioDecodersCB& create_audio_decoders_cb)
+      : default_renderer_factory_(std::move(renderer_factory)),
+        create_video_decoders_cb_(create_video_decoders_cb),
+        create_audio_decoders_cb_(create_audio_decoders_cb) {}
+  ~TimingRendererFactory() override {}
+
+  // PipelineTestRendererFactory implementation.
+  std::unique_ptr<Renderer> CreateRenderer(
+      CreateVideoDecodersCB prepend_video_decoders_cb,
+      CreateAudioDecodersCB prepend_audio_decoders_cb) override {
+    DCHECK(prepend_video_decoders_cb.is_null());
+    DCHECK(prepend_audio_decoders_cb.is_null());
+    return default_renderer_factory_->CreateRenderer(
+        create_video_decoders_cb_, create_audio_decoders_cb_);
+  }
+
+ private:
+  std::unique_ptr<PipelineTestRendererFactory> default_renderer_factory_;
+  const CreateVideoDecodersCB create_video_decoders_cb_;
+  const CreateAudioDecodersCB create_audio_decoders_cb_;
+
+  DISALLOW_COPY_AND_ASSIGN(TimingRendererFactory);
+};
+
+// A pipeline whose decoders and decryptor report how long they take.
+class PipelineBenchmark : public PipelineIntegrationTestBase {
+ public:
+  PipelineBenchmark() {
+    std::unique_ptr<PipelineTestRendererFactory> factory =
+        std::move(renderer_factory_);
+    renderer_factory_ = base::MakeUnique<TimingRendererFactory>(
+        std::move(factory),
+        base::BindRepeating(&PipelineBenchmark::CreateVideoDecoders,
+                            base::Unretained(this)),
+        base::BindRepeating(&PipelineBenchmark::CreateAudioDecoders,
+                            base::Unretained(this)));
+  }
+  ~PipelineBenchmark() override {
+    // Stop before the timing CDM and the media source go away.
+    if (pipeline_->IsRunning())
+      Stop();
+  }
+
+  // Plays |params| to the end, seeks back to the middle and adds the
+  // measurements to |result|.
+  void Run(const PipelineBenchmarkParams& params,
+           PipelineBenchmarkResult* result) {
+    // MSE startup includes appending, and so demuxing, the whole file.
+    if (params.mime_type) {
+      source_ = base::MakeUnique<MockMediaSource>(
+          params.filename, params.mime_type, kAppendWholeFile);
+    }
+    const base::TimeTicks start = base::TimeTicks::Now();
+    if (source_) {
+      if (params.encrypted)
+        SetUpDecryption();
+      ASSERT_EQ(PIPELINE_OK,
+                StartPipelineWithMediaSource(source_.get(), kNormal, nullptr));
+      source_->EndOfStream();
+    } else {
+      ASSERT_FALSE(params.encrypted);
+      ASSERT_EQ(PIPELINE_OK, Start(params.filename));
+    }
+    result->startup_time += base::TimeTicks::Now() - start;
+    const PipelineStageTimes started_stages = stage_totals_;
+    AddStageTimes(PipelineStageTimes(), started_stages, &result->startup_stages);
+
+    const base::ThreadTicks cpu_start = base::ThreadTicks::IsSupported()
+                                            ? base::ThreadTicks::Now()
+                                            : base::ThreadTicks();
+    const base::TimeTicks play_start = base::TimeTicks::Now();
+    Play();
+    ASSERT_TRUE(WaitUntilOnEnded());
+    result->playback_time += base::TimeTicks::Now() - play_start;
+    const PipelineStageTimes ended_stages = stage_totals_;
+    AddStageTimes(started_stages, ended_stages, &result->playback_stages);
+    if (base::ThreadTicks::IsSupported())
+      result->media_thread_cpu_time += base::ThreadTicks::Now() - cpu_start;
+    result->video_frames_decoded +=
+        pipeline_->GetStatistics().video_frames_decoded;
+
+    const base::TimeDelta seek_time = pipeline_->GetMediaDuration() / 2;
+    const base::TimeTicks seek_start = base::TimeTicks::Now();
+    if (source_)
+      source_->Seek(seek_time);
+    ASSERT_TRUE(Seek(seek_time));
+    result->seek_time += base::TimeTicks::Now() - seek_start;
+    AddStageTimes(ended_stages, stage_totals_, &result->seek_stages);
+
+    if (source_)
+      source_->Shutdown();
+    Stop();
+    result->peak_memory_usage =
+        std::max(result->peak_memory_usage, peak_memory_usage_);
+  }
+
+ private:
+  void SetUpDecryption() {
+    encrypted_media_ =
+        base::MakeUnique<FakeEncryptedMedia>(new KeyProvidingApp());
+    cdm_context_ = base::MakeUnique<TimingCdmContext>(
+        encrypted_media_->GetCdmContext(), &stage_totals_.decrypt_time,
+        base::Bind(&PipelineBenchmark::SampleMemoryUsage,
+                   base::Unretained(this)));
+    EXPECT_CALL(*this, DecryptorAttached(true));
+    pipeline_->SetCdm(cdm_context_.get(),
+                      base::Bind(&PipelineBenchmark::DecryptorAttached,
+                                 base::Unretained(this)));
+    source_->set_encrypted_media_init_data_cb(
+        base::Bind(&FakeEncryptedMedia::OnEncryptedMediaInitData,
+                   base::Unretained(encrypted_media_.get())));
+  }
+
+  std::vector<std::unique_ptr<VideoDecoder>> CreateVideoDecoders() {
+    std::vector<std::unique_ptr<VideoDecoder>> decoders;
+#if !defined(MEDIA_DISABLE_LIBVPX)
+    decoders.push_back(WrapVideoDecoder(base::MakeUnique<VpxVideoDecoder>()));
+#endif
+#if !defined(OS_ANDROID) && !defined(DISABLE_FFMPEG_VIDEO_DECODERS)
+    decoders.push_back(
+        WrapVideoDecoder(base::MakeUnique<FFmpegVideoDecoder>(&media_log_)));
+#endif
+    return decoders;
+  }
+
+  std::vector<std::unique_ptr<AudioDecoder>> CreateAudioDecoders() {
+    std::vector<std::unique_ptr<AudioDecoder>> decoders;
+    decoders.push_back(base::MakeUnique<TimingAudioDecoder>(
+        base::MakeUnique<FFmpegAudioDecoder>(
+            scoped_task_environment_.GetMainThreadTaskRunner(), &media_log_),
+        &stage_totals_.audio_decode_time,
+        base::Bind(&PipelineBenchmark::SampleMemoryUsage,
+                   base::Unretained(this))));
+    return decoders;
+  }
+
+  std::unique_ptr<VideoDecoder> WrapVideoDecoder(
+      std::unique_ptr<VideoDecoder> decoder) {
+    return base::MakeUnique<TimingVideoDecoder>(
+        std::move(decoder), &stage_totals_.video_decode_time,
+        base::Bind(&PipelineBenchmark::SampleMemoryUsage,
+                   base::Unretained(this)));
+  }
+
+  void SampleMemoryUsage() {
+    const PipelineStatistics stats = pipeline_->GetStatistics();
+    peak_memory_usage_ =
+        std::max(peak_memory_usage_,
+                 stats.audio_memory_usage + stats.video_memory_usage);
+  }
+
+  // Running totals of the stage times, snapshotted at the window boundaries.
+  PipelineStageTimes stage_totals_;
+  int64_t peak_memory_usage_ = 0;
+  std::unique_ptr<MockMediaSource> source_;
+  std::unique_ptr<FakeEncryptedMedia> encrypted_media_;
+  std::unique_ptr<TimingCdmContext> cdm_context_;
+
+  DISALLOW_COPY_AND_ASSIGN(PipelineBenchmark);
+};
+
+void PrintTimeResult(const std::string& measurement,
+                     const std::string& modifier,
+                     const std::string& trace,
+                     base::TimeDelta total_time,
+                     bool important) {
+  perf_test::PrintResult(
+      measurement, modifier, trace,
+      total_time.InMillisecondsF() / kBenchmarkIterationsPipeline, "ms",
+      important);
+}
+
+// Prints the time spent in each stage during the |window| of |window_time|.
+void PrintStageTimes(const std::string& window,
+                     const std::string& modifier,
+                     const std::string& trace,
+                     base::TimeDelta window_time,
+                     const PipelineStageTimes& stages,
+                     bool encrypted) {
+  const std::string prefix = "pipeline_" + window + "_stage_";
+  if (encrypted) {
+    PrintTimeResult(prefix + "decrypt", modifier, trace, stages.decrypt_time,
+                    false);
+  }
+  PrintTimeResult(prefix + "audio_decode", modifier, trace,
+                  stages.audio_decode_time, false);
+  PrintTimeResult(prefix + "video_decode", modifier, trace,
+                  stages.video_decode_time, false);
+  // Demuxing, rendering and scheduling on the media thread.
+  PrintTimeResult(prefix + "other", modifier, trace,
+                  window_time - stages.decrypt_time -
+                      stages.audio_decode_time - stages.video_decode_time,
+                  false);
+}
+
+// Runs |params| |kBenchmarkIterationsPipeline| times and prints the mean of
+// each measurement, and the peak memory usage, as perf dashboard results.
+void RunPipelineBenchmark(const PipelineBenchmarkParams& params) {
+  PipelineBenchmarkResult result;
+  for (int i = 0; i < kBenchmarkIterationsPipeline; ++i) {
+    PipelineBenchmark benchmark;
+    benchmark.Run(params, &result);
+    if (::testing::Test::HasFatalFailure())
+      return;
+  }
+
+  const std::string modifier =
+      std::string(params.mime_type ? "_mse" : "_src") +
+      (params.encrypted ? "_encrypted" : "");
+  const std::string trace = params.filename;
+  PrintTimeResult("pipeline_startup", modifier, trace, result.startup_time,
+                  true);
+  PrintTimeResult("pipeline_seek", modifier, trace, result.seek_time, true);
+  PrintTimeResult("pipeline_playback", modifier, trace, result.playback_time,
+                  true);
+  if (result.video_frames_decoded > 0) {
+    perf_test::PrintResult(
+        "pipeline_video_frames", modifier, trace,
+        result.video_frames_decoded / result.playback_time.InSecondsF(),
+        "frames/s", true);
+  }
+  PrintStageTimes("startup", modifier, trace, result.startup_time,
+                  result.startup_stages, params.encrypted);
+  PrintStageTimes("playback", modifier, trace, result.playback_time,
+                  result.playback_stages, params.encrypted);
+  PrintStageTimes("seek", modifier, trace, result.seek_time,
+                  result.seek_stages, params.encrypted);
+  if (base::ThreadTicks::IsSupported()) {
+    PrintTimeResult("pipeline_media_thread_cpu", modifier, trace,
+                    result.media_thread_cpu_time, false);
+  }
+  perf_test::PrintResult("pipeline_peak_memory", modifier, trace,
+                         result.peak_memory_usage / 1024.0, "KB", false);
+}
+
+const PipelineBenchmarkParams kPipelineBenchmarks[] = {
+    {"bear-320x240.webm", nullptr, false},
+    {"bear-1280x720.webm", nullptr, false},
+    {"bear-vp9-opus.webm", nullptr, false},
+    {"bear-320x240.webm", kWebM, false},
+    {"bear-vp9.webm", kWebMVP9, false},
+    {"bear-320x240-av_enc-av.webm", kWebM, true},
+};
+
+// PipelineIntegrationTests can't play h264 content on Android.
+#if BUILDFLAG(USE_PROPRIETARY_CODECS) && !defined(OS_ANDROID)
+const PipelineBenchmarkParams kProprietaryPipelineBenchmarks[] = {
+    {"bear-1280x720.mp4", nullptr, false},
+    {"bear-640x360-av_frag.mp4", kMP4, false},
+    {"bear-1280x720-av_frag.mp4", kMP4, false},
+    {"bear-640x360-v_frag-cenc.mp4", kMP4Video, true},
+};
+#endif
+
+}  // namespace
+
+TEST(PipelineIntegrationPerfTest, PipelineBenchmarkSuite) {
+  for (const auto& params : kPipelineBenchmarks)
+    RunPipelineBenchmark(params);
+}
+
+#if BUILDFLAG(USE_PROPRIETARY_CODECS) && !defined(OS_ANDROID)
+TEST(PipelineIntegrationPerfTest, ProprietaryPipelineBenchmarkSuite) {
+  for (const auto& params : kProprietaryPipelineBenchmarks)
+    RunPipelineBenchmark(params);
+}
+#endif
+
 }  // namespace media